@@ -0,0 +1,121 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include "SystemTypes.h"
+#include "SensorFields.h"
+
+// 検知の種類
+enum class AnomalyType : uint8_t {
+    SPIKE,          // zスコア：基準の予測から大きく外れた単発の値
+    SHIFT,          // CUSUM：予測残差の偏りが続く水準変化
+    DRIFT           // Page-Hinkley：変化率（傾き）の変化（横ばいだった気圧が下がり始めたなど）
+};
+
+// 異常イベント（トリビアルコピー可能な固定長）
+struct AnomalyEvent {
+    uint32_t timestamp;
+    bool timeSynced;        // 元の読み取り値のtime_synced（TimeUtils::toSeconds()に渡す）
+    uint8_t channel;
+    uint8_t sensorId;       // BSEC_OUTPUT_*（SENSOR_FIELDSと同じ）
+    AnomalyType type;
+    int8_t direction;       // +1:上昇 -1:下降
+    float value;            // 検知時の値
+    float baseline;         // 検知時の基準値
+    float score;            // SPIKE・SHIFTは標準偏差単位、DRIFTは項目の単位での累積変化量
+};
+
+typedef std::function<void(const AnomalyEvent&)> AnomalyCallback;
+
+// 監視対象の項目（gas_resistanceは桁で変わるので対数で扱う）
+// DRIFTの閾値は日内変動（気温・気圧の日変化）で鳴らないよう項目の単位で与える
+struct AnomalyField {
+    uint8_t sensorId;
+    float minSigma;         // 残差の標準偏差の下限（量子化・静穏時にzスコアが過大にならないように）
+    float driftDelta;       // 傾きの許容幅（単位/時）
+    float driftThreshold;   // 許容幅を超えた傾きの変化による累積変化量（単位）
+    bool logScale;
+};
+
+inline constexpr AnomalyField ANOMALY_FIELDS[] = {
+    { BSEC_OUTPUT_RAW_TEMPERATURE, 0.05f, 0.5f,  1.5f,  false },
+    { BSEC_OUTPUT_RAW_HUMIDITY,    0.3f,  3.0f,  8.0f,  false },
+    { BSEC_OUTPUT_RAW_PRESSURE,    0.05f, 0.3f,  1.0f,  false },
+    { BSEC_OUTPUT_IAQ,             2.0f,  20.0f, 50.0f, false },
+    { BSEC_OUTPUT_RAW_GAS,         0.01f, 0.1f,  0.3f,  true },
+};
+
+struct AnomalyDetectorConfig {
+    float zThreshold;           // SPIKE判定（標準偏差の何倍）
+    float cusumSlack;           // CUSUMの許容幅k（標準偏差単位）
+    float cusumThreshold;       // CUSUMの判定値h
+    uint32_t baselineSeconds;   // 基準（水準＋傾き）の時定数
+    uint32_t varianceSeconds;   // 残差分散の時定数
+    uint16_t warmupSamples;     // 判定を始めるまでのサンプル数（加えて傾きが落ち着くまで基準の時定数の2倍の経過を待つ）
+    uint32_t holdSeconds;       // 検知後に「異常中」とみなす時間
+    uint32_t maxGapSeconds;     // これ以上間隔が空いたら基準を作り直す（時刻の戻り・NTP同期での飛びも含む）
+    
+    AnomalyDetectorConfig() :
+        zThreshold(5.0f), cusumSlack(1.0f), cusumThreshold(12.0f),
+        baselineSeconds(900), varianceSeconds(3600), warmupSamples(30), holdSeconds(600),
+        maxGapSeconds(3600) {}
+};
+
+// zスコア・CUSUM・Page-Hinkleyによる逐次の異常・変化点検知
+// 基準はHolt法（水準＋傾き）の1ステップ予測とし、日内変動のような緩やかな変化では残差が
+// 大きくならないようにする。読み取り1件あたり項目数×定数の計算で、履歴は保持しない
+class AnomalyDetector {
+public:
+    static const uint8_t MAX_CHANNELS = 4;
+    static const uint8_t FIELD_COUNT = sizeof(ANOMALY_FIELDS) / sizeof(ANOMALY_FIELDS[0]);
+    static constexpr float Z_CLIP = 4.0f;   // 単発の外れ値で累積和が一気に閾値を超えないよう制限
+    
+    struct FieldState {
+        uint32_t samples;
+        uint32_t firstTimestamp;
+        uint32_t lastTimestamp;
+        float level;            // 基準の水準
+        float trend;            // 基準の傾き（単位/秒）
+        float variance;         // 予測残差の分散
+        float cusumUp;
+        float cusumDown;
+        float segmentHours;     // Page-Hinkleyの区間（検知でリセット）
+        float segmentSlope;     // 区間内の平均の傾き（単位/時）
+        float driftUp;
+        float driftUpMin;
+        float driftDown;
+        float driftDownMin;
+    };
+
+private:
+    AnomalyDetectorConfig config;
+    FieldState states[MAX_CHANNELS][FIELD_COUNT];
+    AnomalyCallback callback;
+    uint32_t lastEventSeconds[MAX_CHANNELS];
+    uint32_t eventCounts[3];
+    
+    void updateField(FieldState& state, const AnomalyField& field, const SensorReading& reading, 
+                     float value, uint32_t seconds);
+    void emit(AnomalyType type, const AnomalyField& field, const SensorReading& reading, uint32_t seconds,
+              int8_t direction, float value, float baseline, float score);
+    void resetChange(FieldState& state);
+
+public:
+    AnomalyDetector();
+    
+    void setConfig(const AnomalyDetectorConfig& newConfig) { config = newConfig; }
+    const AnomalyDetectorConfig& getConfig() const { return config; }
+    void setCallback(AnomalyCallback cb) { callback = cb; }
+    void reset();
+    
+    // 読み取り値ごとに呼び出す（外れ値フィルタで置換された項目は判定しない）
+    void update(const SensorReading& reading);
+    
+    // 最後の検知からholdSeconds以内ならtrue
+    bool isActive(uint8_t channel, uint32_t nowSeconds) const;
+    uint32_t getEventCount(AnomalyType type) const { return eventCounts[(int)type]; }
+    String getReport() const;
+    
+    static const char* typeToString(AnomalyType type);
+};
+
+#endif // ANOMALY_DETECTOR_H
\ No newline at end of file
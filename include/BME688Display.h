@@ -3,6 +3,7 @@
 
 #include <M5Unified.h>
 #include <bsec2.h>
+#include "SystemTypes.h"
 
 // シンプルなBME688表示クラス
 class BME688Display {
@@ -25,9 +26,10 @@ private:
         float runin = 0;
         bool dataValid = false;
     } sensorData;
+    SensorReading decodedReading;   // BSEC出力のデコード先（届かなかった項目は前回値を保持）
     
-    // 静的コールバック用
-    static BME688Display* instance;
+    // 静的コールバック用（run()を呼び出している間だけ設定し、複数インスタンスでも振り分けられるようにする）
+    static BME688Display* activeInstance;
     static void bsecCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bsec);
     
     // 表示関数
@@ -0,0 +1,75 @@
+#ifndef BSEC_STATE_STORE_H
+#define BSEC_STATE_STORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <bsec2.h>
+
+// BSECの校正状態（state blob）をNVSへ保存・復元する
+// 再起動やOTA後に数時間の慣らし運転をやり直さないためのもの。
+// ヘッダーにBSECライブラリのバージョンとCRC32を持ち、不一致の場合は復元しない。
+// 保存先は2つのスロットを交互に使い、本体とヘッダーの両方を書き終えたスロットだけを
+// 通し番号で新しいものとして扱う（書き込み中に電源が落ちても前回の状態が残る）。
+class BsecStateStore {
+private:
+    struct StateHeader {
+        uint32_t magic;
+        uint16_t formatVersion;
+        uint16_t stateLength;     // 保存した本体の長さ（末尾の0を除く）
+        uint8_t bsecVersion[4];   // major, minor, major_bugfix, minor_bugfix
+        uint32_t crc;             // 本体stateLengthバイトのCRC32
+        uint32_t sequence;        // 保存ごとに増える通し番号
+    };
+    
+    enum class SlotStatus {
+        MISSING,
+        VERSION_MISMATCH,
+        VALID
+    };
+    
+    Preferences preferences;
+    char nvsNamespace[16];
+    bool opened;
+    uint32_t lastSavedCrc;
+    int8_t activeSlot;            // 最新の状態が入っているスロット（-1: なし）
+    uint32_t activeSequence;
+    
+    // 計測用
+    uint32_t saveCount;
+    uint32_t skippedCount;
+    uint32_t bytesWritten;
+    
+    static void packVersion(const bsec_version_t& version, uint8_t out[4]);
+    SlotStatus readHeader(const char* key, const uint8_t version[4], size_t capacity, StateHeader& header);
+    bool readState(const char* key, const StateHeader& header, uint8_t* state, size_t capacity);
+
+public:
+    BsecStateStore();
+    ~BsecStateStore();
+    
+    // NVS名前空間の変更（複数センサーで別々に保存する場合、begin()より前に呼ぶ）
+    void setNamespace(const char* name);
+    bool begin();
+    
+    // 保存済みの状態を読み込む（バージョン・CRC不一致や未保存ならfalse）
+    // 保存した長さより後ろは0で埋める
+    bool load(uint8_t* state, size_t length, const bsec_version_t& version);
+    // 状態を保存する（前回保存と同一内容なら書き込みを省略してtrue）
+    // Bsec2::getState()は直列化した長さを返さないため、0で初期化したバッファを渡すと末尾の0は保存しない
+    bool save(const uint8_t* state, size_t length, const bsec_version_t& version);
+    bool erase();
+    
+    uint32_t getSaveCount() const { return saveCount; }
+    uint32_t getSkippedCount() const { return skippedCount; }
+    uint32_t getBytesWritten() const { return bytesWritten; }
+    
+    static uint32_t crc32(const uint8_t* data, size_t length);
+    
+    // 定数
+    static const uint32_t STATE_MAGIC = 0x59425354;  // "YBST"
+    static const uint16_t FORMAT_VERSION = 2;
+    static const size_t STATE_SIZE = BSEC_MAX_STATE_BLOB_SIZE;
+    static constexpr const char* DEFAULT_NAMESPACE = "bsec";
+};
+
+#endif // BSEC_STATE_STORE_H
\ No newline at end of file
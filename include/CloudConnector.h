@@ -2,6 +2,8 @@
 #define CLOUD_CONNECTOR_H
 
 #include "SystemTypes.h"
+#include "StreamingStats.h"
+#include "OmenSummary.h"
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <vector>
@@ -15,6 +17,9 @@ private:
     unsigned long lastConnectionCheck;
     unsigned long lastUploadAttempt;
     int retryCount;
+    const StreamingStats* statsSource;  // 送信データに添える逐次統計（未設定なら省略）
+    bool derivedMetricsEnabled;         // 送信データに派生指標（露点など）を添える
+    float altitude;
     
     // WiFi管理
     bool connectToWiFi();
@@ -31,6 +36,9 @@ private:
     static const uint32_t MAX_QUEUE_SIZE = 1000;
     static const uint32_t CONNECTION_CHECK_INTERVAL = 30000; // 30秒
     static const uint32_t MAX_RETRY_ATTEMPTS = 3;
+    static const uint8_t MAX_REPORT_EVENTS = 5;                 // レポートに載せる直近の異常
+    static constexpr float PRESSURE_FALL_WARNING = -1.0f;       // hPa/h
+    static constexpr float HUMIDITY_RISE_WARNING = 3.0f;        // %/h
 
 public:
     CloudConnector();
@@ -42,7 +50,10 @@ public:
     bool uploadToGoogleSheets(const SensorReading& data);
     bool uploadToCloudDatabase(const SensorReading& data);
     bool syncOfflineData(const std::vector<String>& files);
-    String generateOmenReport(const std::vector<SensorReading>& data);
+    // 直近days日分の予感レポートをbufferに書き込み、書き込んだ長さを返す（収まらない分は切り詰め）
+    size_t generateOmenReport(const OmenSummary& summary, char* buffer, size_t size, uint8_t days = 7);
+    void setStatsSource(const StreamingStats* stats) { statsSource = stats; }
+    void setDerivedMetrics(bool enabled, float altitudeMeters) { derivedMetricsEnabled = enabled; altitude = altitudeMeters; }
     
     // ネットワーク復旧メソッド
     void addToUploadQueue(const SensorReading& data);
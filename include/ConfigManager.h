@@ -36,9 +36,13 @@ public:
     bool setWiFiCredentials(const String& ssid, const String& password);
     bool setGoogleSheetsId(const String& sheetsId);
     bool setApiKey(const String& apiKey);
+    bool setLlmSettings(const String& endpoint, const String& model);
+    bool setLlmRootCa(const String& path);      // 反映は次回起動時（空ならhttps://のエンドポイントは使わない）
     bool setSamplingInterval(uint32_t interval);
     bool setAutoUpload(bool enabled);
     bool setStorageMode(StorageMode mode);
+    bool setDerivedMetrics(bool enabled, float altitude);
+    bool setGasScanConfig(const String& path);  // 反映は次回起動時（空で通常のIAQモード）
     
     // バリデーションメソッド
     bool validateConfig(const SystemConfig& config);
@@ -48,6 +52,8 @@ public:
     static const char* CONFIG_FILE_PATH;
     static const uint32_t MIN_SAMPLING_INTERVAL = 1000; // 1秒
     static const uint32_t MAX_SAMPLING_INTERVAL = 300000; // 5分
+    static constexpr float MIN_ALTITUDE = -500.0f;       // m
+    static constexpr float MAX_ALTITUDE = 9000.0f;       // m
 };
 
 #endif // CONFIG_MANAGER_H
\ No newline at end of file
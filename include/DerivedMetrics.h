@@ -0,0 +1,58 @@
+#ifndef DERIVED_METRICS_H
+#define DERIVED_METRICS_H
+
+#include "SystemTypes.h"
+#include <ArduinoJson.h>
+
+// 温度・湿度・気圧から求める派生指標
+struct DerivedField {
+    const char* column;
+    const char* unit;
+    uint8_t decimals;
+};
+
+inline constexpr DerivedField DERIVED_FIELDS[] = {
+    { "dew_point",          "℃",     2 },
+    { "absolute_humidity",  "g/m³",  2 },
+    { "heat_index",         "℃",     2 },
+    { "sea_level_pressure", "hPa",   2 },
+};
+
+// 列ごとにまとめた派生指標（BATCH_SIZE件ずつ計算する）
+struct DerivedColumns {
+    static const size_t BATCH_SIZE = 32;
+    
+    size_t count;
+    float dewPoint[BATCH_SIZE];
+    float absoluteHumidity[BATCH_SIZE];
+    float heatIndex[BATCH_SIZE];
+    float seaLevelPressure[BATCH_SIZE];
+    
+    float get(uint8_t fieldIndex, size_t i) const;
+};
+
+// 派生指標の計算（露点：Magnus式、絶対湿度：飽和水蒸気圧から、
+// 体感温度：米国気象局の暑さ指数（Rothfusz回帰と補正）、海面気圧：標準大気の気温減率で高度補正）
+// 計算は入力・出力とも列（float配列）で受け取り、分岐とlibm呼び出しのないループにしてある。
+// 対数・指数は多項式近似（相対誤差1e-6程度）をインライン展開するため、ホスト（-O3等）では自動ベクトル化され、
+// ESP32ではFPUだけで1件ずつ処理される
+class DerivedMetrics {
+public:
+    static constexpr size_t FIELD_COUNT = sizeof(DERIVED_FIELDS) / sizeof(DERIVED_FIELDS[0]);
+    
+    // 列の計算カーネル（温度℃・相対湿度%・気圧hPa、altitudeは設置高度m）
+    static void computeColumns(const float* temperature, const float* humidity, const float* pressure,
+                               size_t count, float altitude,
+                               float* dewPoint, float* absoluteHumidity, float* heatIndex, float* seaLevelPressure);
+    
+    // readingsの先頭から最大BATCH_SIZE件を列に展開して計算し、計算した件数を返す
+    static size_t compute(const SensorReading* readings, size_t count, float altitude, DerivedColumns& out);
+    
+    // CSV・JSON・スキーマ（保存・送信で派生指標を有効にした場合の追加列）
+    static String csvHeader();
+    static void appendCsv(String& row, const DerivedColumns& columns, size_t index);
+    static void toJson(const DerivedColumns& columns, size_t index, JsonDocument& doc);
+    static void describeSchema(JsonDocument& doc, float altitude);
+};
+
+#endif // DERIVED_METRICS_H
\ No newline at end of file
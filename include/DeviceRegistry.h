@@ -0,0 +1,32 @@
+#ifndef DEVICE_REGISTRY_H
+#define DEVICE_REGISTRY_H
+
+#include <Arduino.h>
+
+// デバイスIDのインターンテーブル
+// SensorReadingは数値ハンドルだけを持ち、CSV出力やアップロードなど
+// 文字列が必要な箇所でのみ名前に解決する
+class DeviceRegistry {
+private:
+    static const uint16_t MAX_DEVICES = 32;
+    static const size_t MAX_NAME_LENGTH = 24;
+    
+    static char names[MAX_DEVICES][MAX_NAME_LENGTH];
+    static uint16_t deviceCount;
+
+public:
+    // 名前を登録してハンドルを返す（登録済みなら既存のハンドル）
+    static uint16_t intern(const char* name);
+    static uint16_t intern(const String& name) { return intern(name.c_str()); }
+    
+    // ハンドルから名前を取得（未登録のハンドルは"unknown"）
+    static const char* getName(uint16_t handle);
+    static bool isValid(uint16_t handle) { return handle < deviceCount; }
+    static uint16_t getDeviceCount() { return deviceCount; }
+    
+    // 定数
+    static const uint16_t DEFAULT_DEVICE = 0;      // "M5Stack_001"
+    static const uint16_t INVALID_HANDLE = 0xFFFF;
+};
+
+#endif // DEVICE_REGISTRY_H
\ No newline at end of file
@@ -2,29 +2,118 @@
 #define DISPLAY_CONTROLLER_H
 
 #include "SystemTypes.h"
+#include "StreamingStats.h"
+#include "WindowedAggregator.h"
+#include "TrendForecaster.h"
+#include "PipelineMetrics.h"
+#include "HistoryGraph.h"
+#include "ToastQueue.h"
+#include "GlyphCache.h"
 #include <M5Unified.h>
 
 class DisplayController {
 private:
+    // 画面上の1行（フィールド）の前回描画内容と外接矩形
+    // 整形後の文字列・色・位置が前回と同じなら再描画を省く
+    struct FieldSlot {
+        int16_t x;
+        int16_t y;
+        int16_t width;          // 前回描画した文字列の幅（px）
+        uint32_t color;
+        uint32_t background;
+        bool valid;             // 画面上に描画済み（矩形が有効）
+        bool cached;            // textに前回の文字列を保持している
+        char text[64];          // 63バイトを超える文字列は記録せず毎回描画する
+    };
+    static const uint8_t MAX_FIELDS = 12;
+    
+    // LCDへ転送が必要なバッファ上の矩形
+    struct DirtyRect {
+        int16_t x;
+        int16_t y;
+        int16_t width;
+        int16_t height;
+    };
+    static const uint8_t MAX_DIRTY_RECTS = 8;
+    
     DisplayPage currentPage;
     unsigned long lastPageChange;
     bool touchPressed;
     SensorReading lastSensorData;
     SystemStatus lastSystemStatus;
+    const StreamingStats* statsSource;  // 平均・最小・最大の表示用（未設定なら表示しない）
+    const WindowedAggregator* windowSource;  // IAQ分位点の表示用
+    int8_t iaqWindow;                   // windowSourceの窓番号（-1なら表示しない）
+    const TrendForecaster* trendSource; // 気圧傾向の表示用
+    
+    // 差分描画の状態（画面全体の消去はページ切り替え・メッセージ表示後のみ）
+    FieldSlot fields[MAX_FIELDS];
+    uint8_t fieldCursor;                // 描画中ページの次のフィールド番号
+    DisplayPage renderedPage;           // fieldsが表しているページ
+    bool layoutValid;                   // falseなら次の描画で画面を消去して全フィールドを描き直す
+    
+    // オフスクリーン描画（PSRAMの画面サイズのスプライトに合成し、変更矩形だけをDMAでLCDへ転送）
+    // 確保できなければLCDへ直接描画する
+    M5Canvas canvas;
+    bool canvasReady;
+    bool pushPending;                   // DMA転送中（SPIバスのトランザクションを保持中）
+    DirtyRect dirtyRects[MAX_DIRTY_RECTS];
+    uint8_t dirtyCount;
+    unsigned long frameStartMicros;
+    uint64_t pushedPixels;
+    StageMetrics composeStage;          // 1フレームの合成と転送開始までのCPU時間
+    StageMetrics pushWaitStage;         // DMA完了を待ってCPUが止まった時間
+    static const uint8_t PAGE_COUNT = 5;
+    StageMetrics pageStages[PAGE_COUNT];  // ページごとの描画時間（DisplayPageの順）
+    
+    // 描いた文字の画素をPSRAMに保存し、ラベル・数字・単位はフォントを使わずコピーで描く
+    GlyphCache glyphs;
+    
+    // 履歴グラフ（読み取りはページに関わらず取り込み、表示中は列が増えた時だけ線を描き直す）
+    HistoryGraph history;
+    uint8_t graphField;                 // GRAPH_FIELDSの添字
+    uint32_t graphDrawnColumns;         // 描画済みの列の総数（history.getColumnCount()と比較）
+    float graphLow;                     // 縦軸の範囲
+    float graphHigh;
+    bool graphValid;                    // falseなら次の描画で背景から描き直す
+    // 画面の各列に描いてある線分（描画領域の上端からの行、GRAPH_NONEなら何も描いていない）
+    uint8_t graphSegmentTop[HistoryGraph::MAX_COLUMNS];
+    uint8_t graphSegmentBottom[HistoryGraph::MAX_COLUMNS];
+    static const uint8_t GRAPH_NONE = 0xFF;
+    
+    // メッセージ表示（待たずに戻り、表示時間が過ぎたらupdate()で元のページに戻す）
+    ToastQueue toasts;
+    bool toastVisible;                  // メッセージを表示中（ページの描画を止めている）
+    uint32_t toastSequence;             // 表示中のメッセージ
+    uint16_t toastRepeats;
+    bool hasSensorData;                 // ページを描けるだけのデータを受け取った
     
     // 表示ヘルパーメソッド
+    LovyanGFX& surface();
+    void markDirty(int x, int y, int width, int height);
+    void pushFrame();
     void clearScreen();
+    void beginPage(DisplayPage page);
+    void endPage();
+    void drawField(int x, int y, const String& text, uint32_t color, uint32_t background = BLACK);
+    void eraseField(FieldSlot& slot);
+    int16_t drawText(int x, int y, const char* text, size_t skip, uint32_t color, uint32_t background, int16_t& drawnX);
     void lcdPrint(int y, const String& msg, uint32_t color = GREEN);
     void lcdPrint(int x, int y, const String& msg, uint32_t color = GREEN);
     void drawPageHeader(const String& title);
     void drawPageFooter();
     void drawStatusIndicators();
+    void drawGraph(bool replot);
+    int graphRow(float value) const;
+    void renderCurrentPage();
+    void updateToasts();
     
     // ページレンダリングメソッド
     void renderSensorDataPage1();
     void renderSensorDataPage2();
     void renderStatusPage();
     void renderConfigPage();
+    void renderGraphPage();
     
     // タッチハンドリング
     bool handleTouchInput();
@@ -42,21 +131,45 @@ public:
     void handleTouch();
     DisplayPage getCurrentPage() const { return currentPage; }
     void setCurrentPage(DisplayPage page);
+    void setStatsSource(const StreamingStats* stats) { statsSource = stats; }
+    void setTrendSource(const TrendForecaster* trends) { trendSource = trends; }
+    void setWindowSource(const WindowedAggregator* windows, int8_t iaqWindowIndex) {
+        windowSource = windows;
+        iaqWindow = iaqWindowIndex;
+    }
+    void setGraphChannel(uint8_t channel) { history.setChannel(channel); graphValid = false; }
+    const HistoryGraph& getHistoryGraph() const { return history; }
     
     // メインループで呼び出す更新メソッド
     void update();
     
+    // 転送中のフレームを完了させる（SDカードはLCDとSPIバスを共有するため、SDアクセスの前に呼ぶ）
+    // showSensorData()は転送を開始したまま戻るので、その間CPUは他の処理を進められる
+    void finishFrame();
+    bool isPushing() const { return pushPending; }
+    String getFrameReport() const;
+    
     // 表示制御
     void setBrightness(uint8_t brightness);
-    void showMessage(const String& message, uint32_t color = WHITE, uint32_t duration = 2000);
+    // メッセージはキューに積んで即座に戻る（表示時間の間もセンサー処理・通信は止まらない）
+    void showMessage(const String& message, uint32_t color = WHITE, uint32_t duration = 2000, 
+                     ToastPriority priority = ToastPriority::INFO);
     void showError(const String& error);
     void showWarning(const String& warning);
+    bool isShowingMessage() const { return toastVisible; }
     
     // 定数
     static const int SCREEN_WIDTH = 320;
     static const int SCREEN_HEIGHT = 240;
     static const int LINE_HEIGHT = 24;
     static const uint32_t TOUCH_DEBOUNCE_MS = 1000;
+    
+    // グラフの描画領域（フッターより上）
+    static const int GRAPH_X = 10;
+    static const int GRAPH_Y = 70;
+    static const int GRAPH_WIDTH = 300;
+    static const int GRAPH_HEIGHT = 114;
+    static_assert(GRAPH_WIDTH <= HistoryGraph::MAX_COLUMNS, "history must cover the graph width");
 };
 
 #endif // DISPLAY_CONTROLLER_H
\ No newline at end of file
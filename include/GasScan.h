@@ -0,0 +1,73 @@
+#ifndef GAS_SCAN_H
+#define GAS_SCAN_H
+
+#include <Arduino.h>
+#include <bsec2.h>
+#include <functional>
+#include <type_traits>
+
+// 並列モードのヒータープロファイル1周分のガス抵抗ベクトル（ガスの指紋）
+// ガス抵抗は対数で16bitに符号化する（1/2048オクターブ ≒ 0.034%の分解能で1Ω〜4GΩ）
+// トリビアルコピー可能な固定長POD（リングバッファ・SD保存でそのまま扱う）
+struct GasScan {
+    static const uint8_t MAX_STEPS = 10;       // BME688のヒータープロファイルは最大10ステップ
+    static const uint8_t ESTIMATE_COUNT = 4;   // BSEC_OUTPUT_GAS_ESTIMATE_1〜4
+    
+    uint32_t timestamp;
+    uint16_t device_handle;
+    uint8_t channel;
+    uint8_t stepCount;                 // プロファイルのステップ数（最大のgas_index + 1）
+    uint16_t validMask;                // 有効な測定が得られたステップ（bit n = gas_index n）
+    uint16_t gasCode[MAX_STEPS];       // encodeResistance()で符号化したガス抵抗
+    float gasEstimate[ESTIMATE_COUNT]; // BSECのガス分類確率（出力がなければ0）
+    
+    GasScan() : timestamp(0), device_handle(0), channel(0), stepCount(0), validMask(0) {
+        for (uint8_t i = 0; i < MAX_STEPS; i++) gasCode[i] = 0;
+        for (uint8_t i = 0; i < ESTIMATE_COUNT; i++) gasEstimate[i] = 0;
+    }
+    
+    bool isStepValid(uint8_t step) const { return step < MAX_STEPS && (validMask & (1 << step)); }
+    float getResistance(uint8_t step) const { return isStepValid(step) ? decodeResistance(gasCode[step]) : 0.0f; }
+    
+    // ガス抵抗（Ω）⇔ 16bit対数コード
+    static uint16_t encodeResistance(float ohms);
+    static float decodeResistance(uint16_t code);
+    static const uint16_t CODE_SCALE = 2048;   // 1オクターブあたりのコード数
+};
+
+static_assert(std::is_trivially_copyable<GasScan>::value,
+              "GasScan must stay trivially copyable");
+
+typedef std::function<void(const GasScan&)> GasScanCallback;
+
+// SD保存用バイナリファイルの先頭ヘッダー（以降はGasScanがそのまま並ぶ）
+struct GasScanFileHeader {
+    char magic[4];            // "YKGS"
+    uint16_t version;
+    uint16_t recordSize;      // sizeof(GasScan)
+    
+    static const uint16_t FORMAT_VERSION = 1;
+};
+
+// BSECコールバックで1ステップずつ届く測定値をスキャン1周分にまとめる
+// gas_indexが前回以下に戻った時点で1周完了とみなし、それまでの内容を出力する
+class GasScanAssembler {
+private:
+    GasScan pending;
+    uint8_t lastIndex;
+    bool hasPending;
+    uint32_t completedCount;
+    uint32_t incompleteCount;    // 途中のステップが欠けたまま完了したスキャン
+
+public:
+    GasScanAssembler();
+    
+    // 1ステップ分を追加する。1周分がそろったらtrueを返し、completedに出力する
+    bool addStep(const bme68xData& data, const bsecOutputs& outputs, uint32_t timestamp, GasScan& completed);
+    void reset();
+    
+    uint32_t getCompletedCount() const { return completedCount; }
+    uint32_t getIncompleteCount() const { return incompleteCount; }
+};
+
+#endif // GAS_SCAN_H
\ No newline at end of file
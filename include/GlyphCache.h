@@ -0,0 +1,71 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <Arduino.h>
+#include <M5Unified.h>
+
+// ラスタライズ済みグリフのキャッシュ（PSRAM）
+// 日本語フォントは描画のたびにグリフ表の検索と拡大描画を行うため、文字・色・背景色ごとに
+// 一度だけ描いた画素をPSRAMに保存し、以降は画素のコピーで描く。
+// 描画先はPSRAMのスプライトを想定（LCDから画素を読み戻すのは遅いので直接描画では使わない）
+class GlyphCache {
+public:
+    static const uint16_t CAPACITY = 192;       // ラベル・数字・単位を合わせても全ページ分に足りる数
+    static const uint8_t BUCKET_COUNT = 64;
+
+private:
+    struct Entry {
+        uint32_t codepoint;
+        uint32_t color;
+        uint32_t background;
+        uint32_t lastUsed;          // 満杯時に最も長く使われていないものを入れ替える
+        uint8_t width;              // 送り幅（px）
+        int16_t next;               // 同じバケットの次の要素（-1で終端）
+        bool valid;
+    };
+    
+    Entry entries[CAPACITY];
+    int16_t buckets[BUCKET_COUNT];
+    lgfx::swap565_t* pixels;        // CAPACITY個のセル（セルごとに幅×高さの連続領域）
+    uint8_t cellWidth;              // 全角1文字分の幅
+    uint8_t cellHeight;
+    uint16_t used;
+    uint32_t clock;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    
+    static uint8_t bucketOf(uint32_t codepoint, uint32_t color, uint32_t background);
+    int16_t find(uint32_t codepoint, uint32_t color, uint32_t background) const;
+    int16_t allocate(uint32_t codepoint, uint32_t color, uint32_t background);
+    void unlink(int16_t index);
+    lgfx::swap565_t* cell(int16_t index) const { return pixels + (size_t)index * cellWidth * cellHeight; }
+
+public:
+    GlyphCache();
+    ~GlyphCache();
+    
+    // 描画先のフォント設定からセルの大きさを決めてPSRAMを確保する。確保できなければfalse
+    bool begin(LovyanGFX& target);
+    void end();
+    bool isReady() const { return pixels != nullptr; }
+    void clear();
+    
+    // UTF-8の1文字（bytesバイト）を(x, y)に描き、送り幅を返す
+    // キャッシュになければフォントで描いてから描画先の画素を保存する
+    int16_t drawGlyph(LovyanGFX& target, int x, int y, const char* glyph, uint8_t bytes, 
+                      uint32_t color, uint32_t background);
+    
+    // 描かずに送り幅だけを求める（キャッシュになければフォントで測る）
+    int16_t glyphWidth(LovyanGFX& target, const char* glyph, uint8_t bytes, uint32_t color, uint32_t background);
+    
+    // UTF-8の先頭バイトから1文字のバイト数を求める
+    static uint8_t sequenceLength(uint8_t leadByte);
+    
+    uint32_t getHits() const { return hits; }
+    uint32_t getMisses() const { return misses; }
+    uint32_t getEvictions() const { return evictions; }
+    uint16_t size() const { return used; }
+};
+
+#endif // GLYPH_CACHE_H
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef HAMPEL_FILTER_H
+#define HAMPEL_FILTER_H
+
+#include <Arduino.h>
+
+// 直近w個の中央値とMAD（中央絶対偏差）による外れ値判定（因果的Hampelフィルタ）
+// 新しい値は判定後に窓へ入れるため、外れ値自身が判定基準を汚さない。
+// 窓は時系列順のリングと昇順配列の2本で持ち、挿入・削除位置は二分探索で求める。
+class HampelFilter {
+public:
+    static const uint8_t MAX_WINDOW = 15;
+    static constexpr float MAD_SCALE = 1.4826f;   // 正規分布で標準偏差に換算する係数
+    
+private:
+    float ring[MAX_WINDOW];     // 到着順
+    float sorted[MAX_WINDOW];   // 昇順
+    uint8_t window;
+    uint8_t count;
+    uint8_t head;               // 次に上書きするringの位置
+    float threshold;            // MADの何倍で外れ値とするか
+    float minDeviation;         // 判定幅の下限（絶対値）
+    float minRelativeDeviation; // 判定幅の下限（中央値に対する比率）
+    
+    uint8_t lowerBound(float value) const;
+    void insertSorted(float value);
+    void removeSorted(float value);
+    float computeMad(float median) const;
+
+public:
+    HampelFilter();
+    
+    void configure(uint8_t windowSize, float thresholdK, float minAbs, float minRel);
+    void reset();
+    
+    // 値を判定してから窓に追加する。外れ値ならtrueを返す（窓がそろうまでは常にfalse）
+    // medianには判定に使った窓の中央値を返す
+    bool update(float value, float& median);
+    
+    bool isReady() const { return count >= window; }
+    float getMedian() const;
+    uint8_t getWindow() const { return window; }
+};
+
+#endif // HAMPEL_FILTER_H
\ No newline at end of file
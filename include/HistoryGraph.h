@@ -0,0 +1,79 @@
+#ifndef HISTORY_GRAPH_H
+#define HISTORY_GRAPH_H
+
+#include "SystemTypes.h"
+#include "SensorFields.h"
+
+// グラフに表示できる項目
+struct GraphField {
+    uint8_t sensorId;       // BSEC_OUTPUT_*
+    const char* label;
+    float minSpan;          // 縦軸の最小幅（ほぼ一定の値でノイズが拡大されないように）
+};
+
+inline constexpr GraphField GRAPH_FIELDS[] = {
+    { BSEC_OUTPUT_RAW_TEMPERATURE, "温度",   1.0f },
+    { BSEC_OUTPUT_RAW_HUMIDITY,    "湿度",   2.0f },
+    { BSEC_OUTPUT_RAW_PRESSURE,    "気圧",   1.0f },
+    { BSEC_OUTPUT_CO2_EQUIVALENT,  "CO2",    50.0f },
+    { BSEC_OUTPUT_IAQ,             "空気質", 10.0f },
+};
+
+// 表示幅に合わせて間引いた履歴（1列 = samplesPerColumn件の読み取り）
+// 列はLTTB（Largest-Triangle-Three-Buckets）で選ぶ。直前に選んだ点と次の区間の平均とで作る三角形の
+// 面積が最大になる点を区間から1つ選ぶため、平均化と違い短いピークが潰れない。
+// 次の区間がそろった時点で1つ前の区間の点を確定させるので、表示は1列分遅れる。
+// 列はリングに保持するため、履歴全体を描き直す場合も再計算は不要
+class HistoryGraph {
+public:
+    static const uint8_t FIELD_COUNT = sizeof(GRAPH_FIELDS) / sizeof(GRAPH_FIELDS[0]);
+    static const uint16_t MAX_COLUMNS = 320;
+    static const uint8_t MAX_SAMPLES_PER_COLUMN = 16;
+
+private:
+    struct FieldState {
+        float pending[MAX_SAMPLES_PER_COLUMN];  // 列の確定待ちの区間
+        float current[MAX_SAMPLES_PER_COLUMN];  // 読み取り中の区間
+        float currentSum;
+        uint8_t currentValid;                   // current区間の欠測でない件数
+        float anchor;                           // 直前に選んだ点の値（未選択ならNAN）
+        uint8_t anchorOffset;                   // その点の区間内の位置
+        float lastValue;                        // 欠測時に繰り返す値
+        bool hasValue;
+        float columns[MAX_COLUMNS];
+    };
+    
+    uint8_t channel;
+    uint8_t samplesPerColumn;
+    uint8_t sampleCount;            // current区間に入っている件数
+    bool pendingReady;              // pending区間がそろっている
+    uint16_t head;                  // 次に書き込む列
+    uint32_t columnCount;           // これまでに確定した列の総数
+    FieldState fields[FIELD_COUNT];
+    
+    void closeBucket();
+
+public:
+    explicit HistoryGraph(uint8_t channelId = 0, uint8_t samples = 4);
+    
+    void setChannel(uint8_t channelId);
+    void setSamplesPerColumn(uint8_t samples);
+    void reset();
+    
+    // 対象チャンネルの読み取りを取り込む（欠測・外れ値の項目は直前の値で埋める）
+    void update(const SensorReading& reading);
+    
+    // 列の総数（増えた分だけ描き足せばよい）と保持している列数
+    uint32_t getColumnCount() const { return columnCount; }
+    uint16_t size() const { return columnCount < MAX_COLUMNS ? (uint16_t)columnCount : MAX_COLUMNS; }
+    
+    // ago列前の値（0が最新）。保持範囲外・欠測ならfalse
+    bool getColumn(uint8_t fieldIndex, uint16_t ago, float& value) const;
+    // 最新count列の最小・最大。値のある列がなければfalse
+    bool getRange(uint8_t fieldIndex, uint16_t count, float& low, float& high) const;
+    
+    uint8_t getChannel() const { return channel; }
+    uint8_t getSamplesPerColumn() const { return samplesPerColumn; }
+};
+
+#endif // HISTORY_GRAPH_H
\ No newline at end of file
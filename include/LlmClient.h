@@ -0,0 +1,102 @@
+#ifndef LLM_CLIENT_H
+#define LLM_CLIENT_H
+
+#include "SystemTypes.h"
+#include "LlmProtocol.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+// 応答の受け取り（成功時はtextに応答本文、失敗時は理由）
+typedef std::function<void(bool success, const char* text)> LlmCallback;
+
+// OpenAI互換のChat Completions APIへの非同期リクエスト
+// HTTPS通信は専用タスク（コア0）で行い、メインループはrequest()で依頼してupdate()で結果を受け取るだけ。
+// 同時に処理するのは1件のみ。同じプロンプト（ダイジェスト一致）への応答は一定時間キャッシュから返す。
+// https://のサーバー証明書は設定のルートCA（PEM）で検証し、http://はモックサーバー用としてAPIキーを送らない。
+class LlmClient {
+public:
+    enum class State : uint8_t {
+        IDLE,
+        PENDING,    // タスクで通信中
+        DONE,       // 応答あり（update()で配信待ち）
+        FAILED
+    };
+    
+    static const size_t PROMPT_BUFFER_SIZE = 2048;
+    static const size_t RESPONSE_BUFFER_SIZE = 1024;
+    static const uint16_t MAX_COMPLETION_TOKENS = 200;
+    static const uint32_t CONNECT_TIMEOUT_MS = 5000;
+    static const uint32_t RESPONSE_TIMEOUT_MS = 20000;
+    static const uint32_t CACHE_TTL_MS = 3600000;   // 1時間
+    static const uint32_t LLM_TASK_STOP_MARGIN_MS = 1000;   // end()で通信の待ち時間に加えて待つ時間
+    static const uint32_t LLM_TASK_STACK_SIZE = 12288;
+    static const UBaseType_t LLM_TASK_PRIORITY = 1;
+    static const BaseType_t LLM_TASK_CORE = 0;      // WiFiと同じコア（BSEC・描画の邪魔をしない）
+
+private:
+    String endpoint;
+    String model;
+    String apiKey;
+    String rootCa;              // WiFiClientSecureが参照し続けるため保持する
+    LlmTransport transport;
+    
+    uint32_t connectTimeoutMs;
+    uint32_t responseTimeoutMs;
+    
+    TaskHandle_t task;
+    SemaphoreHandle_t taskExited;   // タスクがループを抜けたことをend()へ通知
+    volatile bool taskRunning;
+    std::atomic<State> state;
+    
+    // PENDINGの間はタスクだけが触る
+    char promptBuffer[PROMPT_BUFFER_SIZE];
+    char responseBuffer[RESPONSE_BUFFER_SIZE];
+    uint32_t promptDigest;
+    unsigned long requestStartMs;
+    uint32_t lastLatencyMs;
+    LlmCallback pendingCallback;
+    
+    // 直近の応答（ダイジェストが一致すれば再送しない）
+    bool cacheValid;
+    uint32_t cacheDigest;
+    unsigned long cacheTimeMs;
+    
+    // 統計
+    uint32_t requestCount;
+    uint32_t cacheHitCount;
+    uint32_t failureCount;
+    uint32_t totalLatencyMs;
+    uint16_t lastPromptTokens;
+    
+    static void taskEntry(void* param);
+    void taskLoop();
+    bool performRequest();
+
+public:
+    LlmClient();
+    ~LlmClient();
+    
+    // rootCaPem: https://のエンドポイントを検証するルートCA（空ならhttps://は使わない）
+    bool begin(const String& endpointUrl, const String& modelName, const String& key, const String& rootCaPem);
+    void end();   // 通信中なら完了（最長で接続と応答の待ち時間）までタスクの終了を待つ
+    bool isAvailable() const { return taskRunning; }
+    
+    // 接続・応答の待ち時間（既定はCONNECT_TIMEOUT_MS・RESPONSE_TIMEOUT_MS、次の依頼から有効）
+    void setTimeouts(uint32_t connectMs, uint32_t responseMs) { connectTimeoutMs = connectMs; responseTimeoutMs = responseMs; }
+    
+    // プロンプトを送る（コピーするので呼び出し後にpromptを再利用してよい）
+    // キャッシュ命中時はその場でcallbackを呼ぶ。通信中・未開始ならfalse
+    bool request(const char* prompt, LlmCallback callback);
+    // メインループで呼び出す（完了した応答のcallbackはここから呼ばれる）
+    void update();
+    
+    State getState() const { return state.load(std::memory_order_acquire); }
+    bool isBusy() const { return getState() != State::IDLE; }
+    const char* getCachedResponse() const { return cacheValid ? responseBuffer : nullptr; }
+    void invalidateCache() { cacheValid = false; }
+    String getReport() const;
+};
+
+#endif // LLM_CLIENT_H
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef LLM_PROTOCOL_H
+#define LLM_PROTOCOL_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// LLM通信の経路
+enum class LlmTransport : uint8_t {
+    PLAIN,          // http://（ローカルのモックサーバー用。APIキーは送らない）
+    VERIFIED_TLS,   // https://（設定のルートCAでサーバー証明書を検証する）
+    REJECTED        // https://でルートCAがない、または未対応のスキーム
+};
+
+// OpenAI互換のChat Completions APIの要求・応答の組み立てと解析
+// 通信（WiFi・HTTPClient）から切り離してあるため、ホスト（PlatformIOのnative環境）でもビルドできる
+namespace LlmProtocol {
+    // 証明書を検証しない接続は使わない。https://はルートCAがある場合のみ許可する
+    LlmTransport selectTransport(const char* endpoint, bool hasRootCa);
+    // APIキーは検証済みのTLS上でだけ送る
+    inline bool sendsApiKey(LlmTransport transport) { return transport == LlmTransport::VERIFIED_TLS; }
+    
+    // 要求本文をbodyに書き込む。失敗したらfalse
+    bool buildRequest(const String& model, const char* prompt, uint16_t maxTokens, String& body);
+    
+    // 応答本文から生成文をoutへ書き込む（収まらない分は切り詰める）
+    // 本文がない・解析できない・APIのエラーならfalseを返し、outには理由を書き込む
+    bool parseResponse(const String& body, char* out, size_t size);
+}
+
+#endif // LLM_PROTOCOL_H
\ No newline at end of file
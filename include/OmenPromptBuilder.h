@@ -0,0 +1,24 @@
+#ifndef OMEN_PROMPT_BUILDER_H
+#define OMEN_PROMPT_BUILDER_H
+
+#include "OmenSummary.h"
+
+// 予感レポート用のLLMプロンプトを要約から組み立てる
+// 読み取り値は渡さず、集計・傾向・兆し・異常・日ごとの推移を1行ずつ優先度順に並べ、
+// トークン数の見積もりが予算を超える行から先は載せない（期間が長くても長さは一定以下）
+class OmenPromptBuilder {
+public:
+    static const uint16_t DEFAULT_TOKEN_BUDGET = 400;
+    static const uint8_t MAX_PROMPT_EVENTS = 3;
+    
+    // bufferにプロンプトを書き込み、長さを返す。tokensには見積もりトークン数を返す
+    static size_t build(const OmenSummary& summary, uint8_t days, uint16_t tokenBudget,
+                        char* buffer, size_t size, uint16_t* tokens = nullptr);
+    
+    // トークン数の概算（ASCIIは3文字で1、それ以外は1文字で1として切り上げ）
+    static uint16_t estimateTokens(const char* text);
+    // 入力の同一性判定用（FNV-1a 32bit）
+    static uint32_t digest(const char* text);
+};
+
+#endif // OMEN_PROMPT_BUILDER_H
\ No newline at end of file
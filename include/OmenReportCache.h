@@ -0,0 +1,87 @@
+#ifndef OMEN_REPORT_CACHE_H
+#define OMEN_REPORT_CACHE_H
+
+#include "SystemTypes.h"
+
+// 予感レポートの種類（生成の周期と対象期間）
+enum class OmenReportKind : uint8_t {
+    HOURLY,     // 毎時、直近1日分
+    DAILY       // 毎日、直近7日分
+};
+
+// 生成済みの予感レポート（SDカードにはこの構造体をそのまま保存する）
+struct OmenReportEntry {
+    static const size_t TEXT_SIZE = 2048;
+    
+    uint32_t version;
+    uint32_t windowStart;       // 対象の時間窓（時・日の開始時刻、秒）
+    uint32_t digest;            // 入力（プロンプト）のダイジェスト
+    uint32_t generatedAt;       // 生成した時点のデータ時刻（秒）
+    uint16_t length;
+    bool valid;
+    bool narrative;             // LLMの文章ならtrue、ローカル生成のレポートならfalse
+    bool timeSynced;            // windowStart・generatedAtがUNIX時刻ならtrue（falseは起動からの秒で、保存しない）
+    char text[TEXT_SIZE];
+};
+
+static_assert(std::is_trivially_copyable<OmenReportEntry>::value,
+              "OmenReportEntry must stay trivially copyable");
+
+// 予感レポートのキャッシュ（種類ごとに最新の1件）
+// 時間窓と入力のダイジェストで管理し、同じ窓・同じ入力では作り直さない。
+// 表示はキャッシュから返すだけなので要約もLLMも待たない。SDカードがあれば再起動後も引き継ぐ
+// NTP同期前の窓は起動からの秒で区切るため、同期状態が一致する窓だけを同じ窓とみなし、再起動をまたいで残さない
+class OmenReportCache {
+public:
+    static const uint8_t KIND_COUNT = 2;
+    static const uint32_t ENTRY_VERSION = 2;
+
+private:
+    OmenReportEntry entries[KIND_COUNT];
+    bool persistent;
+    
+    // 統計
+    uint32_t viewCount;
+    uint32_t hitCount;          // 現在の窓のレポートを返した
+    uint32_t staleCount;        // 前の窓のレポートを返した（生成待ち）
+    uint32_t missCount;         // レポートなし
+    uint32_t generatedCount;
+    uint32_t unchangedCount;    // 入力が変わらず生成を省略した
+    uint32_t totalViewMicros;
+    uint32_t maxViewMicros;
+    
+    static const char* filePath(OmenReportKind kind);
+    bool load(OmenReportKind kind);
+    bool save(OmenReportKind kind);
+
+public:
+    OmenReportCache();
+    
+    // SDカードの準備ができていれば保存済みのレポートを読み込む
+    bool begin(bool sdCardReady);
+    
+    // 現在時刻（秒、syncedはTimeUtils::toSeconds()と同じ同期状態）が属する時間窓の開始時刻
+    static uint32_t windowStart(OmenReportKind kind, uint32_t seconds, bool synced);
+    static uint8_t reportDays(OmenReportKind kind) { return kind == OmenReportKind::DAILY ? 7 : 1; }
+    
+    // windowのレポートが生成済みか（同期状態も一致すること）
+    bool hasWindow(OmenReportKind kind, uint32_t window, bool synced) const;
+    // 入力が前回と同じなら既存のレポートをwindowに引き継いでtrueを返す（生成不要）
+    bool adoptIfUnchanged(OmenReportKind kind, uint32_t window, bool synced, uint32_t digest);
+    bool store(OmenReportKind kind, uint32_t window, bool synced, uint32_t digest, uint32_t generatedAt,
+               const char* text, bool narrative);
+    
+    // 表示用に最新のレポートを返す（なければnullptr）。currentWindowと比べてヒット率を数える
+    const OmenReportEntry* view(OmenReportKind kind, uint32_t currentWindow, bool synced);
+    const OmenReportEntry* get(OmenReportKind kind) const;
+    
+    float getHitRate() const { return viewCount > 0 ? (float)hitCount / viewCount : 0.0f; }
+    uint32_t getViewCount() const { return viewCount; }
+    uint32_t getStaleCount() const { return staleCount; }
+    uint32_t getMissCount() const { return missCount; }
+    uint32_t getGeneratedCount() const { return generatedCount; }
+    uint32_t getUnchangedCount() const { return unchangedCount; }
+    String getReport() const;
+};
+
+#endif // OMEN_REPORT_CACHE_H
\ No newline at end of file
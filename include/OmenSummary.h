@@ -0,0 +1,97 @@
+#ifndef OMEN_SUMMARY_H
+#define OMEN_SUMMARY_H
+
+#include "SystemTypes.h"
+#include "SensorFields.h"
+#include "AnomalyDetector.h"
+#include "TrendForecaster.h"
+
+// レポートに載せる項目
+inline constexpr uint8_t OMEN_FIELDS[] = {
+    BSEC_OUTPUT_RAW_TEMPERATURE,
+    BSEC_OUTPUT_RAW_HUMIDITY,
+    BSEC_OUTPUT_RAW_PRESSURE,
+    BSEC_OUTPUT_IAQ,
+    BSEC_OUTPUT_CO2_EQUIVALENT,
+};
+
+// 1区間（1時間・1日）の集計
+struct OmenRollup {
+    static const uint8_t FIELD_COUNT = sizeof(OMEN_FIELDS) / sizeof(OMEN_FIELDS[0]);
+    
+    struct Value {
+        uint32_t count;
+        float mean;
+        float minValue;
+        float maxValue;
+    };
+    
+    uint32_t start;                 // 区間の開始時刻（秒、0なら未使用）
+    uint16_t eventCount;            // 区間内の異常イベント数
+    Value values[FIELD_COUNT];
+    
+    void reset(uint32_t startSeconds);
+    void add(uint8_t fieldIndex, float value);
+    void merge(const OmenRollup& other);
+};
+
+// 予感レポートの材料（集計・傾向・検知イベント・時間/日ごとの集計）
+// 読み取りごとに1チャンネル分を更新し、期間の長さによらず固定サイズ（約3KB）で7日分を表す
+class OmenSummary {
+public:
+    static const uint8_t FIELD_COUNT = OmenRollup::FIELD_COUNT;
+    static const uint8_t HOURLY_ROLLUPS = 24;
+    static const uint8_t DAILY_ROLLUPS = 8;     // 当日＋過去7日
+    static const uint8_t RECENT_EVENTS = 16;
+
+private:
+    uint8_t channel;
+    uint32_t readingCount;
+    uint32_t firstTimestamp;        // 秒
+    uint32_t lastTimestamp;         // 秒
+    bool timeSynced;                // 集計中の時刻がUNIX時刻か（NTP同期前は起動からの秒）
+    
+    OmenRollup hourly[HOURLY_ROLLUPS];
+    OmenRollup daily[DAILY_ROLLUPS];
+    
+    AnomalyEvent events[RECENT_EVENTS];
+    uint8_t eventHead;              // 次に書き込む位置
+    uint8_t eventCount;
+    uint32_t eventTotals[3];
+    
+    TrendSnapshot trends[FIELD_COUNT];
+    
+    OmenRollup& rollupFor(OmenRollup* ring, uint8_t size, uint32_t start, uint32_t period);
+
+public:
+    explicit OmenSummary(uint8_t channelId = 0);
+    
+    void reset();
+    uint8_t getChannel() const { return channel; }
+    
+    // 読み取り値ごとに呼び出す（他チャンネル・データなし・外れ値の項目は無視）
+    void update(const SensorReading& reading);
+    void recordEvent(const AnomalyEvent& event);
+    // レポート生成前に最新の傾き・予測を取り込む
+    void updateTrends(const TrendForecaster& forecaster);
+    
+    // 直近days日（当日を含む）の集計をまとめる。該当なしならfalse
+    bool aggregate(uint8_t days, OmenRollup& result) const;
+    // ago日前の日ごとの集計（0=当日）。未使用ならnullptr
+    const OmenRollup* getDaily(uint8_t ago) const;
+    const OmenRollup* getHourly(uint8_t ago) const;
+    
+    // 新しい順にindex番目のイベント
+    const AnomalyEvent* getRecentEvent(uint8_t index) const;
+    uint8_t getRecentEventCount() const { return eventCount; }
+    uint32_t getEventTotal(AnomalyType type) const { return eventTotals[(int)type]; }
+    
+    const TrendSnapshot& getTrend(uint8_t fieldIndex) const { return trends[fieldIndex]; }
+    uint32_t getReadingCount() const { return readingCount; }
+    uint32_t getFirstTimestamp() const { return firstTimestamp; }
+    uint32_t getLastTimestamp() const { return lastTimestamp; }
+    
+    static int8_t fieldIndex(uint8_t sensorId);
+};
+
+#endif // OMEN_SUMMARY_H
\ No newline at end of file
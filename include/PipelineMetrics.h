@@ -0,0 +1,55 @@
+#ifndef PIPELINE_METRICS_H
+#define PIPELINE_METRICS_H
+
+#include <Arduino.h>
+
+// パイプライン各段（表示・アップロード・保存など）の処理時間計測
+// 平均処理時間から各段が処理できる最大サンプル数/秒（飽和点）を求める
+struct StageMetrics {
+    const char* name;
+    uint32_t count;
+    uint32_t failures;
+    uint64_t totalMicros;
+    uint32_t maxMicros;
+    
+    explicit StageMetrics(const char* stageName = "") :
+        name(stageName), count(0), failures(0), totalMicros(0), maxMicros(0) {}
+    
+    void record(uint32_t elapsedMicros, bool success = true) {
+        count++;
+        totalMicros += elapsedMicros;
+        if (elapsedMicros > maxMicros) maxMicros = elapsedMicros;
+        if (!success) failures++;
+    }
+    
+    float getAverageMicros() const { return count ? (float)totalMicros / count : 0.0f; }
+    
+    // この段だけでCPUを使い切った場合の処理能力（サンプル/秒）
+    float getSaturationRate() const {
+        float avg = getAverageMicros();
+        return avg > 0.0f ? 1000000.0f / avg : 0.0f;
+    }
+    
+    void reset() { count = 0; failures = 0; totalMicros = 0; maxMicros = 0; }
+    
+    String toString() const {
+        return String(name) + ": " + String(count) + "件, 平均" + String(getAverageMicros(), 1) + "us, 最大" +
+               String(maxMicros) + "us, 失敗" + String(failures) + "件, 飽和点 " +
+               String(getSaturationRate(), 0) + "件/秒";
+    }
+};
+
+// スコープ内の処理時間をStageMetricsに記録するヘルパー
+class StageTimer {
+private:
+    StageMetrics& metrics;
+    unsigned long startMicros;
+    bool success;
+
+public:
+    explicit StageTimer(StageMetrics& target) : metrics(target), startMicros(micros()), success(true) {}
+    ~StageTimer() { metrics.record(micros() - startMicros, success); }
+    void setFailed() { success = false; }
+};
+
+#endif // PIPELINE_METRICS_H
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <Arduino.h>
+
+// 固定メモリのKLL分位点スケッチ（マージ可能）
+// 段hの要素は重み2^hを表す。上の段ほど容量を大きく（2/3倍ずつ小さく）取り、
+// 段が容量を超えたら整列して1つおきに上の段へ送る。順位誤差はK=32で数%程度。
+// 要素は1本の配列に詰め、段0を先頭側（空き領域の直後）、最上段を末尾側に置く。
+class QuantileSketch {
+public:
+    static const uint16_t K = 32;                 // 最上段の容量
+    static const uint8_t MAX_LEVELS = 20;         // 約1600万件まで段を増やせる
+    static const uint8_t MIN_LEVEL_WIDTH = 2;
+    static const uint16_t CAPACITY = 3 * K + 2 * MAX_LEVELS;  // 各段の容量の合計以上
+    
+private:
+    float items[CAPACITY];
+    uint16_t levelStart[MAX_LEVELS + 1];  // 段hは[levelStart[h], levelStart[h+1])、段0以外は昇順
+    uint8_t numLevels;
+    bool compactOffset;                   // 間引きの開始位置（偏らないよう交互に切り替える）
+    uint32_t count;
+    float minValue;
+    float maxValue;
+    
+    uint16_t levelSize(uint8_t level) const { return levelStart[level + 1] - levelStart[level]; }
+    uint16_t levelCapacity(uint8_t level) const;
+    void addLevel();
+    void compress();
+    void compactLevel(uint8_t level);
+    void thinTopLevel();
+    void insertRun(uint8_t level, const float* values, uint16_t n);
+
+public:
+    QuantileSketch() { reset(); }
+    
+    void reset();
+    void add(float value);
+    void merge(const QuantileSketch& other);
+    
+    // qは0〜1。空ならNAN。段0を整列するため非const
+    float quantile(float q);
+    
+    uint32_t getCount() const { return count; }
+    float getMin() const { return minValue; }
+    float getMax() const { return maxValue; }
+    uint16_t getRetainedCount() const { return CAPACITY - levelStart[0]; }
+};
+
+#endif // QUANTILE_SKETCH_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef READING_FILTER_H
+#define READING_FILTER_H
+
+#include "SystemTypes.h"
+#include "SensorFields.h"
+#include "HampelFilter.h"
+
+// 項目ごとの外れ値判定設定
+struct OutlierFilterConfig {
+    bool enabled;
+    bool replace;              // trueなら外れ値を窓の中央値に置き換える（既定のfalseはフラグのみで生の値を残す）
+    uint8_t window;
+    float threshold;           // MADの何倍で外れ値とするか
+    float minDeviation;        // 判定幅の下限（絶対値）
+    float minRelativeDeviation;// 判定幅の下限（中央値に対する比率）
+    
+    OutlierFilterConfig() :
+        enabled(false), replace(false), window(7), threshold(3.0f),
+        minDeviation(0.0f), minRelativeDeviation(0.0f) {}
+};
+
+// 保存・アップロード前の外れ値除去段（SensorDataCollectorの配信直前に適用）
+// 外れ値は捨てずにSensorReading::outlier_maskのビット（SENSOR_FIELDSの添字）で印を付ける
+// 統計・異常検知・グラフはフラグの立った項目を読み飛ばすため、保存値は生のまま残す
+class ReadingFilter {
+public:
+    static const uint8_t MAX_CHANNELS = 4;
+    
+private:
+    OutlierFilterConfig configs[SensorFields::FIELD_COUNT];
+    HampelFilter filters[MAX_CHANNELS][SensorFields::FIELD_COUNT];
+    uint32_t outlierCounts[SensorFields::FIELD_COUNT];
+    uint32_t processedCount;
+    bool enabled;
+    
+    void applyDefaults();
+
+public:
+    ReadingFilter();
+    
+    // 読み取り値を判定し、外れ値の項目にフラグを立てる（設定により中央値へ置き換え）
+    // 外れ値が1つでもあればtrue
+    bool apply(SensorReading& reading);
+    
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+    
+    // sensorIdはBSEC_OUTPUT_*（SENSOR_FIELDSにない出力ならfalse）
+    bool configure(uint8_t sensorId, const OutlierFilterConfig& config);
+    bool getConfig(uint8_t sensorId, OutlierFilterConfig& config) const;
+    void reset();
+    
+    uint32_t getOutlierCount(uint8_t sensorId) const;
+    uint32_t getProcessedCount() const { return processedCount; }
+    String getReport() const;
+};
+
+#endif // READING_FILTER_H
\ No newline at end of file
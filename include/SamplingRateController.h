@@ -0,0 +1,89 @@
+#ifndef SAMPLING_RATE_CONTROLLER_H
+#define SAMPLING_RATE_CONTROLLER_H
+
+#include "SystemTypes.h"
+
+// BSECのサンプリングモード
+enum class SamplingMode {
+    ULP,   // 5分間隔（超低消費電力）
+    LP,    // 3秒間隔（低消費電力）
+    CONT   // 1秒間隔（連続測定）
+};
+
+// 適応サンプリングの設定
+struct SamplingControllerConfig {
+    // IAQ逸脱（この値以上でCONTへ、EXIT未満に戻るまで維持）
+    float iaqExcursionEnter;
+    float iaqExcursionExit;
+    
+    // 変化率の閾値（1分あたり、平滑化後）
+    // HIGHを超えるとCONT、LOWを超えるとLP、LOW未満が続けば安定とみなす
+    float temperatureRateLow;
+    float temperatureRateHigh;
+    float humidityRateLow;
+    float humidityRateHigh;
+    float iaqRateLow;
+    float iaqRateHigh;
+    
+    uint32_t minDwellSeconds;     // モード変更後、降格を許可するまでの最短時間
+    uint32_t stableSeconds;       // ULPへ降格するまでの安定継続時間
+    float rateSmoothing;          // 変化率のEWMA係数（0-1、大きいほど追従が速い）
+    
+    SamplingControllerConfig() :
+        iaqExcursionEnter(150.0f), iaqExcursionExit(120.0f),
+        temperatureRateLow(0.05f), temperatureRateHigh(0.5f),
+        humidityRateLow(0.3f), humidityRateHigh(3.0f),
+        iaqRateLow(2.0f), iaqRateHigh(15.0f),
+        minDwellSeconds(120), stableSeconds(1800), rateSmoothing(0.3f) {}
+};
+
+// 観測した変化率と異常状態からサンプリングモードを決定するコントローラー
+// 昇格は即時、降格は最短滞在時間と安定継続時間を満たした場合のみ行い、
+// BSECの購読変更が頻発しないようにする（ヒステリシス）
+class SamplingRateController {
+private:
+    SamplingControllerConfig config;
+    SamplingMode currentMode;
+    bool hasPrevious;
+    bool excursionActive;
+    bool anomalyActive;
+    SensorReading previous;
+    uint32_t previousSeconds;
+    uint32_t lastModeChangeSeconds;
+    SamplingMode previousMode;              // 直前のモード変更を取り消すための値
+    uint32_t previousModeChangeSeconds;
+    uint32_t stableSinceSeconds;
+    float temperatureRate;
+    float humidityRate;
+    float iaqRate;
+    uint32_t modeChangeCount;
+    uint32_t secondsInMode[3];
+    
+    SamplingMode decideMode(const SensorReading& reading, uint32_t nowSeconds);
+    void updateRates(const SensorReading& reading, uint32_t nowSeconds);
+
+public:
+    SamplingRateController();
+    
+    void setConfig(const SamplingControllerConfig& newConfig) { config = newConfig; }
+    const SamplingControllerConfig& getConfig() const { return config; }
+    void reset(SamplingMode initialMode, uint32_t nowSeconds);
+    
+    // 読み取り値ごとに呼び出す。モードを変更すべき場合はtrueを返しnewModeに設定
+    bool update(const SensorReading& reading, uint32_t nowSeconds, SamplingMode& newMode);
+    // update()が返したモードを適用できなかった場合に呼ぶ
+    // 変化率の平滑値・安定継続時間は保ったまま、モードと滞在時間の起点だけを変更前に戻す
+    void rejectModeChange();
+    
+    // 異常検知など外部からの昇格要求（trueの間はCONTを維持）
+    void setAnomalyActive(bool active) { anomalyActive = active; }
+    
+    SamplingMode getCurrentMode() const { return currentMode; }
+    uint32_t getModeChangeCount() const { return modeChangeCount; }
+    uint32_t getSecondsInMode(SamplingMode mode) const { return secondsInMode[(int)mode]; }
+    
+    static float toBsecSampleRate(SamplingMode mode);
+    static const char* modeToString(SamplingMode mode);
+};
+
+#endif // SAMPLING_RATE_CONTROLLER_H
\ No newline at end of file
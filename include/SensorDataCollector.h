@@ -2,55 +2,288 @@
 #define SENSOR_DATA_COLLECTOR_H
 
 #include "SystemTypes.h"
+#include "SpscRingBuffer.h"
+#include "SamplingRateController.h"
+#include "BsecStateStore.h"
+#include "GasScan.h"
+#include "ReadingFilter.h"
 #include <bsec2.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+class SensorTraceRecorder;
+class SensorDataCollector;
+
+// BSEC呼び出し時刻の誤差（要求時刻からの遅れ）の計測結果
+struct BsecTimingStats {
+    static const uint8_t BUCKET_COUNT = 9;
+    static const uint16_t BUCKET_LIMITS_MS[BUCKET_COUNT - 1];  // 各区間の上限（ms、未満）
+    
+    uint32_t histogram[BUCKET_COUNT];
+    uint32_t sampleCount;
+    int32_t maxErrorMs;
+    uint32_t timingViolationCount;  // BSEC警告14の回数
+    
+    BsecTimingStats() : sampleCount(0), maxErrorMs(0), timingViolationCount(0) {
+        for (uint8_t i = 0; i < BUCKET_COUNT; i++) histogram[i] = 0;
+    }
+    
+    void record(int32_t errorMs);
+    String toString() const;
+};
+
+// BSEC出力から読み取り値・ガススキャンを組み立てる途中の状態
+// 実センサーのチャンネルとトレースの再生で別々に持ち、再生の値が実センサー側に混ざらないようにする
+struct BsecDecodeState {
+    SensorReading currentReading;    // BSECコールバック側で更新
+    GasScanAssembler scanAssembler;  // 並列モードのヒータープロファイルスキャン
+    volatile uint8_t iaqAccuracy;    // IAQ出力の精度（3で校正完了）
+    
+    BsecDecodeState() : iaqAccuracy(0) {}
+};
+
+// BME688 1個分の状態（BSECインスタンスは個別に持ち、コールバックはチャンネル単位で振り分ける）
+struct SensorChannel {
+    Bsec2 envSensor;
+    BsecDecodeState decode;
+    SensorDataCollector* owner;
+    uint8_t channelId;
+    uint8_t i2cAddress;
+    uint32_t samplePeriodMs;
+    volatile int64_t nextCallMs;     // 次にBSECを呼び出すべき時刻（Bsec2::getTimeMs()基準）
+    
+    // BSEC校正状態の保存・復元（チャンネルごとに別のNVS名前空間）
+    BsecStateStore stateStore;
+    bool stateRestored;
+    bool stateSavedThisBoot;
+    unsigned long lastStateSaveMs;
+    unsigned long lastStateSaveAttemptMs;
+    uint32_t stateSaveBackoffMs;     // 保存に失敗した後、次に試すまでの間隔（0: 失敗していない）
+
+#ifdef BSEC_INSTANCE_SIZE
+    uint8_t bsecMemory[BSEC_INSTANCE_SIZE];  // 複数インスタンス時のBSEC作業領域
+#endif
+
+    SensorChannel() :
+        owner(nullptr), channelId(0), i2cAddress(0), samplePeriodMs(3000), nextCallMs(0),
+        stateRestored(false), stateSavedThisBoot(false), lastStateSaveMs(0), lastStateSaveAttemptMs(0),
+        stateSaveBackoffMs(0) {}
+};
+
+// 一括配信の登録先（件数上限または最大遅延に達したら連続した配列として渡す）
+struct SensorBatchConsumer {
+    static const size_t MAX_SIZE = 32;
+    
+    SensorBatchCallback callback;
+    bool autoEnqueue;              // trueは配信する全サンプル、falseはenqueueBatch()で入れたサンプルだけを受け取る
+    size_t maxBatchSize;
+    uint32_t maxLatencyMs;
+    SensorReading buffer[MAX_SIZE];
+    size_t count;
+    unsigned long firstQueuedMs;   // バッファ内で最も古いサンプルを受け取った時刻
+    uint32_t batchCount;
+    uint32_t readingCount;
+    
+    SensorBatchConsumer() :
+        autoEnqueue(true), maxBatchSize(MAX_SIZE), maxLatencyMs(0), count(0), firstQueuedMs(0), batchCount(0), readingCount(0) {}
+};
 
 class SensorDataCollector {
+public:
+    // 定数（メンバー宣言で使用するため先頭で定義）
+    static const uint8_t MAX_SENSORS = 4;
+    static const uint8_t PRIMARY_CHANNEL = 0;
+    static const size_t READING_RING_CAPACITY = 32;
+    static const size_t GAS_SCAN_RING_CAPACITY = 8;
+    static const uint8_t MAX_BATCH_CONSUMERS = 4;
+    static_assert(ReadingFilter::MAX_CHANNELS >= MAX_SENSORS, "ReadingFilter must cover every sensor channel");
+    static const UBaseType_t SENSOR_TASK_PRIORITY = configMAX_PRIORITIES - 2;
+    static const BaseType_t SENSOR_TASK_CORE = 1;   // loop()と同じコアだが優先度で横取りする（コア0はWiFi）
+    static const uint32_t SENSOR_TASK_STACK_SIZE = 8192;
+    static const int32_t POLL_BACKOFF_MS = 20;
+    static const uint32_t SENSOR_TASK_STOP_TIMEOUT_MS = 1000;
+    static const int BSEC_TIMING_WARNING = 14;  // BSEC_W_SC_CALL_TIMING_VIOLATION（要求時刻から外れた呼び出し）
+    static const uint32_t STATE_SAVE_INTERVAL_MS = 6UL * 60 * 60 * 1000;  // 校正完了後の保存間隔（6時間）
+    static const uint32_t STATE_SAVE_RETRY_MS = 60UL * 1000;              // 保存失敗後の最初の再試行間隔（失敗ごとに倍）
+
 private:
-    Bsec2 envSensor;
+    // 接続済みセンサー（チャンネル番号 = 配列の添字）
+    SensorChannel channels[MAX_SENSORS];
+    uint8_t channelCount;
+    SensorReading latestReadings[MAX_SENSORS];  // 消費者側で配信済みの最新値（ゲッター用）
+    uint16_t deviceHandle;
+    
     SensorCallback dataCallback;
-    SensorReading currentReading;
+    SensorBatchConsumer batchConsumers[MAX_BATCH_CONSUMERS];
+    uint8_t batchConsumerCount;
     bool initialized;
-    unsigned long lastReadingTime;
+    volatile unsigned long lastReadingTime;
+    
+    // BSECコールバック（生産者）→ 消費者への読み取り値受け渡し（全チャンネル共通）
+    SpscRingBuffer<SensorReading, READING_RING_CAPACITY> readingRing;
+    
+    // ガススキャン（並列モード時のみ、プロファイル1周ごとに1件）
+    SpscRingBuffer<GasScan, GAS_SCAN_RING_CAPACITY> scanRing;
+    GasScanCallback gasScanCallback;
+    volatile bool gasScanEnabled;
+    
+    // 配信前の外れ値判定（保存・アップロード・適応サンプリングの前に適用）
+    ReadingFilter readingFilter;
+    
+    // 適応サンプリング（主チャンネルの値で判定し、全チャンネルに適用）
+    SamplingRateController samplingController;
+    bool adaptiveSamplingEnabled;
+    
+    // 生データ記録（未設定ならnullptr）
+    SensorTraceRecorder* traceRecorder;
+    
+    // 実センサー以外（トレース再生・合成負荷）から投入した値の状態（最初の投入時に確保）
+    // 投入した値は実センサーのチャンネル・外れ値判定・適応サンプリング・最新値に影響しない
+    struct InjectedState {
+        BsecDecodeState replayChannels[MAX_SENSORS];  // 再生用のチャンネル状態
+        ReadingFilter filter;
+    };
+    InjectedState* injected;
+    
+    // 専用BSECタスク（UI・ネットワーク処理から分離し、BSECの要求時刻に起床する）
+    TaskHandle_t sensorTask;
+    SemaphoreHandle_t sensorMutex;   // 各チャンネルのenvSensorへのアクセスを保護
+    SemaphoreHandle_t sensorTaskExited; // タスクがループを抜けたことをstopSensorTask()へ通知
+    volatile bool sensorTaskRunning;
+    volatile bool bsecStatusPending; // タスク側で検出したBSEC異常（ログはメインループで出力）
+    BsecTimingStats timingStats;
+    
+    unsigned long initializedAtMs;
+    unsigned long calibratedAtMs;    // 初めて校正済みデータを配信した時刻
+    
+    bool subscribeChannel(SensorChannel& channel);
+    bool restoreState(SensorChannel& channel);
+    bool saveState(SensorChannel& channel);
+    void maybeSaveState();
+    void checkBsecStatus(SensorChannel& channel);
+    
+    static void sensorTaskEntry(void* param);
+    void sensorTaskLoop();
+    int64_t getEarliestCallMs() const;
+    bool runChannel(SensorChannel& channel);
+    void onBsecTriggered(SensorChannel& channel, const bsecOutputs& outputs);
+    void lockSensor();
+    void unlockSensor();
     
     // BSEC2用静的コールバック
+    // コールバックにはインスタンスを識別する情報がないため、run()の直前に実行中のチャンネルを記録して振り分ける
     static void bsecCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bsec);
-    static SensorDataCollector* instance;
+    static SensorChannel* runningChannel;
     
-    void processBsecData(const bme68xData data, const bsecOutputs outputs);
-    void updateCurrentReading(const bsecOutputs& outputs);
+    void processBsecData(BsecDecodeState& state, const bme68xData& data, const bsecOutputs& outputs, 
+                         uint32_t timestamp, bool timeSynced);
+    void updateCurrentReading(BsecDecodeState& state, const bsecOutputs& outputs);
+    void createInjectedState();
+    void logReading(const SensorReading& reading);
+    void appendToBatch(SensorBatchConsumer& consumer, const SensorReading& reading);
+    void flushBatch(SensorBatchConsumer& consumer);
 
 public:
     SensorDataCollector();
     ~SensorDataCollector();
     
     // コアインターフェースメソッド（要件1.1, 1.2対応）
-    bool initialize();                          // センサー初期化
-    SensorReading getCurrentReading();          // 現在のセンサーデータ取得
+    bool initialize();                          // センサー初期化（0x77・0x76の両方を検出）
+    SensorReading getCurrentReading();          // 現在のセンサーデータ取得（主チャンネル）
+    SensorReading getCurrentReading(uint8_t channel);
     bool isDataValid();                        // データ有効性チェック
-    void setCallback(SensorCallback callback);  // データ更新コールバック設定
+    void setCallback(SensorCallback callback);  // データ更新コールバック設定（全チャンネル共通）
+    
+    // 一括配信（SD保存・アップロードなどまとめて処理したい消費者向け）
+    // maxBatchSize件たまるか、最も古いサンプルからmaxLatencyMs経過したらまとめて呼び出す
+    // autoEnqueue=falseの消費者には、setCallback()のコールバックなどからenqueueBatch()で入れたサンプルだけが届く
+    // 登録番号を返す（登録できなければ-1）
+    int8_t addBatchConsumer(SensorBatchCallback callback, size_t maxBatchSize, uint32_t maxLatencyMs,
+                            bool autoEnqueue = true);
+    bool enqueueBatch(int8_t consumerId, const SensorReading& reading);   // dispatchPendingReadings()と同じスレッドから呼ぶ
+    void flushBatches(bool force = false);   // 遅延上限に達したバッファを配信（forceで全て）
+    String getBatchReport() const;
+    
+    // センサーの追加（I2Cマルチプレクサ経由などinitialize()以外の接続用）
+    bool addSensor(uint8_t i2cAddress, TwoWire& wire = Wire);
+    uint8_t getSensorCount() const { return channelCount; }
+    uint8_t getSensorAddress(uint8_t channel) const { return channel < channelCount ? channels[channel].i2cAddress : 0; }
     
     // ステータスとコントロールメソッド
     bool isInitialized() const { return initialized; }
-    bool isStabilized() const { return currentReading.stabilized; }
-    float getRunInStatus() const { return currentReading.runin_status; }
-    
-    // センサー情報取得メソッド
-    float getTemperature() const { return currentReading.temperature; }
-    float getHumidity() const { return currentReading.humidity; }
-    float getPressure() const { return currentReading.pressure; }
-    float getCO2Equivalent() const { return currentReading.co2_equivalent; }
-    float getIAQ() const { return currentReading.iaq; }
-    float getVOCEquivalent() const { return currentReading.voc_equivalent; }
+    bool isStabilized() const { return latestReadings[PRIMARY_CHANNEL].stabilized; }
+    float getRunInStatus() const { return latestReadings[PRIMARY_CHANNEL].runin_status; }
+    
+    // センサー情報取得メソッド（主チャンネル）
+    float getTemperature() const { return latestReadings[PRIMARY_CHANNEL].temperature; }
+    float getHumidity() const { return latestReadings[PRIMARY_CHANNEL].humidity; }
+    float getPressure() const { return latestReadings[PRIMARY_CHANNEL].pressure; }
+    float getCO2Equivalent() const { return latestReadings[PRIMARY_CHANNEL].co2_equivalent; }
+    float getIAQ() const { return latestReadings[PRIMARY_CHANNEL].iaq; }
+    float getVOCEquivalent() const { return latestReadings[PRIMARY_CHANNEL].voc_equivalent; }
     uint32_t getLastReadingTime() const { return lastReadingTime; }
     
-    // サンプリング間隔制御メソッド
+    // サンプリング間隔制御メソッド（全チャンネルに適用）
     bool setSamplingMode(float sampleRate);  // サンプリング間隔変更
     bool upgradeToFullMode();                // フル機能モードに変更
     
+    // 適応サンプリング（変化率・異常状態に応じてULP/LP/CONTを自動切り替え）
+    void setAdaptiveSampling(bool enabled) { adaptiveSamplingEnabled = enabled; }
+    bool isAdaptiveSamplingEnabled() const { return adaptiveSamplingEnabled; }
+    SamplingRateController& getSamplingController() { return samplingController; }
+    
+    // 外れ値除去段の設定・統計
+    ReadingFilter& getReadingFilter() { return readingFilter; }
+    const ReadingFilter& getReadingFilter() const { return readingFilter; }
+    
+    // BSEC校正状態の保存（シャットダウン・OTA前など任意のタイミングで呼び出し可能）
+    bool saveState();
+    bool isStateRestored() const { return channels[PRIMARY_CHANNEL].stateRestored; }
+    uint8_t getIaqAccuracy() const { return channels[PRIMARY_CHANNEL].decode.iaqAccuracy; }
+    String getStateReport() const;
+    
     // メインループで呼び出す更新メソッド
     void update();
     
-    // エラーチェック
+    // 専用BSECタスク（起動後はupdate()からBSECを呼び出さない）
+    bool startSensorTask(UBaseType_t priority = SENSOR_TASK_PRIORITY, BaseType_t core = SENSOR_TASK_CORE);
+    // タスクの終了まで待って戻る（戻った後はインスタンスを破棄してよい）
+    void stopSensorTask();
+    bool isSensorTaskRunning() const { return sensorTaskRunning; }
+    const BsecTimingStats& getTimingStats() const { return timingStats; }
+    
+    // リングバッファの消費者側メソッド（BSECコールバックの外で呼び出す）
+    size_t dispatchPendingReadings(size_t maxCount = READING_RING_CAPACITY);
+    bool popReading(SensorReading& reading);
+    size_t getPendingReadingCount() const { return readingRing.size(); }
+    size_t getFreeReadingSlots() const { return readingRing.capacity() - readingRing.size(); }
+    uint32_t getDroppedReadingCount() const { return readingRing.getDroppedCount(); }
+    
+    // 合成負荷など外部ソースからの投入（BSECコールバックと同じ生産者側）
+    // リングは単一生産者のため、専用BSECタスクとはlockSensor()で排他する
+    // syntheticの印が付いた値は再生した値と同じく実センサーとは別の窓で外れ値を判定する
+    bool publishReading(const SensorReading& reading);
+    
+    // 並列モードのヒータープロファイルスキャン（ガスの指紋取得）
+    // configはBME AI-Studioで生成したガススキャン用のBSEC設定。有効化後はIAQ出力と適応サンプリングは停止する
+    // 通常のIAQモードに戻すには再起動する
+    bool enableGasScan(const uint8_t* config);
+    bool isGasScanEnabled() const { return gasScanEnabled; }
+    void setGasScanCallback(GasScanCallback callback) { gasScanCallback = callback; }
+    bool popGasScan(GasScan& scan) { return scanRing.pop(scan); }
+    uint32_t getDroppedGasScanCount() const { return scanRing.getDroppedCount(); }
+    
+    // 記録・再生（SensorTrace.h）
+    // どちらも専用BSECタスクとlockSensor()で排他するため、タスク動作中でも呼び出せる
+    void setTraceRecorder(SensorTraceRecorder* recorder);
+    // 再生はチャンネルごとに実センサーとは別の状態で組み立て、読み取り値にreplayedの印を付ける
+    // リングに空きがなければ投入せずにfalseを返す（channelがMAX_SENSORS以上のレコードは読み飛ばす）
+    bool injectBsecData(const bme68xData& data, const bsecOutputs& outputs, uint32_t timestamp, 
+                        bool timeSynced, uint8_t channel = PRIMARY_CHANNEL);
+    
+    // エラーチェック（全チャンネル）
     void checkBsecStatus();
 };
 
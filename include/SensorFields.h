@@ -0,0 +1,117 @@
+#ifndef SENSOR_FIELDS_H
+#define SENSOR_FIELDS_H
+
+#include "SystemTypes.h"
+#include <ArduinoJson.h>
+#include <bsec2.h>
+
+// SensorReadingの各項目とBSEC出力・保存列の対応表
+// BSEC出力のデコード、購読リスト、CSVヘッダー・行、アップロード用JSON、スキーマ記述はすべてこの表から生成する。
+// 新しいBSEC出力はSENSOR_FIELDSにFIELD_EXTRAの行を1行追加するだけでよい（値はSensorReading::extraの
+// 空き枠へ表の順に割り当てる。枠の数はSENSOR_EXTRA_FIELDS、項目数の上限はoutlier_maskのビット数の16）。
+
+// 値を取り込んだときに立てる状態フラグ
+enum SensorFieldFlag : uint8_t {
+    FIELD_NONE          = 0,
+    FIELD_HAS_CO2       = 1 << 0,   // has_co2_data
+    FIELD_HAS_IAQ       = 1 << 1,   // has_iaq_data（精度をiaqAccuracyとして返す）
+    FIELD_HAS_VOC       = 1 << 2,   // has_voc_data
+    FIELD_STABILIZED    = 1 << 3,   // stabilized（値は1で安定）
+    FIELD_CALIBRATED    = 1 << 4,   // is_calibrated（値が75%以上で校正済み）
+    FIELD_EXTRA         = 1 << 5    // 格納先はSensorReading::extraの枠（memberはnullptr）
+};
+
+struct SensorField {
+    uint8_t sensorId;                  // BSEC_OUTPUT_*
+    float SensorReading::* member;     // 格納先（nullptrはフラグのみかFIELD_EXTRAの項目）
+    float scale;                       // BSEC出力 → 保存単位の換算係数
+    const char* column;                // CSV列名・JSONキー
+    const char* unit;
+    uint8_t decimals;                  // CSV出力の小数点以下桁数
+    uint8_t flags;                     // SensorFieldFlag
+};
+
+//   BSEC出力                              格納先                              換算    列名               単位     桁  フラグ
+inline constexpr SensorField SENSOR_FIELDS[] = {
+    { BSEC_OUTPUT_RAW_TEMPERATURE,       &SensorReading::temperature,        1.0f,  "temperature",     "℃",    2, FIELD_NONE },
+    { BSEC_OUTPUT_RAW_HUMIDITY,          &SensorReading::humidity,           1.0f,  "humidity",        "%",     2, FIELD_NONE },
+    { BSEC_OUTPUT_RAW_PRESSURE,          &SensorReading::pressure,           0.01f, "pressure",        "hPa",   2, FIELD_NONE },
+    { BSEC_OUTPUT_CO2_EQUIVALENT,        &SensorReading::co2_equivalent,     1.0f,  "co2_equivalent",  "ppm",   2, FIELD_HAS_CO2 },
+    { BSEC_OUTPUT_IAQ,                   &SensorReading::iaq,                1.0f,  "iaq",             "",      2, FIELD_HAS_IAQ },
+    { BSEC_OUTPUT_BREATH_VOC_EQUIVALENT, &SensorReading::voc_equivalent,     1.0f,  "voc_equivalent",  "ppm",   2, FIELD_HAS_VOC },
+    { BSEC_OUTPUT_RAW_GAS,               &SensorReading::gas_resistance,     1.0f,  "gas_resistance",  "Ω",    2, FIELD_NONE },
+    { BSEC_OUTPUT_STABILIZATION_STATUS,  nullptr,                            1.0f,  "stabilized",      "",      0, FIELD_STABILIZED },
+    { BSEC_OUTPUT_RUN_IN_STATUS,         &SensorReading::runin_status,       1.0f,  "runin_status",    "%",     2, FIELD_CALIBRATED },
+    { BSEC_OUTPUT_STATIC_IAQ,            &SensorReading::static_iaq,         1.0f,  "static_iaq",      "",      2, FIELD_NONE },
+    { BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE, nullptr,              1.0f,  "heat_comp_temperature", "℃", 2, FIELD_EXTRA },
+    { BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY,    nullptr,              1.0f,  "heat_comp_humidity", "%",   2, FIELD_EXTRA },
+    { BSEC_OUTPUT_GAS_PERCENTAGE,        nullptr,                            1.0f,  "gas_percentage",  "%",     2, FIELD_EXTRA },
+};
+
+// sensor_id → SENSOR_FIELDSの添字（該当なしは-1）と、FIELD_EXTRAの項目のextra[]の枠をコンパイル時に作る
+struct SensorFieldIndex {
+    static constexpr uint8_t MAX_SENSOR_ID = 64;
+    int8_t index[MAX_SENSOR_ID];
+    int8_t extraSlot[sizeof(SENSOR_FIELDS) / sizeof(SENSOR_FIELDS[0])];   // FIELD_EXTRA以外は-1
+    uint8_t extraCount;
+};
+
+constexpr SensorFieldIndex buildSensorFieldIndex() {
+    SensorFieldIndex table = {};
+    for (uint8_t id = 0; id < SensorFieldIndex::MAX_SENSOR_ID; id++) table.index[id] = -1;
+    for (size_t i = 0; i < sizeof(SENSOR_FIELDS) / sizeof(SENSOR_FIELDS[0]); i++) {
+        table.index[SENSOR_FIELDS[i].sensorId] = (int8_t)i;
+        table.extraSlot[i] = (SENSOR_FIELDS[i].flags & FIELD_EXTRA) ? (int8_t)table.extraCount++ : -1;
+    }
+    return table;
+}
+
+inline constexpr SensorFieldIndex SENSOR_FIELD_INDEX = buildSensorFieldIndex();
+
+class SensorFields {
+public:
+    static constexpr size_t FIELD_COUNT = sizeof(SENSOR_FIELDS) / sizeof(SENSOR_FIELDS[0]);
+    
+    static constexpr const SensorField* find(uint8_t sensorId) {
+        return (sensorId < SensorFieldIndex::MAX_SENSOR_ID && SENSOR_FIELD_INDEX.index[sensorId] >= 0) ?
+               &SENSOR_FIELDS[SENSOR_FIELD_INDEX.index[sensorId]] : nullptr;
+    }
+    
+    // 項目の格納先（フラグのみの項目はnullptr）。fieldはSENSOR_FIELDSの要素であること
+    static float* slot(const SensorField& field, SensorReading& reading) {
+        if (field.member) return &(reading.*(field.member));
+        const int8_t extra = SENSOR_FIELD_INDEX.extraSlot[&field - SENSOR_FIELDS];
+        return (extra >= 0) ? &reading.extra[extra] : nullptr;
+    }
+    static const float* slot(const SensorField& field, const SensorReading& reading) {
+        return slot(field, const_cast<SensorReading&>(reading));
+    }
+    static constexpr bool hasSlot(const SensorField& field) {
+        return field.member != nullptr || (field.flags & FIELD_EXTRA);
+    }
+    
+    // BSEC出力をreadingに取り込む（表にない出力は無視）。IAQの精度が得られた場合はiaqAccuracyに返す
+    static void decode(const bsecOutputs& outputs, SensorReading& reading, uint8_t* iaqAccuracy = nullptr);
+    
+    // 表の全出力のsensor_idをlistに書き出す（購読リスト用）。書き出した件数を返す
+    static uint8_t buildSubscription(bsecSensor* list, uint8_t maxCount);
+    
+    // 保存・送信時の値
+    static float getValue(const SensorField& field, const SensorReading& reading);
+    // 今回の読み取りで値が得られているか（CO2・IAQ・VOCはhas_*フラグで判定）
+    static bool hasValue(const SensorField& field, const SensorReading& reading);
+    
+    // CSV・JSON・スキーマ
+    static String csvHeader();
+    static String csvRow(const SensorReading& reading);
+    static void toJson(const SensorReading& reading, JsonDocument& doc);
+    static void describeSchema(JsonDocument& doc);   // 列名・単位・BSEC出力・SensorReading内の型とオフセット
+    
+    static constexpr uint16_t SCHEMA_VERSION = 2;   // 2: FIELD_EXTRAの列を追加
+};
+
+static_assert(SENSOR_FIELD_INDEX.index[BSEC_OUTPUT_IAQ] >= 0, "IAQ must be decoded");
+static_assert(SensorFields::FIELD_COUNT <= 16, "SensorReading::outlier_mask holds one bit per field");
+static_assert(SENSOR_FIELD_INDEX.extraCount <= SENSOR_EXTRA_FIELDS, "SensorReading::extra is full; raise SENSOR_EXTRA_FIELDS");
+
+#endif // SENSOR_FIELDS_H
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef SENSOR_TRACE_H
+#define SENSOR_TRACE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <bsec2.h>
+#include "SensorTracePlayer.h"
+
+class SensorDataCollector;
+
+// トレースの形式はSensorTracePlayer.hを参照
+
+// BSECコールバック内から呼ばれるレコーダー
+// record()はRAMバッファへのコピーのみ行い、ファイル書き込みはflush()で行う
+// バッファは2面持ち、swapBuffers()で書き出し側と入れ替えることで、SDカードへの書き込み中もrecord()を止めない
+class SensorTraceRecorder {
+private:
+    File traceFile;
+    bool recording;
+    uint8_t* buffer;        // record()が書き込む側
+    size_t bufferUsed;
+    uint8_t* flushBuffer;   // flush()がファイルへ書き出す側
+    size_t flushUsed;
+    uint32_t recordCount;
+    uint32_t droppedCount;
+
+public:
+    SensorTraceRecorder();
+    ~SensorTraceRecorder();
+    
+    bool begin(fs::FS& fs, const String& path);
+    void stop();
+    
+    // BSECコールバック内で呼び出す（ファイルI/Oなし）
+    void record(const bme68xData& data, const bsecOutputs& outputs, uint32_t timestamp, bool timeSynced, 
+                uint8_t channel = 0);
+    // 記録済みの分を書き出し側へ移す（record()と排他して呼び出す。ファイルI/Oなし）
+    // 書き出し側にflush()前のデータが残っている場合は何もしない
+    void swapBuffers();
+    // メインループで呼び出す（swapBuffers()で移した分をファイルへ書き出す。record()と並行してよい）
+    bool flush();
+    
+    bool isRecording() const { return recording; }
+    uint32_t getRecordCount() const { return recordCount; }
+    uint32_t getDroppedCount() const { return droppedCount; }
+    
+    static const uint16_t TRACE_VERSION = SensorTraceFormat::VERSION;
+    static const size_t BUFFER_SIZE = 4096;
+};
+
+// SDカード上のトレースを読み出し元にする
+class SensorTraceFileSource : public SensorTraceSource {
+private:
+    File& file;
+
+public:
+    explicit SensorTraceFileSource(File& file) : file(file) {}
+    size_t read(uint8_t* dst, size_t length) override { return file.read(dst, length); }
+};
+
+// 記録済みトレースを実時間または加速してパイプラインへ再生する（デバイス用）
+// 再生の中身はSensorTracePlayer（ホストでもビルド可能）が行い、ここではファイルと投入先をつなぐ
+class SensorTraceReplayer {
+private:
+    File traceFile;
+    SensorTraceFileSource fileSource;
+    SensorTracePlayer player;
+    SensorDataCollector* target;
+    bool replaying;
+
+public:
+    SensorTraceReplayer();
+    ~SensorTraceReplayer();
+    
+    // speed: 1.0で実時間、10080.0で1週間を1分、0で待ち時間なし
+    bool begin(fs::FS& fs, const String& path, SensorDataCollector& collector, float speed = 1.0f);
+    void stop();
+    
+    // メインループで呼び出す（再生時刻に達したレコードを投入）
+    // 1回の投入数は読み取り値リングの空き以下に抑え、満杯のレコードは次回に持ち越す
+    size_t update(size_t maxRecords = DEFAULT_BATCH_SIZE);
+    
+    bool isReplaying() const { return replaying; }
+    uint32_t getReplayedCount() const { return player.getReplayedCount(); }
+    
+    static const size_t DEFAULT_BATCH_SIZE = 16;
+    static const float SPEED_UNTHROTTLED;
+};
+
+#endif // SENSOR_TRACE_H
\ No newline at end of file
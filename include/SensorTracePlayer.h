@@ -0,0 +1,117 @@
+#ifndef SENSOR_TRACE_PLAYER_H
+#define SENSOR_TRACE_PLAYER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <bsec2.h>
+
+// BSECコールバックの生データ（bme68xData + bsecOutputs）を記録・再生するためのトレース形式
+// ファイル先頭にSensorTraceHeader、以降は
+// [SensorTraceRecordHeader][bme68xData][bsecData × nOutputs] のレコードが続く。
+// 構造体をそのまま書き出すため、ヘッダーのサイズ情報で互換性を確認する。
+// このファイルはFS・millis()に依存しないため、ホスト（PlatformIOのnative環境）でもビルドできる。
+struct SensorTraceHeader {
+    char magic[4];            // "YKTR"
+    uint16_t version;
+    uint16_t recordHeaderSize;
+    uint16_t bmeDataSize;     // sizeof(bme68xData)
+    uint16_t bsecDataSize;    // sizeof(bsecData)
+};
+
+struct SensorTraceRecordHeader {
+    uint32_t captureMs;       // 記録時のmillis()
+    uint32_t timestamp;       // 記録時のSensorReading::timestamp
+    uint8_t nOutputs;
+    uint8_t channel;          // 記録元のセンサーチャンネル（旧形式では0）
+    uint8_t flags;            // FLAG_*
+    uint8_t reserved;
+    
+    static const uint8_t FLAG_TIME_SYNCED = 0x01;  // timestampがUNIX時刻（SensorReading::time_synced）
+};
+
+// 読み出した1レコード
+struct SensorTraceRecord {
+    SensorTraceRecordHeader header;
+    bme68xData data;
+    bsecOutputs outputs;
+};
+
+namespace SensorTraceFormat {
+    const uint16_t VERSION = 1;
+    
+    SensorTraceHeader makeHeader();
+    bool isCompatible(const SensorTraceHeader& header);
+    size_t recordSize(uint8_t nOutputs);
+    
+    // 1レコードをdstへ書き出す（容量不足なら何も書かずに0を返す）
+    size_t encodeRecord(uint8_t* dst, size_t capacity, const SensorTraceRecordHeader& header,
+                        const bme68xData& data, const bsecData* outputs);
+}
+
+// トレースの読み出し元（デバイスではFile、ホストのテストではメモリ）
+class SensorTraceSource {
+public:
+    virtual ~SensorTraceSource() {}
+    // 読み出せたバイト数を返す
+    virtual size_t read(uint8_t* dst, size_t length) = 0;
+};
+
+class SensorTraceMemorySource : public SensorTraceSource {
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+
+public:
+    SensorTraceMemorySource(const uint8_t* data, size_t size) : data(data), size(size), position(0) {}
+    size_t read(uint8_t* dst, size_t length) override;
+};
+
+// 記録時の間隔を再生速度で縮めながらレコードを取り出す
+// 時刻は呼び出し側が渡す（デバイスではmillis()、テストでは任意の値）
+class SensorTracePlayer {
+public:
+    // 投入先：受け入れられなければfalseを返し、そのレコードは次回のupdate()まで保留される
+    typedef std::function<bool(const SensorTraceRecord&)> RecordSink;
+    
+    enum class State {
+        IDLE,
+        PLAYING,
+        FINISHED,
+        FORMAT_MISMATCH,
+        CORRUPTED
+    };
+
+private:
+    SensorTraceSource* source;
+    State state;
+    float speedFactor;
+    uint32_t startMs;
+    uint32_t firstCaptureMs;
+    uint32_t replayedCount;
+    
+    // 先読みした次のレコード
+    bool hasPending;
+    SensorTraceRecord pending;
+    
+    bool readNextRecord();
+
+public:
+    SensorTracePlayer();
+    
+    // speed: 1.0で実時間、10080.0で1週間を1分、0で待ち時間なし
+    bool begin(SensorTraceSource& traceSource, float speed, uint32_t nowMs);
+    void stop();
+    
+    // 再生時刻に達したレコードを最大maxRecords件sinkへ渡し、受け入れられた件数を返す
+    size_t update(uint32_t nowMs, size_t maxRecords, const RecordSink& sink);
+    
+    bool isPlaying() const { return state == State::PLAYING; }
+    State getState() const { return state; }
+    uint32_t getReplayedCount() const { return replayedCount; }
+    
+    static const float SPEED_UNTHROTTLED;
+};
+
+#endif // SENSOR_TRACE_PLAYER_H
\ No newline at end of file
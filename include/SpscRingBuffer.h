@@ -0,0 +1,59 @@
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// ロックフリー単一生産者・単一消費者リングバッファ
+// 生産者（BSECコールバック）と消費者（メインループや別コア）がそれぞれ1つだけの場合に、
+// ミューテックスなしで安全に要素を受け渡す。容量は2のべき乗であること。
+template <typename T, size_t Capacity>
+class SpscRingBuffer {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscRingBuffer elements must be trivially copyable");
+
+private:
+    T buffer[Capacity];
+    std::atomic<uint32_t> head;     // 次に書き込む位置（生産者のみ更新）
+    std::atomic<uint32_t> tail;     // 次に読み出す位置（消費者のみ更新）
+    std::atomic<uint32_t> dropped;  // 満杯で破棄した件数
+
+public:
+    SpscRingBuffer() : head(0), tail(0), dropped(0) {}
+
+    // 生産者側：満杯の場合は破棄してfalseを返す（生産者をブロックしない）
+    bool push(const T& item) {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= Capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        buffer[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消費者側：空の場合はfalseを返す
+    bool pop(T& item) {
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = buffer[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    uint32_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    static constexpr size_t capacity() { return Capacity; }
+};
+
+#endif // SPSC_RING_BUFFER_H
\ No newline at end of file
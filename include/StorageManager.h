@@ -2,6 +2,7 @@
 #define STORAGE_MANAGER_H
 
 #include "SystemTypes.h"
+#include "GasScan.h"
 #include <vector>
 #include <SD.h>
 
@@ -9,11 +10,19 @@ class StorageManager {
 private:
     StorageMode currentMode;
     bool sdCardInitialized;
-    String currentLogFile;
+    String currentLogFile;        // 実際に追記しているファイル（列構成が違えば連番付き）
+    String currentLogBaseFile;    // 日付から決まるファイル名
+    String currentScanFile;
     uint32_t maxStorageSize;
+    bool derivedMetricsEnabled;   // 露点などの派生指標をCSVに追加する
+    float altitude;               // 海面気圧の補正に使う設置高度（m）
     
     String generateDailyFileName();
+    String generateLogHeader();
+    String generateDailyScanFileName();
+    bool createDailyScanFile();
     bool ensureDirectoryExists(const String& path);
+    bool writeSchemaFile();
     void cleanupOldFiles();
 
 public:
@@ -23,11 +32,15 @@ public:
     // コアインターフェースメソッド
     bool initializeSDCard();
     bool saveToSDCard(const SensorReading& data);
+    bool saveBatchToSDCard(const SensorReading* readings, size_t count);  // 連続した読み取り値をまとめて追記
     bool createDailyLogFile();
+    bool saveGasScan(const GasScan& scan);   // ガススキャンをバイナリで追記（1件48バイト）
     std::vector<String> getUnsyncedFiles();
     bool markFileAsSynced(const String& filename);
     StorageMode getCurrentMode() const { return currentMode; }
     void setStorageMode(StorageMode mode);
+    // 派生指標の列を追加する（列構成が変わるため、有効時は別名のファイル sensor_data_derived_* に保存する）
+    void setDerivedMetrics(bool enabled, float altitudeMeters);
     uint32_t getAvailableSpace();
     
     // ステータスメソッド
@@ -41,6 +54,7 @@ public:
     // 定数
     static const uint32_t MAX_STORAGE_MB = 8000; // センサーデータ用8GB
     static const uint32_t WARNING_THRESHOLD_PERCENT = 85;
+    static const uint8_t MAX_LOG_FILE_VARIANTS = 9;  // 同じ日に列構成の違うファイルを作れる数
 };
 
 #endif // STORAGE_MANAGER_H
\ No newline at end of file
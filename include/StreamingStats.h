@@ -0,0 +1,68 @@
+#ifndef STREAMING_STATS_H
+#define STREAMING_STATS_H
+
+#include "SystemTypes.h"
+#include "SensorFields.h"
+#include <ArduinoJson.h>
+
+// 1項目分の逐次統計（読み取りごとにO(1)で更新、全履歴は保持しない）
+// 平均・分散はWelford法、EWMAはサンプル間隔に応じて係数を変える（ULP/LP切り替えでも時定数を保つ）
+struct RunningStats {
+    static const uint8_t EWMA_COUNT = 4;
+    static constexpr float EWMA_TAU_SECONDS[EWMA_COUNT] = { 60.0f, 900.0f, 3600.0f, 86400.0f };  // 1分・15分・1時間・24時間
+    
+    uint32_t count;
+    double mean;
+    double m2;                     // 偏差平方和
+    float minValue;
+    float maxValue;
+    float ewma[EWMA_COUNT];
+    uint32_t lastTimestamp;        // 秒
+    
+    RunningStats() { reset(); }
+    
+    void reset();
+    void update(float value, uint32_t timestampSeconds);
+    
+    float getMean() const { return (float)mean; }
+    float getVariance() const { return count > 1 ? (float)(m2 / (count - 1)) : 0.0f; }
+    float getStdDev() const;
+    float getEwma(uint8_t index) const { return index < EWMA_COUNT ? ewma[index] : 0.0f; }
+};
+
+// 全チャンネル・全項目（SENSOR_FIELDS）の逐次統計
+// 表示・レポート・アップロードからは参照を通じて定数時間で取得できる
+class StreamingStats {
+public:
+    static const uint8_t MAX_CHANNELS = 4;
+    
+    // EWMA_TAU_SECONDSの添字
+    enum EwmaIndex : uint8_t { EWMA_1MIN = 0, EWMA_15MIN = 1, EWMA_1HOUR = 2, EWMA_24HOUR = 3 };
+    
+    struct ChannelStats {
+        RunningStats fields[SensorFields::FIELD_COUNT];
+        uint32_t readingCount;
+        uint32_t skippedOutliers;  // 外れ値として統計から除いた値の数
+        uint32_t lastTimestamp;
+    };
+
+private:
+    ChannelStats channels[MAX_CHANNELS];
+
+public:
+    StreamingStats();
+    
+    // 読み取り値を取り込む（データなし・外れ値の項目は除外）
+    void update(const SensorReading& reading);
+    void reset();
+    
+    // sensorIdはBSEC_OUTPUT_*。該当なし・未取得ならnullptr
+    const RunningStats* get(uint8_t channel, uint8_t sensorId) const;
+    const ChannelStats* getChannel(uint8_t channel) const { return channel < MAX_CHANNELS ? &channels[channel] : nullptr; }
+    
+    // アップロード用: doc["stats"][列名] = {n, mean, sd, min, max, ewma_1h}
+    void toJson(uint8_t channel, JsonDocument& doc) const;
+    String getReport(uint8_t channel) const;
+};
+
+#endif // STREAMING_STATS_H
\ No newline at end of file
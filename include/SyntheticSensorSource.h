@@ -0,0 +1,90 @@
+#ifndef SYNTHETIC_SENSOR_SOURCE_H
+#define SYNTHETIC_SENSOR_SOURCE_H
+
+#include "SystemTypes.h"
+#include <vector>
+
+class SensorDataCollector;
+
+// 合成センサー負荷の設定
+struct SyntheticLoadConfig {
+    uint16_t deviceCount;          // 仮想デバイス数
+    uint32_t samplesPerSecond;     // 全デバイス合計の生成レート（0で上限なし）
+    uint32_t simulatedStepSeconds; // 1サンプルごとに進める模擬時刻（秒）
+    uint32_t startTimestamp;       // 模擬時刻の開始値（UNIX時刻）
+    
+    float baseTemperature;         // ℃
+    float diurnalTemperatureAmplitude;
+    float baseHumidity;            // %
+    float diurnalHumidityAmplitude;
+    float basePressure;            // hPa
+    float baseIaq;
+    
+    float noiseLevel;              // 各チャンネルに加えるガウスノイズの標準偏差の倍率
+    float stepChangeProbability;   // 1サンプルあたりのステップ変化発生確率
+    float stepChangeMagnitude;     // ステップ変化の大きさ（℃、湿度はその2倍%）
+    float iaqSpikeProbability;     // 1サンプルあたりのIAQスパイク発生確率
+    float iaqSpikeHeight;          // スパイク時のIAQ上昇量
+    float iaqSpikeDecay;           // スパイクの1サンプルあたり減衰率（0-1）
+    uint32_t seed;
+    
+    SyntheticLoadConfig() :
+        deviceCount(1), samplesPerSecond(1000), simulatedStepSeconds(3), startTimestamp(1700000000),
+        baseTemperature(24.0f), diurnalTemperatureAmplitude(3.0f),
+        baseHumidity(50.0f), diurnalHumidityAmplitude(10.0f),
+        basePressure(1013.0f), baseIaq(50.0f),
+        noiseLevel(1.0f), stepChangeProbability(0.0005f), stepChangeMagnitude(2.0f),
+        iaqSpikeProbability(0.001f), iaqSpikeHeight(150.0f), iaqSpikeDecay(0.02f),
+        seed(12345) {}
+};
+
+// 高レートの合成センサーデータ生成器
+// SensorDataCollectorのリングバッファへBSECコールバックと同じ形で読み取り値を投入し、
+// パイプライン下流（外れ値判定・統計・表示）の限界性能を測定する
+// 生成した値にはsyntheticの印を付け、保存・アップロード・予感レポート・異常検知・適応サンプリングには流さない
+class SyntheticSensorSource {
+private:
+    struct DeviceState {
+        uint16_t handle;
+        uint8_t channel;     // 投入先のセンサーチャンネル（デバイス番号 % MAX_SENSORS）
+        uint32_t timestamp;
+        float temperatureOffset;
+        float humidityOffset;
+        float pressureWalk;
+        float iaqSpike;
+        float phase;
+    };
+    
+    SyntheticLoadConfig config;
+    SensorDataCollector* target;
+    std::vector<DeviceState> devices;
+    bool running;
+    uint32_t rngState;
+    uint16_t nextDevice;
+    unsigned long startMicros;
+    uint32_t generatedCount;
+    uint32_t droppedCount;
+    
+    float nextUniform();
+    float nextGaussian();
+    void generateReading(DeviceState& device, SensorReading& reading);
+
+public:
+    SyntheticSensorSource();
+    
+    bool begin(SensorDataCollector& collector, const SyntheticLoadConfig& loadConfig);
+    void stop();
+    
+    // メインループで呼び出す：目標レートに達するまで生成・投入し、投入件数を返す
+    size_t update(size_t maxSamples = 256);
+    
+    bool isRunning() const { return running; }
+    uint32_t getGeneratedCount() const { return generatedCount; }
+    uint32_t getDroppedCount() const { return droppedCount; }
+    float getAchievedRate() const;
+    String getReport() const;
+    
+    static const uint16_t MAX_VIRTUAL_DEVICES = 16;
+};
+
+#endif // SYNTHETIC_SENSOR_SOURCE_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <functional>
+#include <type_traits>
 
 // 前方宣言
 struct SensorReading;
@@ -33,10 +34,17 @@ enum class DisplayPage {
     SENSOR_DATA_1,
     SENSOR_DATA_2,
     STATUS,
-    CONFIG
+    CONFIG,
+    GRAPH       // 選択項目の履歴グラフ
 };
 
+// SensorFieldsの表で名前付きメンバーを持たない出力（FIELD_EXTRA）の格納枠の数
+// 枠は表の順に割り当てるため、この数までは表に1行足すだけで出力を追加できる
+static const uint8_t SENSOR_EXTRA_FIELDS = 4;
+
 // コアセンサーデータ構造体
+// トリビアルコピー可能な固定長POD（リングバッファ・キュー・値返しでヒープ確保なし）
+// デバイス名はDeviceRegistryのハンドルで保持し、文字列が必要な境界で解決する
 struct SensorReading {
     uint32_t timestamp;
     float temperature;
@@ -46,24 +54,38 @@ struct SensorReading {
     float iaq;
     float voc_equivalent;
     float gas_resistance;
-    bool stabilized;
     float runin_status;
-    String device_id;
+    float static_iaq;
+    float extra[SENSOR_EXTRA_FIELDS];  // FIELD_EXTRAの出力（SensorFields::slot()で参照）
+    uint16_t device_handle;  // DeviceRegistry::getName()で名前に変換
+    uint16_t outlier_mask;   // 外れ値と判定された項目（bit n = SENSOR_FIELDS[n]、ReadingFilterが設定）
+    uint8_t channel;         // 同一デバイス内のセンサー番号（SensorDataCollectorのチャンネル）
     
-    // データ品質フラグ
-    bool has_co2_data;
-    bool has_iaq_data;
-    bool has_voc_data;
-    bool is_calibrated;  // runin_status >= 75%
+    // 状態・データ品質フラグ（ビットフィールドで1バイトに詰める）
+    bool stabilized : 1;
+    bool has_co2_data : 1;
+    bool has_iaq_data : 1;
+    bool has_voc_data : 1;
+    bool is_calibrated : 1;  // runin_status >= 75%
+    bool time_synced : 1;    // timestampがUNIX時刻（false: NTP同期前のmillis()）。TimeUtils::toSeconds()に渡す
+    bool replayed : 1;       // 記録済みトレースの再生（SensorDataCollector::injectBsecData()）から得た値
+    bool synthetic : 1;      // 合成負荷（SyntheticSensorSource）が生成した値。保存・送信・異常検知には使わない
     
     // デフォルト値付きコンストラクタ
     SensorReading() : 
         timestamp(0), temperature(0), humidity(0), pressure(0),
         co2_equivalent(0), iaq(0), voc_equivalent(0), gas_resistance(0),
-        stabilized(false), runin_status(0), device_id("M5Stack_001"),
-        has_co2_data(false), has_iaq_data(false), has_voc_data(false), is_calibrated(false) {}
+        runin_status(0), static_iaq(0), extra(), device_handle(0), outlier_mask(0), channel(0),
+        stabilized(false), has_co2_data(false), has_iaq_data(false),
+        has_voc_data(false), is_calibrated(false), time_synced(false), replayed(false), synthetic(false) {}
 };
 
+static_assert(std::is_trivially_copyable<SensorReading>::value,
+              "SensorReading must stay trivially copyable");
+// 4 + 9×4 + 4×SENSOR_EXTRA_FIELDS + 2 + 2 + 1 + 1（フラグ）、uint32_tの境界に合わせて末尾2バイトを詰める（枠4個で64バイト）
+// 途中に隙間ができないよう2バイトの項目を1バイトの項目より前に置く
+static_assert(sizeof(SensorReading) == 48 + 4 * SENSOR_EXTRA_FIELDS, "SensorReading layout changed; update the size note above");
+
 // システムステータス構造体
 struct SystemStatus {
     bool sensor_healthy;
@@ -81,23 +103,34 @@ struct SystemStatus {
 };
 
 // システム設定構造体
+inline constexpr const char* DEFAULT_LLM_ENDPOINT = "https://api.openai.com/v1/chat/completions";
+inline constexpr const char* DEFAULT_LLM_MODEL = "gpt-4o-mini";
+
 struct SystemConfig {
     String wifi_ssid;
     String wifi_password;
     String google_sheets_id;
     String api_key;
+    String llm_endpoint;     // OpenAI互換のChat Completions API（空なら予感レポートのLLM生成を行わない）
+    String llm_model;
+    String llm_root_ca;      // https://のエンドポイントを検証するルートCA（PEM）のSPIFFS上のパス。空ならhttp://のみ
     uint32_t sampling_interval;
     bool auto_upload_enabled;
     StorageMode storage_mode;
+    bool derived_metrics_enabled;   // 露点・絶対湿度・暑さ指数・海面気圧を保存・送信に追加
+    float altitude;                 // 設置高度（m、海面気圧の補正用）
+    String gas_scan_config;         // ガススキャン用BSEC設定（BME AI-Studioの書き出し）のSPIFFS上のパス。空なら通常のIAQモード
     
     SystemConfig() :
         wifi_ssid(""), wifi_password(""), google_sheets_id(""),
-        api_key(""), sampling_interval(3000), auto_upload_enabled(true),
-        storage_mode(StorageMode::HYBRID) {}
+        api_key(""), llm_endpoint(DEFAULT_LLM_ENDPOINT), llm_model(DEFAULT_LLM_MODEL), llm_root_ca(""),
+        sampling_interval(3000), auto_upload_enabled(true),
+        storage_mode(StorageMode::HYBRID), derived_metrics_enabled(false), altitude(0.0f), gas_scan_config("") {}
 };
 
 // コールバック関数型
 typedef std::function<void(const SensorReading&)> SensorCallback;
+typedef std::function<void(const SensorReading* readings, size_t count)> SensorBatchCallback;
 typedef std::function<void(const SystemStatus&)> StatusCallback;
 
 #endif // SYSTEM_TYPES_H
\ No newline at end of file
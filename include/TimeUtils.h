@@ -18,8 +18,16 @@ public:
     
     // 時刻計算
     static uint32_t getCurrentUnixTime();
+    static uint32_t getCurrentUnixTime(bool& synced);  // 同じ時点の同期状態も返す（読み取り値のtime_synced用）
     static bool isNewDay(uint32_t lastTimestamp);
     static uint32_t getSecondsSinceMidnight();
+    static uint32_t toSeconds(uint32_t timestamp);  // getCurrentUnixTime()の現在値を秒単位に変換
+    static uint32_t secondsOfDay(uint32_t seconds); // toSeconds()の値の0時からの秒数（未同期時は起動からの24時間周期）
+    
+    // 記録済みのタイムスタンプは記録時の同期状態で変換する
+    // （同期前に取得して同期後に処理した読み取り値を、現在の同期状態で読み違えないように）
+    static uint32_t toSeconds(uint32_t timestamp, bool synced) { return synced ? timestamp : timestamp / 1000; }
+    static uint32_t secondsOfDay(uint32_t seconds, bool synced);
     
     // NTP同期
     static bool syncTimeWithNTP();
@@ -0,0 +1,61 @@
+#ifndef TOAST_QUEUE_H
+#define TOAST_QUEUE_H
+
+#include <Arduino.h>
+
+enum class ToastPriority : uint8_t {
+    INFO,
+    WARNING,
+    ERROR
+};
+
+// 画面に一定時間表示するメッセージ
+struct Toast {
+    static const size_t TEXT_SIZE = 96;
+    
+    char text[TEXT_SIZE];
+    uint32_t color;
+    ToastPriority priority;
+    uint16_t repeats;               // 同じメッセージがまとめられた回数（1なら重複なし）
+    uint32_t durationMs;            // 表示時間（実際に画面に出ていた時間の合計で数える）
+    uint32_t displayedMs;           // 割り込まれる前までに表示した時間
+    unsigned long shownAt;          // 今回表示し始めた時刻
+    bool shown;                     // 一度でも表示した（押し出しの対象にしない）
+    uint32_t sequence;              // 追加順（同じ優先度では古いものから表示）
+};
+
+// 表示待ちメッセージのキュー（固定長・ヒープ確保なし）
+// 表示側はupdate()で先頭を受け取り、時間が来たものは自動的に取り除かれる。
+// 優先度の高いメッセージに割り込まれた間は表示時間を数えず、戻ったときに残りの時間だけ表示する。
+// 表示中・表示待ちと同じ文言・色のメッセージは新しく積まずに回数を数え、表示時間を延ばす
+class ToastQueue {
+public:
+    static const uint8_t CAPACITY = 8;
+
+private:
+    Toast entries[CAPACITY];
+    uint8_t count;
+    uint32_t nextSequence;
+    uint32_t droppedCount;
+    bool displaying;
+    uint32_t displayedSequence;     // 画面に出しているメッセージ（displayingの間のみ有効）
+    
+    void removeAt(uint8_t index);
+
+public:
+    ToastQueue();
+    
+    // 満杯のときは優先度が同じか低い、まだ表示していない最も古いメッセージを押し出す。押し出せなければfalse
+    bool push(const char* text, uint32_t color, ToastPriority priority, uint32_t durationMs, unsigned long now);
+    
+    // 期限切れを取り除き、表示すべきメッセージ（優先度が最も高く、その中で最も古いもの）を返す
+    // 返したメッセージはその時点から表示時間を数え、前回返したものが別なら中断する。なければnullptr
+    const Toast* update(unsigned long now);
+    
+    void clear() { count = 0; displaying = false; }
+    uint8_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    uint32_t getDroppedCount() const { return droppedCount; }
+};
+
+#endif // TOAST_QUEUE_H
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef TREND_FORECASTER_H
+#define TREND_FORECASTER_H
+
+#include "SystemTypes.h"
+#include "SensorFields.h"
+
+// 傾向を追う項目
+inline constexpr uint8_t TREND_FIELDS[] = {
+    BSEC_OUTPUT_RAW_TEMPERATURE,
+    BSEC_OUTPUT_RAW_HUMIDITY,
+    BSEC_OUTPUT_RAW_PRESSURE,
+    BSEC_OUTPUT_IAQ,
+};
+
+struct TrendForecasterConfig {
+    uint32_t regressionSeconds;   // 傾きの回帰の時定数（気圧傾向の慣例に合わせ3時間）
+    uint32_t levelSeconds;        // Holt-Wintersの水準の時定数
+    uint32_t trendSeconds;        // Holt-Wintersの傾きの時定数
+    float seasonDays;             // 日周成分を何日分で平均するか
+    uint32_t dampingSeconds;      // 予測で傾きを延長する時定数（減衰トレンド、遠い先ほど傾きを弱める）
+    uint32_t maxGapSeconds;       // これ以上間隔が空いたら水準・傾きを作り直す（NTP同期での時刻の飛びも含む）
+    
+    TrendForecasterConfig() :
+        regressionSeconds(3 * 3600), levelSeconds(900), trendSeconds(4 * 3600),
+        seasonDays(3.0f), dampingSeconds(3 * 3600), maxGapSeconds(2 * 3600) {}
+};
+
+// 傾きと予測の参照用スナップショット
+struct TrendSnapshot {
+    static const uint8_t FORECAST_HOURS = 6;
+    
+    bool valid;
+    bool seasonal;                      // 日周成分の学習が1日分を超えたか（未満でも学習途中の値を使う）
+    float level;                        // 現在の推定値（日周成分を含む）
+    float slopePerHour;                 // 回帰による傾き（単位/時）
+    float forecast[FORECAST_HOURS];     // 1〜6時間後の予測
+};
+
+// チャンネル・項目ごとの傾向と短期予測（読み取りごとにO(1)で更新、履歴は保持しない）
+// 傾き：指数重み付き最小二乗（忘却係数つきRLSと等価）。時刻は最新サンプルを原点に取り直し、
+//       5つの重み付き和だけを持つ
+// 予測：加法型Holt-Winters。日周成分（1時間ごと24個、スロット間は線形補間）は24時間平均からの
+//       偏差を日をまたいで平均して求め、それを除いた系列に減衰傾きつきのHolt法を当てる。
+//       （Holtの水準を速くしても日周成分の学習が止まらないよう分けて更新する）
+//       係数はサンプル間隔から求める
+class TrendForecaster {
+public:
+    static const uint8_t MAX_CHANNELS = 4;
+    static const uint8_t FIELD_COUNT = sizeof(TREND_FIELDS) / sizeof(TREND_FIELDS[0]);
+    static const uint8_t SEASON_SLOTS = 24;
+    static const uint32_t SLOT_SECONDS = 86400 / SEASON_SLOTS;
+    
+    struct FieldState {
+        // 回帰（s0=Σw, s1=Σwt, s2=Σwt², sx=Σwx, stx=Σwtx、tは最新サンプルからの秒数）
+        double s0, s1, s2, sx, stx;
+        
+        // Holt-Winters
+        float level;                    // 日周成分を除いた水準
+        float trend;                    // 単位/秒
+        float dailyMean;                // 日周成分の学習用の24時間平均
+        float season[SEASON_SLOTS];
+        uint32_t samples;
+        uint32_t lastTimestamp;
+        uint32_t seasonStart;           // 日周成分の学習を始めた時刻
+        bool timeSynced;                // lastTimestampがUNIX時刻か（日周の位置の計算に使う）
+    };
+
+private:
+    TrendForecasterConfig config;
+    FieldState states[MAX_CHANNELS][FIELD_COUNT];
+    
+    static int8_t fieldIndex(uint8_t sensorId);
+    static float seasonalAt(const FieldState& state, uint32_t secondsOfDay);
+    float forecastAt(const FieldState& state, uint32_t aheadSeconds) const;
+    bool isSeasonReady(const FieldState& state) const { return state.lastTimestamp - state.seasonStart >= 86400; }
+    void resetLocal(FieldState& state, float value, uint32_t seconds);
+    void updateField(FieldState& state, float value, uint32_t seconds, bool timeSynced);
+    float regressionSlope(const FieldState& state) const;
+
+public:
+    TrendForecaster();
+    
+    void setConfig(const TrendForecasterConfig& newConfig) { config = newConfig; }
+    const TrendForecasterConfig& getConfig() const { return config; }
+    void reset();
+    
+    // 読み取り値を取り込む（データなし・外れ値の項目は除外）
+    void update(const SensorReading& reading);
+    
+    // sensorIdはBSEC_OUTPUT_*。未対応・データ不足ならvalid=false
+    TrendSnapshot getSnapshot(uint8_t channel, uint8_t sensorId) const;
+    bool getSlope(uint8_t channel, uint8_t sensorId, float& slopePerHour) const;
+    bool getForecast(uint8_t channel, uint8_t sensorId, float hoursAhead, float& value) const;
+    
+    String getReport(uint8_t channel) const;
+    
+    static const uint8_t MIN_SAMPLES = 10;
+};
+
+#endif // TREND_FORECASTER_H
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef WINDOWED_AGGREGATOR_H
+#define WINDOWED_AGGREGATOR_H
+
+#include "SystemTypes.h"
+#include "SensorFields.h"
+#include "QuantileSketch.h"
+
+// 直近の一定時間に対する最小・最大（単調デック）
+// 窓を最大WINDOW_SLOTS個の時間スロットに分け、スロット単位で期限切れにすることで要素数を固定する
+// （1秒周期・24時間窓でも保持は最大63件、対象期間の誤差はスロット長以内）
+struct MonotonicDeque {
+    static const uint8_t CAPACITY = 64;
+    
+    struct Entry {
+        uint32_t slot;
+        float value;
+    };
+    
+    Entry entries[CAPACITY];
+    uint8_t head;    // 先頭（最も古い）
+    uint8_t size;
+    bool keepMax;    // trueなら最大値、falseなら最小値を保持
+    
+    void reset(bool maxMode) { head = 0; size = 0; keepMax = maxMode; }
+    void push(uint32_t slot, float value);
+    void expire(uint32_t oldestSlot);
+    bool empty() const { return size == 0; }
+    float front() const { return entries[head].value; }
+};
+
+// 設定したチャンネル・項目・時間幅ごとの窓集計（最小・最大・分位点）
+// 分位点は窓をQUANTILE_BUCKETS個に分けた区間ごとのスケッチを問い合わせ時にマージして求める
+// （区間単位で期限切れになるため、対象期間は窓幅の7/8〜8/8）
+class WindowedAggregator {
+public:
+    static const uint8_t MAX_CHANNELS = 4;      // 窓を置けるチャンネル番号の上限（SensorDataCollector::MAX_SENSORS以上）
+    static const uint8_t MAX_WINDOWS = 4;
+    static const uint8_t WINDOW_SLOTS = MonotonicDeque::CAPACITY - 1;
+    static const uint8_t QUANTILE_BUCKETS = 8;
+    static const uint32_t MAX_WINDOW_SECONDS = 7 * 86400;
+    
+    struct Window {
+        uint8_t channel;
+        uint8_t fieldIndex;         // SENSOR_FIELDSの添字
+        uint32_t seconds;
+        uint32_t slotSeconds;
+        uint8_t slotCount;          // 保持するスロット数（現在のスロットを含む、窓幅-スロット長〜窓幅を覆う）
+        uint32_t bucketSeconds;
+        uint32_t lastTimestamp;
+        uint32_t bucketIds[QUANTILE_BUCKETS];
+        QuantileSketch buckets[QUANTILE_BUCKETS];
+        MonotonicDeque minDeque;
+        MonotonicDeque maxDeque;
+    };
+
+private:
+    Window windows[MAX_WINDOWS];
+    uint8_t windowCount;
+    mutable QuantileSketch merged;  // 分位点問い合わせ用の作業領域
+    mutable int8_t mergedWindow;    // mergedに入っている窓（更新されたら-1に戻す）
+    
+    void updateWindow(Window& window, float value, uint32_t timestamp);
+    void resetWindow(Window& window);
+    bool isBucketLive(const Window& window, uint8_t bucket) const;
+
+public:
+    WindowedAggregator();
+    
+    // 窓を追加して番号を返す（sensorIdはBSEC_OUTPUT_*、満杯・未知の項目・範囲外のチャンネルなら-1）
+    int8_t addWindow(uint8_t channel, uint8_t sensorId, uint32_t seconds);
+    int8_t findWindow(uint8_t channel, uint8_t sensorId, uint32_t seconds) const;
+    void clearWindows() { windowCount = 0; mergedWindow = -1; }
+    
+    // 読み取り値を取り込む（データなし・外れ値の項目は除外）
+    void update(const SensorReading& reading);
+    
+    // 窓内にデータがなければfalse
+    bool getMin(uint8_t index, float& value) const;
+    bool getMax(uint8_t index, float& value) const;
+    bool getQuantile(uint8_t index, float q, float& value) const;
+    uint32_t getCount(uint8_t index) const;
+    
+    uint8_t getWindowCount() const { return windowCount; }
+    const Window* getWindow(uint8_t index) const { return index < windowCount ? &windows[index] : nullptr; }
+    String getReport() const;
+};
+
+#endif // WINDOWED_AGGREGATOR_H
\ No newline at end of file
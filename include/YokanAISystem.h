@@ -9,6 +9,17 @@
 #include "DisplayController.h"
 #include "ErrorHandler.h"
 #include "TimeUtils.h"
+#include "PipelineMetrics.h"
+#include "StreamingStats.h"
+#include "WindowedAggregator.h"
+#include "AnomalyDetector.h"
+#include "TrendForecaster.h"
+#include "OmenSummary.h"
+#include "OmenPromptBuilder.h"
+#include "LlmClient.h"
+#include "OmenReportCache.h"
+#include "SensorTrace.h"
+#include "SyntheticSensorSource.h"
 
 class YokanAISystem {
 private:
@@ -18,21 +29,57 @@ private:
     StorageManager storageManager;
     CloudConnector cloudConnector;
     DisplayController displayController;
+    static_assert(StreamingStats::MAX_CHANNELS >= SensorDataCollector::MAX_SENSORS, 
+                  "StreamingStats must cover every sensor channel");
+    StreamingStats sensorStats;  // 全チャンネルの逐次統計（表示・レポート・アップロードで共有）
+    static_assert(WindowedAggregator::MAX_CHANNELS >= SensorDataCollector::MAX_SENSORS, 
+                  "WindowedAggregator must cover every sensor channel");
+    WindowedAggregator windowStats;  // 直近の窓での最小・最大・分位点
+    AnomalyDetector anomalyDetector; // 単発・水準変化・ドリフトの検知
+    TrendForecaster trendForecaster; // 傾きと1〜6時間先の予測
+    static_assert(AnomalyDetector::MAX_CHANNELS >= SensorDataCollector::MAX_SENSORS, 
+                  "AnomalyDetector must cover every sensor channel");
+    static_assert(TrendForecaster::MAX_CHANNELS >= SensorDataCollector::MAX_SENSORS, 
+                  "TrendForecaster must cover every sensor channel");
+    OmenSummary omenSummary;         // 予感レポートの材料（主チャンネル、7日分を固定サイズで保持）
+    LlmClient llmClient;             // 予感レポートの文章生成（別タスクで通信）
+    OmenReportCache omenReports;     // 毎時・毎日に事前生成した予感レポート
+    bool omenGenerationPending;
+    int8_t storageBatchConsumer;     // SD保存用の一括配信（onSensorDataReceived()で保存と判定した値だけを入れる）
+    char omenPrompt[LlmClient::PROMPT_BUFFER_SIZE];
+    char omenReportBuffer[OmenReportEntry::TEXT_SIZE];
+    SensorTraceRecorder traceRecorder;  // BSEC生データの記録（SDカード）
+    SensorTraceReplayer traceReplayer;  // 記録済みトレースのパイプラインへの再生
+    SyntheticSensorSource syntheticLoad; // 下流の限界性能測定用の合成データ
     
     // システム状態
     SystemStatus systemStatus;
     bool systemInitialized;
     unsigned long lastStatusUpdate;
     unsigned long systemStartTime;
+    uint32_t lastDisplayedErrorTime;    // 画面に出した最後の重大エラー（ErrorEntry::timestamp）
+    
+    // パイプライン各段の処理時間
+    StageMetrics displayStage;
+    StageMetrics uploadStage;
+    StageMetrics storageStage;
+    StageMetrics queueStage;
+    StageMetrics scanStage;
     
     // コールバック
     void onSensorDataReceived(const SensorReading& data);
+    void onSensorBatchReceived(const SensorReading* readings, size_t count);
+    void onGasScanReceived(const GasScan& scan);
+    void onAnomalyDetected(const AnomalyEvent& event);
     void onSystemStatusChanged(const SystemStatus& status);
     
     // システム管理
     void updateSystemStatus();
     void handleSystemErrors();
     void performPeriodicMaintenance();
+    void scheduleOmenReports();
+    bool startGasScan(const String& configPath);
+    bool loadLlmRootCa(const String& path, String& pem);
     
     // モード管理
     void switchToOnlineMode();
@@ -51,6 +98,26 @@ public:
     // ステータスとコントロール
     bool isInitialized() const { return systemInitialized; }
     SystemStatus getSystemStatus() const { return systemStatus; }
+    String getPipelineReport() const;
+    // 直近days日の予感レポートをbufferに書き込む（書き込んだ長さを返す）
+    size_t writeOmenReport(char* buffer, size_t size, uint8_t days = 7);
+    // 要約からプロンプトを作ってLLMに文章化を依頼する（結果はcallbackで受け取る。通信中ならfalse）
+    bool requestOmenNarrative(LlmCallback callback, uint8_t days = 7);
+    // 事前生成済みの予感レポート（待たずに返す。まだなければnullptr）
+    const OmenReportEntry* viewOmenReport(OmenReportKind kind);
+    void resetPipelineMetrics();
+    
+    // BSEC生データの記録・再生（SDカード上のトレース、SensorTrace.h）
+    // ビルドフラグYOKAN_TRACE_RECORD_PATH / YOKAN_TRACE_REPLAY_PATHを指定すると起動時に開始する
+    bool startTraceRecording(const String& path);
+    void stopTraceRecording();
+    bool startTraceReplay(const String& path, float speed = 1.0f);
+    void stopTraceReplay();
+    bool isReplayingTrace() const { return traceReplayer.isReplaying(); }
+    
+    // 合成センサー負荷（ビルドフラグYOKAN_SYNTHETIC_DEVICESを指定すると起動時に開始する）
+    bool startSyntheticLoad(const SyntheticLoadConfig& config);
+    void stopSyntheticLoad() { syntheticLoad.stop(); }
     
     // モジュールアクセス（高度な制御用）
     SensorDataCollector& getSensorCollector() { return sensorCollector; }
@@ -58,10 +125,21 @@ public:
     CloudConnector& getCloudConnector() { return cloudConnector; }
     DisplayController& getDisplayController() { return displayController; }
     ConfigManager& getConfigManager() { return configManager; }
+    const StreamingStats& getSensorStats() const { return sensorStats; }
+    WindowedAggregator& getWindowStats() { return windowStats; }
+    AnomalyDetector& getAnomalyDetector() { return anomalyDetector; }
+    LlmClient& getLlmClient() { return llmClient; }
+    const TrendForecaster& getTrendForecaster() const { return trendForecaster; }
+    const OmenSummary& getOmenSummary() const { return omenSummary; }
     
     // 定数
     static const uint32_t STATUS_UPDATE_INTERVAL = 5000; // 5秒
     static const uint32_t MAINTENANCE_INTERVAL = 300000; // 5分
+    static const size_t STORAGE_BATCH_SIZE = 16;          // SD保存の一括件数
+    static const uint32_t STORAGE_BATCH_LATENCY = 60000;  // SD保存の最大遅延（1分）
+    static const uint32_t CO2_PEAK_WINDOW = 15 * 60;      // CO2最大値の窓（15分）
+    static const uint32_t IAQ_DAILY_WINDOW = 24 * 3600;   // IAQ分位点の窓（24時間）
+    static const uint16_t OMEN_PROMPT_TOKEN_BUDGET = OmenPromptBuilder::DEFAULT_TOKEN_BUDGET;
 };
 
 #endif // YOKAN_AI_SYSTEM_H
\ No newline at end of file
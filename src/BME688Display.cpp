@@ -1,15 +1,15 @@
 #include "BME688Display.h"
+#include "SensorFields.h"
 #include <Wire.h>
 
 // 静的メンバーの初期化
-BME688Display* BME688Display::instance = nullptr;
+BME688Display* BME688Display::activeInstance = nullptr;
 
 BME688Display::BME688Display() :
     initialized(false),
     currentPage(0),
     lastPageChange(0),
     touchPressed(false) {
-    instance = this;
 }
 
 bool BME688Display::initialize() {
@@ -67,45 +67,24 @@ bool BME688Display::initialize() {
 }
 
 void BME688Display::bsecCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bsec) {
-    if (instance) {
-        instance->processBsecData(outputs);
+    if (activeInstance) {
+        activeInstance->processBsecData(outputs);
     }
 }
 
 void BME688Display::processBsecData(const bsecOutputs& outputs) {
     if (!outputs.nOutputs) return;
     
-    // センサーデータを更新
-    for (uint8_t i = 0; i < outputs.nOutputs; i++) {
-        const bsecData output = outputs.output[i];
-        
-        switch (output.sensor_id) {
-            case BSEC_OUTPUT_RAW_TEMPERATURE:
-                sensorData.temperature = output.signal;
-                break;
-            case BSEC_OUTPUT_RAW_HUMIDITY:
-                sensorData.humidity = output.signal;
-                break;
-            case BSEC_OUTPUT_RAW_PRESSURE:
-                sensorData.pressure = output.signal / 100.0f; // hPaに変換
-                break;
-            case BSEC_OUTPUT_CO2_EQUIVALENT:
-                sensorData.co2 = output.signal;
-                break;
-            case BSEC_OUTPUT_IAQ:
-                sensorData.iaq = output.signal;
-                break;
-            case BSEC_OUTPUT_BREATH_VOC_EQUIVALENT:
-                sensorData.voc = output.signal;
-                break;
-            case BSEC_OUTPUT_STABILIZATION_STATUS:
-                sensorData.stabilized = (output.signal == 1);
-                break;
-            case BSEC_OUTPUT_RUN_IN_STATUS:
-                sensorData.runin = output.signal;
-                break;
-        }
-    }
+    // センサーデータを更新（sensor_idごとの格納先はSensorFields.hの対応表で定義）
+    SensorFields::decode(outputs, decodedReading);
+    sensorData.temperature = decodedReading.temperature;
+    sensorData.humidity = decodedReading.humidity;
+    sensorData.pressure = decodedReading.pressure;
+    sensorData.co2 = decodedReading.co2_equivalent;
+    sensorData.iaq = decodedReading.iaq;
+    sensorData.voc = decodedReading.voc_equivalent;
+    sensorData.stabilized = decodedReading.stabilized;
+    sensorData.runin = decodedReading.runin_status;
     
     sensorData.dataValid = true;
     
@@ -216,7 +195,10 @@ void BME688Display::update() {
     if (!initialized) return;
     
     // BSECライブラリの更新
-    if (!envSensor.run()) {
+    activeInstance = this;
+    bool ok = envSensor.run();
+    activeInstance = nullptr;
+    if (!ok) {
         // エラーハンドリング
         if (envSensor.status < BSEC_OK) {
             Serial.println("BSECエラー: " + String(envSensor.status));
@@ -1,9 +1,28 @@
 #include "YokanAISystem.h"
 
+// 起動時の再生速度（1.0で実時間、0で待ち時間なし）
+#ifndef YOKAN_TRACE_REPLAY_SPEED
+#define YOKAN_TRACE_REPLAY_SPEED 1.0f
+#endif
+
+// 起動時の合成負荷の生成レート（全デバイス合計、件/秒）
+#ifndef YOKAN_SYNTHETIC_RATE
+#define YOKAN_SYNTHETIC_RATE 1000
+#endif
+
 YokanAISystem::YokanAISystem() :
+    omenSummary(SensorDataCollector::PRIMARY_CHANNEL),
+    omenGenerationPending(false),
+    storageBatchConsumer(-1),
     systemInitialized(false),
     lastStatusUpdate(0),
-    systemStartTime(0) {
+    systemStartTime(0),
+    lastDisplayedErrorTime(0),
+    displayStage("表示"),
+    uploadStage("アップロード"),
+    storageStage("SD保存"),
+    queueStage("キュー追加"),
+    scanStage("ガススキャン保存") {
 }
 
 YokanAISystem::~YokanAISystem() {
@@ -36,14 +55,50 @@ bool YokanAISystem::initialize() {
         return false;
     }
     
-    // センサーの安定化を待つ
+    // 安定化までの値はstabilizedフラグで区別されるので待たずに進め、表示だけで知らせる
     displayController.showMessage("センサー安定化中...", YELLOW, 3000);
-    delay(3000); // センサーの安定化時間
+    
+    // 変化率に応じたサンプリング間隔の自動切り替えを有効化
+    sensorCollector.setAdaptiveSampling(true);
+    
+    // BSEC処理を専用タスクへ移し、表示やネットワークの待ち時間の影響を受けないようにする
+    if (!sensorCollector.startSensorTask()) {
+        ErrorHandler::logWarning(ErrorComponent::SENSOR, "SENSOR_TASK_FALLBACK", 
+                                "BSECはメインループから呼び出します");
+    }
     
     // Set up sensor callback
     sensorCollector.setCallback([this](const SensorReading& data) {
         this->onSensorDataReceived(data);
     });
+    // SD保存はファイルのオープン・クローズをまとめるため一括配信で受け取る
+    // （アップロードできなかった値とOFFLINEモードの値だけをonSensorDataReceived()からバッファに入れる）
+    storageBatchConsumer = sensorCollector.addBatchConsumer([this](const SensorReading* readings, size_t count) {
+        this->onSensorBatchReceived(readings, count);
+    }, STORAGE_BATCH_SIZE, STORAGE_BATCH_LATENCY, false);
+    displayController.setStatsSource(&sensorStats);
+    displayController.setTrendSource(&trendForecaster);
+    displayController.setGraphChannel(SensorDataCollector::PRIMARY_CHANNEL);
+    displayController.setWindowSource(&windowStats, 
+        windowStats.addWindow(SensorDataCollector::PRIMARY_CHANNEL, BSEC_OUTPUT_IAQ, IAQ_DAILY_WINDOW));
+    windowStats.addWindow(SensorDataCollector::PRIMARY_CHANNEL, BSEC_OUTPUT_CO2_EQUIVALENT, CO2_PEAK_WINDOW);
+    cloudConnector.setStatsSource(&sensorStats);
+    anomalyDetector.setCallback([this](const AnomalyEvent& event) {
+        this->onAnomalyDetected(event);
+    });
+    sensorCollector.setGasScanCallback([this](const GasScan& scan) {
+        this->onGasScanReceived(scan);
+    });
+    
+    // 派生指標（保存・送信の追加列）はSDカードの初期化（スキーマ書き出し）より前に設定する
+    const SystemConfig config = configManager.getCurrentConfig();
+    storageManager.setDerivedMetrics(config.derived_metrics_enabled, config.altitude);
+    cloudConnector.setDerivedMetrics(config.derived_metrics_enabled, config.altitude);
+    
+    // ガススキャン（設定でBSEC設定ファイルが指定されている場合のみ、IAQ出力の代わりに動作）
+    if (config.gas_scan_config.length() > 0 && !startGasScan(config.gas_scan_config)) {
+        displayController.showWarning("ガススキャン開始失敗");
+    }
     
     // Initialize storage manager
     if (!storageManager.initializeSDCard()) {
@@ -59,6 +114,27 @@ bool YokanAISystem::initialize() {
         displayController.showWarning("WiFi接続失敗");
     }
     
+    // 生成済みの予感レポートを読み込み、文章化（エンドポイント未設定なら無効のまま）を準備する
+    omenReports.begin(storageManager.isSDCardReady());
+    String llmRootCa;
+    if (config.llm_root_ca.length() > 0) {
+        loadLlmRootCa(config.llm_root_ca, llmRootCa);
+    }
+    llmClient.begin(config.llm_endpoint, config.llm_model, config.api_key, llmRootCa);
+
+#ifdef YOKAN_TRACE_RECORD_PATH
+    startTraceRecording(YOKAN_TRACE_RECORD_PATH);
+#endif
+#ifdef YOKAN_TRACE_REPLAY_PATH
+    startTraceReplay(YOKAN_TRACE_REPLAY_PATH, YOKAN_TRACE_REPLAY_SPEED);
+#endif
+#ifdef YOKAN_SYNTHETIC_DEVICES
+    SyntheticLoadConfig loadConfig;
+    loadConfig.deviceCount = YOKAN_SYNTHETIC_DEVICES;
+    loadConfig.samplesPerSecond = YOKAN_SYNTHETIC_RATE;
+    startSyntheticLoad(loadConfig);
+#endif
+
     // Update initial system status
     updateSystemStatus();
     
@@ -72,9 +148,13 @@ bool YokanAISystem::initialize() {
 void YokanAISystem::update() {
     if (!systemInitialized) return;
     
-    // Update all modules
+    // Update all modules（再生中のトレースは配信より先にリングへ投入する）
+    traceReplayer.update();
+    syntheticLoad.update();
     sensorCollector.update();
     cloudConnector.update();
+    llmClient.update();
+    scheduleOmenReports();
     displayController.update();
     
     // Update system status periodically
@@ -99,6 +179,17 @@ void YokanAISystem::shutdown() {
     
     Serial.println("Shutting down Yokan AI System...");
     
+    // Stop the dedicated BSEC task and keep the calibration for the next boot
+    sensorCollector.stopSensorTask();
+    stopTraceReplay();
+    stopSyntheticLoad();
+    stopTraceRecording();
+    llmClient.end();
+    sensorCollector.saveState();
+    
+    // Write out readings still held for batch consumers
+    sensorCollector.flushBatches(true);
+    
     // Save current configuration
     configManager.saveConfig(configManager.getCurrentConfig());
     
@@ -110,32 +201,112 @@ void YokanAISystem::shutdown() {
 }
 
 void YokanAISystem::onSensorDataReceived(const SensorReading& data) {
+    // 統計を先に更新（表示・アップロードが今回の値を含めて参照できるように）
+    sensorStats.update(data);
+    windowStats.update(data);
+    trendForecaster.update(data);
+    
+    // 合成負荷の値は処理能力の測定用：統計と表示までで止め、予感レポート・異常検知・保存・アップロードには流さない
+    if (data.synthetic) {
+        {
+            StageTimer timer(displayStage);
+            displayController.showSensorData(data, displayController.getCurrentPage());
+        }
+        displayController.finishFrame();
+        return;
+    }
+    omenSummary.update(data);
+    
+    // 異常検知（主チャンネルで検知中は適応サンプリングをCONTに保つ）
+    anomalyDetector.update(data);
+    if (data.channel == SensorDataCollector::PRIMARY_CHANNEL) {
+        sensorCollector.getSamplingController().setAnomalyActive(
+            anomalyDetector.isActive(data.channel, TimeUtils::toSeconds(data.timestamp, data.time_synced)));
+    }
+    
     // Update display with new sensor data
-    displayController.showSensorData(data, displayController.getCurrentPage());
+    {
+        StageTimer timer(displayStage);
+        displayController.showSensorData(data, displayController.getCurrentPage());
+    }
     
     // Try to upload to cloud if connected
+    // アップロードできなかった値は、保存モードに関わらずSDカードかメモリキューのどちらかに必ず残す
+    bool storeLocally = false;
     if (cloudConnector.isConnected()) {
+        StageTimer timer(uploadStage);
         if (!cloudConnector.uploadToGoogleSheets(data)) {
             // If upload fails, add to queue for retry
+            timer.setFailed();
             cloudConnector.addToUploadQueue(data);
         }
+    } else if (storageManager.isSDCardReady()) {
+        // Store offline if not connected（onSensorBatchReceived()でまとめて書き込む）
+        storeLocally = true;
     } else {
-        // Store offline if not connected
-        if (storageManager.isSDCardReady()) {
-            storageManager.saveToSDCard(data);
-        } else {
-            // Add to memory queue as last resort
-            cloudConnector.addToUploadQueue(data);
+        // Add to memory queue as last resort
+        StageTimer timer(queueStage);
+        cloudConnector.addToUploadQueue(data);
+    }
+    
+    // OFFLINEモードではアップロードの成否に関わらずローカルにも記録する
+    if (storageManager.getCurrentMode() == StorageMode::OFFLINE && storageManager.isSDCardReady()) {
+        storeLocally = true;
+    }
+    
+    // 表示のDMA転送はアップロードと並行させ、SDカード（SPIバス共有）へ書く前に完了させる
+    displayController.finishFrame();
+    
+    // SD保存と判定した値を一括配信のバッファへ入れる（件数上限に達した場合はここで書き込む）
+    if (storeLocally) {
+        sensorCollector.enqueueBatch(storageBatchConsumer, data);
+    }
+}
+
+void YokanAISystem::onSensorBatchReceived(const SensorReading* readings, size_t count) {
+    // onSensorDataReceived()でSD保存と判定された値だけが届く
+    {
+        StageTimer timer(storageStage);
+        if (storageManager.isSDCardReady() && storageManager.saveBatchToSDCard(readings, count)) {
+            return;
         }
+        timer.setFailed();
+    }
+    
+    // SDカードに書けなかった分はメモリキューへ回す
+    StageTimer timer(queueStage);
+    for (size_t i = 0; i < count; i++) {
+        cloudConnector.addToUploadQueue(readings[i]);
     }
 }
 
+void YokanAISystem::onGasScanReceived(const GasScan& scan) {
+    // ガススキャンはデータ量が多いためSDカードにのみ保存する
+    if (!storageManager.isSDCardReady()) return;
+    
+    StageTimer timer(scanStage);
+    if (!storageManager.saveGasScan(scan)) {
+        timer.setFailed();
+    }
+}
+
+void YokanAISystem::onAnomalyDetected(const AnomalyEvent& event) {
+    const SensorField* field = SensorFields::find(event.sensorId);
+    ErrorHandler::logInfo(ErrorComponent::SENSOR, 
+                          String("異常検知[") + AnomalyDetector::typeToString(event.type) + "] ch" + 
+                          String(event.channel) + " " + (field ? field->column : "?") + 
+                          (event.direction > 0 ? " 上昇 " : " 下降 ") + String(event.value, 2) + 
+                          " (基準" + String(event.baseline, 2) + ", スコア" + String(event.score, 1) + ")");
+    omenSummary.recordEvent(event);
+}
+
 void YokanAISystem::onSystemStatusChanged(const SystemStatus& status) {
     systemStatus = status;
     
     // Update display if on status page
     if (displayController.getCurrentPage() == DisplayPage::STATUS) {
         displayController.showStatus(status);
+        displayController.finishFrame();
     }
 }
 
@@ -156,15 +327,217 @@ void YokanAISystem::handleSystemErrors() {
     if (!recentErrors.empty()) {
         const auto& lastError = recentErrors[0];
         
-        // Handle critical errors
-        if (lastError.level == ErrorLevel::CRITICAL) {
+        // Handle critical errors（同じエラーを毎ループ表示し直さないよう、新しいものだけ）
+        if (lastError.level == ErrorLevel::CRITICAL && lastError.timestamp != lastDisplayedErrorTime) {
+            lastDisplayedErrorTime = lastError.timestamp;
             displayController.showError("重大エラー: " + lastError.message);
             Serial.println("CRITICAL ERROR: " + lastError.message);
         }
     }
 }
 
+bool YokanAISystem::startTraceRecording(const String& path) {
+    if (!storageManager.isSDCardReady()) {
+        ErrorHandler::logWarning(ErrorComponent::STORAGE, "TRACE_NO_SD", 
+                                "SDカードがないためトレースを記録できません");
+        return false;
+    }
+    
+    // 記録中のファイルを閉じる前にコールバックからの参照を外す
+    sensorCollector.setTraceRecorder(nullptr);
+    if (!traceRecorder.begin(SD, path)) {
+        return false;
+    }
+    sensorCollector.setTraceRecorder(&traceRecorder);
+    return true;
+}
+
+void YokanAISystem::stopTraceRecording() {
+    sensorCollector.setTraceRecorder(nullptr);
+    traceRecorder.stop();
+}
+
+bool YokanAISystem::startTraceReplay(const String& path, float speed) {
+    if (!storageManager.isSDCardReady()) {
+        ErrorHandler::logWarning(ErrorComponent::STORAGE, "TRACE_NO_SD", 
+                                "SDカードがないためトレースを再生できません");
+        return false;
+    }
+    return traceReplayer.begin(SD, path, sensorCollector, speed);
+}
+
+void YokanAISystem::stopTraceReplay() {
+    traceReplayer.stop();
+}
+
+bool YokanAISystem::startGasScan(const String& configPath) {
+    File file = SPIFFS.open(configPath, "r");
+    if (!file) {
+        ErrorHandler::logError(ErrorComponent::SENSOR, "GAS_SCAN_CONFIG_MISSING", 
+                              "ガススキャン設定を開けません: " + configPath);
+        return false;
+    }
+    
+    size_t size = file.size();
+    if (size == 0 || size > BSEC_MAX_PROPERTY_BLOB_SIZE) {
+        ErrorHandler::logError(ErrorComponent::SENSOR, "GAS_SCAN_CONFIG_INVALID", 
+                              "ガススキャン設定のサイズが不正です: " + String(size) + "バイト");
+        file.close();
+        return false;
+    }
+    
+    uint8_t* bsecConfig = new uint8_t[size];
+    bool ok = file.read(bsecConfig, size) == size;
+    file.close();
+    if (ok) {
+        ok = sensorCollector.enableGasScan(bsecConfig);
+    }
+    delete[] bsecConfig;
+    return ok;
+}
+
+bool YokanAISystem::loadLlmRootCa(const String& path, String& pem) {
+    File file = SPIFFS.open(path, "r");
+    if (!file) {
+        ErrorHandler::logError(ErrorComponent::NETWORK, "LLM_ROOT_CA_MISSING", 
+                              "LLMのルートCAを開けません: " + path);
+        return false;
+    }
+    pem = file.readString();
+    file.close();
+    
+    if (pem.indexOf("-----BEGIN CERTIFICATE-----") < 0) {
+        ErrorHandler::logError(ErrorComponent::NETWORK, "LLM_ROOT_CA_INVALID", 
+                              "LLMのルートCAがPEM形式ではありません: " + path);
+        pem = "";
+        return false;
+    }
+    return true;
+}
+
+bool YokanAISystem::startSyntheticLoad(const SyntheticLoadConfig& config) {
+    return syntheticLoad.begin(sensorCollector, config);
+}
+
+String YokanAISystem::getPipelineReport() const {
+    String report = "=== パイプライン処理時間 ===\n";
+    report += displayStage.toString() + "\n";
+    report += uploadStage.toString() + "\n";
+    report += storageStage.toString() + "\n";
+    report += queueStage.toString() + "\n";
+    report += scanStage.toString() + "\n";
+    report += displayController.getFrameReport() + "\n";
+    report += "リング破棄: " + String(sensorCollector.getDroppedReadingCount()) + "件\n";
+    if (syntheticLoad.isRunning()) {
+        report += syntheticLoad.getReport() + "\n";
+    }
+    if (sensorCollector.isGasScanEnabled()) {
+        report += "ガススキャン破棄: " + String(sensorCollector.getDroppedGasScanCount()) + "件\n";
+    }
+    report += sensorCollector.getReadingFilter().getReport() + "\n";
+    for (uint8_t channel = 0; channel < sensorCollector.getSensorCount(); channel++) {
+        report += sensorStats.getReport(channel);
+        report += trendForecaster.getReport(channel);
+    }
+    report += windowStats.getReport();
+    report += anomalyDetector.getReport() + "\n";
+    report += llmClient.getReport() + "\n";
+    report += omenReports.getReport() + "\n";
+    report += sensorCollector.getBatchReport();
+    report += sensorCollector.getTimingStats().toString();
+    report += sensorCollector.getStateReport() + "\n";
+    return report;
+}
+
+size_t YokanAISystem::writeOmenReport(char* buffer, size_t size, uint8_t days) {
+    // 傾き・予測はレポート生成時にだけ取り込む（読み取りごとのコピーを避ける）
+    omenSummary.updateTrends(trendForecaster);
+    return cloudConnector.generateOmenReport(omenSummary, buffer, size, days);
+}
+
+bool YokanAISystem::requestOmenNarrative(LlmCallback callback, uint8_t days) {
+    if (!llmClient.isAvailable() || llmClient.isBusy()) {
+        return false;
+    }
+    
+    // プロンプトはLlmClientがコピーするので、作業用バッファは使い回す
+    omenSummary.updateTrends(trendForecaster);
+    OmenPromptBuilder::build(omenSummary, days, OMEN_PROMPT_TOKEN_BUDGET, omenPrompt, sizeof(omenPrompt));
+    return llmClient.request(omenPrompt, callback);
+}
+
+void YokanAISystem::scheduleOmenReports() {
+    // 生成中（LLMの応答待ち）は次を始めない
+    if (omenGenerationPending || llmClient.isBusy() || omenSummary.getReadingCount() == 0) {
+        return;
+    }
+    
+    // 時間窓は実時刻で区切る（センサーが止まっている間も窓は進み、入力が同じなら作り直さない）
+    // NTP同期前は起動からの秒で区切り、同期後の窓とは別の窓として扱う
+    bool synced;
+    const uint32_t now = TimeUtils::toSeconds(TimeUtils::getCurrentUnixTime(synced), synced);
+    for (uint8_t i = 0; i < OmenReportCache::KIND_COUNT; i++) {
+        const OmenReportKind kind = (OmenReportKind)(OmenReportCache::KIND_COUNT - 1 - i);  // 日次を優先
+        const uint32_t window = OmenReportCache::windowStart(kind, now, synced);
+        if (omenReports.hasWindow(kind, window, synced)) {
+            continue;
+        }
+        
+        // 新しい窓：入力が前回から変わっていなければ作り直さない
+        const uint8_t days = OmenReportCache::reportDays(kind);
+        omenSummary.updateTrends(trendForecaster);
+        OmenPromptBuilder::build(omenSummary, days, OMEN_PROMPT_TOKEN_BUDGET, omenPrompt, sizeof(omenPrompt));
+        const uint32_t digest = OmenPromptBuilder::digest(omenPrompt);
+        if (omenReports.adoptIfUnchanged(kind, window, synced, digest)) {
+            continue;
+        }
+        
+        // LLMが使えれば文章化を依頼し、使えない・失敗した場合はローカルのレポートを保存する
+        if (llmClient.isAvailable() && cloudConnector.isConnected()) {
+            omenGenerationPending = true;
+            bool requested = llmClient.request(omenPrompt, [this, kind, window, synced, digest, now](bool success, const char* text) {
+                omenGenerationPending = false;
+                if (success) {
+                    omenReports.store(kind, window, synced, digest, now, text, true);
+                    Serial.println(String("予感AIちゃん: ") + text);
+                } else {
+                    writeOmenReport(omenReportBuffer, sizeof(omenReportBuffer), OmenReportCache::reportDays(kind));
+                    omenReports.store(kind, window, synced, digest, now, omenReportBuffer, false);
+                }
+            });
+            if (requested) {
+                return;
+            }
+            omenGenerationPending = false;
+        }
+        
+        writeOmenReport(omenReportBuffer, sizeof(omenReportBuffer), days);
+        omenReports.store(kind, window, synced, digest, now, omenReportBuffer, false);
+        if (kind == OmenReportKind::DAILY) {
+            Serial.print(omenReportBuffer);
+        }
+        return;     // 1回の呼び出しで生成するのは1件まで
+    }
+}
+
+const OmenReportEntry* YokanAISystem::viewOmenReport(OmenReportKind kind) {
+    bool synced;
+    const uint32_t now = TimeUtils::toSeconds(TimeUtils::getCurrentUnixTime(synced), synced);
+    return omenReports.view(kind, OmenReportCache::windowStart(kind, now, synced), synced);
+}
+
+void YokanAISystem::resetPipelineMetrics() {
+    displayStage.reset();
+    uploadStage.reset();
+    storageStage.reset();
+    queueStage.reset();
+    scanStage.reset();
+}
+
 void YokanAISystem::performPeriodicMaintenance() {
+    // パイプラインの処理時間をログに出力
+    Serial.print(getPipelineReport());
+    
     // Check storage usage and cleanup if needed
     if (storageManager.getStorageUsagePercent() > StorageManager::WARNING_THRESHOLD_PERCENT) {
         storageManager.archiveOldFiles();
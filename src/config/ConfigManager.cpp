@@ -95,9 +95,15 @@ void ConfigManager::setDefaultConfig() {
     currentConfig.wifi_password = "";
     currentConfig.google_sheets_id = "";
     currentConfig.api_key = "";
+    currentConfig.llm_endpoint = DEFAULT_LLM_ENDPOINT;
+    currentConfig.llm_model = DEFAULT_LLM_MODEL;
+    currentConfig.llm_root_ca = "";
     currentConfig.sampling_interval = 3000; // 3秒間隔
     currentConfig.auto_upload_enabled = true;
     currentConfig.storage_mode = StorageMode::HYBRID;
+    currentConfig.derived_metrics_enabled = false;
+    currentConfig.altitude = 0.0f;
+    currentConfig.gas_scan_config = "";
     
     Serial.println("デフォルト設定を適用しました");
 }
@@ -114,9 +120,15 @@ bool ConfigManager::serializeConfig(const SystemConfig& config, String& jsonStri
     doc["wifi_password"] = config.wifi_password;
     doc["google_sheets_id"] = config.google_sheets_id;
     doc["api_key"] = config.api_key;
+    doc["llm_endpoint"] = config.llm_endpoint;
+    doc["llm_model"] = config.llm_model;
+    doc["llm_root_ca"] = config.llm_root_ca;
     doc["sampling_interval"] = config.sampling_interval;
     doc["auto_upload_enabled"] = config.auto_upload_enabled;
     doc["storage_mode"] = (int)config.storage_mode;
+    doc["derived_metrics_enabled"] = config.derived_metrics_enabled;
+    doc["altitude"] = config.altitude;
+    doc["gas_scan_config"] = config.gas_scan_config;
     
     if (serializeJson(doc, jsonString) == 0) {
         return false;
@@ -138,9 +150,15 @@ bool ConfigManager::deserializeConfig(const String& jsonString, SystemConfig& co
     config.wifi_password = doc["wifi_password"] | "";
     config.google_sheets_id = doc["google_sheets_id"] | "";
     config.api_key = doc["api_key"] | "";
+    config.llm_endpoint = doc["llm_endpoint"] | DEFAULT_LLM_ENDPOINT;
+    config.llm_model = doc["llm_model"] | DEFAULT_LLM_MODEL;
+    config.llm_root_ca = doc["llm_root_ca"] | "";
     config.sampling_interval = doc["sampling_interval"] | 3000;
     config.auto_upload_enabled = doc["auto_upload_enabled"] | true;
     config.storage_mode = (StorageMode)(doc["storage_mode"] | (int)StorageMode::HYBRID);
+    config.derived_metrics_enabled = doc["derived_metrics_enabled"] | false;
+    config.altitude = doc["altitude"] | 0.0f;
+    config.gas_scan_config = doc["gas_scan_config"] | "";
     
     return true;
 }
@@ -176,6 +194,11 @@ bool ConfigManager::validateConfig(const SystemConfig& config) {
         return false;
     }
     
+    // 設置高度（死海〜高山の範囲）
+    if (config.altitude < MIN_ALTITUDE || config.altitude > MAX_ALTITUDE) {
+        return false;
+    }
+    
     // その他の妥当性チェックは必要に応じて追加
     return true;
 }
@@ -197,6 +220,31 @@ bool ConfigManager::setApiKey(const String& apiKey) {
     return saveConfig(currentConfig);
 }
 
+bool ConfigManager::setLlmSettings(const String& endpoint, const String& model) {
+    currentConfig.llm_endpoint = endpoint;
+    currentConfig.llm_model = model;
+    return saveConfig(currentConfig);
+}
+
+bool ConfigManager::setLlmRootCa(const String& path) {
+    currentConfig.llm_root_ca = path;
+    return saveConfig(currentConfig);
+}
+
+bool ConfigManager::setDerivedMetrics(bool enabled, float altitude) {
+    if (altitude < MIN_ALTITUDE || altitude > MAX_ALTITUDE) {
+        return false;
+    }
+    currentConfig.derived_metrics_enabled = enabled;
+    currentConfig.altitude = altitude;
+    return saveConfig(currentConfig);
+}
+
+bool ConfigManager::setGasScanConfig(const String& path) {
+    currentConfig.gas_scan_config = path;
+    return saveConfig(currentConfig);
+}
+
 bool ConfigManager::setSamplingInterval(uint32_t interval) {
     if (interval < MIN_SAMPLING_INTERVAL || interval > MAX_SAMPLING_INTERVAL) {
         return false;
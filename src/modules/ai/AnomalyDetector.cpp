@@ -0,0 +1,189 @@
+#include "AnomalyDetector.h"
+#include "TimeUtils.h"
+#include "ErrorHandler.h"
+#include <math.h>
+
+constexpr float AnomalyDetector::Z_CLIP;
+
+AnomalyDetector::AnomalyDetector() {
+    reset();
+}
+
+void AnomalyDetector::reset() {
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+            FieldState& state = states[channel][i];
+            state.samples = 0;
+            state.firstTimestamp = 0;
+            state.lastTimestamp = 0;
+            state.level = 0.0f;
+            state.trend = 0.0f;
+            state.variance = 0.0f;
+            resetChange(state);
+        }
+        lastEventSeconds[channel] = 0;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        eventCounts[i] = 0;
+    }
+}
+
+void AnomalyDetector::resetChange(FieldState& state) {
+    state.cusumUp = 0.0f;
+    state.cusumDown = 0.0f;
+    state.segmentHours = 0.0f;
+    state.segmentSlope = 0.0f;
+    state.driftUp = 0.0f;
+    state.driftUpMin = 0.0f;
+    state.driftDown = 0.0f;
+    state.driftDownMin = 0.0f;
+}
+
+void AnomalyDetector::update(const SensorReading& reading) {
+    if (reading.channel >= MAX_CHANNELS) return;
+    
+    const uint32_t seconds = TimeUtils::toSeconds(reading.timestamp, reading.time_synced);
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const AnomalyField& anomalyField = ANOMALY_FIELDS[i];
+        const SensorField* field = SensorFields::find(anomalyField.sensorId);
+        if (!field || !SensorFields::hasValue(*field, reading) || 
+            (reading.outlier_mask & (1 << (field - SENSOR_FIELDS)))) {
+            continue;
+        }
+        
+        float value = SensorFields::getValue(*field, reading);
+        if (anomalyField.logScale) {
+            if (value <= 0.0f) continue;
+            value = logf(value);
+        }
+        updateField(states[reading.channel][i], anomalyField, reading, value, seconds);
+    }
+}
+
+void AnomalyDetector::updateField(FieldState& state, const AnomalyField& field, const SensorReading& reading,
+                                  float value, uint32_t seconds) {
+    if (isnan(value)) return;
+    
+    // 間隔が空いた・時刻が戻った場合は、基準の予測が当てにならないので立ち上がりからやり直す
+    // （NTP同期の前後ではtime_syncedで秒の基準が変わり、大きく飛ぶか戻るためここで捕まる）
+    if (state.samples != 0 && 
+        (seconds < state.lastTimestamp || seconds - state.lastTimestamp > config.maxGapSeconds)) {
+        state.samples = 0;
+        resetChange(state);
+    }
+    
+    if (state.samples == 0) {
+        state.level = value;
+        state.trend = 0.0f;
+        state.variance = 0.0f;
+        state.samples = 1;
+        state.firstTimestamp = seconds;
+        state.lastTimestamp = seconds;
+        return;
+    }
+    
+    // 判定は更新前の基準で行う（同じ秒に複数届いた場合は1秒扱い）
+    const float dt = (seconds > state.lastTimestamp) ? (float)(seconds - state.lastTimestamp) : 1.0f;
+    const float forecast = state.level + state.trend * dt;
+    const float residual = value - forecast;
+    const float sigma = fmaxf(sqrtf(state.variance), field.minSigma);
+    const float z = residual / sigma;
+    const bool ready = state.samples >= config.warmupSamples && 
+                       seconds - state.firstTimestamp >= 2 * config.baselineSeconds;
+    
+    if (ready) {
+        // zスコア
+        if (fabsf(z) >= config.zThreshold) {
+            emit(AnomalyType::SPIKE, field, reading, seconds, z > 0 ? 1 : -1, value, forecast, z);
+        }
+        
+        // CUSUM（zを上下に分けて累積、許容幅kを超えた分だけ溜まる）
+        const float clipped = fmaxf(-Z_CLIP, fminf(Z_CLIP, z));
+        state.cusumUp = fmaxf(0.0f, state.cusumUp + clipped - config.cusumSlack);
+        state.cusumDown = fmaxf(0.0f, state.cusumDown - clipped - config.cusumSlack);
+        if (state.cusumUp > config.cusumThreshold || state.cusumDown > config.cusumThreshold) {
+            bool up = state.cusumUp > config.cusumThreshold;
+            emit(AnomalyType::SHIFT, field, reading, seconds, up ? 1 : -1, value, forecast,
+                 up ? state.cusumUp : state.cusumDown);
+            state.cusumUp = 0.0f;
+            state.cusumDown = 0.0f;
+        }
+    }
+    
+    // 基準の更新（Holt法の誤差修正形、係数はサンプル間隔から求める）
+    const float alpha = 1.0f - expf(-dt / config.baselineSeconds);
+    state.level = forecast + alpha * residual;
+    state.trend += alpha * alpha * residual / dt;
+    
+    // 立ち上がりは単純平均で分散を推定し、過小評価による誤検知を防ぐ
+    const float varianceAlpha = fmaxf(1.0f - expf(-dt / config.varianceSeconds), 1.0f / state.samples);
+    state.variance += varianceAlpha * (residual * residual - state.variance);
+    
+    if (ready) {
+        // Page-Hinkley（傾きの区間平均からのずれを時間で積分し、項目の単位の変化量で判定）
+        const float hours = dt / 3600.0f;
+        const float slope = state.trend * 3600.0f;
+        state.segmentHours += hours;
+        state.segmentSlope += (slope - state.segmentSlope) * hours / state.segmentHours;
+        
+        const float deviation = slope - state.segmentSlope;
+        state.driftUp += (deviation - field.driftDelta) * hours;
+        state.driftDown += (-deviation - field.driftDelta) * hours;
+        state.driftUpMin = fminf(state.driftUpMin, state.driftUp);
+        state.driftDownMin = fminf(state.driftDownMin, state.driftDown);
+        
+        const float upScore = state.driftUp - state.driftUpMin;
+        const float downScore = state.driftDown - state.driftDownMin;
+        if (upScore > field.driftThreshold || downScore > field.driftThreshold) {
+            bool up = upScore > field.driftThreshold;
+            emit(AnomalyType::DRIFT, field, reading, seconds, up ? 1 : -1, value, state.level,
+                 up ? upScore : downScore);
+            resetChange(state);
+        }
+    }
+    
+    state.samples++;
+    state.lastTimestamp = seconds;
+}
+
+void AnomalyDetector::emit(AnomalyType type, const AnomalyField& field, const SensorReading& reading, uint32_t seconds,
+                           int8_t direction, float value, float baseline, float score) {
+    AnomalyEvent event;
+    event.timestamp = reading.timestamp;
+    event.timeSynced = reading.time_synced;
+    event.channel = reading.channel;
+    event.sensorId = field.sensorId;
+    event.type = type;
+    event.direction = direction;
+    // 対数で扱う項目は元の単位に戻して通知する
+    event.value = field.logScale ? expf(value) : value;
+    event.baseline = field.logScale ? expf(baseline) : baseline;
+    event.score = score;
+    
+    eventCounts[(int)type]++;
+    lastEventSeconds[reading.channel] = seconds;
+    
+    if (callback) {
+        callback(event);
+    }
+}
+
+bool AnomalyDetector::isActive(uint8_t channel, uint32_t nowSeconds) const {
+    if (channel >= MAX_CHANNELS || lastEventSeconds[channel] == 0) return false;
+    return nowSeconds - lastEventSeconds[channel] < config.holdSeconds;
+}
+
+String AnomalyDetector::getReport() const {
+    return "異常検知: 単発" + String(eventCounts[(int)AnomalyType::SPIKE]) + 
+           "件, 水準変化" + String(eventCounts[(int)AnomalyType::SHIFT]) + 
+           "件, ドリフト" + String(eventCounts[(int)AnomalyType::DRIFT]) + "件";
+}
+
+const char* AnomalyDetector::typeToString(AnomalyType type) {
+    switch (type) {
+        case AnomalyType::SPIKE: return "単発";
+        case AnomalyType::SHIFT: return "水準変化";
+        case AnomalyType::DRIFT: return "ドリフト";
+        default: return "不明";
+    }
+}
\ No newline at end of file
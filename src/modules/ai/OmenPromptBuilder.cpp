@@ -0,0 +1,141 @@
+#include "OmenPromptBuilder.h"
+#include "AnomalyDetector.h"
+#include "TimeUtils.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace {
+
+// 予算内に収まる行だけを追記する（収まらない行は書きかけを取り消す）
+struct PromptWriter {
+    char* buffer;
+    size_t size;
+    size_t length;
+    uint16_t budget;
+    uint16_t tokens;
+    bool full;
+    
+    PromptWriter(char* buf, size_t bufSize, uint16_t tokenBudget) :
+        buffer(buf), size(bufSize), length(0), budget(tokenBudget), tokens(0), full(false) {
+        if (size > 0) buffer[0] = '\0';
+    }
+    
+    bool line(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        if (full || size == 0) return false;
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(buffer + length, size - length, format, args);
+        va_end(args);
+        
+        uint16_t lineTokens = written > 0 ? OmenPromptBuilder::estimateTokens(buffer + length) : 0;
+        if (written < 0 || (size_t)written >= size - length || tokens + lineTokens > budget) {
+            buffer[length] = '\0';
+            full = true;
+            return false;
+        }
+        length += written;
+        tokens += lineTokens;
+        return true;
+    }
+};
+
+const char* shortColumn(uint8_t sensorId) {
+    switch (sensorId) {
+        case BSEC_OUTPUT_RAW_TEMPERATURE: return "temp";
+        case BSEC_OUTPUT_RAW_HUMIDITY: return "hum";
+        case BSEC_OUTPUT_RAW_PRESSURE: return "pres";
+        case BSEC_OUTPUT_IAQ: return "iaq";
+        case BSEC_OUTPUT_CO2_EQUIVALENT: return "co2";
+        default: {
+            const SensorField* field = SensorFields::find(sensorId);
+            return field ? field->column : "?";
+        }
+    }
+}
+
+} // namespace
+
+uint16_t OmenPromptBuilder::estimateTokens(const char* text) {
+    uint32_t ascii = 0;
+    uint32_t others = 0;
+    for (const uint8_t* p = (const uint8_t*)text; *p; p++) {
+        if (*p < 0x80) {
+            ascii++;
+        } else if ((*p & 0xC0) != 0x80) {
+            others++;   // UTF-8の先頭バイトだけ数える
+        }
+    }
+    uint32_t tokens = (ascii + 2) / 3 + others;
+    return tokens > UINT16_MAX ? UINT16_MAX : (uint16_t)tokens;
+}
+
+uint32_t OmenPromptBuilder::digest(const char* text) {
+    uint32_t hash = 2166136261u;
+    for (const uint8_t* p = (const uint8_t*)text; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+size_t OmenPromptBuilder::build(const OmenSummary& summary, uint8_t days, uint16_t tokenBudget,
+                                char* buffer, size_t size, uint16_t* tokens) {
+    PromptWriter out(buffer, size, tokenBudget);
+    
+    // 1. 指示（これが入らない予算では何も送らない）
+    out.line("あなたは室内の環境センサーを見守る「予感AIちゃん」です。"
+             "以下の要約から、これからの天気や空気の変化の予感を日本語で3文以内、やさしく伝えてください。\n");
+    out.line("period %ud n=%lu\n", days, (unsigned long)summary.getReadingCount());
+    
+    // 2. 項目ごとの集計と傾向（全期間の平均・範囲、現在値・傾き・6時間後の予測）
+    OmenRollup total;
+    summary.aggregate(days, total);
+    for (uint8_t i = 0; i < OmenSummary::FIELD_COUNT; i++) {
+        const OmenRollup::Value& value = total.values[i];
+        if (value.count == 0) continue;
+        
+        const TrendSnapshot& trend = summary.getTrend(i);
+        if (trend.valid) {
+            out.line("%s mean %.1f range %.1f-%.1f now %.1f slope %+.2f/h +6h %.1f\n",
+                     shortColumn(OMEN_FIELDS[i]), value.mean, value.minValue, value.maxValue,
+                     trend.level, trend.slopePerHour, trend.forecast[TrendSnapshot::FORECAST_HOURS - 1]);
+        } else {
+            out.line("%s mean %.1f range %.1f-%.1f\n",
+                     shortColumn(OMEN_FIELDS[i]), value.mean, value.minValue, value.maxValue);
+        }
+    }
+    
+    // 3. 異常の件数と直近のイベント
+    if (summary.getRecentEventCount() > 0) {
+        out.line("anomalies spike %lu shift %lu drift %lu\n",
+                 (unsigned long)summary.getEventTotal(AnomalyType::SPIKE),
+                 (unsigned long)summary.getEventTotal(AnomalyType::SHIFT),
+                 (unsigned long)summary.getEventTotal(AnomalyType::DRIFT));
+        const uint32_t now = summary.getLastTimestamp();
+        for (uint8_t i = 0; i < summary.getRecentEventCount() && i < MAX_PROMPT_EVENTS; i++) {
+            const AnomalyEvent* event = summary.getRecentEvent(i);
+            const uint32_t seconds = TimeUtils::toSeconds(event->timestamp, event->timeSynced);
+            out.line("- %lumin ago %s %s %s %.1f (base %.1f)\n",
+                     (unsigned long)((now > seconds ? now - seconds : 0) / 60),
+                     AnomalyDetector::typeToString(event->type), shortColumn(event->sensorId),
+                     event->direction > 0 ? "up" : "down", event->value, event->baseline);
+        }
+    }
+    
+    // 4. 日ごとの推移（新しい日から、予算が残る限り）
+    const int8_t temperatureIndex = OmenSummary::fieldIndex(BSEC_OUTPUT_RAW_TEMPERATURE);
+    const int8_t humidityIndex = OmenSummary::fieldIndex(BSEC_OUTPUT_RAW_HUMIDITY);
+    const int8_t pressureIndex = OmenSummary::fieldIndex(BSEC_OUTPUT_RAW_PRESSURE);
+    const int8_t iaqIndex = OmenSummary::fieldIndex(BSEC_OUTPUT_IAQ);
+    for (uint8_t ago = 0; ago < days && ago < OmenSummary::DAILY_ROLLUPS && !out.full; ago++) {
+        const OmenRollup* day = summary.getDaily(ago);
+        if (!day) continue;
+        out.line("day-%u temp %.1f-%.1f hum %.0f pres %.1f iaq %.0f/%.0f ev %u\n", ago,
+                 day->values[temperatureIndex].minValue, day->values[temperatureIndex].maxValue,
+                 day->values[humidityIndex].mean, day->values[pressureIndex].mean,
+                 day->values[iaqIndex].mean, day->values[iaqIndex].maxValue, day->eventCount);
+    }
+    
+    if (tokens) *tokens = out.tokens;
+    return out.length;
+}
\ No newline at end of file
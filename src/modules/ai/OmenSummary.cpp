@@ -0,0 +1,171 @@
+#include "OmenSummary.h"
+#include "TimeUtils.h"
+#include <math.h>
+
+void OmenRollup::reset(uint32_t startSeconds) {
+    start = startSeconds;
+    eventCount = 0;
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        values[i].count = 0;
+        values[i].mean = 0.0f;
+        values[i].minValue = 0.0f;
+        values[i].maxValue = 0.0f;
+    }
+}
+
+void OmenRollup::add(uint8_t fieldIndex, float value) {
+    Value& v = values[fieldIndex];
+    if (v.count == 0) {
+        v.minValue = value;
+        v.maxValue = value;
+    } else {
+        if (value < v.minValue) v.minValue = value;
+        if (value > v.maxValue) v.maxValue = value;
+    }
+    v.count++;
+    v.mean += (value - v.mean) / v.count;
+}
+
+void OmenRollup::merge(const OmenRollup& other) {
+    eventCount += other.eventCount;
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const Value& o = other.values[i];
+        if (o.count == 0) continue;
+        
+        Value& v = values[i];
+        if (v.count == 0) {
+            v = o;
+            continue;
+        }
+        uint32_t total = v.count + o.count;
+        v.mean += (o.mean - v.mean) * ((float)o.count / total);
+        v.count = total;
+        if (o.minValue < v.minValue) v.minValue = o.minValue;
+        if (o.maxValue > v.maxValue) v.maxValue = o.maxValue;
+    }
+}
+
+OmenSummary::OmenSummary(uint8_t channelId) :
+    channel(channelId) {
+    reset();
+}
+
+void OmenSummary::reset() {
+    readingCount = 0;
+    firstTimestamp = 0;
+    lastTimestamp = 0;
+    timeSynced = false;
+    for (uint8_t i = 0; i < HOURLY_ROLLUPS; i++) hourly[i].reset(0);
+    for (uint8_t i = 0; i < DAILY_ROLLUPS; i++) daily[i].reset(0);
+    eventHead = 0;
+    eventCount = 0;
+    for (uint8_t i = 0; i < 3; i++) eventTotals[i] = 0;
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) trends[i].valid = false;
+}
+
+int8_t OmenSummary::fieldIndex(uint8_t sensorId) {
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        if (OMEN_FIELDS[i] == sensorId) return i;
+    }
+    return -1;
+}
+
+OmenRollup& OmenSummary::rollupFor(OmenRollup* ring, uint8_t size, uint32_t start, uint32_t period) {
+    // 区間番号でリングの位置を決め、古い区間が残っていれば上書きする
+    OmenRollup& rollup = ring[(start / period) % size];
+    if (rollup.start != start) {
+        rollup.reset(start);
+    }
+    return rollup;
+}
+
+void OmenSummary::update(const SensorReading& reading) {
+    if (reading.channel != channel) return;
+    
+    const uint32_t seconds = TimeUtils::toSeconds(reading.timestamp, reading.time_synced);
+    // 時刻が戻った・NTP同期の前後で時刻の基準が変わった場合は古い集計を捨てる
+    if (seconds < lastTimestamp || (readingCount > 0 && reading.time_synced != timeSynced)) {
+        reset();
+    }
+    if (readingCount == 0) {
+        firstTimestamp = seconds;
+    }
+    lastTimestamp = seconds;
+    timeSynced = reading.time_synced;
+    readingCount++;
+    
+    const uint32_t hourStart = seconds - seconds % 3600;
+    const uint32_t dayStart = seconds - TimeUtils::secondsOfDay(seconds, timeSynced);
+    OmenRollup& hour = rollupFor(hourly, HOURLY_ROLLUPS, hourStart, 3600);
+    OmenRollup& day = rollupFor(daily, DAILY_ROLLUPS, dayStart, 86400);
+    
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const SensorField* field = SensorFields::find(OMEN_FIELDS[i]);
+        if (!field || !SensorFields::hasValue(*field, reading) ||
+            (reading.outlier_mask & (1 << (field - SENSOR_FIELDS)))) {
+            continue;
+        }
+        float value = SensorFields::getValue(*field, reading);
+        hour.add(i, value);
+        day.add(i, value);
+    }
+}
+
+void OmenSummary::recordEvent(const AnomalyEvent& event) {
+    if (event.channel != channel) return;
+    
+    events[eventHead] = event;
+    eventHead = (eventHead + 1) % RECENT_EVENTS;
+    if (eventCount < RECENT_EVENTS) eventCount++;
+    eventTotals[(int)event.type]++;
+    
+    // 集計と時刻の基準が異なるイベント（読み取り値より先に届いたもの）は区間に数えない
+    if (event.timeSynced != timeSynced) return;
+    const uint32_t seconds = TimeUtils::toSeconds(event.timestamp, event.timeSynced);
+    rollupFor(hourly, HOURLY_ROLLUPS, seconds - seconds % 3600, 3600).eventCount++;
+    rollupFor(daily, DAILY_ROLLUPS, seconds - TimeUtils::secondsOfDay(seconds, timeSynced), 86400).eventCount++;
+}
+
+void OmenSummary::updateTrends(const TrendForecaster& forecaster) {
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        trends[i] = forecaster.getSnapshot(channel, OMEN_FIELDS[i]);
+    }
+}
+
+const OmenRollup* OmenSummary::getDaily(uint8_t ago) const {
+    if (readingCount == 0 || ago >= DAILY_ROLLUPS) return nullptr;
+    
+    const uint32_t today = lastTimestamp - TimeUtils::secondsOfDay(lastTimestamp, timeSynced);
+    if (today < (uint32_t)ago * 86400) return nullptr;
+    const uint32_t start = today - (uint32_t)ago * 86400;
+    const OmenRollup& rollup = daily[(start / 86400) % DAILY_ROLLUPS];
+    return rollup.start == start ? &rollup : nullptr;
+}
+
+const OmenRollup* OmenSummary::getHourly(uint8_t ago) const {
+    if (readingCount == 0 || ago >= HOURLY_ROLLUPS) return nullptr;
+    
+    const uint32_t current = lastTimestamp - lastTimestamp % 3600;
+    if (current < (uint32_t)ago * 3600) return nullptr;
+    const uint32_t start = current - (uint32_t)ago * 3600;
+    const OmenRollup& rollup = hourly[(start / 3600) % HOURLY_ROLLUPS];
+    return rollup.start == start ? &rollup : nullptr;
+}
+
+bool OmenSummary::aggregate(uint8_t days, OmenRollup& result) const {
+    result.reset(0);
+    bool found = false;
+    for (uint8_t ago = 0; ago < days && ago < DAILY_ROLLUPS; ago++) {
+        const OmenRollup* rollup = getDaily(ago);
+        if (!rollup) continue;
+        result.merge(*rollup);
+        result.start = rollup->start;   // 最も古い日の開始時刻
+        found = true;
+    }
+    return found;
+}
+
+const AnomalyEvent* OmenSummary::getRecentEvent(uint8_t index) const {
+    if (index >= eventCount) return nullptr;
+    return &events[(eventHead + RECENT_EVENTS - 1 - index) % RECENT_EVENTS];
+}
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "QuantileSketch.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+void QuantileSketch::reset() {
+    numLevels = 1;
+    levelStart[0] = CAPACITY;
+    levelStart[1] = CAPACITY;
+    compactOffset = false;
+    count = 0;
+    minValue = NAN;
+    maxValue = NAN;
+}
+
+uint16_t QuantileSketch::levelCapacity(uint8_t level) const {
+    uint16_t capacity = K;
+    for (uint8_t depth = numLevels - 1 - level; depth > 0; depth--) {
+        capacity = capacity * 2 / 3;
+    }
+    return capacity < MIN_LEVEL_WIDTH ? MIN_LEVEL_WIDTH : capacity;
+}
+
+void QuantileSketch::addLevel() {
+    levelStart[numLevels + 1] = CAPACITY;
+    numLevels++;
+}
+
+void QuantileSketch::add(float value) {
+    if (isnan(value)) return;
+    
+    if (levelStart[0] == 0) {
+        compress();
+    }
+    items[--levelStart[0]] = value;
+    
+    if (count == 0 || value < minValue) minValue = value;
+    if (count == 0 || value > maxValue) maxValue = value;
+    count++;
+}
+
+void QuantileSketch::compress() {
+    // 容量に達している最も下の段を上へ送る（配列が満杯なら必ずどこかの段が容量以上）
+    uint8_t level = 0;
+    while (level < numLevels - 1 && levelSize(level) < levelCapacity(level)) {
+        level++;
+    }
+    
+    if (level == numLevels - 1) {
+        if (numLevels >= MAX_LEVELS) {
+            thinTopLevel();
+            return;
+        }
+        addLevel();
+    }
+    compactLevel(level);
+}
+
+void QuantileSketch::compactLevel(uint8_t level) {
+    const uint16_t start = levelStart[level];
+    const uint16_t end = levelStart[level + 1];
+    const uint16_t upperEnd = levelStart[level + 2];
+    
+    if (level == 0) {
+        std::sort(items + start, items + end);
+    }
+    
+    // 奇数個なら最小の1個をこの段に残し、残りを1つおきに間引く
+    const uint16_t odd = (end - start) & 1;
+    const uint16_t first = start + odd;
+    const uint16_t half = (end - first) / 2;
+    const uint16_t offset = compactOffset ? 1 : 0;
+    compactOffset = !compactOffset;
+    
+    float survivors[CAPACITY / 2];
+    for (uint16_t i = 0; i < half; i++) {
+        survivors[i] = items[first + 2 * i + offset];
+    }
+    
+    // 上の段と前から併合し、[end - half, upperEnd)に昇順で置く（書き込み位置は読み出し位置を追い越さない）
+    uint16_t i = 0;
+    uint16_t j = end;
+    uint16_t k = end - half;
+    while (i < half) {
+        if (j < upperEnd && items[j] < survivors[i]) {
+            items[k++] = items[j++];
+        } else {
+            items[k++] = survivors[i++];
+        }
+    }
+    
+    // 空いたhalf個分、下の段（と残した1個）を後ろへ詰める
+    memmove(items + levelStart[0] + half, items + levelStart[0], (first - levelStart[0]) * sizeof(float));
+    for (uint8_t l = 0; l <= level; l++) {
+        levelStart[l] += half;
+    }
+    levelStart[level + 1] = end - half;
+}
+
+void QuantileSketch::thinTopLevel() {
+    // 段数の上限に達した場合は最上段を同じ段のまま間引く（以降の重みは近似になる）
+    const uint8_t level = numLevels - 1;
+    const uint16_t start = levelStart[level];
+    const uint16_t end = levelStart[level + 1];
+    const uint16_t half = (end - start) / 2;
+    const uint16_t offset = compactOffset ? 1 : 0;
+    compactOffset = !compactOffset;
+    
+    for (uint16_t i = 0; i < half; i++) {
+        items[end - 1 - i] = items[end - 1 - 2 * i - offset];
+    }
+    
+    const uint16_t shift = (end - start) - half;
+    memmove(items + levelStart[0] + shift, items + levelStart[0], (start - levelStart[0]) * sizeof(float));
+    for (uint8_t l = 0; l <= level; l++) {
+        levelStart[l] += shift;
+    }
+}
+
+void QuantileSketch::insertRun(uint8_t level, const float* values, uint16_t n) {
+    // 呼び出し側でn <= 空き容量を保証する
+    const uint16_t base = levelStart[0];
+    const uint16_t start = levelStart[level];
+    const uint16_t end = levelStart[level + 1];
+    
+    // 下の段をn個分前へずらして段levelの手前に隙間を作る
+    memmove(items + base - n, items + base, (start - base) * sizeof(float));
+    for (uint8_t l = 0; l <= level; l++) {
+        levelStart[l] -= n;
+    }
+    
+    if (level == 0) {
+        memcpy(items + start - n, values, n * sizeof(float));
+        return;
+    }
+    
+    // 段level（昇順）と前から併合する
+    uint16_t k = start - n;
+    uint16_t i = start;
+    uint16_t j = 0;
+    while (j < n) {
+        if (i < end && items[i] <= values[j]) {
+            items[k++] = items[i++];
+        } else {
+            items[k++] = values[j++];
+        }
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.count == 0) return;
+    
+    // 相手の段hの要素を同じ重みの段hへ入れる（空きが足りなければ圧縮しながら分割して入れる）
+    for (uint8_t level = 0; level < other.numLevels; level++) {
+        while (numLevels <= level) {
+            addLevel();
+        }
+        
+        const float* source = other.items + other.levelStart[level];
+        uint16_t remaining = other.levelSize(level);
+        while (remaining > 0) {
+            if (levelStart[0] == 0) {
+                compress();
+            }
+            uint16_t n = remaining < levelStart[0] ? remaining : levelStart[0];
+            insertRun(level, source, n);
+            source += n;
+            remaining -= n;
+        }
+    }
+    
+    if (count == 0 || other.minValue < minValue) minValue = other.minValue;
+    if (count == 0 || other.maxValue > maxValue) maxValue = other.maxValue;
+    count += other.count;
+}
+
+float QuantileSketch::quantile(float q) {
+    if (count == 0) return NAN;
+    if (q <= 0.0f) return minValue;
+    if (q >= 1.0f) return maxValue;
+    
+    std::sort(items + levelStart[0], items + levelStart[1]);
+    
+    uint64_t totalWeight = 0;
+    for (uint8_t level = 0; level < numLevels; level++) {
+        totalWeight += (uint64_t)levelSize(level) << level;
+    }
+    const uint64_t target = (uint64_t)((double)q * totalWeight);
+    
+    // 各段は昇順なので、段ごとのカーソルで小さい順にたどって重みを累積する
+    uint16_t cursor[MAX_LEVELS];
+    for (uint8_t level = 0; level < numLevels; level++) {
+        cursor[level] = levelStart[level];
+    }
+    
+    uint64_t cumulative = 0;
+    while (true) {
+        int8_t best = -1;
+        for (uint8_t level = 0; level < numLevels; level++) {
+            if (cursor[level] < levelStart[level + 1] &&
+                (best < 0 || items[cursor[level]] < items[cursor[best]])) {
+                best = level;
+            }
+        }
+        if (best < 0) break;
+        
+        cumulative += (uint64_t)1 << best;
+        if (cumulative > target) {
+            return items[cursor[best]];
+        }
+        cursor[best]++;
+    }
+    return maxValue;
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "StreamingStats.h"
+#include "TimeUtils.h"
+#include <math.h>
+
+constexpr float RunningStats::EWMA_TAU_SECONDS[RunningStats::EWMA_COUNT];
+
+void RunningStats::reset() {
+    count = 0;
+    mean = 0.0;
+    m2 = 0.0;
+    minValue = 0.0f;
+    maxValue = 0.0f;
+    for (uint8_t i = 0; i < EWMA_COUNT; i++) ewma[i] = 0.0f;
+    lastTimestamp = 0;
+}
+
+void RunningStats::update(float value, uint32_t timestampSeconds) {
+    if (isnan(value)) return;
+    
+    if (count == 0) {
+        minValue = value;
+        maxValue = value;
+        for (uint8_t i = 0; i < EWMA_COUNT; i++) ewma[i] = value;
+    } else {
+        if (value < minValue) minValue = value;
+        if (value > maxValue) maxValue = value;
+        
+        // サンプル間隔dtに対して α = 1 - exp(-dt/τ)（同じ秒に複数届いた場合は1秒扱い）
+        float dt = (timestampSeconds > lastTimestamp) ? (float)(timestampSeconds - lastTimestamp) : 1.0f;
+        for (uint8_t i = 0; i < EWMA_COUNT; i++) {
+            float alpha = 1.0f - expf(-dt / EWMA_TAU_SECONDS[i]);
+            ewma[i] += alpha * (value - ewma[i]);
+        }
+    }
+    
+    // Welford法
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+    lastTimestamp = timestampSeconds;
+}
+
+float RunningStats::getStdDev() const {
+    return sqrtf(getVariance());
+}
+
+StreamingStats::StreamingStats() {
+    reset();
+}
+
+void StreamingStats::reset() {
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        ChannelStats& stats = channels[channel];
+        for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+            stats.fields[i].reset();
+        }
+        stats.readingCount = 0;
+        stats.skippedOutliers = 0;
+        stats.lastTimestamp = 0;
+    }
+}
+
+void StreamingStats::update(const SensorReading& reading) {
+    if (reading.channel >= MAX_CHANNELS) return;
+    
+    ChannelStats& stats = channels[reading.channel];
+    uint32_t seconds = TimeUtils::toSeconds(reading.timestamp, reading.time_synced);
+    
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        const SensorField& field = SENSOR_FIELDS[i];
+        if (!SensorFields::hasValue(field, reading)) continue;
+        if (reading.outlier_mask & (1 << i)) {
+            stats.skippedOutliers++;
+            continue;
+        }
+        stats.fields[i].update(SensorFields::getValue(field, reading), seconds);
+    }
+    stats.readingCount++;
+    stats.lastTimestamp = seconds;
+}
+
+const RunningStats* StreamingStats::get(uint8_t channel, uint8_t sensorId) const {
+    const SensorField* field = SensorFields::find(sensorId);
+    if (channel >= MAX_CHANNELS || !field) {
+        return nullptr;
+    }
+    const RunningStats& stats = channels[channel].fields[field - SENSOR_FIELDS];
+    return stats.count > 0 ? &stats : nullptr;
+}
+
+void StreamingStats::toJson(uint8_t channel, JsonDocument& doc) const {
+    if (channel >= MAX_CHANNELS) return;
+    
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        const RunningStats& stats = channels[channel].fields[i];
+        if (stats.count == 0 || !SensorFields::hasSlot(SENSOR_FIELDS[i])) continue;
+        
+        JsonVariant entry = doc["stats"][SENSOR_FIELDS[i].column];
+        entry["n"] = stats.count;
+        entry["mean"] = stats.getMean();
+        entry["sd"] = stats.getStdDev();
+        entry["min"] = stats.minValue;
+        entry["max"] = stats.maxValue;
+        entry["ewma_1h"] = stats.ewma[EWMA_1HOUR];
+    }
+}
+
+String StreamingStats::getReport(uint8_t channel) const {
+    if (channel >= MAX_CHANNELS) return "";
+    
+    const ChannelStats& stats = channels[channel];
+    String report = "統計(ch" + String(channel) + "): " + String(stats.readingCount) + "件, 外れ値除外" + 
+                    String(stats.skippedOutliers) + "件\n";
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        const RunningStats& field = stats.fields[i];
+        if (field.count == 0 || !SensorFields::hasSlot(SENSOR_FIELDS[i])) continue;
+        
+        report += "  " + String(SENSOR_FIELDS[i].column) + ": 平均" + String(field.getMean(), 2) + 
+                  " σ" + String(field.getStdDev(), 2) + 
+                  " [" + String(field.minValue, 2) + "〜" + String(field.maxValue, 2) + "]" +
+                  " 1h" + String(field.ewma[EWMA_1HOUR], 2) + "\n";
+    }
+    return report;
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "TrendForecaster.h"
+#include "TimeUtils.h"
+#include <math.h>
+
+TrendForecaster::TrendForecaster() {
+    reset();
+}
+
+void TrendForecaster::reset() {
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+            FieldState& state = states[channel][i];
+            state.samples = 0;
+            state.lastTimestamp = 0;
+            state.seasonStart = 0;
+            state.timeSynced = false;
+            for (uint8_t slot = 0; slot < SEASON_SLOTS; slot++) {
+                state.season[slot] = 0.0f;
+            }
+        }
+    }
+}
+
+int8_t TrendForecaster::fieldIndex(uint8_t sensorId) {
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        if (TREND_FIELDS[i] == sensorId) return i;
+    }
+    return -1;
+}
+
+float TrendForecaster::seasonalAt(const FieldState& state, uint32_t secondsOfDay) {
+    // スロット中央の値を線形補間する
+    const float position = (float)secondsOfDay / SLOT_SECONDS - 0.5f;
+    const float base = floorf(position);
+    const float weight = position - base;
+    const uint8_t first = (uint8_t)(((int)base + SEASON_SLOTS) % SEASON_SLOTS);
+    const uint8_t second = (first + 1) % SEASON_SLOTS;
+    return state.season[first] * (1.0f - weight) + state.season[second] * weight;
+}
+
+float TrendForecaster::forecastAt(const FieldState& state, uint32_t aheadSeconds) const {
+    // 減衰トレンド：傾きの寄与はdampingSecondsで頭打ちになる
+    const float extension = config.dampingSeconds > 0 ?
+        config.dampingSeconds * (1.0f - expf(-(float)aheadSeconds / config.dampingSeconds)) : (float)aheadSeconds;
+    return state.level + state.trend * extension + 
+           seasonalAt(state, (TimeUtils::secondsOfDay(state.lastTimestamp, state.timeSynced) + aheadSeconds) % 86400);
+}
+
+void TrendForecaster::update(const SensorReading& reading) {
+    if (reading.channel >= MAX_CHANNELS) return;
+    
+    const uint32_t seconds = TimeUtils::toSeconds(reading.timestamp, reading.time_synced);
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const SensorField* field = SensorFields::find(TREND_FIELDS[i]);
+        if (!field || !SensorFields::hasValue(*field, reading) ||
+            (reading.outlier_mask & (1 << (field - SENSOR_FIELDS)))) {
+            continue;
+        }
+        updateField(states[reading.channel][i], SensorFields::getValue(*field, reading), seconds, reading.time_synced);
+    }
+}
+
+void TrendForecaster::resetLocal(FieldState& state, float value, uint32_t seconds) {
+    // 日周成分は残し、水準・傾き・回帰をこの値から始め直す
+    const float seasonal = seasonalAt(state, TimeUtils::secondsOfDay(seconds, state.timeSynced));
+    state.s0 = 1.0;
+    state.s1 = 0.0;
+    state.s2 = 0.0;
+    state.sx = value;
+    state.stx = 0.0;
+    state.level = value - seasonal;
+    state.trend = 0.0f;
+    if (state.seasonStart == 0) {
+        state.dailyMean = value;
+    }
+    state.samples = 1;
+    state.lastTimestamp = seconds;
+    if (state.seasonStart == 0) {
+        state.seasonStart = seconds;
+    }
+}
+
+void TrendForecaster::updateField(FieldState& state, float value, uint32_t seconds, bool timeSynced) {
+    if (isnan(value)) return;
+    
+    const bool epochChanged = state.samples != 0 && timeSynced != state.timeSynced;
+    if (state.samples == 0 || epochChanged || seconds < state.lastTimestamp || 
+        seconds - state.lastTimestamp > config.maxGapSeconds) {
+        // 初回・間隔が空いた場合は水準から作り直す
+        // （時刻が戻った・1日以上飛んだ・NTP同期の前後で時刻の基準が変わった場合は日周成分も学習し直す）
+        if (epochChanged || 
+            (state.samples != 0 && (seconds < state.lastTimestamp || seconds - state.lastTimestamp > 86400))) {
+            state.seasonStart = 0;
+            for (uint8_t slot = 0; slot < SEASON_SLOTS; slot++) {
+                state.season[slot] = 0.0f;
+            }
+        }
+        state.timeSynced = timeSynced;
+        resetLocal(state, value, seconds);
+        return;
+    }
+    
+    const uint32_t elapsed = seconds - state.lastTimestamp;
+    const double dt = elapsed > 0 ? (double)elapsed : 1.0;
+    
+    // 回帰：原点を新しいサンプルへ移し（t → t - dt）、重みを減衰させてから追加
+    state.s2 = state.s2 - 2.0 * dt * state.s1 + dt * dt * state.s0;
+    state.s1 = state.s1 - dt * state.s0;
+    state.stx = state.stx - dt * state.sx;
+    const double decay = exp(-dt / config.regressionSeconds);
+    state.s0 = state.s0 * decay + 1.0;
+    state.s1 *= decay;
+    state.s2 *= decay;
+    state.sx = state.sx * decay + value;
+    state.stx *= decay;
+    
+    // 日周成分：24時間平均からの偏差をスロットごとに日をまたいで平均する
+    // （各スロットは1日のうちSLOT_SECONDSしか更新されないので、スロット内の経過時間で時定数を測る）
+    const float dtf = (float)dt;
+    const uint32_t secondsOfDay = TimeUtils::secondsOfDay(seconds, state.timeSynced);
+    state.dailyMean += (1.0f - expf(-dtf / 86400.0f)) * (value - state.dailyMean);
+    
+    const float position = (float)secondsOfDay / SLOT_SECONDS - 0.5f;
+    const float base = floorf(position);
+    const float weight = position - base;
+    const uint8_t first = (uint8_t)(((int)base + SEASON_SLOTS) % SEASON_SLOTS);
+    const uint8_t second = (first + 1) % SEASON_SLOTS;
+    const float gamma = 1.0f - expf(-dtf / (config.seasonDays * SLOT_SECONDS));
+    const float seasonalError = gamma * (value - state.dailyMean - seasonalAt(state, secondsOfDay));
+    state.season[first] += seasonalError * (1.0f - weight);
+    state.season[second] += seasonalError * weight;
+    
+    // 日周成分を除いた系列にHolt法（誤差修正形、日周成分は学習途中でも差し引いて水準と整合させる）
+    const float deseasonalized = value - seasonalAt(state, secondsOfDay);
+    const float forecast = state.level + state.trend * dtf;
+    const float error = deseasonalized - forecast;
+    const float alpha = 1.0f - expf(-dtf / config.levelSeconds);
+    const float beta = 1.0f - expf(-dtf / config.trendSeconds);
+    state.level = forecast + alpha * error;
+    state.trend += alpha * beta * error / dtf;
+    
+    state.samples++;
+    state.lastTimestamp = seconds;
+}
+
+float TrendForecaster::regressionSlope(const FieldState& state) const {
+    const double denominator = state.s0 * state.s2 - state.s1 * state.s1;
+    if (denominator <= 0.0) return 0.0f;
+    // tは過去ほど負の秒数なので、傾きは単位/秒（表示用に単位/時へ換算）
+    return (float)((state.s0 * state.stx - state.s1 * state.sx) / denominator * 3600.0);
+}
+
+TrendSnapshot TrendForecaster::getSnapshot(uint8_t channel, uint8_t sensorId) const {
+    TrendSnapshot snapshot;
+    snapshot.valid = false;
+    snapshot.seasonal = false;
+    snapshot.level = 0.0f;
+    snapshot.slopePerHour = 0.0f;
+    for (uint8_t h = 0; h < TrendSnapshot::FORECAST_HOURS; h++) {
+        snapshot.forecast[h] = 0.0f;
+    }
+    
+    const int8_t index = fieldIndex(sensorId);
+    if (channel >= MAX_CHANNELS || index < 0) return snapshot;
+    
+    const FieldState& state = states[channel][index];
+    if (state.samples < MIN_SAMPLES) return snapshot;
+    
+    snapshot.valid = true;
+    snapshot.seasonal = isSeasonReady(state);
+    snapshot.level = forecastAt(state, 0);
+    snapshot.slopePerHour = regressionSlope(state);
+    for (uint8_t h = 0; h < TrendSnapshot::FORECAST_HOURS; h++) {
+        snapshot.forecast[h] = forecastAt(state, (h + 1) * 3600);
+    }
+    return snapshot;
+}
+
+bool TrendForecaster::getSlope(uint8_t channel, uint8_t sensorId, float& slopePerHour) const {
+    TrendSnapshot snapshot = getSnapshot(channel, sensorId);
+    if (!snapshot.valid) return false;
+    slopePerHour = snapshot.slopePerHour;
+    return true;
+}
+
+bool TrendForecaster::getForecast(uint8_t channel, uint8_t sensorId, float hoursAhead, float& value) const {
+    const int8_t index = fieldIndex(sensorId);
+    if (channel >= MAX_CHANNELS || index < 0 || hoursAhead < 0.0f) return false;
+    
+    const FieldState& state = states[channel][index];
+    if (state.samples < MIN_SAMPLES) return false;
+    
+    value = forecastAt(state, (uint32_t)(hoursAhead * 3600.0f));
+    return true;
+}
+
+String TrendForecaster::getReport(uint8_t channel) const {
+    String report = "傾向(ch" + String(channel) + "):\n";
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const SensorField* field = SensorFields::find(TREND_FIELDS[i]);
+        TrendSnapshot snapshot = getSnapshot(channel, TREND_FIELDS[i]);
+        if (!field || !snapshot.valid) continue;
+        
+        report += "  " + String(field->column) + ": 傾き" + String(snapshot.slopePerHour, 2) + "/h" +
+                  " 1h後" + String(snapshot.forecast[0], 2) + 
+                  " 3h後" + String(snapshot.forecast[2], 2) + 
+                  " 6h後" + String(snapshot.forecast[5], 2) + 
+                  (snapshot.seasonal ? "" : "（日周未学習）") + "\n";
+    }
+    return report;
+}
\ No newline at end of file
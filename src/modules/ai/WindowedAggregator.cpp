@@ -0,0 +1,202 @@
+#include "WindowedAggregator.h"
+#include "TimeUtils.h"
+
+void MonotonicDeque::push(uint32_t slot, float value) {
+    // 新しい値以下（最小なら以上）の古い要素は今後最大（最小）になり得ないので捨てる
+    while (size > 0) {
+        const Entry& back = entries[(head + size - 1) % CAPACITY];
+        bool dominated = keepMax ? (back.value <= value) : (back.value >= value);
+        if (!dominated) break;
+        size--;
+    }
+    
+    // 同じスロットに勝る値が残っていれば追加不要（期限切れも同時）
+    if (size > 0 && entries[(head + size - 1) % CAPACITY].slot == slot) {
+        return;
+    }
+    
+    // スロットごとに高々1件なので、expire()後はWINDOW_SLOTS件を超えない
+    if (size == CAPACITY) {
+        head = (head + 1) % CAPACITY;
+        size--;
+    }
+    Entry& entry = entries[(head + size) % CAPACITY];
+    entry.slot = slot;
+    entry.value = value;
+    size++;
+}
+
+void MonotonicDeque::expire(uint32_t oldestSlot) {
+    while (size > 0 && entries[head].slot < oldestSlot) {
+        head = (head + 1) % CAPACITY;
+        size--;
+    }
+}
+
+WindowedAggregator::WindowedAggregator() :
+    windowCount(0),
+    mergedWindow(-1) {
+}
+
+int8_t WindowedAggregator::addWindow(uint8_t channel, uint8_t sensorId, uint32_t seconds) {
+    const SensorField* field = SensorFields::find(sensorId);
+    if (!field || !SensorFields::hasSlot(*field) || channel >= MAX_CHANNELS) {
+        return -1;
+    }
+    
+    // 登録済みなら満杯でも既存の番号を返す
+    int8_t existing = findWindow(channel, sensorId, seconds);
+    if (existing >= 0) {
+        return existing;
+    }
+    if (windowCount >= MAX_WINDOWS) {
+        return -1;
+    }
+    
+    if (seconds < WINDOW_SLOTS) seconds = WINDOW_SLOTS;
+    if (seconds > MAX_WINDOW_SECONDS) seconds = MAX_WINDOW_SECONDS;
+    
+    Window& window = windows[windowCount];
+    window.channel = channel;
+    window.fieldIndex = field - SENSOR_FIELDS;
+    window.seconds = seconds;
+    window.slotSeconds = (seconds + WINDOW_SLOTS - 1) / WINDOW_SLOTS;
+    window.slotCount = (seconds + window.slotSeconds - 1) / window.slotSeconds;
+    window.bucketSeconds = (seconds + QUANTILE_BUCKETS - 1) / QUANTILE_BUCKETS;
+    resetWindow(window);
+    
+    return windowCount++;
+}
+
+int8_t WindowedAggregator::findWindow(uint8_t channel, uint8_t sensorId, uint32_t seconds) const {
+    const SensorField* field = SensorFields::find(sensorId);
+    if (!field) return -1;
+    
+    for (uint8_t i = 0; i < windowCount; i++) {
+        const Window& window = windows[i];
+        if (window.channel == channel && window.fieldIndex == (uint8_t)(field - SENSOR_FIELDS) &&
+            (seconds == 0 || window.seconds == seconds)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void WindowedAggregator::resetWindow(Window& window) {
+    window.lastTimestamp = 0;
+    for (uint8_t i = 0; i < QUANTILE_BUCKETS; i++) {
+        window.bucketIds[i] = UINT32_MAX;
+        window.buckets[i].reset();
+    }
+    window.minDeque.reset(false);
+    window.maxDeque.reset(true);
+}
+
+void WindowedAggregator::update(const SensorReading& reading) {
+    const uint32_t timestamp = TimeUtils::toSeconds(reading.timestamp, reading.time_synced);
+    
+    for (uint8_t i = 0; i < windowCount; i++) {
+        Window& window = windows[i];
+        if (window.channel != reading.channel) continue;
+        
+        const SensorField& field = SENSOR_FIELDS[window.fieldIndex];
+        if (!SensorFields::hasValue(field, reading) || (reading.outlier_mask & (1 << window.fieldIndex))) {
+            continue;
+        }
+        
+        updateWindow(window, SensorFields::getValue(field, reading), timestamp);
+        if (mergedWindow == i) {
+            mergedWindow = -1;
+        }
+    }
+}
+
+void WindowedAggregator::updateWindow(Window& window, float value, uint32_t timestamp) {
+    // 時刻が戻った場合（NTP同期など）は窓を作り直す
+    if (timestamp < window.lastTimestamp) {
+        resetWindow(window);
+    }
+    window.lastTimestamp = timestamp;
+    
+    const uint32_t slot = timestamp / window.slotSeconds;
+    const uint32_t oldestSlot = slot >= window.slotCount ? slot - (window.slotCount - 1) : 0;
+    window.minDeque.expire(oldestSlot);
+    window.maxDeque.expire(oldestSlot);
+    window.minDeque.push(slot, value);
+    window.maxDeque.push(slot, value);
+    
+    const uint32_t bucketId = timestamp / window.bucketSeconds;
+    const uint8_t bucket = bucketId % QUANTILE_BUCKETS;
+    if (window.bucketIds[bucket] != bucketId) {
+        window.bucketIds[bucket] = bucketId;
+        window.buckets[bucket].reset();
+    }
+    window.buckets[bucket].add(value);
+}
+
+bool WindowedAggregator::isBucketLive(const Window& window, uint8_t bucket) const {
+    const uint32_t currentId = window.lastTimestamp / window.bucketSeconds;
+    const uint32_t id = window.bucketIds[bucket];
+    return id != UINT32_MAX && id <= currentId && currentId - id < QUANTILE_BUCKETS;
+}
+
+bool WindowedAggregator::getMin(uint8_t index, float& value) const {
+    if (index >= windowCount || windows[index].minDeque.empty()) return false;
+    value = windows[index].minDeque.front();
+    return true;
+}
+
+bool WindowedAggregator::getMax(uint8_t index, float& value) const {
+    if (index >= windowCount || windows[index].maxDeque.empty()) return false;
+    value = windows[index].maxDeque.front();
+    return true;
+}
+
+uint32_t WindowedAggregator::getCount(uint8_t index) const {
+    if (index >= windowCount) return 0;
+    
+    uint32_t total = 0;
+    for (uint8_t bucket = 0; bucket < QUANTILE_BUCKETS; bucket++) {
+        if (isBucketLive(windows[index], bucket)) {
+            total += windows[index].buckets[bucket].getCount();
+        }
+    }
+    return total;
+}
+
+bool WindowedAggregator::getQuantile(uint8_t index, float q, float& value) const {
+    if (index >= windowCount) return false;
+    
+    // 同じ窓への連続した問い合わせ（p50とp95など）ではマージ結果を使い回す
+    if (mergedWindow != (int8_t)index) {
+        merged.reset();
+        for (uint8_t bucket = 0; bucket < QUANTILE_BUCKETS; bucket++) {
+            if (isBucketLive(windows[index], bucket)) {
+                merged.merge(windows[index].buckets[bucket]);
+            }
+        }
+        mergedWindow = index;
+    }
+    
+    if (merged.getCount() == 0) return false;
+    value = merged.quantile(q);
+    return true;
+}
+
+String WindowedAggregator::getReport() const {
+    String report = "窓集計:\n";
+    for (uint8_t i = 0; i < windowCount; i++) {
+        const Window& window = windows[i];
+        report += "  ch" + String(window.channel) + " " + String(SENSOR_FIELDS[window.fieldIndex].column) + 
+                  " " + String(window.seconds / 60) + "分: ";
+        
+        float minValue, maxValue, p50, p95;
+        if (getMin(i, minValue) && getMax(i, maxValue) && getQuantile(i, 0.5f, p50) && getQuantile(i, 0.95f, p95)) {
+            report += String(getCount(i)) + "件 [" + String(minValue, 2) + "〜" + String(maxValue, 2) + 
+                      "] p50=" + String(p50, 2) + " p95=" + String(p95, 2) + "\n";
+        } else {
+            report += "データなし\n";
+        }
+    }
+    return report;
+}
\ No newline at end of file
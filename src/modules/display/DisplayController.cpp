@@ -4,134 +4,565 @@
 DisplayController::DisplayController() :
     currentPage(DisplayPage::SENSOR_DATA_1),
     lastPageChange(0),
-    touchPressed(false) {
+    touchPressed(false),
+    statsSource(nullptr),
+    windowSource(nullptr),
+    iaqWindow(-1),
+    trendSource(nullptr),
+    fieldCursor(0),
+    renderedPage(DisplayPage::SENSOR_DATA_1),
+    layoutValid(false),
+    canvas(&M5.Display),
+    canvasReady(false),
+    pushPending(false),
+    dirtyCount(0),
+    frameStartMicros(0),
+    pushedPixels(0),
+    composeStage("表示フレーム"),
+    pushWaitStage("DMA待ち"),
+    history(0),
+    graphField(0),
+    graphDrawnColumns(0),
+    graphLow(0.0f),
+    graphHigh(0.0f),
+    graphValid(false),
+    toastVisible(false),
+    toastSequence(0),
+    toastRepeats(0),
+    hasSensorData(false) {
+    pageStages[(uint8_t)DisplayPage::SENSOR_DATA_1].name = "環境データ描画";
+    pageStages[(uint8_t)DisplayPage::SENSOR_DATA_2].name = "空気質データ描画";
+    pageStages[(uint8_t)DisplayPage::STATUS].name = "システム状態描画";
+    pageStages[(uint8_t)DisplayPage::CONFIG].name = "設定描画";
+    pageStages[(uint8_t)DisplayPage::GRAPH].name = "グラフ描画";
+    memset(fields, 0, sizeof(fields));
+    memset(graphSegmentTop, GRAPH_NONE, sizeof(graphSegmentTop));
+    memset(graphSegmentBottom, GRAPH_NONE, sizeof(graphSegmentBottom));
+    memset(dirtyRects, 0, sizeof(dirtyRects));
 }
 
 DisplayController::~DisplayController() {
+    finishFrame();
+    if (canvasReady) {
+        canvas.deleteSprite();
+    }
 }
 
 void DisplayController::initialize() {
     // M5Stackディスプレイの初期設定
     M5.Display.setRotation(1);  // 横向き
     M5.Display.setTextSize(2);
-    clearScreen();
     
-    // 日本語フォントを設定
-    M5.Display.setFont(&fonts::lgfxJapanGothic_12);
+    // 画面全体のフレームバッファ（RGB565で150KB）をPSRAMに確保する
+    canvas.setColorDepth(16);
+    canvas.setPsram(true);
+    canvasReady = canvas.createSprite(SCREEN_WIDTH, SCREEN_HEIGHT) != nullptr;
+    if (canvasReady) {
+        canvas.setTextSize(2);
+        canvas.setFont(&fonts::lgfxJapanGothic_12);  // 日本語ゴシック体12px
+        M5.Display.initDMA();
+        // グリフはバッファから読み戻して保存するのでバッファがある時だけ使う
+        if (!glyphs.begin(canvas)) {
+            Serial.println("グリフキャッシュを確保できないためフォントで描画します");
+        }
+    } else {
+        ErrorHandler::logWarning(ErrorComponent::DISPLAY_MODULE, ErrorHandler::ERROR_DISPLAY_MODULE_INIT_FAILED,
+                                 "フレームバッファを確保できないためLCDへ直接描画します");
+    }
+    clearScreen();
     
     Serial.println("ディスプレイコントローラーを初期化しました");
 }
 
+LovyanGFX& DisplayController::surface() {
+    if (canvasReady) {
+        return canvas;
+    }
+    return M5.Display;
+}
+
+void DisplayController::markDirty(int x, int y, int width, int height) {
+    if (!canvasReady) return;  // 直接描画ではLCDに反映済み
+    
+    // 画面内に切り詰める
+    int left = x < 0 ? 0 : x;
+    int top = y < 0 ? 0 : y;
+    int right = x + width > SCREEN_WIDTH ? SCREEN_WIDTH : x + width;
+    int bottom = y + height > SCREEN_HEIGHT ? SCREEN_HEIGHT : y + height;
+    if (left >= right || top >= bottom) return;
+    
+    auto unite = [&](DirtyRect& rect) {
+        int unionLeft = left < rect.x ? left : rect.x;
+        int unionTop = top < rect.y ? top : rect.y;
+        int unionRight = right > rect.x + rect.width ? right : rect.x + rect.width;
+        int unionBottom = bottom > rect.y + rect.height ? bottom : rect.y + rect.height;
+        rect = {(int16_t)unionLeft, (int16_t)unionTop, (int16_t)(unionRight - unionLeft), (int16_t)(unionBottom - unionTop)};
+    };
+    
+    // 行が重なる矩形とは結合する（同じフィールドの描画と末尾消去は1つの矩形になる）
+    for (uint8_t i = 0; i < dirtyCount; i++) {
+        if (top < dirtyRects[i].y + dirtyRects[i].height && bottom > dirtyRects[i].y) {
+            unite(dirtyRects[i]);
+            return;
+        }
+    }
+    if (dirtyCount < MAX_DIRTY_RECTS) {
+        dirtyRects[dirtyCount++] = {(int16_t)left, (int16_t)top, (int16_t)(right - left), (int16_t)(bottom - top)};
+    } else {
+        unite(dirtyRects[dirtyCount - 1]);  // 上限を超えたら最後の矩形に含める
+    }
+}
+
+void DisplayController::pushFrame() {
+    if (canvasReady && dirtyCount > 0) {
+        // 矩形ごとにクリップしてバッファ全体をDMA転送する（クリップ範囲の行だけがDMAキューに積まれる）
+        // 転送完了を待たずに戻り、SPIのトランザクションはfinishFrame()で閉じる
+        const lgfx::swap565_t* pixels = (const lgfx::swap565_t*)canvas.getBuffer();
+        if (!pushPending) {
+            M5.Display.startWrite();
+            pushPending = true;
+        }
+        // 次の転送は前の転送の完了を待つため、最も大きい矩形を最後に回してCPUが待たされる時間を減らす
+        uint8_t largest = 0;
+        for (uint8_t i = 1; i < dirtyCount; i++) {
+            if ((int32_t)dirtyRects[i].width * dirtyRects[i].height > 
+                (int32_t)dirtyRects[largest].width * dirtyRects[largest].height) {
+                largest = i;
+            }
+        }
+        DirtyRect last = dirtyRects[largest];
+        dirtyRects[largest] = dirtyRects[dirtyCount - 1];
+        dirtyRects[dirtyCount - 1] = last;
+        
+        for (uint8_t i = 0; i < dirtyCount; i++) {
+            const DirtyRect& rect = dirtyRects[i];
+            M5.Display.setClipRect(rect.x, rect.y, rect.width, rect.height);
+            M5.Display.pushImageDMA(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, pixels);
+            pushedPixels += (uint32_t)rect.width * rect.height;
+        }
+        M5.Display.clearClipRect();
+        dirtyCount = 0;
+    }
+    composeStage.record(micros() - frameStartMicros);
+}
+
+void DisplayController::finishFrame() {
+    if (!pushPending) return;
+    
+    unsigned long start = micros();
+    M5.Display.waitDMA();
+    M5.Display.endWrite();
+    pushPending = false;
+    pushWaitStage.record(micros() - start);
+}
+
 void DisplayController::clearScreen() {
-    M5.Display.fillScreen(BLACK);  // 背景を黒で塗りつぶし
-    M5.Display.setFont(&fonts::lgfxJapanGothic_12);  // 日本語ゴシック体12px
+    finishFrame();  // 転送中のバッファを書き換えない
+    surface().fillScreen(BLACK);  // 背景を黒で塗りつぶし（フォントはinitialize()で設定済み）
+    markDirty(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    layoutValid = false;  // 画面上のフィールドは消えたので次のページ描画で描き直す
+    graphValid = false;
+}
+
+void DisplayController::beginPage(DisplayPage page) {
+    frameStartMicros = micros();
+    finishFrame();  // 前フレームの転送が残っていればバッファを書き換える前に完了させる
+    
+    // ページが変わった時（またはメッセージ表示で画面が消された後）だけ全画面を消去する
+    if (!layoutValid || renderedPage != page) {
+        clearScreen();
+        memset(fields, 0, sizeof(fields));
+        renderedPage = page;
+        layoutValid = true;
+    }
+    fieldCursor = 0;
+}
+
+void DisplayController::endPage() {
+    // 今回描画しなかった行（条件付きの注記など）が残っていれば背景色で消す
+    for (uint8_t i = fieldCursor; i < MAX_FIELDS; i++) {
+        if (fields[i].valid) {
+            eraseField(fields[i]);
+        }
+    }
+    pushFrame();
+    pageStages[(uint8_t)renderedPage].record(micros() - frameStartMicros);
+}
+
+void DisplayController::eraseField(FieldSlot& slot) {
+    slot.valid = false;
+    if (slot.width <= 0) return;
+    
+    // 消すのは行の外接矩形で、塗るのはページの背景色（ボタンの灰色背景を残さない）
+    LovyanGFX& gfx = surface();
+    const int height = gfx.fontHeight();
+    gfx.fillRect(slot.x, slot.y, slot.width, height, BLACK);
+    markDirty(slot.x, slot.y, slot.width, height);
+    
+    // 行が増減してフィールドの番号がずれると、古い矩形がこのページで描いたばかりの行に重なることがある。
+    // 重なった行は描き直す（先頭の変わらない部分は描き直さないので、画面上の内容を常に正しく保つ必要がある）
+    for (uint8_t i = 0; i < fieldCursor && i < MAX_FIELDS; i++) {
+        FieldSlot& other = fields[i];
+        if (&other == &slot || !other.valid) continue;
+        if (other.x >= slot.x + slot.width || other.x + other.width <= slot.x || 
+            other.y >= slot.y + height || other.y + height <= slot.y) continue;
+        if (other.cached) {
+            int16_t drawnX;
+            drawText(other.x, other.y, other.text, 0, other.color, other.background, drawnX);
+            markDirty(other.x, other.y, other.width, height);
+        } else {
+            other.valid = false;  // 文字列を記録していない行は次の描画で描き直す
+        }
+    }
+}
+
+void DisplayController::drawField(int x, int y, const String& text, uint32_t color, uint32_t background) {
+    if (fieldCursor >= MAX_FIELDS) {
+        // 想定外に行数が多い場合は差分管理せずに描画だけ行う
+        surface().setCursor(x, y);
+        surface().setTextColor(color, background);
+        surface().print(text);
+        markDirty(x, y, surface().textWidth(text), surface().fontHeight());
+        return;
+    }
+    
+    FieldSlot& slot = fields[fieldCursor++];
+    const size_t length = text.length();
+    const bool cacheable = length < sizeof(slot.text);
+    
+    if (slot.valid && slot.cached && slot.x == x && slot.y == y && 
+        slot.color == color && slot.background == background && 
+        memcmp(slot.text, text.c_str(), length + 1) == 0) {
+        return;  // 表示内容に変化なし
+    }
+    
+    // 位置や背景色が変わった場合は前回の矩形を消してから描く
+    if (slot.valid && (slot.x != x || slot.y != y || slot.background != background)) {
+        eraseField(slot);
+    }
+    
+    // 同じ位置・色で描いてある先頭部分（ラベルなど）は残し、最初に変わった文字から描き直す
+    size_t skip = 0;
+    if (slot.valid && slot.cached && slot.color == color) {
+        while (skip < length && slot.text[skip] == text[skip]) skip++;
+        while (skip > 0 && ((uint8_t)text[skip] & 0xC0) == 0x80) skip--;  // 文字の途中なら先頭バイトまで戻す
+    }
+    
+    // 文字セルの背景も塗る指定で上書きし、前回より短くなった分だけ末尾を背景色で消す
+    LovyanGFX& gfx = surface();
+    int16_t drawnX;
+    const int16_t width = drawText(x, y, text.c_str(), skip, color, background, drawnX);
+    if (slot.valid && slot.width > width) {
+        gfx.fillRect(x + width, y, slot.width - width, gfx.fontHeight(), background);
+    }
+    markDirty(drawnX, y, (slot.valid && slot.width > width ? slot.width : width) - (drawnX - x), gfx.fontHeight());
+    
+    slot.x = x;
+    slot.y = y;
+    slot.width = width;
+    slot.color = color;
+    slot.background = background;
+    slot.valid = true;
+    slot.cached = cacheable;  // 記録できない長さなら矩形だけ覚え、次回は比較せずに描き直す
+    if (cacheable) {
+        memcpy(slot.text, text.c_str(), length + 1);
+    }
+}
+
+int16_t DisplayController::drawText(int x, int y, const char* text, size_t skip, uint32_t color, uint32_t background, 
+                                    int16_t& drawnX) {
+    LovyanGFX& gfx = surface();
+    
+    if (!glyphs.isReady()) {
+        // キャッシュなし：先頭skipバイトの幅だけ進め、残りをフォントで描く
+        int cursor = x;
+        if (skip > 0) {
+            char prefix[sizeof(FieldSlot::text)];
+            memcpy(prefix, text, skip);
+            prefix[skip] = '\0';
+            cursor += gfx.textWidth(prefix);
+        }
+        drawnX = cursor;
+        gfx.setCursor(cursor, y);
+        gfx.setTextColor(color, background);
+        gfx.print(text + skip);
+        return cursor - x + gfx.textWidth(text + skip);
+    }
+    
+    // 1文字ずつキャッシュからコピーする（初めての文字だけフォントで描いて保存）
+    int cursor = x;
+    drawnX = -1;
+    const char* p = text;
+    while (*p) {
+        uint8_t bytes = GlyphCache::sequenceLength(*p);
+        for (uint8_t i = 1; i < bytes; i++) {
+            if (!p[i]) {
+                bytes = i;  // 途中で切れた文字
+                break;
+            }
+        }
+        if ((size_t)(p - text) < skip) {
+            cursor += glyphs.glyphWidth(gfx, p, bytes, color, background);
+        } else {
+            if (drawnX < 0) drawnX = cursor;
+            cursor += glyphs.drawGlyph(gfx, cursor, y, p, bytes, color, background);
+        }
+        p += bytes;
+    }
+    if (drawnX < 0) drawnX = cursor;
+    return cursor - x;
 }
 
 void DisplayController::lcdPrint(int y, const String& msg, uint32_t color) {
-    M5.Display.setCursor(5, y);  // 左マージンを5pxに
-    M5.Display.setTextColor(color, BLACK);
-    M5.Display.print(msg);
+    lcdPrint(5, y, msg, color);  // 左マージンを5pxに
 }
 
 void DisplayController::lcdPrint(int x, int y, const String& msg, uint32_t color) {
-    M5.Display.setCursor(x, y);
-    M5.Display.setTextColor(color, BLACK);
-    M5.Display.print(msg);
+    surface().setCursor(x, y);
+    surface().setTextColor(color, BLACK);
+    surface().print(msg);
+    markDirty(x, y, surface().textWidth(msg), surface().fontHeight());
 }
 
 void DisplayController::showSensorData(const SensorReading& data, DisplayPage page) {
     lastSensorData = data;
+    hasSensorData = true;
+    history.update(data);
+    
+    // メッセージ表示中は値だけ保持し、表示が終わった時点で描き直す
+    if (toastVisible) return;
     
     // 現在のページに応じてデータを表示
     if (page == DisplayPage::SENSOR_DATA_1) {
         renderSensorDataPage1();
     } else if (page == DisplayPage::SENSOR_DATA_2) {
         renderSensorDataPage2();
+    } else if (page == DisplayPage::GRAPH) {
+        renderGraphPage();
     }
 }
 
 void DisplayController::renderSensorDataPage1() {
-    clearScreen();
+    beginPage(DisplayPage::SENSOR_DATA_1);
     
     int y = 15;  // 上部マージン
     
     // ページヘッダー
-    lcdPrint(y, "環境データ (1/2)", CYAN);
+    drawField(5, y, "環境データ (1/3)", CYAN);
     y += LINE_HEIGHT + 4;
     
     // センサーデータを表示
-    lcdPrint(y, "温度: " + String(lastSensorData.temperature, 1) + "℃", WHITE);
+    drawField(5, y, "温度: " + String(lastSensorData.temperature, 1) + "℃", WHITE);
+    y += LINE_HEIGHT;
+    drawField(5, y, "湿度: " + String(lastSensorData.humidity, 1) + "%", WHITE);
     y += LINE_HEIGHT;
-    lcdPrint(y, "湿度: " + String(lastSensorData.humidity, 1) + "%", WHITE);
+    // 気圧は1時間あたりの傾向を添える（天気の変化の目安）
+    String pressureText = "気圧: " + String(lastSensorData.pressure, 0) + "hPa";
+    float pressureSlope;
+    if (trendSource && trendSource->getSlope(lastSensorData.channel, BSEC_OUTPUT_RAW_PRESSURE, pressureSlope)) {
+        pressureText += " (" + String(pressureSlope >= 0 ? "+" : "") + String(pressureSlope, 1) + "/h)";
+    }
+    drawField(5, y, pressureText, WHITE);
     y += LINE_HEIGHT;
-    lcdPrint(y, "気圧: " + String(lastSensorData.pressure, 0) + "hPa", WHITE);
+    drawField(5, y, "CO2: " + String(lastSensorData.co2_equivalent, 0) + "ppm", WHITE);
     y += LINE_HEIGHT;
-    lcdPrint(y, "CO2: " + String(lastSensorData.co2_equivalent, 0) + "ppm", WHITE);
+    
+    // 起動後の温度範囲（逐次統計から定数時間で取得）
+    const RunningStats* temperature = statsSource ? 
+        statsSource->get(lastSensorData.channel, BSEC_OUTPUT_RAW_TEMPERATURE) : nullptr;
+    if (temperature) {
+        drawField(5, y, "範囲: " + String(temperature->minValue, 1) + "〜" + String(temperature->maxValue, 1) + 
+                 "℃ 平均" + String(temperature->getMean(), 1), DARKGREY);
+    }
     
     drawPageFooter();
+    endPage();
 }
 
 void DisplayController::renderSensorDataPage2() {
-    clearScreen();
+    beginPage(DisplayPage::SENSOR_DATA_2);
     
     int y = 15;  // 上部マージン
     
     // ページヘッダー
-    lcdPrint(y, "空気質データ (2/2)", CYAN);
+    drawField(5, y, "空気質データ (2/3)", CYAN);
     y += LINE_HEIGHT + 4;
     
     // 空気質データを表示
-    lcdPrint(y, "空気質: " + String(lastSensorData.iaq, 0), WHITE);
+    drawField(5, y, "空気質: " + String(lastSensorData.iaq, 0), WHITE);
     y += LINE_HEIGHT;
-    lcdPrint(y, "VOC: " + String(lastSensorData.voc_equivalent, 1) + "ppm", WHITE);
+    drawField(5, y, "VOC: " + String(lastSensorData.voc_equivalent, 1) + "ppm", WHITE);
     y += LINE_HEIGHT;
-    lcdPrint(y, "状態: " + String(lastSensorData.stabilized ? "安定" : "調整中"), WHITE);
+    drawField(5, y, "状態: " + String(lastSensorData.stabilized ? "安定" : "調整中"), WHITE);
     y += LINE_HEIGHT;
-    lcdPrint(y, "慣らし: " + String(lastSensorData.runin_status, 0) + "%", WHITE);
+    drawField(5, y, "慣らし: " + String(lastSensorData.runin_status, 0) + "%", WHITE);
     y += LINE_HEIGHT;
     
     // 慣らしの説明を追加
     if (lastSensorData.runin_status < 50) {
-        lcdPrint(y, "※長期慣らし運転中", YELLOW);
+        drawField(5, y, "※長期慣らし運転中", YELLOW);
+        y += LINE_HEIGHT;
+    }
+    
+    // 直近24時間のIAQ 95パーセンタイル
+    float iaqP95;
+    if (windowSource && iaqWindow >= 0 && windowSource->getQuantile(iaqWindow, 0.95f, iaqP95)) {
+        drawField(5, y, "空気質95%(24h): " + String(iaqP95, 0), DARKGREY);
     }
     
     drawPageFooter();
+    endPage();
 }
 
 void DisplayController::drawPageFooter() {
     int y = SCREEN_HEIGHT - 50;
     
     // ページ切り替えボタン
-    String buttonText = (currentPage == DisplayPage::SENSOR_DATA_1) ? "次へ >" : "< 前へ";
+    String buttonText = (currentPage == DisplayPage::GRAPH) ? "< 最初へ" : "次へ >";
     int buttonX = 240;  // 右端から余裕を持たせる
     
-    M5.Display.setTextColor(WHITE, DARKGREY);  // 白文字、グレー背景
-    M5.Display.setCursor(buttonX, y);
-    M5.Display.print(buttonText);
+    drawField(buttonX, y, buttonText, WHITE, DARKGREY);  // 白文字、グレー背景
     
     // ページインジケーター（左下）
-    int pageNum = (currentPage == DisplayPage::SENSOR_DATA_1) ? 1 : 2;
-    lcdPrint(10, y, "ページ " + String(pageNum) + "/2", GREEN);
+    int pageNum = (currentPage == DisplayPage::SENSOR_DATA_1) ? 1 : (currentPage == DisplayPage::SENSOR_DATA_2) ? 2 : 3;
+    drawField(10, y, "ページ " + String(pageNum) + "/3", GREEN);
     
     // タイムスタンプ（左下）
     y += 20;
-    lcdPrint(10, y, "更新: " + String(millis()/1000) + "秒", YELLOW);
+    drawField(10, y, "更新: " + String(millis()/1000) + "秒", YELLOW);
+}
+
+void DisplayController::renderGraphPage() {
+    beginPage(DisplayPage::GRAPH);
+    
+    const GraphField& graph = GRAPH_FIELDS[graphField];
+    const SensorField* field = SensorFields::find(graph.sensorId);
+    const char* unit = field ? field->unit : "";
+    
+    int y = 15;
+    drawField(5, y, String("推移: ") + graph.label + " (3/3)", CYAN);
+    y += LINE_HEIGHT + 4;
+    
+    float low, high, latest;
+    uint16_t visible = history.size() < GRAPH_WIDTH ? history.size() : GRAPH_WIDTH;
+    if (!history.getRange(graphField, visible, low, high) || !history.getColumn(graphField, 0, latest)) {
+        drawField(5, y, "データ収集中...", DARKGREY);
+        drawPageFooter();
+        endPage();
+        return;
+    }
+    
+    // 範囲外に出た時、またはデータが範囲の半分未満に縮んだ時だけ縦軸を決め直す（全体を再描画）
+    float span = high - low > graph.minSpan ? high - low : graph.minSpan;
+    bool rescale = !graphValid || low < graphLow || high > graphHigh ||
+                   span * 1.2f < (graphHigh - graphLow) * 0.5f;
+    if (rescale) {
+        float middle = (high + low) * 0.5f;
+        graphLow = middle - span * 0.6f;
+        graphHigh = middle + span * 0.6f;
+    }
+    drawField(5, y, "直近 " + String(latest, 1) + unit + "  範囲 " + String(graphLow, 1) + "〜" + String(graphHigh, 1), WHITE);
+    
+    // 列が増えた時だけ線を更新する（縦軸を決め直した場合は背景から描き直す）
+    if (rescale || history.getColumnCount() != graphDrawnColumns) {
+        drawGraph(rescale);
+    }
+    graphDrawnColumns = history.getColumnCount();
+    
+    drawPageFooter();
+    endPage();
+}
+
+void DisplayController::drawGraph(bool replot) {
+    LovyanGFX& gfx = surface();
+    if (replot) {
+        gfx.drawRect(GRAPH_X - 1, GRAPH_Y - 1, GRAPH_WIDTH + 2, GRAPH_HEIGHT + 2, DARKGREY);
+        gfx.fillRect(GRAPH_X, GRAPH_Y, GRAPH_WIDTH, GRAPH_HEIGHT, BLACK);
+        memset(graphSegmentTop, GRAPH_NONE, sizeof(graphSegmentTop));
+        memset(graphSegmentBottom, GRAPH_NONE, sizeof(graphSegmentBottom));
+        markDirty(GRAPH_X - 1, GRAPH_Y - 1, GRAPH_WIDTH + 2, GRAPH_HEIGHT + 2);
+    }
+    
+    // 列が増えると線全体が左へずれるが、画素を移動したり背景を塗り直したりはせず、
+    // 画面の列ごとに前回描いた線分と今回の線分を比べて、違う画素だけを消す・描く
+    int changedLeft = GRAPH_WIDTH, changedRight = -1, changedTop = GRAPH_HEIGHT, changedBottom = -1;
+    auto drawSpan = [&](int x, int from, int to, uint32_t color) {
+        if (from > to) return;
+        gfx.drawFastVLine(GRAPH_X + x, GRAPH_Y + from, to - from + 1, color);
+        if (x < changedLeft) changedLeft = x;
+        if (x > changedRight) changedRight = x;
+        if (from < changedTop) changedTop = from;
+        if (to > changedBottom) changedBottom = to;
+    };
+    
+    // 最新の列を右端に置き、左端は画面外の列から線をつなぐ
+    uint16_t count = history.size() < GRAPH_WIDTH ? history.size() : GRAPH_WIDTH;
+    int previousRow = -1;
+    float value;
+    if (history.getColumn(graphField, count, value)) {
+        previousRow = graphRow(value);
+    }
+    for (int x = 0; x < GRAPH_WIDTH; x++) {
+        uint16_t ago = GRAPH_WIDTH - 1 - x;
+        int top = GRAPH_NONE, bottom = GRAPH_NONE;
+        if (ago < count) {
+            if (history.getColumn(graphField, ago, value)) {
+                // 前の列の高さから今回の高さまでを縦線でつなぐ
+                int row = graphRow(value);
+                top = (previousRow >= 0 && previousRow < row) ? previousRow : row;
+                bottom = (previousRow >= 0 && previousRow > row) ? previousRow : row;
+                previousRow = row;
+            } else {
+                previousRow = -1;
+            }
+        }
+        
+        int oldTop = graphSegmentTop[x], oldBottom = graphSegmentBottom[x];
+        if (top == oldTop && bottom == oldBottom) continue;
+        
+        if (oldTop == GRAPH_NONE) {
+            drawSpan(x, top, bottom, CYAN);
+        } else if (top == GRAPH_NONE) {
+            drawSpan(x, oldTop, oldBottom, BLACK);
+        } else {
+            // 前回の線分のうち今回の線分から外れる部分を消し、新たにはみ出す部分だけを描く
+            drawSpan(x, oldTop, (oldBottom < top - 1 ? oldBottom : top - 1), BLACK);
+            drawSpan(x, (oldTop > bottom + 1 ? oldTop : bottom + 1), oldBottom, BLACK);
+            drawSpan(x, top, (bottom < oldTop - 1 ? bottom : oldTop - 1), CYAN);
+            drawSpan(x, (top > oldBottom + 1 ? top : oldBottom + 1), bottom, CYAN);
+        }
+        graphSegmentTop[x] = (uint8_t)top;
+        graphSegmentBottom[x] = (uint8_t)bottom;
+    }
+    
+    if (changedRight >= 0) {
+        markDirty(GRAPH_X + changedLeft, GRAPH_Y + changedTop, 
+                  changedRight - changedLeft + 1, changedBottom - changedTop + 1);
+    }
+    graphValid = true;
+}
+
+int DisplayController::graphRow(float value) const {
+    int row = GRAPH_HEIGHT - 1 - (int)lroundf((value - graphLow) / (graphHigh - graphLow) * (GRAPH_HEIGHT - 1));
+    return constrain(row, 0, GRAPH_HEIGHT - 1);
 }
 
 void DisplayController::showStatus(const SystemStatus& status) {
     lastSystemStatus = status;
-    renderStatusPage();
+    if (!toastVisible) {
+        renderStatusPage();
+    }
 }
 
 void DisplayController::renderStatusPage() {
-    clearScreen();
+    beginPage(DisplayPage::STATUS);
     
     int y = 15;
-    lcdPrint(y, "システム状態", CYAN);
+    drawField(5, y, "システム状態", CYAN);
     y += LINE_HEIGHT + 4;
     
     // システム状態を表示
-    lcdPrint(y, "センサー: " + String(lastSystemStatus.sensor_healthy ? "正常" : "エラー"), 
+    drawField(5, y, "センサー: " + String(lastSystemStatus.sensor_healthy ? "正常" : "エラー"), 
              lastSystemStatus.sensor_healthy ? GREEN : RED);
     y += LINE_HEIGHT;
     
@@ -151,18 +582,56 @@ void DisplayController::renderStatusPage() {
             connColor = RED;
             break;
     }
-    lcdPrint(y, "ネットワーク: " + connStatus, connColor);
+    drawField(5, y, "ネットワーク: " + connStatus, connColor);
     y += LINE_HEIGHT;
     
-    lcdPrint(y, "ストレージ: " + String(lastSystemStatus.storage_usage_percent) + "%", WHITE);
+    drawField(5, y, "ストレージ: " + String(lastSystemStatus.storage_usage_percent) + "%", WHITE);
     y += LINE_HEIGHT;
-    lcdPrint(y, "バッテリー: " + String(lastSystemStatus.battery_level) + "%", WHITE);
+    drawField(5, y, "バッテリー: " + String(lastSystemStatus.battery_level) + "%", WHITE);
     y += LINE_HEIGHT;
-    lcdPrint(y, "稼働時間: " + String(lastSystemStatus.uptime_seconds) + "秒", WHITE);
+    drawField(5, y, "稼働時間: " + String(lastSystemStatus.uptime_seconds) + "秒", WHITE);
+    
+    endPage();
 }
 
 void DisplayController::update() {
+    finishFrame();
     handleTouch();
+    updateToasts();
+}
+
+void DisplayController::updateToasts() {
+    const Toast* toast = toasts.update(millis());
+    
+    if (toast) {
+        // 新しいメッセージ、またはまとめられた回数が変わった時だけ描き直す
+        if (toastVisible && toast->sequence == toastSequence && toast->repeats == toastRepeats) {
+            return;
+        }
+        frameStartMicros = micros();
+        clearScreen();
+        String text = toast->text;
+        if (toast->repeats > 1) {
+            text += " (x" + String(toast->repeats) + ")";
+        }
+        lcdPrint(SCREEN_HEIGHT / 2 - 10, text, toast->color);
+        pushFrame();
+        finishFrame();
+        
+        toastVisible = true;
+        toastSequence = toast->sequence;
+        toastRepeats = toast->repeats;
+    } else if (toastVisible) {
+        // 表示時間が過ぎたら元のページを描き直す（画面は消去済みなので全体が描かれる）
+        toastVisible = false;
+        if (hasSensorData || currentPage == DisplayPage::STATUS) {
+            renderCurrentPage();
+        } else {
+            clearScreen();
+            pushFrame();
+        }
+        finishFrame();
+    }
 }
 
 void DisplayController::handleTouch() {
@@ -174,10 +643,12 @@ void DisplayController::handleTouch() {
             
             // 画面右半分のタッチでページ切り替え
             if (touch.x > SCREEN_WIDTH / 2 && millis() - lastPageChange > TOUCH_DEBOUNCE_MS) {
-                // センサーデータページ間の切り替え
+                // センサーデータ1 → センサーデータ2 → グラフ → センサーデータ1
                 if (currentPage == DisplayPage::SENSOR_DATA_1) {
                     currentPage = DisplayPage::SENSOR_DATA_2;
                 } else if (currentPage == DisplayPage::SENSOR_DATA_2) {
+                    currentPage = DisplayPage::GRAPH;
+                } else if (currentPage == DisplayPage::GRAPH) {
                     currentPage = DisplayPage::SENSOR_DATA_1;
                 }
                 
@@ -185,13 +656,24 @@ void DisplayController::handleTouch() {
                 touchPressed = true;
                 
                 // 現在のページを再描画
-                if (currentPage == DisplayPage::SENSOR_DATA_1) {
-                    renderSensorDataPage1();
-                } else {
-                    renderSensorDataPage2();
+                if (!toastVisible) {
+                    renderCurrentPage();
+                    finishFrame();
                 }
                 
                 Serial.println("ページを切り替えました: " + String((int)currentPage + 1));
+            } else if (currentPage == DisplayPage::GRAPH && touch.x <= SCREEN_WIDTH / 2 && 
+                       millis() - lastPageChange > TOUCH_DEBOUNCE_MS) {
+                // グラフページでは左半分のタッチで表示項目を切り替える
+                graphField = (graphField + 1) % HistoryGraph::FIELD_COUNT;
+                graphValid = false;
+                lastPageChange = millis();
+                touchPressed = true;
+                
+                if (!toastVisible) {
+                    renderGraphPage();
+                    finishFrame();
+                }
             }
         }
     } else {
@@ -199,22 +681,64 @@ void DisplayController::handleTouch() {
     }
 }
 
+void DisplayController::renderCurrentPage() {
+    switch (currentPage) {
+        case DisplayPage::SENSOR_DATA_1:
+            renderSensorDataPage1();
+            break;
+        case DisplayPage::SENSOR_DATA_2:
+            renderSensorDataPage2();
+            break;
+        case DisplayPage::GRAPH:
+            renderGraphPage();
+            break;
+        case DisplayPage::STATUS:
+            renderStatusPage();
+            break;
+        default:
+            break;
+    }
+}
+
 void DisplayController::setCurrentPage(DisplayPage page) {
     currentPage = page;
 }
 
-void DisplayController::showMessage(const String& message, uint32_t color, uint32_t duration) {
-    clearScreen();
-    lcdPrint(SCREEN_HEIGHT / 2 - 10, message, color);
-    delay(duration);
+void DisplayController::showMessage(const String& message, uint32_t color, uint32_t duration, ToastPriority priority) {
+    if (!toasts.push(message.c_str(), color, priority, duration, millis())) {
+        Serial.println("表示待ちのメッセージが多いため破棄しました: " + message);
+        return;
+    }
+    // 初期化中などupdate()が呼ばれない間も見えるように、ここで一度表示を更新する
+    updateToasts();
 }
 
 void DisplayController::showError(const String& error) {
-    showMessage("エラー: " + error, RED, 3000);
+    showMessage("エラー: " + error, RED, 3000, ToastPriority::ERROR);
 }
 
 void DisplayController::showWarning(const String& warning) {
-    showMessage("警告: " + warning, YELLOW, 2000);
+    showMessage("警告: " + warning, YELLOW, 2000, ToastPriority::WARNING);
+}
+
+String DisplayController::getFrameReport() const {
+    String report = composeStage.toString() + "\n";
+    report += pushWaitStage.toString() + "\n";
+    report += "表示転送: " + String(canvasReady ? "PSRAMバッファ+DMA" : "直接描画");
+    if (composeStage.count > 0) {
+        report += ", 平均" + String((uint32_t)(pushedPixels / composeStage.count)) + "画素/フレーム";
+    }
+    for (uint8_t i = 0; i < PAGE_COUNT; i++) {
+        if (pageStages[i].count > 0) {
+            report += "\n" + pageStages[i].toString();
+        }
+    }
+    if (glyphs.isReady()) {
+        report += "\nグリフキャッシュ: " + String(glyphs.size()) + "/" + String(GlyphCache::CAPACITY) + 
+                  "文字, ヒット" + String(glyphs.getHits()) + "回, 描画" + String(glyphs.getMisses()) + 
+                  "回, 入れ替え" + String(glyphs.getEvictions()) + "回";
+    }
+    return report;
 }
 
 void DisplayController::setBrightness(uint8_t brightness) {
@@ -0,0 +1,169 @@
+#include "GlyphCache.h"
+#include <esp_heap_caps.h>
+
+GlyphCache::GlyphCache() :
+    pixels(nullptr),
+    cellWidth(0),
+    cellHeight(0),
+    used(0),
+    clock(0),
+    hits(0),
+    misses(0),
+    evictions(0) {
+    clear();
+}
+
+GlyphCache::~GlyphCache() {
+    end();
+}
+
+bool GlyphCache::begin(LovyanGFX& target) {
+    end();
+    
+    // 全角文字の送り幅とフォントの高さを1セルとする（半角はセルの左側だけを使う）
+    int32_t width = target.textWidth("あ");
+    int32_t height = target.fontHeight();
+    if (width <= 0 || height <= 0 || width > UINT8_MAX || height > UINT8_MAX) {
+        return false;
+    }
+    cellWidth = (uint8_t)width;
+    cellHeight = (uint8_t)height;
+    
+    pixels = (lgfx::swap565_t*)heap_caps_malloc((size_t)CAPACITY * cellWidth * cellHeight * sizeof(lgfx::swap565_t),
+                                                MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    clear();
+    return pixels != nullptr;
+}
+
+void GlyphCache::end() {
+    if (pixels) {
+        heap_caps_free(pixels);
+        pixels = nullptr;
+    }
+    clear();
+}
+
+void GlyphCache::clear() {
+    memset(entries, 0, sizeof(entries));
+    for (uint8_t i = 0; i < BUCKET_COUNT; i++) {
+        buckets[i] = -1;
+    }
+    used = 0;
+}
+
+uint8_t GlyphCache::sequenceLength(uint8_t leadByte) {
+    if (leadByte < 0x80) return 1;
+    if (leadByte >= 0xF0) return 4;
+    if (leadByte >= 0xE0) return 3;
+    if (leadByte >= 0xC0) return 2;
+    return 1;  // 継続バイト（不正な列）は1バイトずつ進める
+}
+
+uint8_t GlyphCache::bucketOf(uint32_t codepoint, uint32_t color, uint32_t background) {
+    uint32_t hash = codepoint * 2654435761u ^ color * 40503u ^ background * 97u;
+    return (uint8_t)((hash >> 16) % BUCKET_COUNT);
+}
+
+int16_t GlyphCache::find(uint32_t codepoint, uint32_t color, uint32_t background) const {
+    for (int16_t i = buckets[bucketOf(codepoint, color, background)]; i >= 0; i = entries[i].next) {
+        const Entry& entry = entries[i];
+        if (entry.codepoint == codepoint && entry.color == color && entry.background == background) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void GlyphCache::unlink(int16_t index) {
+    Entry& entry = entries[index];
+    int16_t* link = &buckets[bucketOf(entry.codepoint, entry.color, entry.background)];
+    while (*link >= 0 && *link != index) {
+        link = &entries[*link].next;
+    }
+    if (*link == index) {
+        *link = entry.next;
+    }
+    entry.valid = false;
+}
+
+int16_t GlyphCache::allocate(uint32_t codepoint, uint32_t color, uint32_t background) {
+    int16_t index;
+    if (used < CAPACITY) {
+        index = used++;
+    } else {
+        // 満杯なら最も長く使われていないセルを入れ替える（ページの文字は全て入るので稀）
+        index = 0;
+        for (int16_t i = 1; i < CAPACITY; i++) {
+            if (entries[i].lastUsed < entries[index].lastUsed) {
+                index = i;
+            }
+        }
+        unlink(index);
+        evictions++;
+    }
+    
+    Entry& entry = entries[index];
+    uint8_t bucket = bucketOf(codepoint, color, background);
+    entry.codepoint = codepoint;
+    entry.color = color;
+    entry.background = background;
+    entry.lastUsed = clock;
+    entry.next = buckets[bucket];
+    entry.valid = true;
+    buckets[bucket] = index;
+    return index;
+}
+
+static uint32_t decodeGlyph(const char* glyph, uint8_t bytes) {
+    uint32_t codepoint = (uint8_t)glyph[0];
+    if (bytes > 1) {
+        codepoint &= 0x3F >> (bytes - 1);
+        for (uint8_t i = 1; i < bytes; i++) {
+            codepoint = (codepoint << 6) | ((uint8_t)glyph[i] & 0x3F);
+        }
+    }
+    return codepoint;
+}
+
+int16_t GlyphCache::drawGlyph(LovyanGFX& target, int x, int y, const char* glyph, uint8_t bytes,
+                              uint32_t color, uint32_t background) {
+    const uint32_t codepoint = decodeGlyph(glyph, bytes);
+    clock++;
+    
+    int16_t index = pixels ? find(codepoint, color, background) : -1;
+    if (index >= 0) {
+        Entry& entry = entries[index];
+        entry.lastUsed = clock;
+        target.pushImage(x, y, entry.width, cellHeight, cell(index));
+        hits++;
+        return entry.width;
+    }
+    
+    // フォントで描き、描いた範囲を読み戻して保存する（drawStringは右端で折り返さない）
+    char text[5];
+    memcpy(text, glyph, bytes);
+    text[bytes] = '\0';
+    target.setTextColor(color, background);
+    int32_t width = target.drawString(text, x, y);
+    misses++;
+    
+    // 画面からはみ出した文字やセルに収まらない文字は保存しない
+    if (pixels && width > 0 && width <= cellWidth && x >= 0 && y >= 0 &&
+        x + width <= target.width() && y + cellHeight <= target.height()) {
+        index = allocate(codepoint, color, background);
+        entries[index].width = (uint8_t)width;
+        target.readRect(x, y, width, cellHeight, cell(index));
+    }
+    return (int16_t)width;
+}
+
+int16_t GlyphCache::glyphWidth(LovyanGFX& target, const char* glyph, uint8_t bytes, uint32_t color, uint32_t background) {
+    int16_t index = pixels ? find(decodeGlyph(glyph, bytes), color, background) : -1;
+    if (index >= 0) {
+        return entries[index].width;
+    }
+    char text[5];
+    memcpy(text, glyph, bytes);
+    text[bytes] = '\0';
+    return (int16_t)target.textWidth(text);
+}
\ No newline at end of file
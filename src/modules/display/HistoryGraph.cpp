@@ -0,0 +1,134 @@
+#include "HistoryGraph.h"
+#include <math.h>
+
+HistoryGraph::HistoryGraph(uint8_t channelId, uint8_t samples) :
+    channel(channelId),
+    samplesPerColumn(samples) {
+    setSamplesPerColumn(samples);
+}
+
+void HistoryGraph::setChannel(uint8_t channelId) {
+    channel = channelId;
+    reset();
+}
+
+void HistoryGraph::setSamplesPerColumn(uint8_t samples) {
+    if (samples < 1) samples = 1;
+    if (samples > MAX_SAMPLES_PER_COLUMN) samples = MAX_SAMPLES_PER_COLUMN;
+    samplesPerColumn = samples;
+    reset();
+}
+
+void HistoryGraph::reset() {
+    sampleCount = 0;
+    pendingReady = false;
+    head = 0;
+    columnCount = 0;
+    for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+        FieldState& state = fields[f];
+        state.currentSum = 0.0f;
+        state.currentValid = 0;
+        state.anchor = NAN;
+        state.anchorOffset = 0;
+        state.lastValue = 0.0f;
+        state.hasValue = false;
+    }
+}
+
+void HistoryGraph::update(const SensorReading& reading) {
+    if (reading.channel != channel) return;
+    
+    for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+        FieldState& state = fields[f];
+        const SensorField* field = SensorFields::find(GRAPH_FIELDS[f].sensorId);
+        int8_t bit = SENSOR_FIELD_INDEX.index[GRAPH_FIELDS[f].sensorId];
+        
+        if (field && SensorFields::hasValue(*field, reading) && !(reading.outlier_mask & (1u << bit))) {
+            state.lastValue = SensorFields::getValue(*field, reading);
+            state.hasValue = true;
+        }
+        // 最初の値が得られるまでは欠測（NAN）として列を空ける
+        if (state.hasValue) {
+            state.current[sampleCount] = state.lastValue;
+            state.currentSum += state.lastValue;
+            state.currentValid++;
+        } else {
+            state.current[sampleCount] = NAN;
+        }
+    }
+    
+    if (++sampleCount >= samplesPerColumn) {
+        closeBucket();
+    }
+}
+
+void HistoryGraph::closeBucket() {
+    const uint8_t n = samplesPerColumn;
+    
+    if (pendingReady) {
+        // 点の位置は区間内の読み取り番号（pending区間の先頭を0とする）
+        const float nextX = n + (n - 1) * 0.5f;
+        for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+            FieldState& state = fields[f];
+            const float nextY = state.currentValid ? state.currentSum / state.currentValid : state.anchor;
+            const float anchorX = (float)state.anchorOffset - n;
+            const bool triangle = !isnan(state.anchor) && !isnan(nextY);
+            
+            // 直前の点がなければ区間内の最初の値を使う
+            int8_t best = -1;
+            float bestArea = -1.0f;
+            for (uint8_t i = 0; i < n; i++) {
+                if (isnan(state.pending[i])) continue;
+                if (!triangle) {
+                    best = i;
+                    break;
+                }
+                float area = fabsf((anchorX - nextX) * (state.pending[i] - state.anchor) -
+                                   (anchorX - i) * (nextY - state.anchor));
+                if (area > bestArea) {
+                    bestArea = area;
+                    best = i;
+                }
+            }
+            if (best >= 0) {
+                state.anchor = state.pending[best];
+                state.anchorOffset = best;
+            }
+            state.columns[head] = best >= 0 ? state.pending[best] : NAN;
+        }
+        head = (head + 1) % MAX_COLUMNS;
+        columnCount++;
+    }
+    
+    // 読み取り中の区間を確定待ちへ移す
+    for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+        FieldState& state = fields[f];
+        memcpy(state.pending, state.current, sizeof(float) * n);
+        state.currentSum = 0.0f;
+        state.currentValid = 0;
+    }
+    pendingReady = true;
+    sampleCount = 0;
+}
+
+bool HistoryGraph::getColumn(uint8_t fieldIndex, uint16_t ago, float& value) const {
+    if (fieldIndex >= FIELD_COUNT || ago >= size()) return false;
+    value = fields[fieldIndex].columns[(head + MAX_COLUMNS - 1 - ago) % MAX_COLUMNS];
+    return !isnan(value);
+}
+
+bool HistoryGraph::getRange(uint8_t fieldIndex, uint16_t count, float& low, float& high) const {
+    if (count > size()) count = size();
+    if (fieldIndex >= FIELD_COUNT) return false;
+    
+    const float* columns = fields[fieldIndex].columns;
+    bool found = false;
+    for (uint16_t ago = 0; ago < count; ago++) {
+        float value = columns[(head + MAX_COLUMNS - 1 - ago) % MAX_COLUMNS];
+        if (isnan(value)) continue;
+        if (!found || value < low) low = value;
+        if (!found || value > high) high = value;
+        found = true;
+    }
+    return found;
+}
\ No newline at end of file
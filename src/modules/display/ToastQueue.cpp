@@ -0,0 +1,121 @@
+#include "ToastQueue.h"
+
+ToastQueue::ToastQueue() :
+    count(0),
+    nextSequence(0),
+    droppedCount(0),
+    displaying(false),
+    displayedSequence(0) {
+}
+
+void ToastQueue::removeAt(uint8_t index) {
+    for (uint8_t i = index; i + 1 < count; i++) {
+        entries[i] = entries[i + 1];
+    }
+    count--;
+}
+
+bool ToastQueue::push(const char* text, uint32_t color, ToastPriority priority, uint32_t durationMs, unsigned long now) {
+    // 同じメッセージはまとめる（エラーが繰り返されても画面が埋まらないように）
+    for (uint8_t i = 0; i < count; i++) {
+        Toast& toast = entries[i];
+        if (toast.color == color && strncmp(toast.text, text, Toast::TEXT_SIZE - 1) == 0) {
+            if (toast.repeats < UINT16_MAX) toast.repeats++;
+            if (priority > toast.priority) toast.priority = priority;
+            if (durationMs > toast.durationMs) toast.durationMs = durationMs;
+            if (toast.shown) {
+                // 表示したことがあれば今から改めて表示時間を数える
+                toast.displayedMs = 0;
+                toast.shownAt = now;
+            }
+            return true;
+        }
+    }
+    
+    if (count >= CAPACITY) {
+        // 表示待ちの中で優先度が最も低く最も古いものを押し出す
+        // 表示中・割り込まれて中断しているものは途中で消えないよう対象にしない
+        int8_t victim = -1;
+        for (uint8_t i = 0; i < count; i++) {
+            if (entries[i].shown || entries[i].priority > priority) continue;
+            if (victim < 0 || entries[i].priority < entries[victim].priority ||
+                (entries[i].priority == entries[victim].priority && entries[i].sequence < entries[victim].sequence)) {
+                victim = i;
+            }
+        }
+        droppedCount++;
+        if (victim < 0) {
+            return false;
+        }
+        removeAt(victim);
+    }
+    
+    Toast& toast = entries[count++];
+    snprintf(toast.text, sizeof(toast.text), "%s", text);
+    // 切り詰めた場合はUTF-8の文字の途中で終わらないように、最後の不完全な文字を落とす
+    size_t length = strlen(toast.text);
+    if (length == sizeof(toast.text) - 1) {
+        size_t lead = length;
+        while (lead > 0 && ((uint8_t)toast.text[lead - 1] & 0xC0) == 0x80) {
+            lead--;
+        }
+        if (lead > 0) {
+            uint8_t c = (uint8_t)toast.text[lead - 1];
+            size_t bytes = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+            if (lead - 1 + bytes > length) {
+                toast.text[lead - 1] = '\0';
+            }
+        }
+    }
+    toast.color = color;
+    toast.priority = priority;
+    toast.repeats = 1;
+    toast.durationMs = durationMs;
+    toast.displayedMs = 0;
+    toast.shownAt = 0;
+    toast.shown = false;
+    toast.sequence = nextSequence++;
+    return true;
+}
+
+const Toast* ToastQueue::update(unsigned long now) {
+    // 画面に出しているものが表示時間を過ぎたら取り除く（中断中のものは時間が進まない）
+    for (uint8_t i = 0; displaying && i < count; i++) {
+        const Toast& toast = entries[i];
+        if (toast.sequence != displayedSequence) continue;
+        if (toast.displayedMs + (now - toast.shownAt) >= toast.durationMs) {
+            removeAt(i);
+            displaying = false;
+        }
+        break;
+    }
+    if (count == 0) {
+        displaying = false;
+        return nullptr;
+    }
+    
+    uint8_t best = 0;
+    for (uint8_t i = 1; i < count; i++) {
+        if (entries[i].priority > entries[best].priority ||
+            (entries[i].priority == entries[best].priority && entries[i].sequence < entries[best].sequence)) {
+            best = i;
+        }
+    }
+    Toast& toast = entries[best];
+    if (displaying && toast.sequence == displayedSequence) {
+        return &toast;
+    }
+    
+    // 別のメッセージに切り替わる：表示していたものは中断し、ここまでの表示時間を残す
+    for (uint8_t i = 0; displaying && i < count; i++) {
+        if (entries[i].sequence == displayedSequence) {
+            entries[i].displayedMs += now - entries[i].shownAt;
+            break;
+        }
+    }
+    toast.shown = true;
+    toast.shownAt = now;
+    displaying = true;
+    displayedSequence = toast.sequence;
+    return &toast;
+}
\ No newline at end of file
@@ -1,13 +1,21 @@
 #include "CloudConnector.h"
 #include "ErrorHandler.h"
 #include "TimeUtils.h"
+#include "SensorFields.h"
+#include "DerivedMetrics.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
 
 CloudConnector::CloudConnector() :
     connectionStatus(ConnectionStatus::DISCONNECTED),
     recoveryMode(RecoveryMode::MEMORY_QUEUE),
     lastConnectionCheck(0),
     lastUploadAttempt(0),
-    retryCount(0) {
+    retryCount(0),
+    statsSource(nullptr),
+    derivedMetricsEnabled(false),
+    altitude(0.0f) {
 }
 
 CloudConnector::~CloudConnector() {
@@ -36,13 +44,20 @@ bool CloudConnector::uploadToGoogleSheets(const SensorReading& data) {
     // 基本実装：実際のアップロード機能は後で実装
     Serial.println("Google Sheetsへのアップロード機能は未実装です");
     
-    // デバッグ用：データをシリアルに出力
-    Serial.println("アップロードデータ:");
-    Serial.println("  温度: " + String(data.temperature) + "℃");
-    Serial.println("  湿度: " + String(data.humidity) + "%");
-    Serial.println("  気圧: " + String(data.pressure) + "hPa");
-    Serial.println("  CO2: " + String(data.co2_equivalent) + "ppm");
-    Serial.println("  IAQ: " + String(data.iaq));
+    // デバッグ用：送信予定のデータ（SensorFields.hの対応表から生成）をシリアルに出力
+    JsonDocument doc;
+    SensorFields::toJson(data, doc);
+    if (derivedMetricsEnabled) {
+        DerivedColumns derived;
+        DerivedMetrics::compute(&data, 1, altitude, derived);
+        DerivedMetrics::toJson(derived, 0, doc);
+    }
+    if (statsSource) {
+        statsSource->toJson(data.channel, doc);
+    }
+    String payload;
+    serializeJson(doc, payload);
+    Serial.println("アップロードデータ: " + payload);
     
     return true; // 基本実装では常に成功とする
 }
@@ -68,30 +83,188 @@ bool CloudConnector::syncOfflineData(const std::vector<String>& files) {
     return true;
 }
 
-String CloudConnector::generateOmenReport(const std::vector<SensorReading>& data) {
-    // 基本実装：簡単なレポートを生成
-    String report = "=== 予感AIちゃん レポート ===\n";
-    report += "データ数: " + String(data.size()) + "\n";
-    
-    if (!data.empty()) {
-        const auto& latest = data.back();
-        report += "最新データ:\n";
-        report += "  温度: " + String(latest.temperature, 1) + "℃\n";
-        report += "  湿度: " + String(latest.humidity, 1) + "%\n";
-        report += "  空気質: " + String(latest.iaq, 0) + "\n";
+namespace {
+
+const char REPORT_FOOTER[] = "========================\n";
+
+// 固定長バッファへの行単位の追記（OmenPromptBuilderのPromptWriterと同じく、1行を組み立ててから丸ごと載せる）
+// 行が収まらなければその行以降は載せずtruncatedで通知する。末尾のフッターの分は常に空けておく
+struct ReportWriter {
+    static const size_t LINE_SIZE = 192;
+    
+    char* buffer;
+    size_t size;
+    size_t length;
+    bool truncated;
+    char pending[LINE_SIZE];   // 組み立て中の行
+    size_t pendingLength;
+    bool pendingOverflow;
+    
+    ReportWriter(char* buf, size_t bufSize) :
+        buffer(buf), size(bufSize), length(0), truncated(false), pendingLength(0), pendingOverflow(false) {
+        if (size > 0) buffer[0] = '\0';
+    }
+    
+    void vadd(const char* format, va_list args) {
+        if (pendingOverflow) return;
+        int written = vsnprintf(pending + pendingLength, LINE_SIZE - pendingLength, format, args);
+        if (written < 0 || (size_t)written >= LINE_SIZE - pendingLength) {
+            pendingOverflow = true;
+            return;
+        }
+        pendingLength += written;
+    }
+    
+    // 組み立て中の行に追記する
+    void add(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        vadd(format, args);
+        va_end(args);
+    }
+    
+    // 組み立てた行を改行付きで載せる（フッターの分を残して収まらなければ捨てる）
+    bool endLine() {
+        const bool fits = !truncated && !pendingOverflow &&
+                          length + pendingLength + 1 + sizeof(REPORT_FOOTER) <= size;
+        if (fits) {
+            memcpy(buffer + length, pending, pendingLength);
+            length += pendingLength;
+            buffer[length++] = '\n';
+            buffer[length] = '\0';
+        } else {
+            truncated = true;
+        }
+        pendingLength = 0;
+        pendingOverflow = false;
+        return fits;
+    }
+    
+    // 1行をまとめて載せる（formatに改行は含めない）
+    bool line(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        vadd(format, args);
+        va_end(args);
+        return endLine();
+    }
+    
+    // フッターは予約した領域に必ず載せる
+    void footer() {
+        if (length + sizeof(REPORT_FOOTER) <= size) {
+            memcpy(buffer + length, REPORT_FOOTER, sizeof(REPORT_FOOTER));
+            length += sizeof(REPORT_FOOTER) - 1;
+        }
+    }
+};
+
+const char* relativeTime(uint32_t seconds, char* text, size_t size) {
+    if (seconds < 3600) {
+        snprintf(text, size, "%lu分前", (unsigned long)(seconds / 60));
+    } else if (seconds < 86400) {
+        snprintf(text, size, "%lu時間前", (unsigned long)(seconds / 3600));
+    } else {
+        snprintf(text, size, "%lu日前", (unsigned long)(seconds / 86400));
+    }
+    return text;
+}
+
+} // namespace
+
+size_t CloudConnector::generateOmenReport(const OmenSummary& summary, char* buffer, size_t size, uint8_t days) {
+    // 逐次更新された要約から生成する（読み取り値の履歴もヒープも使わない）
+    ReportWriter out(buffer, size);
+    out.line("=== 予感AIちゃん レポート ===");
+    out.line("データ数: %lu", (unsigned long)summary.getReadingCount());
+    
+    OmenRollup total;
+    if (!summary.aggregate(days, total)) {
+        out.footer();
+        return out.length;
+    }
+    
+    // 期間全体の集計と傾向
+    out.line("直近%u日間:", days);
+    for (uint8_t i = 0; i < OmenSummary::FIELD_COUNT; i++) {
+        const OmenRollup::Value& value = total.values[i];
+        const SensorField* field = SensorFields::find(OMEN_FIELDS[i]);
+        if (value.count == 0 || !field) continue;
+        
+        out.add("  %s: 平均%.1f%s (%.1f〜%.1f)", field->column, value.mean, field->unit,
+                value.minValue, value.maxValue);
+        const TrendSnapshot& trend = summary.getTrend(i);
+        if (trend.valid) {
+            out.add(" 傾き%+.2f/h 6時間後%.1f", trend.slopePerHour,
+                    trend.forecast[TrendSnapshot::FORECAST_HOURS - 1]);
+        }
+        out.endLine();
+    }
+    
+    // 日ごとの推移（主要3項目）
+    for (uint8_t ago = 0; ago < days && ago < OmenSummary::DAILY_ROLLUPS; ago++) {
+        const OmenRollup* day = summary.getDaily(ago);
+        if (!day) continue;
         
-        // 簡単な分析
-        if (latest.iaq < 50) {
-            report += "空気質: 良好です！\n";
-        } else if (latest.iaq < 100) {
-            report += "空気質: 普通です\n";
+        if (ago == 0) {
+            out.add("  今日:");
         } else {
-            report += "空気質: 注意が必要です\n";
+            out.add("  %u日前:", ago);
+        }
+        const OmenRollup::Value& temperature = day->values[OmenSummary::fieldIndex(BSEC_OUTPUT_RAW_TEMPERATURE)];
+        const OmenRollup::Value& humidity = day->values[OmenSummary::fieldIndex(BSEC_OUTPUT_RAW_HUMIDITY)];
+        const OmenRollup::Value& iaq = day->values[OmenSummary::fieldIndex(BSEC_OUTPUT_IAQ)];
+        if (temperature.count > 0) out.add(" 温度%.1f〜%.1f℃", temperature.minValue, temperature.maxValue);
+        if (humidity.count > 0) out.add(" 湿度%.0f%%", humidity.mean);
+        if (iaq.count > 0) out.add(" 空気質%.0f(最大%.0f)", iaq.mean, iaq.maxValue);
+        if (day->eventCount > 0) out.add(" 異常%u件", day->eventCount);
+        out.endLine();
+    }
+    
+    // 最近の異常イベント
+    if (summary.getRecentEventCount() > 0) {
+        out.line("最近の異常 (単発%lu 水準変化%lu ドリフト%lu):",
+                 (unsigned long)summary.getEventTotal(AnomalyType::SPIKE),
+                 (unsigned long)summary.getEventTotal(AnomalyType::SHIFT),
+                 (unsigned long)summary.getEventTotal(AnomalyType::DRIFT));
+        const uint32_t now = summary.getLastTimestamp();
+        for (uint8_t i = 0; i < summary.getRecentEventCount() && i < MAX_REPORT_EVENTS; i++) {
+            const AnomalyEvent* event = summary.getRecentEvent(i);
+            const SensorField* field = SensorFields::find(event->sensorId);
+            const uint32_t seconds = TimeUtils::toSeconds(event->timestamp, event->timeSynced);
+            char when[16];
+            out.line("  %s %s %s%s %.2f", relativeTime(now > seconds ? now - seconds : 0, when, sizeof(when)),
+                     AnomalyDetector::typeToString(event->type), field ? field->column : "?",
+                     event->direction > 0 ? "上昇" : "下降", event->value);
         }
     }
     
-    report += "========================\n";
-    return report;
+    // 予感（直近1時間の空気質と傾き）
+    const OmenRollup* hour = summary.getHourly(0);
+    const OmenRollup::Value* iaq = hour ? &hour->values[OmenSummary::fieldIndex(BSEC_OUTPUT_IAQ)] : nullptr;
+    if (iaq && iaq->count > 0) {
+        if (iaq->mean < 50) {
+            out.line("空気質: 良好です！");
+        } else if (iaq->mean < 100) {
+            out.line("空気質: 普通です");
+        } else {
+            out.line("空気質: 注意が必要です");
+        }
+    }
+    const TrendSnapshot& pressure = summary.getTrend(OmenSummary::fieldIndex(BSEC_OUTPUT_RAW_PRESSURE));
+    if (pressure.valid && pressure.slopePerHour <= PRESSURE_FALL_WARNING) {
+        out.line("気圧が急に下がっています。天気が崩れるかも");
+    }
+    const TrendSnapshot& humidity = summary.getTrend(OmenSummary::fieldIndex(BSEC_OUTPUT_RAW_HUMIDITY));
+    if (humidity.valid && humidity.slopePerHour >= HUMIDITY_RISE_WARNING) {
+        out.line("湿度が上がっています。雨の気配です");
+    }
+    
+    out.footer();
+    if (out.truncated) {
+        ErrorHandler::logWarning(ErrorComponent::NETWORK, "REPORT_TRUNCATED", 
+                                "予感レポートがバッファに収まらず途中で切り詰めました");
+    }
+    return out.length;
 }
 
 void CloudConnector::addToUploadQueue(const SensorReading& data) {
@@ -0,0 +1,230 @@
+#include "LlmClient.h"
+#include "ErrorHandler.h"
+#include "OmenPromptBuilder.h"
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+
+LlmClient::LlmClient() :
+    transport(LlmTransport::REJECTED),
+    connectTimeoutMs(CONNECT_TIMEOUT_MS),
+    responseTimeoutMs(RESPONSE_TIMEOUT_MS),
+    task(nullptr),
+    taskExited(nullptr),
+    taskRunning(false),
+    state(State::IDLE),
+    promptDigest(0),
+    requestStartMs(0),
+    lastLatencyMs(0),
+    cacheValid(false),
+    cacheDigest(0),
+    cacheTimeMs(0),
+    requestCount(0),
+    cacheHitCount(0),
+    failureCount(0),
+    totalLatencyMs(0),
+    lastPromptTokens(0) {
+    promptBuffer[0] = '\0';
+    responseBuffer[0] = '\0';
+}
+
+LlmClient::~LlmClient() {
+    end();
+    if (taskExited) {
+        vSemaphoreDelete(taskExited);
+    }
+}
+
+bool LlmClient::begin(const String& endpointUrl, const String& modelName, const String& key, const String& rootCaPem) {
+    if (taskRunning) {
+        return true;
+    }
+    if (endpointUrl.length() == 0) {
+        ErrorHandler::logWarning(ErrorComponent::NETWORK, "LLM_NOT_CONFIGURED", 
+                                "LLMのエンドポイントが未設定のため予感レポートの生成を無効にします");
+        return false;
+    }
+    
+    transport = LlmProtocol::selectTransport(endpointUrl.c_str(), rootCaPem.length() > 0);
+    if (transport == LlmTransport::REJECTED) {
+        ErrorHandler::logError(ErrorComponent::NETWORK, "LLM_ROOT_CA_MISSING", 
+                              "LLMのルートCAが未設定のため予感レポートの生成を無効にします: " + endpointUrl);
+        return false;
+    }
+    if (transport == LlmTransport::PLAIN && key.length() > 0) {
+        ErrorHandler::logWarning(ErrorComponent::NETWORK, "LLM_PLAIN_HTTP", 
+                                "http://のエンドポイントにはAPIキーを送りません（モックサーバー用）");
+    }
+    
+    endpoint = endpointUrl;
+    model = modelName;
+    apiKey = key;
+    rootCa = rootCaPem;
+    
+    if (!taskExited) {
+        taskExited = xSemaphoreCreateBinary();
+    }
+    taskRunning = true;
+    BaseType_t result = xTaskCreatePinnedToCore(taskEntry, "llm", LLM_TASK_STACK_SIZE, 
+                                                this, LLM_TASK_PRIORITY, &task, LLM_TASK_CORE);
+    if (result != pdPASS) {
+        taskRunning = false;
+        task = nullptr;
+        ErrorHandler::logError(ErrorComponent::NETWORK, "LLM_TASK_CREATE_FAILED", 
+                              "LLM通信タスクの作成に失敗しました");
+        return false;
+    }
+    
+    Serial.println("LLMクライアントを開始しました（" + model + "）");
+    return true;
+}
+
+void LlmClient::end() {
+    if (!taskRunning) return;
+    
+    // タスクは待機から起きたときにフラグを確認して自身を削除する（通信中なら完了後）
+    // タスクはこのオブジェクトのバッファと接続先を使うため、ループを抜けるまで待ってから戻る
+    taskRunning = false;
+    xTaskNotifyGive(task);
+    const uint32_t waitMs = connectTimeoutMs + responseTimeoutMs + LLM_TASK_STOP_MARGIN_MS;
+    if (xSemaphoreTake(taskExited, pdMS_TO_TICKS(waitMs)) != pdTRUE) {
+        ErrorHandler::logWarning(ErrorComponent::NETWORK, "LLM_TASK_STOP_TIMEOUT", 
+                                "LLM通信タスクの終了を確認できませんでした");
+    }
+    task = nullptr;
+}
+
+bool LlmClient::request(const char* prompt, LlmCallback callback) {
+    if (!taskRunning || getState() != State::IDLE) {
+        return false;
+    }
+    
+    const uint32_t digest = OmenPromptBuilder::digest(prompt);
+    if (cacheValid && cacheDigest == digest && millis() - cacheTimeMs < CACHE_TTL_MS) {
+        cacheHitCount++;
+        if (callback) callback(true, responseBuffer);
+        return true;
+    }
+    
+    size_t length = strlen(prompt);
+    if (length >= PROMPT_BUFFER_SIZE) {
+        ErrorHandler::logWarning(ErrorComponent::NETWORK, "LLM_PROMPT_TOO_LONG", 
+                                "プロンプトが長すぎるため切り詰めました");
+        length = PROMPT_BUFFER_SIZE - 1;
+    }
+    memcpy(promptBuffer, prompt, length);
+    promptBuffer[length] = '\0';
+    
+    promptDigest = digest;
+    lastPromptTokens = OmenPromptBuilder::estimateTokens(promptBuffer);
+    pendingCallback = callback;
+    cacheValid = false;     // responseBufferをタスクが上書きする
+    requestStartMs = millis();
+    requestCount++;
+    
+    state.store(State::PENDING, std::memory_order_release);
+    xTaskNotifyGive(task);
+    return true;
+}
+
+void LlmClient::update() {
+    State current = getState();
+    if (current != State::DONE && current != State::FAILED) {
+        return;
+    }
+    
+    lastLatencyMs = millis() - requestStartMs;
+    const bool success = (current == State::DONE);
+    if (success) {
+        totalLatencyMs += lastLatencyMs;
+        cacheValid = true;
+        cacheDigest = promptDigest;
+        cacheTimeMs = millis();
+    } else {
+        failureCount++;
+        ErrorHandler::logWarning(ErrorComponent::NETWORK, "LLM_REQUEST_FAILED", 
+                                String("予感レポートの取得に失敗しました: ") + responseBuffer);
+    }
+    
+    // callbackの中から次のrequest()を呼べるよう、先にIDLEへ戻す
+    LlmCallback callback = pendingCallback;
+    pendingCallback = nullptr;
+    state.store(State::IDLE, std::memory_order_release);
+    if (callback) callback(success, responseBuffer);
+}
+
+void LlmClient::taskEntry(void* param) {
+    LlmClient* client = static_cast<LlmClient*>(param);
+    client->taskLoop();
+    xSemaphoreGive(client->taskExited);
+    vTaskDelete(nullptr);
+}
+
+void LlmClient::taskLoop() {
+    while (taskRunning) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!taskRunning) break;
+        if (state.load(std::memory_order_acquire) != State::PENDING) continue;
+        
+        bool success = performRequest();
+        state.store(success ? State::DONE : State::FAILED, std::memory_order_release);
+    }
+}
+
+bool LlmClient::performRequest() {
+    if (WiFi.status() != WL_CONNECTED) {
+        snprintf(responseBuffer, sizeof(responseBuffer), "WiFi未接続");
+        return false;
+    }
+    
+    String body;
+    if (!LlmProtocol::buildRequest(model, promptBuffer, MAX_COMPLETION_TOKENS, body)) {
+        snprintf(responseBuffer, sizeof(responseBuffer), "要求の組み立てに失敗しました");
+        return false;
+    }
+    
+    // HTTPSは設定のルートCAで検証する（begin()で経路を決めてあり、検証なしの接続はしない）
+    WiFiClient plainClient;
+    WiFiClientSecure secureClient;
+    HTTPClient http;
+    bool started;
+    if (transport == LlmTransport::VERIFIED_TLS) {
+        secureClient.setCACert(rootCa.c_str());
+        started = http.begin(secureClient, endpoint);
+    } else {
+        started = http.begin(plainClient, endpoint);
+    }
+    if (!started) {
+        snprintf(responseBuffer, sizeof(responseBuffer), "エンドポイントに接続できません");
+        return false;
+    }
+    http.setConnectTimeout(connectTimeoutMs);
+    http.setTimeout(responseTimeoutMs);
+    http.addHeader("Content-Type", "application/json");
+    if (apiKey.length() > 0 && LlmProtocol::sendsApiKey(transport)) {
+        http.addHeader("Authorization", "Bearer " + apiKey);
+    }
+    
+    int code = http.POST(body);
+    if (code != HTTP_CODE_OK) {
+        snprintf(responseBuffer, sizeof(responseBuffer), "HTTP %d %s", code, 
+                 code < 0 ? HTTPClient::errorToString(code).c_str() : "");
+        http.end();
+        return false;
+    }
+    
+    String payload = http.getString();
+    http.end();
+    return LlmProtocol::parseResponse(payload, responseBuffer, sizeof(responseBuffer));
+}
+
+String LlmClient::getReport() const {
+    String report = "LLM: 依頼" + String(requestCount) + "件, キャッシュ" + String(cacheHitCount) + 
+                    "件, 失敗" + String(failureCount) + "件";
+    uint32_t succeeded = requestCount - failureCount - (getState() != State::IDLE ? 1 : 0);
+    if (succeeded > 0) {
+        report += ", 平均" + String(totalLatencyMs / succeeded) + "ms";
+    }
+    report += ", 直近" + String(lastLatencyMs) + "ms/" + String(lastPromptTokens) + "トークン";
+    return report;
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "LlmProtocol.h"
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <string.h>
+
+LlmTransport LlmProtocol::selectTransport(const char* endpoint, bool hasRootCa) {
+    if (strncmp(endpoint, "http://", 7) == 0) {
+        return LlmTransport::PLAIN;
+    }
+    if (strncmp(endpoint, "https://", 8) == 0 && hasRootCa) {
+        return LlmTransport::VERIFIED_TLS;
+    }
+    return LlmTransport::REJECTED;
+}
+
+bool LlmProtocol::buildRequest(const String& model, const char* prompt, uint16_t maxTokens, String& body) {
+    JsonDocument request;
+    request["model"] = model;
+    request["max_tokens"] = maxTokens;
+    JsonObject message = request["messages"].to<JsonArray>().add<JsonObject>();
+    message["role"] = "user";
+    message["content"] = prompt;
+    return serializeJson(request, body) > 0;
+}
+
+bool LlmProtocol::parseResponse(const String& body, char* out, size_t size) {
+    if (size == 0) return false;
+    
+    JsonDocument response;
+    DeserializationError error = deserializeJson(response, body);
+    if (error) {
+        snprintf(out, size, "応答の解析に失敗: %s", error.c_str());
+        return false;
+    }
+    
+    const char* apiError = response["error"]["message"] | (const char*)nullptr;
+    if (apiError) {
+        snprintf(out, size, "APIエラー: %s", apiError);
+        return false;
+    }
+    
+    const char* content = response["choices"][0]["message"]["content"] | (const char*)nullptr;
+    if (!content) {
+        snprintf(out, size, "応答に本文がありません");
+        return false;
+    }
+    size_t length = strlen(content);
+    if (length >= size) {
+        // 切り詰めるときはUTF-8の文字の途中で切らない
+        length = size - 1;
+        while (length > 0 && ((uint8_t)content[length] & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+    memcpy(out, content, length);
+    out[length] = '\0';
+    return true;
+}
\ No newline at end of file
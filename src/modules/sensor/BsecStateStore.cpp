@@ -0,0 +1,193 @@
+#include "BsecStateStore.h"
+#include "ErrorHandler.h"
+
+static const char* KEY_HEADER[2] = { "hdr0", "hdr1" };
+static const char* KEY_STATE[2] = { "state0", "state1" };
+
+BsecStateStore::BsecStateStore() :
+    opened(false),
+    lastSavedCrc(0),
+    activeSlot(-1),
+    activeSequence(0),
+    saveCount(0),
+    skippedCount(0),
+    bytesWritten(0) {
+    setNamespace(DEFAULT_NAMESPACE);
+}
+
+BsecStateStore::~BsecStateStore() {
+    if (opened) {
+        preferences.end();
+    }
+}
+
+void BsecStateStore::setNamespace(const char* name) {
+    if (opened) return;
+    strncpy(nvsNamespace, name, sizeof(nvsNamespace) - 1);
+    nvsNamespace[sizeof(nvsNamespace) - 1] = '\0';
+}
+
+bool BsecStateStore::begin() {
+    if (opened) return true;
+    
+    opened = preferences.begin(nvsNamespace, false);
+    if (!opened) {
+        ErrorHandler::logWarning(ErrorComponent::SENSOR, "BSEC_STATE_NVS_FAILED", 
+                                "BSEC状態保存用のNVSを開けませんでした");
+    }
+    return opened;
+}
+
+void BsecStateStore::packVersion(const bsec_version_t& version, uint8_t out[4]) {
+    out[0] = version.major;
+    out[1] = version.minor;
+    out[2] = version.major_bugfix;
+    out[3] = version.minor_bugfix;
+}
+
+uint32_t BsecStateStore::crc32(const uint8_t* data, size_t length) {
+    // CRC-32（IEEE 802.3、反転多項式0xEDB88320）
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+BsecStateStore::SlotStatus BsecStateStore::readHeader(const char* key, const uint8_t version[4], size_t capacity, 
+                                                      StateHeader& header) {
+    size_t size = preferences.isKey(key) ? preferences.getBytesLength(key) : 0;
+    if (size != sizeof(header) || preferences.getBytes(key, &header, size) != size) {
+        return SlotStatus::MISSING;
+    }
+    
+    if (header.magic != STATE_MAGIC || header.formatVersion != FORMAT_VERSION || 
+        header.stateLength == 0 || header.stateLength > capacity || memcmp(header.bsecVersion, version, 4) != 0) {
+        return SlotStatus::VERSION_MISMATCH;
+    }
+    return SlotStatus::VALID;
+}
+
+bool BsecStateStore::readState(const char* key, const StateHeader& header, uint8_t* state, size_t capacity) {
+    if (preferences.getBytes(key, state, header.stateLength) != header.stateLength ||
+        crc32(state, header.stateLength) != header.crc) {
+        return false;
+    }
+    memset(state + header.stateLength, 0, capacity - header.stateLength);
+    return true;
+}
+
+bool BsecStateStore::load(uint8_t* state, size_t length, const bsec_version_t& version) {
+    if (!begin()) return false;
+    
+    uint8_t currentVersion[4];
+    packVersion(version, currentVersion);
+    
+    // 2つのスロットを通し番号が新しい順に試す
+    StateHeader headers[2];
+    bool valid[2];
+    bool anyStored = false;
+    for (uint8_t i = 0; i < 2; i++) {
+        SlotStatus status = readHeader(KEY_HEADER[i], currentVersion, length, headers[i]);
+        valid[i] = (status == SlotStatus::VALID);
+        anyStored = anyStored || status != SlotStatus::MISSING;
+    }
+    
+    if (!anyStored) {
+        Serial.println("保存済みのBSEC状態はありません");
+        return false;
+    }
+    
+    bool anyValid = false;
+    while (true) {
+        int8_t best = -1;
+        for (uint8_t i = 0; i < 2; i++) {
+            if (valid[i] && (best < 0 || headers[i].sequence > headers[best].sequence)) {
+                best = i;
+            }
+        }
+        if (best < 0) break;
+        
+        anyValid = true;
+        if (readState(KEY_STATE[best], headers[best], state, length)) {
+            // 次の保存は別のスロットへ
+            activeSlot = best;
+            activeSequence = headers[best].sequence;
+            lastSavedCrc = headers[best].crc;
+            return true;
+        }
+        valid[best] = false;
+    }
+    
+    if (anyValid) {
+        ErrorHandler::logWarning(ErrorComponent::SENSOR, "BSEC_STATE_CRC_MISMATCH", 
+                                "保存済みBSEC状態が破損しているため破棄します");
+    } else {
+        ErrorHandler::logWarning(ErrorComponent::SENSOR, "BSEC_STATE_VERSION_MISMATCH", 
+                                "保存済みBSEC状態のバージョンが一致しないため破棄します");
+    }
+    erase();
+    return false;
+}
+
+bool BsecStateStore::save(const uint8_t* state, size_t length, const bsec_version_t& version) {
+    if (!begin()) return false;
+    
+    // 末尾の0は保存しない（読み込み時に0で埋め戻すため内容は変わらない）
+    size_t used = length;
+    while (used > 0 && state[used - 1] == 0) {
+        used--;
+    }
+    if (used == 0) {
+        return false;
+    }
+    
+    uint32_t crc = crc32(state, used);
+    if (crc == lastSavedCrc && activeSlot >= 0) {
+        // 内容が変わっていなければフラッシュへ書き込まない
+        skippedCount++;
+        return true;
+    }
+    
+    StateHeader header;
+    header.magic = STATE_MAGIC;
+    header.formatVersion = FORMAT_VERSION;
+    header.stateLength = used;
+    packVersion(version, header.bsecVersion);
+    header.crc = crc;
+    header.sequence = activeSequence + 1;
+    
+    // 最新でない方のスロットへ本体・ヘッダーの順に書く
+    // 途中で電源断しても、このスロットはCRC不一致か古い通し番号になり、最新のスロットが使われる
+    const uint8_t slot = (activeSlot == 0) ? 1 : 0;
+    if (preferences.putBytes(KEY_STATE[slot], state, used) != used ||
+        preferences.putBytes(KEY_HEADER[slot], &header, sizeof(header)) != sizeof(header)) {
+        ErrorHandler::logError(ErrorComponent::SENSOR, "BSEC_STATE_SAVE_FAILED", 
+                              "BSEC状態の保存に失敗しました");
+        return false;
+    }
+    
+    activeSlot = slot;
+    activeSequence = header.sequence;
+    lastSavedCrc = crc;
+    saveCount++;
+    bytesWritten += used + sizeof(header);
+    return true;
+}
+
+bool BsecStateStore::erase() {
+    if (!begin()) return false;
+    
+    lastSavedCrc = 0;
+    activeSlot = -1;
+    activeSequence = 0;
+    bool removed = true;
+    for (uint8_t slot = 0; slot < 2; slot++) {
+        if (preferences.isKey(KEY_STATE[slot])) removed = preferences.remove(KEY_STATE[slot]) && removed;
+        if (preferences.isKey(KEY_HEADER[slot])) removed = preferences.remove(KEY_HEADER[slot]) && removed;
+    }
+    return removed;
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "DerivedMetrics.h"
+
+namespace {
+
+// Magnus式の係数（水面上、-45〜60℃）
+constexpr float MAGNUS_A = 17.62f;
+constexpr float MAGNUS_B = 243.12f;                 // ℃
+constexpr float MAGNUS_E0 = 6.112f;                 // hPa
+constexpr float WATER_VAPOR_FACTOR = 216.7f;        // g·K/(m³·hPa)（水蒸気の気体定数の逆数）
+constexpr float KELVIN = 273.15f;
+constexpr float LAPSE_RATE = 0.0065f;              // K/m
+constexpr float BAROMETRIC_EXPONENT = 5.257f;       // g·M/(R·L)
+
+constexpr float LN2 = 0.69314718f;
+constexpr float LOG2E = 1.44269504f;
+constexpr uint32_t SQRT2_MANTISSA = 0x003504F3;   // √2の仮数部
+
+inline uint32_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bitsFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// 条件でどちらかを選ぶ（ビットマスクで合成する。浮動小数点の三項演算子は
+// -ftrapping-math（既定）のままだとGCCがループをベクトル化しない）
+inline float select(bool condition, float ifTrue, float ifFalse) {
+    const uint32_t mask = 0u - (uint32_t)condition;
+    return bitsFloat((floatBits(ifTrue) & mask) | (floatBits(ifFalse) & ~mask));
+}
+
+inline float clamp(float x, float low, float high) {
+    x = select(x < low, low, x);
+    return select(x > high, high, x);
+}
+
+// 正の正規化数の自然対数。仮数を[√2/2, √2)に寄せ、t=(m-1)/(m+1)の奇数べき級数で求める
+inline float fastLog(float x) {
+    const uint32_t bits = floatBits(x);
+    const bool high = (bits & 0x007FFFFF) > SQRT2_MANTISSA;          // 仮数 > √2
+    const int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + (high ? 1 : 0);
+    const float mantissa = bitsFloat(((bits & 0x007FFFFF) | 0x3F800000) - (high ? 0x00800000 : 0));
+    
+    const float t = (mantissa - 1.0f) / (mantissa + 1.0f);
+    const float t2 = t * t;
+    const float series = 1.0f + t2 * (1.0f / 3.0f + t2 * (1.0f / 5.0f + t2 * (1.0f / 7.0f)));
+    return 2.0f * t * series + (float)exponent * LN2;
+}
+
+// 自然指数。2^nと2^f（|f|≦0.5、テイラー展開6次）に分ける
+inline float fastExp(float x) {
+    x = clamp(x, -80.0f, 80.0f);
+    const float y = x * LOG2E + 0.5f;
+    int32_t n = (int32_t)y;
+    n -= (y < (float)n) ? 1 : 0;                    // floor
+    const float f = (x * LOG2E - (float)n) * LN2;   // [-ln2/2, ln2/2)
+    const float poly = 1.0f + f * (1.0f + f * (1.0f / 2.0f + f * (1.0f / 6.0f + 
+                       f * (1.0f / 24.0f + f * (1.0f / 120.0f + f * (1.0f / 720.0f))))));
+    return poly * bitsFloat((uint32_t)(n + 127) << 23);
+}
+
+// 平方根（逆平方根の初期値からニュートン法2回。sqrtf()はerrno処理のためループのベクトル化を妨げる）
+inline float fastSqrt(float x) {
+    x = select(x < 1e-12f, 1e-12f, x);
+    float inverse = bitsFloat(0x5F3759DF - (floatBits(x) >> 1));
+    inverse *= 1.5f - 0.5f * x * inverse * inverse;
+    inverse *= 1.5f - 0.5f * x * inverse * inverse;
+    return x * inverse;
+}
+
+} // namespace
+
+float DerivedColumns::get(uint8_t fieldIndex, size_t i) const {
+    switch (fieldIndex) {
+        case 0: return dewPoint[i];
+        case 1: return absoluteHumidity[i];
+        case 2: return heatIndex[i];
+        default: return seaLevelPressure[i];
+    }
+}
+
+void DerivedMetrics::computeColumns(const float* __restrict temperature, const float* __restrict humidity,
+                                    const float* __restrict pressure, size_t count, float altitude,
+                                    float* __restrict dewPoint, float* __restrict absoluteHumidity,
+                                    float* __restrict heatIndex, float* __restrict seaLevelPressure) {
+    const float heightTerm = LAPSE_RATE * altitude;
+    
+    for (size_t i = 0; i < count; i++) {
+        const float t = temperature[i];
+        float rh = humidity[i];
+        rh = clamp(rh, 0.1f, 100.0f);
+        
+        // 露点と絶対湿度（ln(e/E0) = ln(RH/100) + aT/(b+T) を共有する）
+        const float gamma = fastLog(rh * 0.01f) + MAGNUS_A * t / (MAGNUS_B + t);
+        dewPoint[i] = MAGNUS_B * gamma / (MAGNUS_A - gamma);
+        absoluteHumidity[i] = WATER_VAPOR_FACTOR * MAGNUS_E0 * fastExp(gamma) / (KELVIN + t);
+        
+        // 体感温度（°Fで計算。簡易式の平均が80°F未満なら簡易式、以上ならRothfusz回帰と補正）
+        const float tf = t * 1.8f + 32.0f;
+        const float simple = 0.5f * (tf + 61.0f + (tf - 68.0f) * 1.2f + rh * 0.094f);
+        float regression = -42.379f + 2.04901523f * tf + 10.14333127f * rh 
+                           - 0.22475541f * tf * rh - 0.00683783f * tf * tf - 0.05481717f * rh * rh 
+                           + 0.00122874f * tf * tf * rh + 0.00085282f * tf * rh * rh 
+                           - 0.00000199f * tf * tf * rh * rh;
+        const float dry = 17.0f - fabsf(tf - 95.0f);
+        const float dryAdjust = (13.0f - rh) * 0.25f * fastSqrt(select(dry > 0.0f, dry, 0.0f) * (1.0f / 17.0f));
+        const float humidAdjust = (rh - 85.0f) * 0.1f * (87.0f - tf) * 0.2f;
+        regression -= select((rh < 13.0f) & (tf >= 80.0f) & (tf <= 112.0f), dryAdjust, 0.0f);
+        regression += select((rh > 85.0f) & (tf >= 80.0f) & (tf <= 87.0f), humidAdjust, 0.0f);
+        const float heatF = select(0.5f * (simple + tf) < 80.0f, simple, regression);
+        heatIndex[i] = (heatF - 32.0f) * (1.0f / 1.8f);
+        
+        // 海面気圧 P0 = P (1 - Lh / (T + Lh + 273.15))^-5.257
+        const float ratio = 1.0f - heightTerm / (t + heightTerm + KELVIN);
+        seaLevelPressure[i] = pressure[i] * fastExp(-BAROMETRIC_EXPONENT * fastLog(ratio));
+    }
+}
+
+size_t DerivedMetrics::compute(const SensorReading* readings, size_t count, float altitude, DerivedColumns& out) {
+    // AoSのSensorReadingから必要な3列だけを取り出してカーネルに渡す
+    float temperature[DerivedColumns::BATCH_SIZE];
+    float humidity[DerivedColumns::BATCH_SIZE];
+    float pressure[DerivedColumns::BATCH_SIZE];
+    
+    const size_t n = count < DerivedColumns::BATCH_SIZE ? count : DerivedColumns::BATCH_SIZE;
+    for (size_t i = 0; i < n; i++) {
+        temperature[i] = readings[i].temperature;
+        humidity[i] = readings[i].humidity;
+        pressure[i] = readings[i].pressure;
+    }
+    
+    computeColumns(temperature, humidity, pressure, n, altitude, 
+                   out.dewPoint, out.absoluteHumidity, out.heatIndex, out.seaLevelPressure);
+    out.count = n;
+    return n;
+}
+
+String DerivedMetrics::csvHeader() {
+    String header;
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        header += ",";
+        header += DERIVED_FIELDS[i].column;
+    }
+    return header;
+}
+
+void DerivedMetrics::appendCsv(String& row, const DerivedColumns& columns, size_t index) {
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        row += ",";
+        row += String(columns.get(i, index), (unsigned int)DERIVED_FIELDS[i].decimals);
+    }
+}
+
+void DerivedMetrics::toJson(const DerivedColumns& columns, size_t index, JsonDocument& doc) {
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        doc[DERIVED_FIELDS[i].column] = columns.get(i, index);
+    }
+}
+
+void DerivedMetrics::describeSchema(JsonDocument& doc, float altitude) {
+    // CSVではSensorFieldsの列とdevice_id等の後ろに並ぶ（SensorReadingには含まれない）
+    doc["altitude_m"] = altitude;
+    JsonArray fields = doc["derived"].to<JsonArray>();
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        JsonObject entry = fields.add<JsonObject>();
+        entry["name"] = DERIVED_FIELDS[i].column;
+        entry["unit"] = DERIVED_FIELDS[i].unit;
+    }
+}
\ No newline at end of file
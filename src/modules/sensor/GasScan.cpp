@@ -0,0 +1,73 @@
+#include "GasScan.h"
+#include <math.h>
+
+uint16_t GasScan::encodeResistance(float ohms) {
+    if (!(ohms > 1.0f)) return 0;
+    
+    float code = log2f(ohms) * CODE_SCALE + 0.5f;
+    if (code >= 65535.0f) return 65535;
+    return (uint16_t)code;
+}
+
+float GasScan::decodeResistance(uint16_t code) {
+    return exp2f((float)code / CODE_SCALE);
+}
+
+GasScanAssembler::GasScanAssembler() :
+    lastIndex(0),
+    hasPending(false),
+    completedCount(0),
+    incompleteCount(0) {
+}
+
+void GasScanAssembler::reset() {
+    pending = GasScan();
+    lastIndex = 0;
+    hasPending = false;
+}
+
+bool GasScanAssembler::addStep(const bme68xData& data, const bsecOutputs& outputs, uint32_t timestamp, 
+                               GasScan& completed) {
+    uint8_t index = data.gas_index;
+    if (index >= GasScan::MAX_STEPS) {
+        return false;
+    }
+    
+    // プロファイルの先頭に戻った場合は前の周回を確定する
+    bool emitted = false;
+    if (hasPending && index <= lastIndex) {
+        completed = pending;
+        emitted = true;
+        completedCount++;
+        if (pending.validMask != (uint16_t)((1 << pending.stepCount) - 1)) {
+            incompleteCount++;
+        }
+        pending = GasScan();
+    }
+    
+    if (!hasPending || emitted) {
+        pending.timestamp = timestamp;   // スキャン開始時刻
+        hasPending = true;
+    }
+    
+    // ヒーター温度が安定し、ガス測定が有効なステップのみ採用
+    const uint8_t validMask = BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK;
+    if ((data.status & validMask) == validMask) {
+        pending.gasCode[index] = GasScan::encodeResistance(data.gas_resistance);
+        pending.validMask |= (1 << index);
+    }
+    if (index + 1 > pending.stepCount) {
+        pending.stepCount = index + 1;
+    }
+    lastIndex = index;
+    
+    // ガス分類の推定値はプロファイル1周ごとに出力される
+    for (uint8_t i = 0; i < outputs.nOutputs; i++) {
+        const bsecData& output = outputs.output[i];
+        if (output.sensor_id >= BSEC_OUTPUT_GAS_ESTIMATE_1 && output.sensor_id <= BSEC_OUTPUT_GAS_ESTIMATE_4) {
+            pending.gasEstimate[output.sensor_id - BSEC_OUTPUT_GAS_ESTIMATE_1] = output.signal;
+        }
+    }
+    
+    return emitted;
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "HampelFilter.h"
+#include <math.h>
+#include <string.h>
+
+HampelFilter::HampelFilter() :
+    window(7),
+    count(0),
+    head(0),
+    threshold(3.0f),
+    minDeviation(0.0f),
+    minRelativeDeviation(0.0f) {
+}
+
+void HampelFilter::configure(uint8_t windowSize, float thresholdK, float minAbs, float minRel) {
+    if (windowSize < 3) windowSize = 3;
+    if (windowSize > MAX_WINDOW) windowSize = MAX_WINDOW;
+    if (windowSize % 2 == 0) windowSize--;   // 中央値が1点に決まるよう奇数にそろえる
+    window = windowSize;
+    threshold = thresholdK;
+    minDeviation = minAbs;
+    minRelativeDeviation = minRel;
+    reset();
+}
+
+void HampelFilter::reset() {
+    count = 0;
+    head = 0;
+}
+
+uint8_t HampelFilter::lowerBound(float value) const {
+    uint8_t low = 0;
+    uint8_t high = count;
+    while (low < high) {
+        uint8_t mid = (low + high) / 2;
+        if (sorted[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void HampelFilter::insertSorted(float value) {
+    uint8_t pos = lowerBound(value);
+    memmove(&sorted[pos + 1], &sorted[pos], (count - pos) * sizeof(float));
+    sorted[pos] = value;
+    count++;
+}
+
+void HampelFilter::removeSorted(float value) {
+    uint8_t pos = lowerBound(value);
+    memmove(&sorted[pos], &sorted[pos + 1], (count - pos - 1) * sizeof(float));
+    count--;
+}
+
+float HampelFilter::getMedian() const {
+    if (count == 0) return 0.0f;
+    uint8_t mid = count / 2;
+    return (count % 2) ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) * 0.5f;
+}
+
+float HampelFilter::computeMad(float median) const {
+    // 昇順配列では中央値からの偏差が左右それぞれ単調に増えるため、
+    // 2本の列をマージする要領で小さい順に半分+1個たどればMADが得られる
+    int left = (int)lowerBound(median) - 1;
+    int right = left + 1;
+    uint8_t target = count / 2;
+    float deviation = 0.0f;
+    
+    for (uint8_t taken = 0; taken <= target; taken++) {
+        float leftDev = (left >= 0) ? median - sorted[left] : INFINITY;
+        float rightDev = (right < count) ? sorted[right] - median : INFINITY;
+        if (leftDev <= rightDev) {
+            deviation = leftDev;
+            left--;
+        } else {
+            deviation = rightDev;
+            right++;
+        }
+    }
+    return deviation;
+}
+
+bool HampelFilter::update(float value, float& median) {
+    bool outlier = false;
+    median = value;
+    
+    if (isnan(value)) {
+        return false;   // 欠測値は窓に入れない
+    }
+    
+    if (isReady()) {
+        median = getMedian();
+        float scale = MAD_SCALE * computeMad(median);
+        float limit = threshold * scale;
+        float floor = fmaxf(minDeviation, minRelativeDeviation * fabsf(median));
+        if (limit < floor) limit = floor;
+        outlier = fabsf(value - median) > limit;
+        
+        // 最も古い値を窓から外す
+        removeSorted(ring[head]);
+    }
+    
+    // 外れ値もそのまま窓に入れる（実際の段差変化には半窓分で追従する）
+    ring[head] = value;
+    head = (head + 1) % window;
+    insertSorted(value);
+    
+    return outlier;
+}
\ No newline at end of file
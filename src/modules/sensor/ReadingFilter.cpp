@@ -0,0 +1,106 @@
+#include "ReadingFilter.h"
+
+ReadingFilter::ReadingFilter() :
+    processedCount(0),
+    enabled(true) {
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        outlierCounts[i] = 0;
+    }
+    applyDefaults();
+}
+
+void ReadingFilter::applyDefaults() {
+    // ヒーター動作直後のガス抵抗の跳ねや結露付近の湿度スパイクなど、生データのグリッチのみ対象とする
+    // BSECが平滑化済みのIAQ・CO2・VOCは急変自体が検出対象になるため既定では判定しない
+    // 置き換えると実際の急変（窓を開けたなど）の生の値が失われるため、フラグのみとする
+    OutlierFilterConfig config;
+    config.enabled = true;
+    
+    config.minDeviation = 0.5f;              // ℃
+    configure(BSEC_OUTPUT_RAW_TEMPERATURE, config);
+    
+    config.minDeviation = 3.0f;              // %RH
+    configure(BSEC_OUTPUT_RAW_HUMIDITY, config);
+    
+    config.minDeviation = 0.5f;              // hPa
+    configure(BSEC_OUTPUT_RAW_PRESSURE, config);
+    
+    config.minDeviation = 0.0f;
+    config.minRelativeDeviation = 0.2f;      // ガス抵抗は桁で変わるため比率で下限を設ける
+    configure(BSEC_OUTPUT_RAW_GAS, config);
+}
+
+bool ReadingFilter::configure(uint8_t sensorId, const OutlierFilterConfig& config) {
+    const SensorField* field = SensorFields::find(sensorId);
+    if (!field || !SensorFields::hasSlot(*field)) {
+        return false;
+    }
+    
+    size_t index = field - SENSOR_FIELDS;
+    configs[index] = config;
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        filters[channel][index].configure(config.window, config.threshold, 
+                                          config.minDeviation, config.minRelativeDeviation);
+    }
+    return true;
+}
+
+bool ReadingFilter::getConfig(uint8_t sensorId, OutlierFilterConfig& config) const {
+    const SensorField* field = SensorFields::find(sensorId);
+    if (!field) {
+        return false;
+    }
+    config = configs[field - SENSOR_FIELDS];
+    return true;
+}
+
+void ReadingFilter::reset() {
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+            filters[channel][i].reset();
+        }
+    }
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        outlierCounts[i] = 0;
+    }
+    processedCount = 0;
+}
+
+bool ReadingFilter::apply(SensorReading& reading) {
+    reading.outlier_mask = 0;
+    if (!enabled || reading.channel >= MAX_CHANNELS) {
+        return false;
+    }
+    
+    processedCount++;
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        const OutlierFilterConfig& config = configs[i];
+        if (!config.enabled) continue;
+        
+        float& value = *SensorFields::slot(SENSOR_FIELDS[i], reading);
+        float median;
+        if (filters[reading.channel][i].update(value, median)) {
+            reading.outlier_mask |= (1 << i);
+            outlierCounts[i]++;
+            if (config.replace) {
+                value = median;
+            }
+        }
+    }
+    
+    return reading.outlier_mask != 0;
+}
+
+uint32_t ReadingFilter::getOutlierCount(uint8_t sensorId) const {
+    const SensorField* field = SensorFields::find(sensorId);
+    return field ? outlierCounts[field - SENSOR_FIELDS] : 0;
+}
+
+String ReadingFilter::getReport() const {
+    String report = "外れ値: " + String(processedCount) + "件中";
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        if (!configs[i].enabled) continue;
+        report += " " + String(SENSOR_FIELDS[i].column) + "=" + String(outlierCounts[i]);
+    }
+    return report;
+}
\ No newline at end of file
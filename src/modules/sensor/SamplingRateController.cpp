@@ -0,0 +1,133 @@
+#include "SamplingRateController.h"
+#include <bsec2.h>
+
+SamplingRateController::SamplingRateController() :
+    currentMode(SamplingMode::LP),
+    hasPrevious(false),
+    excursionActive(false),
+    anomalyActive(false),
+    previousSeconds(0),
+    lastModeChangeSeconds(0),
+    previousMode(SamplingMode::LP),
+    previousModeChangeSeconds(0),
+    stableSinceSeconds(0),
+    temperatureRate(0.0f),
+    humidityRate(0.0f),
+    iaqRate(0.0f),
+    modeChangeCount(0) {
+    secondsInMode[0] = secondsInMode[1] = secondsInMode[2] = 0;
+}
+
+void SamplingRateController::reset(SamplingMode initialMode, uint32_t nowSeconds) {
+    currentMode = initialMode;
+    hasPrevious = false;
+    excursionActive = false;
+    lastModeChangeSeconds = nowSeconds;
+    previousMode = initialMode;
+    previousModeChangeSeconds = nowSeconds;
+    stableSinceSeconds = nowSeconds;
+    temperatureRate = humidityRate = iaqRate = 0.0f;
+    modeChangeCount = 0;
+    secondsInMode[0] = secondsInMode[1] = secondsInMode[2] = 0;
+}
+
+void SamplingRateController::updateRates(const SensorReading& reading, uint32_t nowSeconds) {
+    if (hasPrevious && nowSeconds > previousSeconds) {
+        float minutes = (nowSeconds - previousSeconds) / 60.0f;
+        float a = config.rateSmoothing;
+        
+        // 1分あたりの変化量をEWMAで平滑化（単発のノイズで昇格しないように）
+        temperatureRate += a * (fabsf(reading.temperature - previous.temperature) / minutes - temperatureRate);
+        humidityRate += a * (fabsf(reading.humidity - previous.humidity) / minutes - humidityRate);
+        if (reading.has_iaq_data && previous.has_iaq_data) {
+            iaqRate += a * (fabsf(reading.iaq - previous.iaq) / minutes - iaqRate);
+        }
+        
+        secondsInMode[(int)currentMode] += nowSeconds - previousSeconds;
+    }
+    
+    previous = reading;
+    previousSeconds = nowSeconds;
+    hasPrevious = true;
+}
+
+SamplingMode SamplingRateController::decideMode(const SensorReading& reading, uint32_t nowSeconds) {
+    // IAQ逸脱の判定（入る閾値と出る閾値を分けてばたつきを防ぐ）
+    if (reading.has_iaq_data) {
+        if (reading.iaq >= config.iaqExcursionEnter) {
+            excursionActive = true;
+        } else if (reading.iaq < config.iaqExcursionExit) {
+            excursionActive = false;
+        }
+    }
+    
+    bool fastChange = temperatureRate > config.temperatureRateHigh ||
+                      humidityRate > config.humidityRateHigh ||
+                      iaqRate > config.iaqRateHigh;
+    bool slowChange = temperatureRate > config.temperatureRateLow ||
+                      humidityRate > config.humidityRateLow ||
+                      iaqRate > config.iaqRateLow;
+    
+    if (anomalyActive || excursionActive || fastChange) {
+        stableSinceSeconds = nowSeconds;
+        return SamplingMode::CONT;
+    }
+    if (slowChange) {
+        stableSinceSeconds = nowSeconds;
+        return SamplingMode::LP;
+    }
+    if (nowSeconds - stableSinceSeconds >= config.stableSeconds) {
+        return SamplingMode::ULP;
+    }
+    // 安定しはじめてから一定時間はLPを維持
+    return (currentMode == SamplingMode::ULP) ? SamplingMode::ULP : SamplingMode::LP;
+}
+
+bool SamplingRateController::update(const SensorReading& reading, uint32_t nowSeconds, SamplingMode& newMode) {
+    updateRates(reading, nowSeconds);
+    SamplingMode target = decideMode(reading, nowSeconds);
+    
+    if (target == currentMode) {
+        return false;
+    }
+    
+    // 昇格は即時、降格は最短滞在時間を過ぎてから
+    bool escalate = (int)target > (int)currentMode;
+    if (!escalate && nowSeconds - lastModeChangeSeconds < config.minDwellSeconds) {
+        return false;
+    }
+    
+    previousMode = currentMode;
+    previousModeChangeSeconds = lastModeChangeSeconds;
+    currentMode = target;
+    lastModeChangeSeconds = nowSeconds;
+    modeChangeCount++;
+    newMode = target;
+    return true;
+}
+
+void SamplingRateController::rejectModeChange() {
+    if (currentMode == previousMode) return;
+    
+    currentMode = previousMode;
+    lastModeChangeSeconds = previousModeChangeSeconds;
+    modeChangeCount--;
+}
+
+float SamplingRateController::toBsecSampleRate(SamplingMode mode) {
+    switch (mode) {
+        case SamplingMode::ULP: return BSEC_SAMPLE_RATE_ULP;
+        case SamplingMode::CONT: return BSEC_SAMPLE_RATE_CONT;
+        case SamplingMode::LP:
+        default: return BSEC_SAMPLE_RATE_LP;
+    }
+}
+
+const char* SamplingRateController::modeToString(SamplingMode mode) {
+    switch (mode) {
+        case SamplingMode::ULP: return "ULP (5分間隔)";
+        case SamplingMode::LP: return "LP (3秒間隔)";
+        case SamplingMode::CONT: return "CONT (1秒間隔)";
+        default: return "不明";
+    }
+}
\ No newline at end of file
@@ -1,32 +1,77 @@
 #include "SensorDataCollector.h"
 #include "ErrorHandler.h"
 #include "TimeUtils.h"
-#include <Wire.h>
+#include "DeviceRegistry.h"
+#include "SensorTrace.h"
+#include "SensorFields.h"
 
 // Static member initialization
-SensorDataCollector* SensorDataCollector::instance = nullptr;
+SensorChannel* SensorDataCollector::runningChannel = nullptr;
+
+const uint16_t BsecTimingStats::BUCKET_LIMITS_MS[BsecTimingStats::BUCKET_COUNT - 1] = {
+    1, 2, 5, 10, 20, 50, 100, 500
+};
+
+void BsecTimingStats::record(int32_t errorMs) {
+    if (errorMs < 0) errorMs = 0;
+    
+    uint8_t bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && errorMs >= BUCKET_LIMITS_MS[bucket]) {
+        bucket++;
+    }
+    histogram[bucket]++;
+    sampleCount++;
+    if (errorMs > maxErrorMs) maxErrorMs = errorMs;
+}
+
+String BsecTimingStats::toString() const {
+    String result = "BSEC呼び出し誤差: " + String(sampleCount) + "回, 最大" + String(maxErrorMs) + 
+                    "ms, 警告14: " + String(timingViolationCount) + "回\n";
+    for (uint8_t i = 0; i < BUCKET_COUNT; i++) {
+        String label = (i < BUCKET_COUNT - 1) ? "  <" + String(BUCKET_LIMITS_MS[i]) + "ms: " : 
+                                                 "  >=" + String(BUCKET_LIMITS_MS[BUCKET_COUNT - 2]) + "ms: ";
+        result += label + String(histogram[i]) + "\n";
+    }
+    return result;
+}
 
 SensorDataCollector::SensorDataCollector() :
+    channelCount(0),
+    deviceHandle(DeviceRegistry::DEFAULT_DEVICE),
+    batchConsumerCount(0),
     initialized(false),
-    lastReadingTime(0) {
-    instance = this;
-    
-    // SensorReading構造体の初期化
-    currentReading.timestamp = 0;
-    currentReading.temperature = 0.0f;
-    currentReading.humidity = 0.0f;
-    currentReading.pressure = 0.0f;
-    currentReading.co2_equivalent = 0.0f;
-    currentReading.iaq = 0.0f;
-    currentReading.voc_equivalent = 0.0f;
-    currentReading.gas_resistance = 0.0f;
-    currentReading.stabilized = false;
-    currentReading.runin_status = 0.0f;
-    currentReading.device_id = "M5Stack_001";
+    lastReadingTime(0),
+    gasScanEnabled(false),
+    adaptiveSamplingEnabled(false),
+    traceRecorder(nullptr),
+    injected(nullptr),
+    sensorTask(nullptr),
+    sensorMutex(nullptr),
+    sensorTaskExited(nullptr),
+    sensorTaskRunning(false),
+    bsecStatusPending(false),
+    initializedAtMs(0),
+    calibratedAtMs(0) {
+    // チャンネルごとの読み取り値に所属デバイスとチャンネル番号を設定
+    for (uint8_t i = 0; i < MAX_SENSORS; i++) {
+        channels[i].owner = this;
+        channels[i].channelId = i;
+        channels[i].decode.currentReading.device_handle = deviceHandle;
+        channels[i].decode.currentReading.channel = i;
+        latestReadings[i].device_handle = deviceHandle;
+        latestReadings[i].channel = i;
+    }
 }
 
 SensorDataCollector::~SensorDataCollector() {
-    instance = nullptr;
+    stopSensorTask();
+    if (sensorMutex) {
+        vSemaphoreDelete(sensorMutex);
+    }
+    if (sensorTaskExited) {
+        vSemaphoreDelete(sensorTaskExited);
+    }
+    delete injected;
 }
 
 bool SensorDataCollector::initialize() {
@@ -36,46 +81,117 @@ bool SensorDataCollector::initialize() {
     Wire.begin();
     delay(1000); // センサーの安定化を待つ
     
-    // BME688の初期化（高アドレスから試行）
-    Serial.println("BME688 高アドレス(0x77)で接続を試行中...");
-    if (!envSensor.begin(BME68X_I2C_ADDR_HIGH, Wire)) {
-        Serial.println("BME688 低アドレス(0x76)で接続を試行中...");
-        if (!envSensor.begin(BME68X_I2C_ADDR_LOW, Wire)) {
-            ErrorHandler::logError(ErrorComponent::SENSOR, "BME688_INIT_FAILED", 
-                                  "BME688センサーの初期化に失敗しました");
-            return false;
-        }
+    // envSensorへのアクセス保護（専用BSECタスクとメインループ間）
+    if (!sensorMutex) {
+        sensorMutex = xSemaphoreCreateMutex();
+    }
+    if (!sensorTaskExited) {
+        sensorTaskExited = xSemaphoreCreateBinary();
     }
     
-    Serial.println("BME688センサーが検出されました");
+    // デバイスIDの設定（同じデバイスの複数センサーはチャンネル番号で区別する）
+    deviceHandle = DeviceRegistry::intern("M5Stack_001");
     
-    // BSECライブラリの状態確認
-    checkBsecStatus();
+    // BME688の検出（高アドレス・低アドレスの両方に接続されていれば2チャンネルで動作）
+    const uint8_t addresses[] = { BME68X_I2C_ADDR_HIGH, BME68X_I2C_ADDR_LOW };
+    for (uint8_t i = 0; i < ARRAY_LEN(addresses); i++) {
+        addSensor(addresses[i], Wire);
+    }
+    
+    if (channelCount == 0) {
+        ErrorHandler::logError(ErrorComponent::SENSOR, "BME688_INIT_FAILED", 
+                              "BME688センサーの初期化に失敗しました");
+        return false;
+    }
+    
+    Serial.println("BME688センサーが" + String(channelCount) + "個検出されました");
     
     // センサーの安定化を待つ
     delay(2000);
     
-    // BSEC出力の設定（要件1.1に対応：温度・湿度・気圧・CO2・IAQ・VOCデータ）
     // 最初からフル機能モードで開始
-    bsecSensor fullSensorList[] = {
-        BSEC_OUTPUT_IAQ,                    // 室内空気品質指数
-        BSEC_OUTPUT_STATIC_IAQ,             // 静的IAQ
-        BSEC_OUTPUT_CO2_EQUIVALENT,         // CO2等価値
-        BSEC_OUTPUT_BREATH_VOC_EQUIVALENT,  // VOC等価値
-        BSEC_OUTPUT_RAW_TEMPERATURE,        // 温度
-        BSEC_OUTPUT_RAW_PRESSURE,           // 気圧
-        BSEC_OUTPUT_RAW_HUMIDITY,           // 湿度
-        BSEC_OUTPUT_RAW_GAS,                // ガス抵抗値
-        BSEC_OUTPUT_STABILIZATION_STATUS,   // 安定化状態
-        BSEC_OUTPUT_RUN_IN_STATUS           // 慣らし運転状態
-    };
+    for (uint8_t i = 0; i < channelCount; i++) {
+        if (!subscribeChannel(channels[i])) {
+            return false;
+        }
+    }
+    
+    SamplingMode initialMode = (channels[PRIMARY_CHANNEL].samplePeriodMs == 3000) ? SamplingMode::LP : SamplingMode::ULP;
+    samplingController.reset(initialMode, TimeUtils::toSeconds(TimeUtils::getCurrentUnixTime()));
+    
+    initialized = true;
+    initializedAtMs = millis();
+    Serial.println("BME688センサーの初期化が完了しました（ULPモード: 5分間隔）");
+    Serial.println("注意: 初期化後にupgradeToFullMode()を呼び出すことで、より頻繁な間隔に変更できます");
+    ErrorHandler::logInfo(ErrorComponent::SENSOR, "BME688センサーが正常に初期化されました（" + 
+                          String(channelCount) + "チャンネル）");
+    
+    return true;
+}
+
+bool SensorDataCollector::addSensor(uint8_t i2cAddress, TwoWire& wire) {
+    if (channelCount >= MAX_SENSORS) {
+        ErrorHandler::logWarning(ErrorComponent::SENSOR, "SENSOR_CHANNEL_LIMIT", 
+                                "接続できるBME688は最大" + String(MAX_SENSORS) + "個です");
+        return false;
+    }
+    
+    // 追加が完了するまでchannelCountを増やさないため、タスク側からは見えない
+    SensorChannel& channel = channels[channelCount];
+    
+    Serial.println("BME688 (0x" + String(i2cAddress, HEX) + ") で接続を試行中...");
+#ifdef BSEC_INSTANCE_SIZE
+    // 複数インスタンスではBSECの作業領域をインスタンスごとに割り当てる
+    channel.envSensor.allocateMemory(channel.bsecMemory);
+#endif
+    if (!channel.envSensor.begin(i2cAddress, wire)) {
+        Serial.println("0x" + String(i2cAddress, HEX) + " にBME688は見つかりませんでした");
+        return false;
+    }
+    
+    channel.i2cAddress = i2cAddress;
+    channel.decode.currentReading.device_handle = deviceHandle;
+    Serial.println("BME688センサーが検出されました（チャンネル" + String(channel.channelId) + "）");
+    
+    // BSECライブラリの状態確認
+    checkBsecStatus(channel);
+    
+    // 前回保存した校正状態を復元（購読設定より前に行う）
+    // 主チャンネルは従来の名前空間を使い、既存の保存内容を引き継ぐ
+    if (channel.channelId != PRIMARY_CHANNEL) {
+        char nvsNamespace[16];
+        snprintf(nvsNamespace, sizeof(nvsNamespace), "%s%u", BsecStateStore::DEFAULT_NAMESPACE, channel.channelId);
+        channel.stateStore.setNamespace(nvsNamespace);
+    }
+    restoreState(channel);
+    
+    // コールバック関数の設定（振り分けはrunningChannelで行う）
+    channel.envSensor.attachCallback(bsecCallback);
+    
+    // 初期化後に追加したセンサーはすぐに購読を開始する
+    if (initialized && !subscribeChannel(channel)) {
+        return false;
+    }
+    
+    lockSensor();
+    channelCount++;
+    unlockSensor();
+    return true;
+}
+
+bool SensorDataCollector::subscribeChannel(SensorChannel& channel) {
+    Bsec2& envSensor = channel.envSensor;
+    
+    // BSEC出力の購読内容（要件1.1に対応：温度・湿度・気圧・CO2・IAQ・VOCデータ）
+    bsecSensor fullSensorList[SensorFields::FIELD_COUNT];
+    uint8_t fullSensorCount = SensorFields::buildSubscription(fullSensorList, ARRAY_LEN(fullSensorList));
     
     // フル機能モードで初期化を試行（LP mode: 3秒間隔）
     Serial.println("フル機能モード（LP: 3秒間隔）で初期化中...");
-    if (!envSensor.updateSubscription(fullSensorList, ARRAY_LEN(fullSensorList), BSEC_SAMPLE_RATE_LP)) {
+    if (!envSensor.updateSubscription(fullSensorList, fullSensorCount, BSEC_SAMPLE_RATE_LP)) {
         Serial.println("LP mode失敗、ULP mode（5分間隔）で再試行...");
         
-        if (!envSensor.updateSubscription(fullSensorList, ARRAY_LEN(fullSensorList), BSEC_SAMPLE_RATE_ULP)) {
+        if (!envSensor.updateSubscription(fullSensorList, fullSensorCount, BSEC_SAMPLE_RATE_ULP)) {
             Serial.println("フル機能モード失敗、基本RAWデータで再試行...");
             
             // 最後の手段として基本RAWデータのみ
@@ -90,151 +206,227 @@ bool SensorDataCollector::initialize() {
             
             if (!envSensor.updateSubscription(basicSensorList, ARRAY_LEN(basicSensorList), BSEC_SAMPLE_RATE_ULP)) {
                 ErrorHandler::logError(ErrorComponent::SENSOR, "BSEC_SUBSCRIPTION_FAILED", 
-                                      "BSECセンサー出力の購読に失敗しました");
-                checkBsecStatus(); // エラー詳細を出力
+                                      "BSECセンサー出力の購読に失敗しました（チャンネル" + String(channel.channelId) + "）");
+                checkBsecStatus(channel); // エラー詳細を出力
                 return false;
             }
             Serial.println("基本RAWデータモードで初期化成功");
         } else {
             Serial.println("フル機能モード（ULP: 5分間隔）で初期化成功");
         }
+        channel.samplePeriodMs = 300000;
     } else {
         Serial.println("フル機能モード（LP: 3秒間隔）で初期化成功");
+        channel.samplePeriodMs = 3000;
     }
+    channel.nextCallMs = 0;
     
     // 購読設定後の状態確認
-    checkBsecStatus();
+    checkBsecStatus(channel);
+    return true;
+}
+
+void SensorDataCollector::bsecCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bsec) {
+    SensorChannel* channel = runningChannel;
+    if (!channel || !channel->owner) {
+        return;
+    }
+    SensorDataCollector* collector = channel->owner;
     
-    // コールバック関数の設定
-    envSensor.attachCallback(bsecCallback);
+    if (outputs.nOutputs) {
+        collector->onBsecTriggered(*channel, outputs);
+    }
     
-    // デバイスIDの設定
-    currentReading.device_id = "M5Stack_001";
+    // タイムスタンプ（要件1.2に対応：正確な日時タイムスタンプ）
+    bool timeSynced;
+    uint32_t timestamp = TimeUtils::getCurrentUnixTime(timeSynced);
     
-    initialized = true;
-    Serial.println("BME688センサーの初期化が完了しました（ULPモード: 5分間隔）");
-    Serial.println("注意: 初期化後にupgradeToFullMode()を呼び出すことで、より頻繁な間隔に変更できます");
-    ErrorHandler::logInfo(ErrorComponent::SENSOR, "BME688センサーが正常に初期化されました");
+    if (collector->traceRecorder) {
+        collector->traceRecorder->record(data, outputs, timestamp, timeSynced, channel->channelId);
+    }
+    collector->processBsecData(channel->decode, data, outputs, timestamp, timeSynced);
+}
+
+bool SensorDataCollector::runChannel(SensorChannel& channel) {
+    // コールバックの振り分け先を記録してから呼び出す
+    // （タスク動作中はlockSensor()の内側で呼ぶため、他のチャンネルと重ならない）
+    runningChannel = &channel;
+    bool ok = channel.envSensor.run();
+    runningChannel = nullptr;
+    
+    // 警告ではrun()がtrueを返すため、タイミング違反は呼び出しごとにステータスで数える
+    if (channel.envSensor.status == BSEC_TIMING_WARNING) {
+        timingStats.timingViolationCount++;
+    }
+    return ok;
+}
+
+void SensorDataCollector::onBsecTriggered(SensorChannel& channel, const bsecOutputs& outputs) {
+    // 出力のタイムスタンプはBSECを実際に呼び出した時刻（ns）
+    int64_t triggerMs = outputs.output[0].time_stamp / 1000000;
+    
+    // 予定時刻からの遅れを記録し、次の呼び出し予定時刻を更新
+    // （ガススキャン中は周期を推定せずにポーリングするため記録しない）
+    if (channel.nextCallMs > 0 && channel.samplePeriodMs > 0) {
+        timingStats.record((int32_t)(triggerMs - channel.nextCallMs));
+    }
+    channel.nextCallMs = triggerMs + channel.samplePeriodMs;
+}
+
+void SensorDataCollector::setTraceRecorder(SensorTraceRecorder* recorder) {
+    // record()はBSECタスクのコールバック内から呼ばれるため、差し替えはBSEC呼び出しの合間に行う
+    lockSensor();
+    traceRecorder = recorder;
+    unlockSensor();
+}
+
+bool SensorDataCollector::publishReading(const SensorReading& reading) {
+    if (reading.synthetic && !injected) {
+        createInjectedState();
+    }
     
+    lockSensor();
+    bool pushed = readingRing.push(reading);
+    unlockSensor();
+    return pushed;
+}
+
+bool SensorDataCollector::injectBsecData(const bme68xData& data, const bsecOutputs& outputs, uint32_t timestamp, 
+                                         bool timeSynced, uint8_t channel) {
+    // 記録済みトレースの再生用：BSECコールバックと同じ経路で、再生用のチャンネル状態へデータを投入
+    if (channel >= MAX_SENSORS) {
+        return true;  // 投入先がないレコードは読み飛ばす
+    }
+    if (!injected) {
+        createInjectedState();
+    }
+    
+    // リングは単一生産者のため、BSECタスクのrun()と同じロックの内側で積む
+    lockSensor();
+    if (getFreeReadingSlots() == 0) {
+        unlockSensor();
+        return false;
+    }
+    processBsecData(injected->replayChannels[channel], data, outputs, timestamp, timeSynced);
+    unlockSensor();
     return true;
 }
 
-void SensorDataCollector::bsecCallback(const bme68xData data, const bsecOutputs outputs, Bsec2 bsec) {
-    if (instance) {
-        instance->processBsecData(data, outputs);
+void SensorDataCollector::createInjectedState() {
+    injected = new InjectedState();
+    for (uint8_t i = 0; i < MAX_SENSORS; i++) {
+        SensorReading& reading = injected->replayChannels[i].currentReading;
+        reading.device_handle = deviceHandle;
+        reading.channel = i;
+        reading.replayed = true;
     }
+    // 外れ値判定は実センサーと同じ設定で、窓と件数だけ別にする
+    injected->filter = readingFilter;
+    injected->filter.reset();
 }
 
-void SensorDataCollector::processBsecData(const bme68xData data, const bsecOutputs outputs) {
-    if (!outputs.nOutputs) {
+void SensorDataCollector::processBsecData(BsecDecodeState& state, const bme68xData& data, 
+                                          const bsecOutputs& outputs, uint32_t timestamp, bool timeSynced) {
+    const bool hasOutputs = outputs.nOutputs > 0;
+    if (hasOutputs) {
+        state.currentReading.timestamp = timestamp;
+        state.currentReading.time_synced = timeSynced;
+        lastReadingTime = millis();
+        
+        // BSECデータの処理
+        updateCurrentReading(state, outputs);
+    }
+    
+    // ガススキャン中はヒーターステップごとに呼ばれるため、プロファイル1周ごとにまとめて配信する
+    // BSECの出力がないステップでも生のガス抵抗は有効なので、出力の有無より先にまとめる
+    if (gasScanEnabled) {
+        lastReadingTime = millis();
+        GasScan scan;
+        if (!state.scanAssembler.addStep(data, outputs, timestamp, scan)) {
+            return;
+        }
+        scan.device_handle = state.currentReading.device_handle;
+        scan.channel = state.currentReading.channel;
+        if (!scanRing.push(scan)) {
+            Serial.println("ガススキャンのリングバッファが満杯です - スキャンを破棄しました");
+        }
+        if (!hasOutputs) {
+            return;
+        }
+    } else if (!hasOutputs) {
         Serial.println("BSECから出力データがありません");
         return;
     }
     
-    // タイムスタンプの更新（要件1.2に対応：正確な日時タイムスタンプ）
-    currentReading.timestamp = TimeUtils::getCurrentUnixTime();
-    lastReadingTime = millis();
-    
-    // BSECデータの処理
-    updateCurrentReading(outputs);
-    
+    // BSECコールバック内ではPODの読み取り値をリングに積むだけにする
+    // 表示・アップロード・保存はdispatchPendingReadings()でBSEC処理の外から実行される
+    if (!readingRing.push(state.currentReading)) {
+        Serial.println("センサーデータのリングバッファが満杯です - サンプルを破棄しました");
+    }
+}
+
+void SensorDataCollector::updateCurrentReading(BsecDecodeState& state, const bsecOutputs& outputs) {
+    // sensor_idごとの格納先・単位換算はSensorFields.hの対応表で定義
+    uint8_t accuracy = state.iaqAccuracy;
+    SensorFields::decode(outputs, state.currentReading, &accuracy);
+    state.iaqAccuracy = accuracy;
+}
+
+void SensorDataCollector::logReading(const SensorReading& reading) {
     // デバッグ情報の出力（取得できたデータのみ表示）
-    Serial.println("センサーデータを更新しました (" + String(outputs.nOutputs) + "個の出力):");
+    Serial.println("センサーデータを更新しました:");
     
     // 基本データ（常に表示）
-    Serial.println("  温度: " + String(currentReading.temperature, 1) + "℃");
-    Serial.println("  湿度: " + String(currentReading.humidity, 1) + "%");
-    Serial.println("  気圧: " + String(currentReading.pressure, 1) + "hPa");
-    Serial.println("  ガス抵抗: " + String(currentReading.gas_resistance, 0) + "Ω");
+    Serial.println("  温度: " + String(reading.temperature, 1) + "℃");
+    Serial.println("  湿度: " + String(reading.humidity, 1) + "%");
+    Serial.println("  気圧: " + String(reading.pressure, 1) + "hPa");
+    Serial.println("  ガス抵抗: " + String(reading.gas_resistance, 0) + "Ω");
     
     // 拡張データ（取得できた場合のみ表示）
-    if (currentReading.co2_equivalent > 0) {
-        String co2Status = (currentReading.runin_status < 50) ? " (校正中)" : "";
-        Serial.println("  ✓ CO2: " + String(currentReading.co2_equivalent, 0) + "ppm" + co2Status);
+    if (reading.co2_equivalent > 0) {
+        String co2Status = (reading.runin_status < 50) ? " (校正中)" : "";
+        Serial.println("  ✓ CO2: " + String(reading.co2_equivalent, 0) + "ppm" + co2Status);
     } else {
         Serial.println("  ⚠ CO2: データなし");
     }
     
-    if (currentReading.iaq > 0) {
-        String iaqStatus = (currentReading.runin_status < 50) ? " (校正中)" : "";
-        Serial.println("  ✓ IAQ: " + String(currentReading.iaq, 0) + iaqStatus);
+    if (reading.iaq > 0) {
+        String iaqStatus = (reading.runin_status < 50) ? " (校正中)" : "";
+        Serial.println("  ✓ IAQ: " + String(reading.iaq, 0) + iaqStatus);
     } else {
         Serial.println("  ⚠ IAQ: データなし");
     }
     
-    if (currentReading.voc_equivalent > 0) {
-        String vocStatus = (currentReading.runin_status < 50) ? " (校正中)" : "";
-        Serial.println("  ✓ VOC: " + String(currentReading.voc_equivalent, 1) + "ppm" + vocStatus);
+    if (reading.voc_equivalent > 0) {
+        String vocStatus = (reading.runin_status < 50) ? " (校正中)" : "";
+        Serial.println("  ✓ VOC: " + String(reading.voc_equivalent, 1) + "ppm" + vocStatus);
     } else {
         Serial.println("  ⚠ VOC: データなし");
     }
     
     // ステータス情報
-    Serial.println("  安定状態: " + String(currentReading.stabilized ? "安定" : "調整中"));
-    Serial.println("  慣らし状況: " + String(currentReading.runin_status, 1) + "%");
+    Serial.println("  安定状態: " + String(reading.stabilized ? "安定" : "調整中"));
+    Serial.println("  慣らし状況: " + String(reading.runin_status, 1) + "%");
     
     // 校正状態の説明
-    if (currentReading.runin_status < 25) {
+    if (reading.runin_status < 25) {
         Serial.println("  📝 BME688センサーは初期校正中です（数分～数時間かかります）");
-    } else if (currentReading.runin_status < 75) {
+    } else if (reading.runin_status < 75) {
         Serial.println("  🔄 センサー校正が進行中です（値が安定するまでお待ちください）");
     } else {
         Serial.println("  ✅ センサー校正がほぼ完了しました");
     }
-    
-    // ユーザーコールバックの呼び出し
-    if (dataCallback) {
-        dataCallback(currentReading);
-    }
 }
 
-void SensorDataCollector::updateCurrentReading(const bsecOutputs& outputs) {
-    // データ品質フラグをリセット
-    currentReading.has_co2_data = false;
-    currentReading.has_iaq_data = false;
-    currentReading.has_voc_data = false;
-    
-    for (uint8_t i = 0; i < outputs.nOutputs; i++) {
-        const bsecData output = outputs.output[i];
-        
-        switch (output.sensor_id) {
-            case BSEC_OUTPUT_RAW_TEMPERATURE:
-                currentReading.temperature = output.signal;
-                break;
-            case BSEC_OUTPUT_RAW_HUMIDITY:
-                currentReading.humidity = output.signal;
-                break;
-            case BSEC_OUTPUT_RAW_PRESSURE:
-                currentReading.pressure = output.signal / 100.0f; // Convert to hPa
-                break;
-            case BSEC_OUTPUT_CO2_EQUIVALENT:
-                currentReading.co2_equivalent = output.signal;
-                currentReading.has_co2_data = true;
-                break;
-            case BSEC_OUTPUT_IAQ:
-                currentReading.iaq = output.signal;
-                currentReading.has_iaq_data = true;
-                break;
-            case BSEC_OUTPUT_BREATH_VOC_EQUIVALENT:
-                currentReading.voc_equivalent = output.signal;
-                currentReading.has_voc_data = true;
-                break;
-            case BSEC_OUTPUT_RAW_GAS:
-                currentReading.gas_resistance = output.signal;
-                break;
-            case BSEC_OUTPUT_STABILIZATION_STATUS:
-                currentReading.stabilized = (output.signal == 1);
-                break;
-            case BSEC_OUTPUT_RUN_IN_STATUS:
-                currentReading.runin_status = output.signal;
-                currentReading.is_calibrated = (output.signal >= 75.0f);
-                break;
-        }
-    }
+SensorReading SensorDataCollector::getCurrentReading() {
+    return latestReadings[PRIMARY_CHANNEL];
 }
 
-SensorReading SensorDataCollector::getCurrentReading() {
-    return currentReading;
+SensorReading SensorDataCollector::getCurrentReading(uint8_t channel) {
+    if (channel >= MAX_SENSORS) {
+        return SensorReading();
+    }
+    return latestReadings[channel];
 }
 
 bool SensorDataCollector::isDataValid() {
@@ -244,7 +436,7 @@ bool SensorDataCollector::isDataValid() {
     // 3. タイムスタンプが設定されている
     bool isValid = initialized && 
                    (millis() - lastReadingTime < 600000) && 
-                   (currentReading.timestamp > 0);
+                   (latestReadings[PRIMARY_CHANNEL].timestamp > 0);
     
     if (!isValid && initialized) {
         Serial.println("センサーデータが無効です - 最後の読み取りから時間が経過しています");
@@ -258,12 +450,364 @@ void SensorDataCollector::setCallback(SensorCallback callback) {
 }
 
 void SensorDataCollector::update() {
-    if (!initialized) return;
+    // Run BSEC processing（専用タスク動作中はタスク側で実行、未初期化でも再生データの配信は行う）
+    if (initialized && !sensorTaskRunning) {
+        for (uint8_t i = 0; i < channelCount; i++) {
+            if (!runChannel(channels[i])) {
+                checkBsecStatus(channels[i]);
+            }
+        }
+    }
     
-    // Run BSEC processing
-    if (!envSensor.run()) {
+    // タスク側で検出したBSEC異常をログに出力
+    if (bsecStatusPending) {
+        bsecStatusPending = false;
+        lockSensor();
         checkBsecStatus();
+        unlockSensor();
     }
+    
+    // 校正状態の定期保存
+    maybeSaveState();
+    
+    // 記録中のトレースをファイルへ書き出す
+    // record()はBSEC呼び出し中に行われるため、バッファの入れ替えだけを排他し、SDカードへの書き込みはロックの外で行う
+    // （setTraceRecorder()による差し替えもメインループから行うため、ここで取り出したレコーダーは書き出し中に外れない）
+    if (traceRecorder) {
+        lockSensor();
+        traceRecorder->swapBuffers();
+        unlockSensor();
+        traceRecorder->flush();
+    }
+    
+    // BSEC処理の外で溜まったサンプルを消費者へ配信
+    dispatchPendingReadings();
+    flushBatches();
+}
+
+bool SensorDataCollector::restoreState(SensorChannel& channel) {
+    uint8_t state[BsecStateStore::STATE_SIZE];
+    
+    if (!channel.stateStore.load(state, sizeof(state), channel.envSensor.version)) {
+        return false;
+    }
+    if (!channel.envSensor.setState(state)) {
+        ErrorHandler::logWarning(ErrorComponent::SENSOR, "BSEC_STATE_RESTORE_FAILED", 
+                                "BSEC状態の復元に失敗しました。校正をやり直します（チャンネル" + 
+                                String(channel.channelId) + "）");
+        checkBsecStatus(channel);
+        return false;
+    }
+    
+    channel.stateRestored = true;
+    Serial.println("保存済みのBSEC校正状態を復元しました（チャンネル" + String(channel.channelId) + "）");
+    return true;
+}
+
+bool SensorDataCollector::saveState() {
+    bool saved = false;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        if (saveState(channels[i])) {
+            saved = true;
+        }
+    }
+    return saved;
+}
+
+bool SensorDataCollector::saveState(SensorChannel& channel) {
+    // 校正が完了していない状態で良い保存内容を上書きしない
+    if (!initialized || channel.decode.iaqAccuracy < 3) return false;
+    
+    // getState()は直列化した長さを返さないため、0で初期化して末尾の未使用部分を一定にする
+    uint8_t state[BsecStateStore::STATE_SIZE];
+    memset(state, 0, sizeof(state));
+    lockSensor();
+    bool ok = channel.envSensor.getState(state);
+    unlockSensor();
+    
+    if (!ok) {
+        checkBsecStatus(channel);
+        return false;
+    }
+    return channel.stateStore.save(state, sizeof(state), channel.envSensor.version);
+}
+
+void SensorDataCollector::maybeSaveState() {
+    if (!initialized) return;
+    
+    // 校正完了後に1回保存し、その後はフラッシュの摩耗を抑えるため一定間隔ごと
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < channelCount; i++) {
+        SensorChannel& channel = channels[i];
+        if (channel.decode.iaqAccuracy < 3) continue;
+        if (channel.stateSavedThisBoot && now - channel.lastStateSaveMs < STATE_SAVE_INTERVAL_MS) continue;
+        if (channel.stateSaveBackoffMs > 0 && now - channel.lastStateSaveAttemptMs < channel.stateSaveBackoffMs) continue;
+        
+        channel.lastStateSaveAttemptMs = now;
+        if (!saveState(channel)) {
+            // 保存済みとはせず、間隔を倍にしながら再試行する（最長で通常の保存間隔）
+            uint32_t backoffMs = (channel.stateSaveBackoffMs == 0) ? STATE_SAVE_RETRY_MS : channel.stateSaveBackoffMs * 2;
+            channel.stateSaveBackoffMs = (backoffMs < STATE_SAVE_INTERVAL_MS) ? backoffMs : STATE_SAVE_INTERVAL_MS;
+            continue;
+        }
+        
+        Serial.println("BSEC校正状態を保存しました（チャンネル" + String(i) + "、累計" + 
+                       String(channel.stateStore.getSaveCount()) + "回）");
+        channel.stateSavedThisBoot = true;
+        channel.lastStateSaveMs = now;
+        channel.stateSaveBackoffMs = 0;
+    }
+}
+
+String SensorDataCollector::getStateReport() const {
+    String report = "BSEC状態:";
+    for (uint8_t i = 0; i < channelCount; i++) {
+        const SensorChannel& channel = channels[i];
+        report += " [ch" + String(i) + "] " + String(channel.stateRestored ? "復元済み" : "新規校正") + 
+                  ", 保存" + String(channel.stateStore.getSaveCount()) + "回" +
+                  "（変化なしで省略" + String(channel.stateStore.getSkippedCount()) + "回、" +
+                  String(channel.stateStore.getBytesWritten()) + "バイト書き込み）";
+    }
+    if (calibratedAtMs != 0) {
+        report += ", 校正済みまで" + String((calibratedAtMs - initializedAtMs) / 1000) + "秒";
+    }
+    return report;
+}
+
+bool SensorDataCollector::startSensorTask(UBaseType_t priority, BaseType_t core) {
+    if (!initialized || sensorTaskRunning) {
+        return false;
+    }
+    
+    sensorTaskRunning = true;
+    BaseType_t result = xTaskCreatePinnedToCore(sensorTaskEntry, "bsec", SENSOR_TASK_STACK_SIZE, 
+                                                this, priority, &sensorTask, core);
+    if (result != pdPASS) {
+        sensorTaskRunning = false;
+        sensorTask = nullptr;
+        ErrorHandler::logError(ErrorComponent::SENSOR, "SENSOR_TASK_CREATE_FAILED", 
+                              "BSECタスクの作成に失敗しました。メインループで処理します");
+        return false;
+    }
+    
+    Serial.println("BSEC専用タスクを開始しました（優先度 " + String((int)priority) + ", コア " + String((int)core) + "）");
+    return true;
+}
+
+void SensorDataCollector::stopSensorTask() {
+    if (!sensorTaskRunning) return;
+    
+    // タスクは待ちから起こされるとフラグを確認してループを抜け、終了を通知してから自身を削除する
+    // 戻った後は呼び出し側がインスタンスを破棄できるよう、終了の通知まで待つ
+    sensorTaskRunning = false;
+    xTaskNotifyGive(sensorTask);
+    if (xSemaphoreTake(sensorTaskExited, pdMS_TO_TICKS(SENSOR_TASK_STOP_TIMEOUT_MS)) != pdTRUE) {
+        ErrorHandler::logWarning(ErrorComponent::SENSOR, "SENSOR_TASK_STOP_TIMEOUT", 
+                                "BSECタスクの終了を確認できませんでした");
+    }
+    sensorTask = nullptr;
+}
+
+void SensorDataCollector::sensorTaskEntry(void* param) {
+    SensorDataCollector* collector = static_cast<SensorDataCollector*>(param);
+    collector->sensorTaskLoop();
+    xSemaphoreGive(collector->sensorTaskExited);
+    vTaskDelete(nullptr);
+}
+
+int64_t SensorDataCollector::getEarliestCallMs() const {
+    int64_t earliest = INT64_MAX;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        if (channels[i].nextCallMs < earliest) {
+            earliest = channels[i].nextCallMs;
+        }
+    }
+    return (earliest == INT64_MAX) ? 0 : earliest;
+}
+
+void SensorDataCollector::sensorTaskLoop() {
+    while (sensorTaskRunning) {
+        // いずれかのチャンネルが次の呼び出しを要求する時刻まで眠る（stopSensorTask()の通知でも起床）
+        int64_t expectedCallMs = getEarliestCallMs();
+        int64_t waitMs = expectedCallMs - Bsec2::getTimeMs();
+        if (waitMs > 0) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+            if (!sensorTaskRunning) break;
+        }
+        
+        // 測定時刻に達していないチャンネルはrun()内で何もせずに戻る
+        bool triggered = false;
+        lockSensor();
+        for (uint8_t i = 0; i < channelCount; i++) {
+            SensorChannel& channel = channels[i];
+            int64_t channelExpectedMs = channel.nextCallMs;
+            if (!runChannel(channel)) {
+                bsecStatusPending = true;
+            }
+            if (channel.nextCallMs != channelExpectedMs) {
+                triggered = true;
+            }
+        }
+        unlockSensor();
+        
+        // 測定がまだ始まらなかった場合（予定時刻の推定がBSECより早い）は短い間隔で再試行
+        // モード変更直後など推定が大きく外れている間は10ms間隔に落としてCPUを消費しすぎない
+        // （この待ちもstopSensorTask()の通知で抜ける）
+        if (!triggered) {
+            int64_t lateMs = Bsec2::getTimeMs() - expectedCallMs;
+            ulTaskNotifyTake(pdTRUE, (expectedCallMs == 0 || lateMs > POLL_BACKOFF_MS) ? pdMS_TO_TICKS(10) : 1);
+        }
+    }
+}
+
+void SensorDataCollector::lockSensor() {
+    if (sensorMutex) {
+        xSemaphoreTake(sensorMutex, portMAX_DELAY);
+    }
+}
+
+void SensorDataCollector::unlockSensor() {
+    if (sensorMutex) {
+        xSemaphoreGive(sensorMutex);
+    }
+}
+
+size_t SensorDataCollector::dispatchPendingReadings(size_t maxCount) {
+    size_t dispatched = 0;
+    SensorReading reading;
+    
+    while (dispatched < maxCount && popReading(reading)) {
+        // 外れ値に印を付けてから（設定により中央値に置き換えて）配信する
+        // 再生・合成負荷の値は実センサーとは別の窓で判定し、最新値・校正時間・適応サンプリングには使わない
+        const bool live = !reading.replayed && !reading.synthetic;
+        ReadingFilter& filter = (live || !injected) ? readingFilter : injected->filter;
+        if (filter.apply(reading)) {
+            Serial.println("外れ値を検出しました（mask=0x" + String(reading.outlier_mask, HEX) + "）");
+        }
+        
+        bool primary = live && (reading.channel == PRIMARY_CHANNEL);
+        if (live && reading.channel < MAX_SENSORS) {
+            latestReadings[reading.channel] = reading;
+        }
+        
+        // 起動から校正済みデータが得られるまでの時間を記録
+        if (primary && calibratedAtMs == 0 && reading.is_calibrated && initializedAtMs != 0) {
+            calibratedAtMs = millis();
+            ErrorHandler::logInfo(ErrorComponent::SENSOR, "校正済みデータまでの時間: " + 
+                                  String((calibratedAtMs - initializedAtMs) / 1000) + "秒" +
+                                  (channels[PRIMARY_CHANNEL].stateRestored ? "（保存状態から復元）" : ""));
+        }
+        if (channelCount > 1) {
+            Serial.println("[チャンネル" + String(reading.channel) + "]");
+        }
+        logReading(reading);
+        
+        // ユーザーコールバックの呼び出し（チャンネルはreading.channelで判別）
+        if (dataCallback) {
+            dataCallback(reading);
+        }
+        
+        // 全件を受け取る一括配信のバッファへ追加し、件数上限に達したものから配信
+        for (uint8_t i = 0; i < batchConsumerCount; i++) {
+            if (batchConsumers[i].autoEnqueue) {
+                appendToBatch(batchConsumers[i], reading);
+            }
+        }
+        
+        // 変化率に応じてサンプリングモードを切り替え（BSECコールバックの外で行う）
+        // 判定は主チャンネルの値で行い、モードは全チャンネルに適用する
+        // （切り替えに失敗した場合は変化率の平滑値を残したままモードだけ戻し、次の読み取り値で再判定する）
+        SamplingMode newMode;
+        if (adaptiveSamplingEnabled && initialized && primary && !gasScanEnabled &&
+            samplingController.update(reading, TimeUtils::toSeconds(reading.timestamp, reading.time_synced), newMode)) {
+            if (!setSamplingMode(SamplingRateController::toBsecSampleRate(newMode))) {
+                samplingController.rejectModeChange();
+            }
+        }
+        dispatched++;
+    }
+    
+    GasScan scan;
+    while (dispatched < maxCount && scanRing.pop(scan)) {
+        if (gasScanCallback) {
+            gasScanCallback(scan);
+        }
+        dispatched++;
+    }
+    
+    return dispatched;
+}
+
+int8_t SensorDataCollector::addBatchConsumer(SensorBatchCallback callback, size_t maxBatchSize, uint32_t maxLatencyMs,
+                                             bool autoEnqueue) {
+    if (batchConsumerCount >= MAX_BATCH_CONSUMERS || !callback) {
+        ErrorHandler::logWarning(ErrorComponent::SENSOR, "BATCH_CONSUMER_LIMIT", 
+                                "一括配信の登録数が上限に達しています");
+        return -1;
+    }
+    
+    int8_t consumerId = (int8_t)batchConsumerCount;
+    SensorBatchConsumer& consumer = batchConsumers[batchConsumerCount++];
+    consumer.callback = callback;
+    consumer.autoEnqueue = autoEnqueue;
+    if (maxBatchSize < 1) maxBatchSize = 1;
+    if (maxBatchSize > SensorBatchConsumer::MAX_SIZE) maxBatchSize = SensorBatchConsumer::MAX_SIZE;
+    consumer.maxBatchSize = maxBatchSize;
+    consumer.maxLatencyMs = maxLatencyMs;
+    consumer.count = 0;
+    return consumerId;
+}
+
+bool SensorDataCollector::enqueueBatch(int8_t consumerId, const SensorReading& reading) {
+    if (consumerId < 0 || consumerId >= batchConsumerCount) {
+        return false;
+    }
+    appendToBatch(batchConsumers[consumerId], reading);
+    return true;
+}
+
+void SensorDataCollector::appendToBatch(SensorBatchConsumer& consumer, const SensorReading& reading) {
+    if (consumer.count == 0) {
+        consumer.firstQueuedMs = millis();
+    }
+    consumer.buffer[consumer.count++] = reading;
+    if (consumer.count >= consumer.maxBatchSize) {
+        flushBatch(consumer);
+    }
+}
+
+void SensorDataCollector::flushBatches(bool force) {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < batchConsumerCount; i++) {
+        SensorBatchConsumer& consumer = batchConsumers[i];
+        if (consumer.count > 0 && (force || now - consumer.firstQueuedMs >= consumer.maxLatencyMs)) {
+            flushBatch(consumer);
+        }
+    }
+}
+
+void SensorDataCollector::flushBatch(SensorBatchConsumer& consumer) {
+    // 配信中に新しいサンプルが追加されることはない（dispatchPendingReadings()と同じスレッド）
+    consumer.callback(consumer.buffer, consumer.count);
+    consumer.batchCount++;
+    consumer.readingCount += consumer.count;
+    consumer.count = 0;
+}
+
+String SensorDataCollector::getBatchReport() const {
+    String report = "";
+    for (uint8_t i = 0; i < batchConsumerCount; i++) {
+        const SensorBatchConsumer& consumer = batchConsumers[i];
+        float average = consumer.batchCount ? (float)consumer.readingCount / consumer.batchCount : 0.0f;
+        report += "一括配信" + String(i) + ": " + String(consumer.batchCount) + "回, " + 
+                  String(consumer.readingCount) + "件（平均" + String(average, 1) + "件/回）, 保留" + 
+                  String((uint32_t)consumer.count) + "件\n";
+    }
+    return report;
+}
+
+bool SensorDataCollector::popReading(SensorReading& reading) {
+    return readingRing.pop(reading);
 }
 
 bool SensorDataCollector::setSamplingMode(float sampleRate) {
@@ -271,9 +815,56 @@ bool SensorDataCollector::setSamplingMode(float sampleRate) {
         Serial.println("エラー: センサーが初期化されていません");
         return false;
     }
+    if (gasScanEnabled) {
+        Serial.println("ガススキャン中はサンプリングモードを変更できません");
+        return false;
+    }
+    
+    String modeStr = (sampleRate == BSEC_SAMPLE_RATE_ULP) ? "ULP (5分間隔)" :
+                     (sampleRate == BSEC_SAMPLE_RATE_LP) ? "LP (3秒間隔)" : "CONT (1秒間隔)";
+    
+    Serial.println("サンプリングモードを " + modeStr + " に変更中...");
+    
+    // 現在のフル機能の購読内容を維持したまま間隔だけ変更する（全チャンネル）
+    bsecSensor fullSensorList[SensorFields::FIELD_COUNT];
+    uint8_t fullSensorCount = SensorFields::buildSubscription(fullSensorList, ARRAY_LEN(fullSensorList));
+    bool subscribed = true;
+    lockSensor();
+    for (uint8_t i = 0; i < channelCount; i++) {
+        SensorChannel& channel = channels[i];
+        if (!channel.envSensor.updateSubscription(fullSensorList, fullSensorCount, sampleRate)) {
+            subscribed = false;
+            continue;
+        }
+        // 呼び出し周期を更新し、次回の要求時刻はBSECの次の測定から取り直す
+        channel.samplePeriodMs = (uint32_t)(1000.0f / sampleRate + 0.5f);
+        channel.nextCallMs = 0;
+    }
+    unlockSensor();
+    
+    if (!subscribed) {
+        ErrorHandler::logError(ErrorComponent::SENSOR, "SAMPLING_MODE_CHANGE_FAILED", 
+                              "サンプリングモードの変更に失敗しました");
+        checkBsecStatus();
+        return false;
+    }
+    
+    Serial.println("サンプリングモードの変更が完了しました: " + modeStr);
+    return true;
+}
+
+bool SensorDataCollector::enableGasScan(const uint8_t* config) {
+    if (!initialized) {
+        Serial.println("エラー: センサーが初期化されていません");
+        return false;
+    }
     
-    // 現在の設定を保持
-    bsecSensor sensorList[] = {
+    bsecSensor scanSensorList[] = {
+        BSEC_OUTPUT_GAS_ESTIMATE_1,         // ガス分類の推定値（AI-Studioで学習したクラス）
+        BSEC_OUTPUT_GAS_ESTIMATE_2,
+        BSEC_OUTPUT_GAS_ESTIMATE_3,
+        BSEC_OUTPUT_GAS_ESTIMATE_4,
+        BSEC_OUTPUT_RAW_GAS_INDEX,          // ヒーターステップ番号
         BSEC_OUTPUT_RAW_TEMPERATURE,
         BSEC_OUTPUT_RAW_PRESSURE,
         BSEC_OUTPUT_RAW_HUMIDITY,
@@ -282,19 +873,35 @@ bool SensorDataCollector::setSamplingMode(float sampleRate) {
         BSEC_OUTPUT_RUN_IN_STATUS
     };
     
-    String modeStr = (sampleRate == BSEC_SAMPLE_RATE_ULP) ? "ULP (5分間隔)" :
-                     (sampleRate == BSEC_SAMPLE_RATE_LP) ? "LP (3秒間隔)" : "CONT (1秒間隔)";
+    Serial.println("並列モードのヒータープロファイルスキャンに切り替え中...");
     
-    Serial.println("サンプリングモードを " + modeStr + " に変更中...");
+    bool ok = true;
+    lockSensor();
+    for (uint8_t i = 0; i < channelCount; i++) {
+        SensorChannel& channel = channels[i];
+        if (!channel.envSensor.setConfig(config) ||
+            !channel.envSensor.updateSubscription(scanSensorList, ARRAY_LEN(scanSensorList), BSEC_SAMPLE_RATE_SCAN)) {
+            ok = false;
+            break;
+        }
+        // ステップごとの要求間隔はプロファイルで変わるため、周期は推定せずにポーリングする
+        channel.samplePeriodMs = 0;
+        channel.nextCallMs = 0;
+        channel.decode.scanAssembler.reset();
+    }
+    if (ok) {
+        gasScanEnabled = true;
+    }
+    unlockSensor();
     
-    if (!envSensor.updateSubscription(sensorList, ARRAY_LEN(sensorList), sampleRate)) {
-        ErrorHandler::logError(ErrorComponent::SENSOR, "SAMPLING_MODE_CHANGE_FAILED", 
-                              "サンプリングモードの変更に失敗しました");
+    if (!ok) {
+        ErrorHandler::logError(ErrorComponent::SENSOR, "GAS_SCAN_ENABLE_FAILED", 
+                              "ガススキャンモードへの切り替えに失敗しました");
         checkBsecStatus();
         return false;
     }
     
-    Serial.println("サンプリングモードの変更が完了しました: " + modeStr);
+    Serial.println("ガススキャンモードを開始しました");
     return true;
 }
 
@@ -306,61 +913,54 @@ bool SensorDataCollector::upgradeToFullMode() {
     
     Serial.println("フル機能モード（CO2・IAQ・VOC含む）にアップグレード中...");
     
-    // フル機能のセンサーリスト
-    bsecSensor fullSensorList[] = {
-        BSEC_OUTPUT_IAQ,                    // 室内空気品質指数
-        BSEC_OUTPUT_STATIC_IAQ,             // 静的IAQ
-        BSEC_OUTPUT_CO2_EQUIVALENT,         // CO2等価値
-        BSEC_OUTPUT_BREATH_VOC_EQUIVALENT,  // VOC等価値
-        BSEC_OUTPUT_RAW_TEMPERATURE,        // 温度
-        BSEC_OUTPUT_RAW_PRESSURE,           // 気圧
-        BSEC_OUTPUT_RAW_HUMIDITY,           // 湿度
-        BSEC_OUTPUT_RAW_GAS,                // ガス抵抗値
-        BSEC_OUTPUT_STABILIZATION_STATUS,   // 安定化状態
-        BSEC_OUTPUT_RUN_IN_STATUS           // 慣らし運転状態
-    };
-    
     // LP mode (3秒間隔) でフル機能を試行
-    if (!envSensor.updateSubscription(fullSensorList, ARRAY_LEN(fullSensorList), BSEC_SAMPLE_RATE_LP)) {
-        Serial.println("LP mode失敗、ULP mode (5分間隔) でフル機能を試行...");
-        
-        if (!envSensor.updateSubscription(fullSensorList, ARRAY_LEN(fullSensorList), BSEC_SAMPLE_RATE_ULP)) {
-            ErrorHandler::logError(ErrorComponent::SENSOR, "FULL_MODE_UPGRADE_FAILED", 
-                                  "フル機能モードへのアップグレードに失敗しました");
-            checkBsecStatus();
-            return false;
-        }
-        Serial.println("フル機能モード（ULP: 5分間隔）でアップグレード完了");
-    } else {
+    if (setSamplingMode(BSEC_SAMPLE_RATE_LP)) {
         Serial.println("フル機能モード（LP: 3秒間隔）でアップグレード完了");
+        return true;
     }
     
+    Serial.println("LP mode失敗、ULP mode (5分間隔) でフル機能を試行...");
+    if (!setSamplingMode(BSEC_SAMPLE_RATE_ULP)) {
+        ErrorHandler::logError(ErrorComponent::SENSOR, "FULL_MODE_UPGRADE_FAILED", 
+                              "フル機能モードへのアップグレードに失敗しました");
+        return false;
+    }
+    Serial.println("フル機能モード（ULP: 5分間隔）でアップグレード完了");
     return true;
 }
 
 void SensorDataCollector::checkBsecStatus() {
+    for (uint8_t i = 0; i < channelCount; i++) {
+        checkBsecStatus(channels[i]);
+    }
+}
+
+void SensorDataCollector::checkBsecStatus(SensorChannel& channel) {
+    const Bsec2& envSensor = channel.envSensor;
+    String channelLabel = (channelCount > 1) ? "[ch" + String(channel.channelId) + "] " : "";
+    
     // BSECライブラリのステータスチェック
     if (envSensor.status < BSEC_OK) {
-        String errorMsg = "BSECエラー: " + String(envSensor.status);
+        String errorMsg = channelLabel + "BSECエラー: " + String(envSensor.status);
         ErrorHandler::logError(ErrorComponent::SENSOR, "BSEC_ERROR", errorMsg);
         Serial.println(errorMsg);
     } else if (envSensor.status > BSEC_OK) {
-        String warningMsg = "BSEC警告: " + String(envSensor.status);
+        String warningMsg = channelLabel + "BSEC警告: " + String(envSensor.status);
         ErrorHandler::logWarning(ErrorComponent::SENSOR, "BSEC_WARNING", warningMsg);
         
         // 特定の警告の詳細説明
-        if (envSensor.status == 14) {
+        if (envSensor.status == BSEC_TIMING_WARNING) {
             Serial.println("BSEC警告14: タイミング違反が検出されました - ループタイミングを調整してください");
         }
     }
     
     // BME688センサーのステータスチェック
     if (envSensor.sensor.status < BME68X_OK) {
-        String errorMsg = "BME688エラー: " + String(envSensor.sensor.status);
+        String errorMsg = channelLabel + "BME688エラー: " + String(envSensor.sensor.status);
         ErrorHandler::logError(ErrorComponent::SENSOR, "BME688_ERROR", errorMsg);
         Serial.println(errorMsg);
     } else if (envSensor.sensor.status > BME68X_OK) {
-        String warningMsg = "BME688警告: " + String(envSensor.sensor.status);
+        String warningMsg = channelLabel + "BME688警告: " + String(envSensor.sensor.status);
         ErrorHandler::logWarning(ErrorComponent::SENSOR, "BME688_WARNING", warningMsg);
         Serial.println(warningMsg);
     }
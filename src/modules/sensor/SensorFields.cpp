@@ -0,0 +1,111 @@
+#include "SensorFields.h"
+#include "DeviceRegistry.h"
+
+void SensorFields::decode(const bsecOutputs& outputs, SensorReading& reading, uint8_t* iaqAccuracy) {
+    // データ品質フラグをリセット
+    reading.has_co2_data = false;
+    reading.has_iaq_data = false;
+    reading.has_voc_data = false;
+    
+    for (uint8_t i = 0; i < outputs.nOutputs; i++) {
+        const bsecData& output = outputs.output[i];
+        const SensorField* field = find(output.sensor_id);
+        if (!field) continue;
+        
+        if (float* value = slot(*field, reading)) {
+            *value = output.signal * field->scale;
+        }
+        
+        if (field->flags == FIELD_NONE) continue;
+        if (field->flags & FIELD_HAS_CO2) reading.has_co2_data = true;
+        if (field->flags & FIELD_HAS_VOC) reading.has_voc_data = true;
+        if (field->flags & FIELD_HAS_IAQ) {
+            reading.has_iaq_data = true;
+            if (iaqAccuracy) *iaqAccuracy = output.accuracy;
+        }
+        if (field->flags & FIELD_STABILIZED) reading.stabilized = (output.signal == 1);
+        if (field->flags & FIELD_CALIBRATED) reading.is_calibrated = (output.signal >= 75.0f);
+    }
+}
+
+uint8_t SensorFields::buildSubscription(bsecSensor* list, uint8_t maxCount) {
+    uint8_t count = 0;
+    for (size_t i = 0; i < FIELD_COUNT && count < maxCount; i++) {
+        list[count++] = (bsecSensor)SENSOR_FIELDS[i].sensorId;
+    }
+    return count;
+}
+
+float SensorFields::getValue(const SensorField& field, const SensorReading& reading) {
+    if (const float* value = slot(field, reading)) {
+        return *value;
+    }
+    if (field.flags & FIELD_STABILIZED) {
+        return reading.stabilized ? 1.0f : 0.0f;
+    }
+    return 0.0f;
+}
+
+bool SensorFields::hasValue(const SensorField& field, const SensorReading& reading) {
+    if ((field.flags & FIELD_HAS_CO2) && !reading.has_co2_data) return false;
+    if ((field.flags & FIELD_HAS_IAQ) && !reading.has_iaq_data) return false;
+    if ((field.flags & FIELD_HAS_VOC) && !reading.has_voc_data) return false;
+    return true;
+}
+
+String SensorFields::csvHeader() {
+    String header = "timestamp";
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        header += ",";
+        header += SENSOR_FIELDS[i].column;
+    }
+    header += ",device_id,channel,outlier_mask";
+    return header;
+}
+
+String SensorFields::csvRow(const SensorReading& reading) {
+    String row = String(reading.timestamp);
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        const SensorField& field = SENSOR_FIELDS[i];
+        row += ",";
+        row += (field.decimals == 0) ? String((int)getValue(field, reading)) : 
+                                       String(getValue(field, reading), (unsigned int)field.decimals);
+    }
+    row += ",";
+    row += DeviceRegistry::getName(reading.device_handle);
+    row += "," + String(reading.channel) + "," + String(reading.outlier_mask);
+    return row;
+}
+
+void SensorFields::toJson(const SensorReading& reading, JsonDocument& doc) {
+    doc["timestamp"] = reading.timestamp;
+    doc["device_id"] = DeviceRegistry::getName(reading.device_handle);
+    doc["channel"] = reading.channel;
+    doc["outlier_mask"] = reading.outlier_mask;
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        doc[SENSOR_FIELDS[i].column] = getValue(SENSOR_FIELDS[i], reading);
+    }
+}
+
+void SensorFields::describeSchema(JsonDocument& doc) {
+    // SensorReadingをそのまま保存・送信した場合に読み出せるよう、型とオフセットも記述する
+    static const SensorReading probe;
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&probe);
+    
+    doc["version"] = SCHEMA_VERSION;
+    doc["record_size"] = sizeof(SensorReading);
+    JsonArray fields = doc["fields"].to<JsonArray>();
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        const SensorField& field = SENSOR_FIELDS[i];
+        JsonObject entry = fields.add<JsonObject>();
+        entry["name"] = field.column;
+        entry["unit"] = field.unit;
+        entry["bsec_output"] = field.sensorId;
+        if (const float* value = slot(field, probe)) {
+            entry["type"] = "f32";
+            entry["offset"] = (int)(reinterpret_cast<const uint8_t*>(value) - base);
+        } else {
+            entry["type"] = "flag";
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "SensorTrace.h"
+#include "SensorDataCollector.h"
+#include "ErrorHandler.h"
+
+const float SensorTraceReplayer::SPEED_UNTHROTTLED = 0.0f;
+
+// ===== SensorTraceRecorder =====
+
+SensorTraceRecorder::SensorTraceRecorder() :
+    recording(false),
+    buffer(nullptr),
+    bufferUsed(0),
+    flushBuffer(nullptr),
+    flushUsed(0),
+    recordCount(0),
+    droppedCount(0) {
+}
+
+SensorTraceRecorder::~SensorTraceRecorder() {
+    stop();
+}
+
+bool SensorTraceRecorder::begin(fs::FS& fs, const String& path) {
+    stop();
+    
+    traceFile = fs.open(path, FILE_WRITE);
+    if (!traceFile) {
+        ErrorHandler::logError(ErrorComponent::STORAGE, ErrorHandler::ERROR_STORAGE_WRITE_FAILED, 
+                              "トレースファイルの作成に失敗しました: " + path);
+        return false;
+    }
+    
+    buffer = new uint8_t[BUFFER_SIZE];
+    bufferUsed = 0;
+    flushBuffer = new uint8_t[BUFFER_SIZE];
+    flushUsed = 0;
+    recordCount = 0;
+    droppedCount = 0;
+    
+    SensorTraceHeader header = SensorTraceFormat::makeHeader();
+    traceFile.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    
+    recording = true;
+    Serial.println("センサートレースの記録を開始しました: " + path);
+    return true;
+}
+
+void SensorTraceRecorder::stop() {
+    if (recording) {
+        // 書き出し側の残りを先に書いてから、記録側の分を移して書く
+        flush();
+        swapBuffers();
+        flush();
+        traceFile.close();
+        recording = false;
+        Serial.println("センサートレースの記録を終了しました（" + String(recordCount) + "件、破棄" + 
+                       String(droppedCount) + "件）");
+    }
+    
+    delete[] buffer;
+    buffer = nullptr;
+    bufferUsed = 0;
+    delete[] flushBuffer;
+    flushBuffer = nullptr;
+    flushUsed = 0;
+}
+
+void SensorTraceRecorder::record(const bme68xData& data, const bsecOutputs& outputs, uint32_t timestamp, bool timeSynced, 
+                                 uint8_t channel) {
+    if (!recording) return;
+    
+    uint8_t nOutputs = outputs.nOutputs;
+    if (nOutputs > BSEC_NUMBER_OUTPUTS) {
+        nOutputs = BSEC_NUMBER_OUTPUTS;
+    }
+    
+    SensorTraceRecordHeader header;
+    header.captureMs = millis();
+    header.timestamp = timestamp;
+    header.nOutputs = nOutputs;
+    header.channel = channel;
+    header.flags = timeSynced ? SensorTraceRecordHeader::FLAG_TIME_SYNCED : 0;
+    header.reserved = 0;
+    
+    size_t written = SensorTraceFormat::encodeRecord(buffer + bufferUsed, BUFFER_SIZE - bufferUsed, 
+                                                     header, data, outputs.output);
+    if (written == 0) {
+        // flush()が追いつかない場合はBSEC処理を止めずに破棄する
+        droppedCount++;
+        return;
+    }
+    bufferUsed += written;
+    
+    recordCount++;
+}
+
+void SensorTraceRecorder::swapBuffers() {
+    if (!recording || bufferUsed == 0 || flushUsed != 0) {
+        return;
+    }
+    
+    uint8_t* filled = buffer;
+    buffer = flushBuffer;
+    flushBuffer = filled;
+    flushUsed = bufferUsed;
+    bufferUsed = 0;
+}
+
+bool SensorTraceRecorder::flush() {
+    if (!recording || flushUsed == 0) {
+        return true;
+    }
+    
+    size_t written = traceFile.write(flushBuffer, flushUsed);
+    traceFile.flush();
+    bool ok = (written == flushUsed);
+    flushUsed = 0;
+    
+    if (!ok) {
+        ErrorHandler::logError(ErrorComponent::STORAGE, ErrorHandler::ERROR_STORAGE_WRITE_FAILED, 
+                              "トレースの書き込みに失敗しました");
+    }
+    return ok;
+}
+
+// ===== SensorTraceReplayer =====
+
+SensorTraceReplayer::SensorTraceReplayer() :
+    fileSource(traceFile),
+    target(nullptr),
+    replaying(false) {
+}
+
+SensorTraceReplayer::~SensorTraceReplayer() {
+    stop();
+}
+
+bool SensorTraceReplayer::begin(fs::FS& fs, const String& path, SensorDataCollector& collector, float speed) {
+    stop();
+    
+    traceFile = fs.open(path, FILE_READ);
+    if (!traceFile) {
+        ErrorHandler::logError(ErrorComponent::STORAGE, "TRACE_OPEN_FAILED", 
+                              "トレースファイルを開けません: " + path);
+        return false;
+    }
+    
+    if (!player.begin(fileSource, speed, millis())) {
+        ErrorHandler::logError(ErrorComponent::STORAGE, "TRACE_FORMAT_MISMATCH", 
+                              "トレースファイルの形式が一致しません: " + path);
+        traceFile.close();
+        return false;
+    }
+    
+    target = &collector;
+    replaying = true;
+    
+    Serial.println("センサートレースの再生を開始しました: " + path + "（速度 x" + String(speed, 0) + "）");
+    return true;
+}
+
+void SensorTraceReplayer::stop() {
+    if (replaying) {
+        player.stop();
+        traceFile.close();
+        replaying = false;
+        Serial.println("センサートレースの再生を終了しました（" + String(player.getReplayedCount()) + "件）");
+    }
+}
+
+size_t SensorTraceReplayer::update(size_t maxRecords) {
+    if (!replaying) return 0;
+    
+    // 空きを超えて投入するとリング側で破棄されるため、空きの分だけ渡す
+    size_t freeSlots = target->getFreeReadingSlots();
+    if (maxRecords > freeSlots) {
+        maxRecords = freeSlots;
+    }
+    
+    SensorDataCollector* collector = target;
+    size_t fed = player.update(millis(), maxRecords, [collector](const SensorTraceRecord& record) {
+        bool timeSynced = (record.header.flags & SensorTraceRecordHeader::FLAG_TIME_SYNCED) != 0;
+        return collector->injectBsecData(record.data, record.outputs, record.header.timestamp, timeSynced, 
+                                         record.header.channel);
+    });
+    
+    if (!player.isPlaying()) {
+        if (player.getState() == SensorTracePlayer::State::CORRUPTED) {
+            ErrorHandler::logError(ErrorComponent::STORAGE, "TRACE_CORRUPTED", "トレースレコードが破損しています");
+        }
+        stop();
+    }
+    return fed;
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "SensorTracePlayer.h"
+#include <string.h>
+
+const float SensorTracePlayer::SPEED_UNTHROTTLED = 0.0f;
+
+// ===== SensorTraceFormat =====
+
+SensorTraceHeader SensorTraceFormat::makeHeader() {
+    SensorTraceHeader header;
+    memcpy(header.magic, "YKTR", sizeof(header.magic));
+    header.version = VERSION;
+    header.recordHeaderSize = sizeof(SensorTraceRecordHeader);
+    header.bmeDataSize = sizeof(bme68xData);
+    header.bsecDataSize = sizeof(bsecData);
+    return header;
+}
+
+bool SensorTraceFormat::isCompatible(const SensorTraceHeader& header) {
+    return memcmp(header.magic, "YKTR", sizeof(header.magic)) == 0 &&
+           header.version == VERSION &&
+           header.recordHeaderSize == sizeof(SensorTraceRecordHeader) &&
+           header.bmeDataSize == sizeof(bme68xData) &&
+           header.bsecDataSize == sizeof(bsecData);
+}
+
+size_t SensorTraceFormat::recordSize(uint8_t nOutputs) {
+    return sizeof(SensorTraceRecordHeader) + sizeof(bme68xData) + nOutputs * sizeof(bsecData);
+}
+
+size_t SensorTraceFormat::encodeRecord(uint8_t* dst, size_t capacity, const SensorTraceRecordHeader& header,
+                                       const bme68xData& data, const bsecData* outputs) {
+    size_t size = recordSize(header.nOutputs);
+    if (size > capacity) {
+        return 0;
+    }
+    
+    size_t offset = 0;
+    memcpy(dst + offset, &header, sizeof(header));
+    offset += sizeof(header);
+    memcpy(dst + offset, &data, sizeof(bme68xData));
+    offset += sizeof(bme68xData);
+    memcpy(dst + offset, outputs, header.nOutputs * sizeof(bsecData));
+    return size;
+}
+
+// ===== SensorTraceMemorySource =====
+
+size_t SensorTraceMemorySource::read(uint8_t* dst, size_t length) {
+    size_t available = size - position;
+    if (length > available) {
+        length = available;
+    }
+    memcpy(dst, data + position, length);
+    position += length;
+    return length;
+}
+
+// ===== SensorTracePlayer =====
+
+SensorTracePlayer::SensorTracePlayer() :
+    source(nullptr),
+    state(State::IDLE),
+    speedFactor(1.0f),
+    startMs(0),
+    firstCaptureMs(0),
+    replayedCount(0),
+    hasPending(false) {
+}
+
+bool SensorTracePlayer::begin(SensorTraceSource& traceSource, float speed, uint32_t nowMs) {
+    stop();
+    
+    SensorTraceHeader header;
+    if (traceSource.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) != sizeof(header) ||
+        !SensorTraceFormat::isCompatible(header)) {
+        state = State::FORMAT_MISMATCH;
+        return false;
+    }
+    
+    source = &traceSource;
+    speedFactor = speed;
+    replayedCount = 0;
+    state = State::PLAYING;
+    
+    hasPending = readNextRecord();
+    firstCaptureMs = hasPending ? pending.header.captureMs : 0;
+    startMs = nowMs;
+    return state == State::PLAYING;
+}
+
+void SensorTracePlayer::stop() {
+    if (state == State::PLAYING) {
+        state = State::FINISHED;
+    }
+    source = nullptr;
+    hasPending = false;
+}
+
+bool SensorTracePlayer::readNextRecord() {
+    if (source->read(reinterpret_cast<uint8_t*>(&pending.header), sizeof(pending.header)) != sizeof(pending.header)) {
+        return false;
+    }
+    if (pending.header.nOutputs > BSEC_NUMBER_OUTPUTS) {
+        state = State::CORRUPTED;
+        return false;
+    }
+    if (source->read(reinterpret_cast<uint8_t*>(&pending.data), sizeof(pending.data)) != sizeof(pending.data)) {
+        return false;
+    }
+    
+    size_t outputBytes = pending.header.nOutputs * sizeof(bsecData);
+    if (source->read(reinterpret_cast<uint8_t*>(pending.outputs.output), outputBytes) != outputBytes) {
+        return false;
+    }
+    pending.outputs.nOutputs = pending.header.nOutputs;
+    return true;
+}
+
+size_t SensorTracePlayer::update(uint32_t nowMs, size_t maxRecords, const RecordSink& sink) {
+    if (state != State::PLAYING) return 0;
+    
+    size_t fed = 0;
+    while (hasPending && fed < maxRecords) {
+        // 記録時の経過時間を再生速度で縮めた時刻に達するまで待つ
+        if (speedFactor > 0.0f) {
+            uint32_t traceElapsed = pending.header.captureMs - firstCaptureMs;
+            uint32_t replayElapsed = nowMs - startMs;
+            if ((float)replayElapsed * speedFactor < (float)traceElapsed) {
+                break;
+            }
+        }
+        
+        // 投入先が満杯なら読み進めずに次回へ持ち越す
+        if (!sink(pending)) {
+            break;
+        }
+        replayedCount++;
+        fed++;
+        
+        hasPending = readNextRecord();
+    }
+    
+    if (!hasPending) {
+        if (state == State::PLAYING) {
+            state = State::FINISHED;
+        }
+        source = nullptr;
+    }
+    return fed;
+}
\ No newline at end of file
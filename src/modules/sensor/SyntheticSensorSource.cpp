@@ -0,0 +1,167 @@
+#include "SyntheticSensorSource.h"
+#include "SensorDataCollector.h"
+#include "DeviceRegistry.h"
+#include "ErrorHandler.h"
+
+SyntheticSensorSource::SyntheticSensorSource() :
+    target(nullptr),
+    running(false),
+    rngState(1),
+    nextDevice(0),
+    startMicros(0),
+    generatedCount(0),
+    droppedCount(0) {
+}
+
+bool SyntheticSensorSource::begin(SensorDataCollector& collector, const SyntheticLoadConfig& loadConfig) {
+    if (loadConfig.deviceCount == 0 || loadConfig.deviceCount > MAX_VIRTUAL_DEVICES) {
+        ErrorHandler::logError(ErrorComponent::SENSOR, "SYNTHETIC_CONFIG_INVALID", 
+                              "仮想デバイス数が範囲外です: " + String(loadConfig.deviceCount));
+        return false;
+    }
+    
+    config = loadConfig;
+    target = &collector;
+    rngState = config.seed ? config.seed : 1;
+    
+    // 仮想デバイスを登録（デバイスごとに位相をずらし、チャンネルを順に割り当てる）
+    // MAX_SENSORSを超えるデバイスはチャンネルを共有するため、チャンネル別の統計には複数デバイスの値が混ざる
+    devices.clear();
+    devices.reserve(config.deviceCount);
+    for (uint16_t i = 0; i < config.deviceCount; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "SIM_%03u", (unsigned)i);
+        
+        DeviceState device;
+        device.handle = DeviceRegistry::intern(name);
+        device.channel = i % SensorDataCollector::MAX_SENSORS;
+        device.timestamp = config.startTimestamp;
+        device.temperatureOffset = 0.0f;
+        device.humidityOffset = 0.0f;
+        device.pressureWalk = 0.0f;
+        device.iaqSpike = 0.0f;
+        device.phase = (float)i / config.deviceCount;
+        devices.push_back(device);
+    }
+    
+    nextDevice = 0;
+    generatedCount = 0;
+    droppedCount = 0;
+    startMicros = micros();
+    running = true;
+    
+    Serial.println("合成センサー負荷を開始しました（" + String(config.deviceCount) + "デバイス、目標" + 
+                   String(config.samplesPerSecond) + "件/秒）");
+    return true;
+}
+
+void SyntheticSensorSource::stop() {
+    if (running) {
+        running = false;
+        Serial.println(getReport());
+    }
+}
+
+float SyntheticSensorSource::nextUniform() {
+    // xorshift32（再現性のある決定的な乱数列）
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState >> 8) * (1.0f / 16777216.0f);
+}
+
+float SyntheticSensorSource::nextGaussian() {
+    // 一様乱数4個の和による近似正規分布（平均0・分散1）
+    float sum = nextUniform() + nextUniform() + nextUniform() + nextUniform();
+    return (sum - 2.0f) * 1.7320508f;
+}
+
+void SyntheticSensorSource::generateReading(DeviceState& device, SensorReading& reading) {
+    const float secondsPerDay = 86400.0f;
+    float dayFraction = (float)(device.timestamp % 86400) / secondsPerDay + device.phase * 0.1f;
+    float diurnal = sinf(2.0f * (float)PI * (dayFraction - 0.375f));  // 15時頃に最大
+    
+    // ステップ変化（窓の開閉や空調の切り替えを想定）
+    if (nextUniform() < config.stepChangeProbability) {
+        float direction = (nextUniform() < 0.5f) ? -1.0f : 1.0f;
+        device.temperatureOffset += direction * config.stepChangeMagnitude;
+        device.humidityOffset -= direction * config.stepChangeMagnitude * 2.0f;
+    }
+    
+    // IAQスパイク（調理・人の出入りなど）とその減衰
+    if (nextUniform() < config.iaqSpikeProbability) {
+        device.iaqSpike += config.iaqSpikeHeight;
+    }
+    device.iaqSpike *= (1.0f - config.iaqSpikeDecay);
+    
+    // 気圧はゆっくりしたランダムウォーク
+    device.pressureWalk += nextGaussian() * 0.02f;
+    device.pressureWalk *= 0.9999f;
+    
+    float noise = config.noiseLevel;
+    reading.timestamp = device.timestamp;
+    reading.time_synced = true;  // 模擬時刻はUNIX時刻
+    reading.synthetic = true;
+    reading.device_handle = device.handle;
+    reading.channel = device.channel;
+    reading.temperature = config.baseTemperature + config.diurnalTemperatureAmplitude * diurnal +
+                          device.temperatureOffset + nextGaussian() * 0.05f * noise;
+    reading.humidity = config.baseHumidity - config.diurnalHumidityAmplitude * diurnal +
+                       device.humidityOffset + nextGaussian() * 0.3f * noise;
+    reading.humidity = constrain(reading.humidity, 0.0f, 100.0f);
+    reading.pressure = config.basePressure + device.pressureWalk + nextGaussian() * 0.05f * noise;
+    reading.iaq = config.baseIaq + device.iaqSpike + nextGaussian() * 2.0f * noise;
+    reading.iaq = constrain(reading.iaq, 0.0f, 500.0f);
+    reading.co2_equivalent = 400.0f + reading.iaq * 6.0f;
+    reading.voc_equivalent = 0.5f + reading.iaq * 0.02f;
+    reading.gas_resistance = 200000.0f / (1.0f + reading.iaq / 50.0f) * (1.0f + nextGaussian() * 0.01f * noise);
+    reading.runin_status = 100.0f;
+    reading.stabilized = true;
+    reading.has_co2_data = true;
+    reading.has_iaq_data = true;
+    reading.has_voc_data = true;
+    reading.is_calibrated = true;
+    
+    device.timestamp += config.simulatedStepSeconds;
+}
+
+size_t SyntheticSensorSource::update(size_t maxSamples) {
+    if (!running) return 0;
+    
+    // 目標レートに対して不足している件数だけ生成する
+    size_t due = maxSamples;
+    if (config.samplesPerSecond > 0) {
+        uint64_t elapsedMicros = micros() - startMicros;
+        uint64_t expected = elapsedMicros * config.samplesPerSecond / 1000000ULL;
+        due = (expected > generatedCount) ? (size_t)(expected - generatedCount) : 0;
+        if (due > maxSamples) due = maxSamples;
+    }
+    
+    SensorReading reading;
+    for (size_t i = 0; i < due; i++) {
+        generateReading(devices[nextDevice], reading);
+        nextDevice = (nextDevice + 1) % devices.size();
+        
+        // リングが満杯なら消費者側を同期的に回して下流の処理能力を測る
+        if (target->getPendingReadingCount() >= SensorDataCollector::READING_RING_CAPACITY) {
+            target->dispatchPendingReadings();
+        }
+        if (!target->publishReading(reading)) {
+            droppedCount++;
+        }
+        generatedCount++;
+    }
+    
+    target->dispatchPendingReadings();
+    return due;
+}
+
+float SyntheticSensorSource::getAchievedRate() const {
+    unsigned long elapsedMicros = micros() - startMicros;
+    return elapsedMicros ? generatedCount * 1000000.0f / elapsedMicros : 0.0f;
+}
+
+String SyntheticSensorSource::getReport() const {
+    return "合成負荷: " + String(generatedCount) + "件生成, 破棄" + String(droppedCount) + "件, 実効" + 
+           String(getAchievedRate(), 0) + "件/秒（目標" + String(config.samplesPerSecond) + "件/秒）";
+}
\ No newline at end of file
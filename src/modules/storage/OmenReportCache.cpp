@@ -0,0 +1,163 @@
+#include "OmenReportCache.h"
+#include "ErrorHandler.h"
+#include "TimeUtils.h"
+#include <SD.h>
+
+OmenReportCache::OmenReportCache() :
+    persistent(false),
+    viewCount(0),
+    hitCount(0),
+    staleCount(0),
+    missCount(0),
+    generatedCount(0),
+    unchangedCount(0),
+    totalViewMicros(0),
+    maxViewMicros(0) {
+    memset(entries, 0, sizeof(entries));
+}
+
+const char* OmenReportCache::filePath(OmenReportKind kind) {
+    return kind == OmenReportKind::DAILY ? "/omen_daily.bin" : "/omen_hourly.bin";
+}
+
+bool OmenReportCache::begin(bool sdCardReady) {
+    persistent = sdCardReady;
+    if (!persistent) {
+        return false;
+    }
+    
+    uint8_t loaded = 0;
+    for (uint8_t i = 0; i < KIND_COUNT; i++) {
+        if (load((OmenReportKind)i)) loaded++;
+    }
+    if (loaded > 0) {
+        Serial.println("保存済みの予感レポートを読み込みました（" + String(loaded) + "件）");
+    }
+    return true;
+}
+
+bool OmenReportCache::load(OmenReportKind kind) {
+    if (!SD.exists(filePath(kind))) {
+        return false;
+    }
+    File file = SD.open(filePath(kind), FILE_READ);
+    if (!file) {
+        return false;
+    }
+    
+    OmenReportEntry& entry = entries[(int)kind];
+    size_t bytesRead = file.read(reinterpret_cast<uint8_t*>(&entry), sizeof(entry));
+    file.close();
+    
+    // 構造体の変更前に保存したファイルや壊れたファイル、起動からの秒の窓（前回の起動のもの）は捨てる
+    if (bytesRead != sizeof(entry) || entry.version != ENTRY_VERSION || !entry.valid || !entry.timeSynced ||
+        entry.length >= OmenReportEntry::TEXT_SIZE) {
+        memset(&entry, 0, sizeof(entry));
+        return false;
+    }
+    entry.text[entry.length] = '\0';
+    return true;
+}
+
+bool OmenReportCache::save(OmenReportKind kind) {
+    if (!persistent) {
+        return false;
+    }
+    // NTP同期前の窓は再起動後には別の時刻を指すため保存しない（前回の同期済みのファイルを残す）
+    if (!entries[(int)kind].timeSynced) {
+        return true;
+    }
+    File file = SD.open(filePath(kind), FILE_WRITE);
+    if (!file) {
+        ErrorHandler::logWarning(ErrorComponent::STORAGE, ErrorHandler::ERROR_STORAGE_WRITE_FAILED, 
+                                "予感レポートの保存に失敗しました");
+        return false;
+    }
+    
+    const OmenReportEntry& entry = entries[(int)kind];
+    size_t bytesWritten = file.write(reinterpret_cast<const uint8_t*>(&entry), sizeof(entry));
+    file.close();
+    return bytesWritten == sizeof(entry);
+}
+
+uint32_t OmenReportCache::windowStart(OmenReportKind kind, uint32_t seconds, bool synced) {
+    if (kind == OmenReportKind::DAILY) {
+        return seconds - TimeUtils::secondsOfDay(seconds, synced);
+    }
+    return seconds - seconds % 3600;
+}
+
+bool OmenReportCache::hasWindow(OmenReportKind kind, uint32_t window, bool synced) const {
+    const OmenReportEntry& entry = entries[(int)kind];
+    return entry.valid && entry.timeSynced == synced && entry.windowStart == window;
+}
+
+bool OmenReportCache::adoptIfUnchanged(OmenReportKind kind, uint32_t window, bool synced, uint32_t digest) {
+    OmenReportEntry& entry = entries[(int)kind];
+    if (!entry.valid || entry.digest != digest) {
+        return false;
+    }
+    entry.windowStart = window;
+    entry.timeSynced = synced;
+    unchangedCount++;
+    save(kind);
+    return true;
+}
+
+bool OmenReportCache::store(OmenReportKind kind, uint32_t window, bool synced, uint32_t digest, uint32_t generatedAt,
+                            const char* text, bool narrative) {
+    OmenReportEntry& entry = entries[(int)kind];
+    size_t length = strlen(text);
+    if (length >= OmenReportEntry::TEXT_SIZE) {
+        length = OmenReportEntry::TEXT_SIZE - 1;
+    }
+    
+    entry.version = ENTRY_VERSION;
+    entry.windowStart = window;
+    entry.digest = digest;
+    entry.generatedAt = generatedAt;
+    entry.length = length;
+    entry.valid = true;
+    entry.narrative = narrative;
+    entry.timeSynced = synced;
+    memcpy(entry.text, text, length);
+    entry.text[length] = '\0';
+    generatedCount++;
+    
+    return save(kind) || !persistent;
+}
+
+const OmenReportEntry* OmenReportCache::view(OmenReportKind kind, uint32_t currentWindow, bool synced) {
+    unsigned long start = micros();
+    const OmenReportEntry* entry = get(kind);
+    
+    viewCount++;
+    if (!entry) {
+        missCount++;
+    } else if (entry->timeSynced == synced && entry->windowStart == currentWindow) {
+        hitCount++;
+    } else {
+        staleCount++;
+    }
+    
+    uint32_t elapsed = micros() - start;
+    totalViewMicros += elapsed;
+    if (elapsed > maxViewMicros) maxViewMicros = elapsed;
+    return entry;
+}
+
+const OmenReportEntry* OmenReportCache::get(OmenReportKind kind) const {
+    const OmenReportEntry& entry = entries[(int)kind];
+    return entry.valid ? &entry : nullptr;
+}
+
+String OmenReportCache::getReport() const {
+    String report = "予感レポート: 表示" + String(viewCount) + "回 (ヒット" + String(hitCount) + 
+                    ", 旧" + String(staleCount) + ", なし" + String(missCount) + ")";
+    if (viewCount > 0) {
+        report += " ヒット率" + String(getHitRate() * 100.0f, 1) + "%, 平均" + 
+                  String(totalViewMicros / viewCount) + "us 最大" + String(maxViewMicros) + "us";
+    }
+    report += ", 生成" + String(generatedCount) + "件, 入力変化なしで省略" + String(unchangedCount) + "件";
+    return report;
+}
\ No newline at end of file
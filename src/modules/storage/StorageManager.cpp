@@ -1,11 +1,15 @@
 #include "StorageManager.h"
 #include "ErrorHandler.h"
 #include "TimeUtils.h"
+#include "SensorFields.h"
+#include "DerivedMetrics.h"
 
 StorageManager::StorageManager() :
     currentMode(StorageMode::HYBRID),
     sdCardInitialized(false),
-    maxStorageSize(MAX_STORAGE_MB * 1024 * 1024) {
+    maxStorageSize(MAX_STORAGE_MB * 1024 * 1024),
+    derivedMetricsEnabled(false),
+    altitude(0.0f) {
 }
 
 StorageManager::~StorageManager() {
@@ -40,27 +44,36 @@ bool StorageManager::initializeSDCard() {
     }
     
     sdCardInitialized = true;
+    writeSchemaFile();
     Serial.println("SDカードの初期化が完了しました");
     return true;
 }
 
 bool StorageManager::saveToSDCard(const SensorReading& data) {
+    return saveBatchToSDCard(&data, 1);
+}
+
+bool StorageManager::saveBatchToSDCard(const SensorReading* readings, size_t count) {
     if (!sdCardInitialized) {
         return false;
     }
+    if (count == 0) {
+        return true;
+    }
     
     // 日次ログファイルを作成/取得
     String filename = generateDailyFileName();
-    if (currentLogFile != filename) {
-        currentLogFile = filename;
+    if (currentLogBaseFile != filename) {
+        currentLogBaseFile = filename;
         if (!createDailyLogFile()) {
+            currentLogBaseFile = "";
             ErrorHandler::logError(ErrorComponent::STORAGE, ErrorHandler::ERROR_STORAGE_WRITE_FAILED, 
                                   "ログファイルの作成に失敗しました");
             return false;
         }
     }
     
-    // データをCSV形式で保存
+    // データをCSV形式で保存（ファイルのオープン・クローズはまとめて1回）
     File file = SD.open(currentLogFile, FILE_APPEND);
     if (!file) {
         ErrorHandler::logError(ErrorComponent::STORAGE, ErrorHandler::ERROR_STORAGE_WRITE_FAILED, 
@@ -68,20 +81,25 @@ bool StorageManager::saveToSDCard(const SensorReading& data) {
         return false;
     }
     
-    // CSVデータを作成
-    String csvLine = String(data.timestamp) + "," +
-                     String(data.temperature, 2) + "," +
-                     String(data.humidity, 2) + "," +
-                     String(data.pressure, 2) + "," +
-                     String(data.co2_equivalent, 2) + "," +
-                     String(data.iaq, 2) + "," +
-                     String(data.voc_equivalent, 2) + "," +
-                     String(data.gas_resistance, 2) + "," +
-                     String(data.stabilized ? 1 : 0) + "," +
-                     String(data.runin_status, 2) + "," +
-                     data.device_id + "\n";
-    
-    size_t bytesWritten = file.print(csvLine);
+    // CSVデータを作成（派生指標はBATCH_SIZE件ずつ列単位で計算して行末に足す）
+    String csvLines;
+    csvLines.reserve(count * (derivedMetricsEnabled ? 128 : 96));
+    DerivedColumns derived;
+    derived.count = 0;
+    size_t derivedStart = 0;
+    for (size_t i = 0; i < count; i++) {
+        csvLines += SensorFields::csvRow(readings[i]);
+        if (derivedMetricsEnabled) {
+            if (i >= derivedStart + derived.count) {
+                derivedStart = i;
+                DerivedMetrics::compute(readings + i, count - i, altitude, derived);
+            }
+            DerivedMetrics::appendCsv(csvLines, derived, i - derivedStart);
+        }
+        csvLines += "\n";
+    }
+    
+    size_t bytesWritten = file.print(csvLines);
     file.close();
     
     if (bytesWritten == 0) {
@@ -98,11 +116,26 @@ bool StorageManager::createDailyLogFile() {
         return false;
     }
     
-    String filename = generateDailyFileName();
+    String baseName = generateDailyFileName();
+    String header = generateLogHeader();
     
-    // ファイルが既に存在する場合はヘッダーを追加しない
-    if (SD.exists(filename)) {
-        return true;
+    // 既存ファイルのヘッダーが同じならそのまま追記する
+    // ファームウェア更新などで列構成が変わった場合は、連番を付けた別ファイル（sensor_data_YYYYMMDD_1.csv など）に切り替える
+    String filename = baseName;
+    for (uint8_t variant = 1; SD.exists(filename); variant++) {
+        File existing = SD.open(filename, FILE_READ);
+        String existingHeader = existing ? existing.readStringUntil('\n') : "";
+        if (existing) {
+            existing.close();
+        }
+        if (existingHeader == header) {
+            currentLogFile = filename;
+            return true;
+        }
+        if (variant > MAX_LOG_FILE_VARIANTS) {
+            return false;
+        }
+        filename = baseName.substring(0, baseName.length() - 4) + "_" + String(variant) + ".csv";
     }
     
     // 新しいファイルを作成してCSVヘッダーを追加
@@ -110,18 +143,110 @@ bool StorageManager::createDailyLogFile() {
     if (!file) {
         return false;
     }
-    
-    // CSVヘッダー
-    String header = "timestamp,temperature,humidity,pressure,co2_equivalent,iaq,voc_equivalent,gas_resistance,stabilized,runin_status,device_id\n";
-    file.print(header);
+    file.print(header + "\n");
     file.close();
     
+    currentLogFile = filename;
     Serial.println("新しいログファイルを作成しました: " + filename);
     return true;
 }
 
+String StorageManager::generateLogHeader() {
+    String header = SensorFields::csvHeader();
+    if (derivedMetricsEnabled) {
+        header += DerivedMetrics::csvHeader();
+    }
+    return header;
+}
+
+bool StorageManager::writeSchemaFile() {
+    // CSV・バイナリの列構成（SensorFields.hの対応表から生成）を保存し、オフラインでも読み出せるようにする
+    JsonDocument doc;
+    SensorFields::describeSchema(doc);
+    if (derivedMetricsEnabled) {
+        DerivedMetrics::describeSchema(doc, altitude);
+    }
+    
+    String json;
+    if (serializeJson(doc, json) == 0) {
+        return false;
+    }
+    
+    File file = SD.open("/sensor_data/schema.json", FILE_WRITE);
+    if (!file) {
+        ErrorHandler::logWarning(ErrorComponent::STORAGE, ErrorHandler::ERROR_STORAGE_WRITE_FAILED, 
+                                "スキーマファイルの作成に失敗しました");
+        return false;
+    }
+    file.print(json);
+    file.close();
+    return true;
+}
+
 String StorageManager::generateDailyFileName() {
-    return "/sensor_data/" + TimeUtils::generateDailyFileName("sensor_data", "csv");
+    return "/sensor_data/" + TimeUtils::generateDailyFileName(derivedMetricsEnabled ? "sensor_data_derived" : "sensor_data", "csv");
+}
+
+bool StorageManager::saveGasScan(const GasScan& scan) {
+    if (!sdCardInitialized) {
+        return false;
+    }
+    
+    // 日次スキャンファイルを作成/取得
+    String filename = generateDailyScanFileName();
+    if (currentScanFile != filename) {
+        currentScanFile = filename;
+        if (!createDailyScanFile()) {
+            ErrorHandler::logError(ErrorComponent::STORAGE, ErrorHandler::ERROR_STORAGE_WRITE_FAILED, 
+                                  "ガススキャンファイルの作成に失敗しました");
+            return false;
+        }
+    }
+    
+    File file = SD.open(currentScanFile, FILE_APPEND);
+    if (!file) {
+        ErrorHandler::logError(ErrorComponent::STORAGE, ErrorHandler::ERROR_STORAGE_WRITE_FAILED, 
+                              "ガススキャンファイルのオープンに失敗しました");
+        return false;
+    }
+    
+    // CSVにすると1周あたり200バイト前後になるため、構造体をそのまま書き込む
+    size_t bytesWritten = file.write(reinterpret_cast<const uint8_t*>(&scan), sizeof(scan));
+    file.close();
+    
+    if (bytesWritten != sizeof(scan)) {
+        ErrorHandler::logError(ErrorComponent::STORAGE, ErrorHandler::ERROR_STORAGE_WRITE_FAILED, 
+                              "ガススキャンの書き込みに失敗しました");
+        return false;
+    }
+    
+    return true;
+}
+
+bool StorageManager::createDailyScanFile() {
+    String filename = generateDailyScanFileName();
+    if (SD.exists(filename)) {
+        return true;
+    }
+    
+    File file = SD.open(filename, FILE_WRITE);
+    if (!file) {
+        return false;
+    }
+    
+    GasScanFileHeader header;
+    memcpy(header.magic, "YKGS", 4);
+    header.version = GasScanFileHeader::FORMAT_VERSION;
+    header.recordSize = sizeof(GasScan);
+    file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    file.close();
+    
+    Serial.println("新しいガススキャンファイルを作成しました: " + filename);
+    return true;
+}
+
+String StorageManager::generateDailyScanFileName() {
+    return "/sensor_data/" + TimeUtils::generateDailyFileName("gas_scan", "bin");
 }
 
 bool StorageManager::ensureDirectoryExists(const String& path) {
@@ -165,6 +290,16 @@ void StorageManager::setStorageMode(StorageMode mode) {
     Serial.println("ストレージモードを変更しました: " + String((int)mode));
 }
 
+void StorageManager::setDerivedMetrics(bool enabled, float altitudeMeters) {
+    derivedMetricsEnabled = enabled;
+    altitude = altitudeMeters;
+    
+    // ファイル名が切り替わるので次の保存で新しいファイル（ヘッダー付き）を作る
+    if (sdCardInitialized) {
+        writeSchemaFile();
+    }
+}
+
 uint32_t StorageManager::getAvailableSpace() {
     if (!sdCardInitialized) {
         return 0;
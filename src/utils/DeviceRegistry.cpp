@@ -0,0 +1,36 @@
+#include "DeviceRegistry.h"
+#include "ErrorHandler.h"
+
+// 静的メンバーの初期化（ハンドル0は既定のデバイス）
+char DeviceRegistry::names[DeviceRegistry::MAX_DEVICES][DeviceRegistry::MAX_NAME_LENGTH] = { "M5Stack_001" };
+uint16_t DeviceRegistry::deviceCount = 1;
+
+uint16_t DeviceRegistry::intern(const char* name) {
+    if (name == nullptr || name[0] == '\0') {
+        return INVALID_HANDLE;
+    }
+    
+    // 登録済みの名前を検索
+    for (uint16_t i = 0; i < deviceCount; i++) {
+        if (strncmp(names[i], name, MAX_NAME_LENGTH - 1) == 0) {
+            return i;
+        }
+    }
+    
+    if (deviceCount >= MAX_DEVICES) {
+        ErrorHandler::logWarning(ErrorComponent::SENSOR, "DEVICE_REGISTRY_FULL", 
+                                "デバイス登録数の上限に達しました: " + String(name));
+        return INVALID_HANDLE;
+    }
+    
+    strncpy(names[deviceCount], name, MAX_NAME_LENGTH - 1);
+    names[deviceCount][MAX_NAME_LENGTH - 1] = '\0';
+    return deviceCount++;
+}
+
+const char* DeviceRegistry::getName(uint16_t handle) {
+    if (handle >= deviceCount) {
+        return "unknown";
+    }
+    return names[handle];
+}
\ No newline at end of file
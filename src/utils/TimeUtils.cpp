@@ -83,7 +83,13 @@ String TimeUtils::generateTimestampedFileName(const String& prefix, const String
 }
 
 uint32_t TimeUtils::getCurrentUnixTime() {
-    if (!timeSynced) {
+    bool synced;
+    return getCurrentUnixTime(synced);
+}
+
+uint32_t TimeUtils::getCurrentUnixTime(bool& synced) {
+    synced = timeSynced;
+    if (!synced) {
         // NTPが同期されていない場合はmillis()を返す
         return millis();
     }
@@ -122,6 +128,22 @@ uint32_t TimeUtils::getSecondsSinceMidnight() {
     return timeinfo->tm_hour * 3600 + timeinfo->tm_min * 60 + timeinfo->tm_sec;
 }
 
+uint32_t TimeUtils::toSeconds(uint32_t timestamp) {
+    // NTP未同期時のタイムスタンプはmillis()のためミリ秒から秒に変換
+    return toSeconds(timestamp, timeSynced);
+}
+
+uint32_t TimeUtils::secondsOfDay(uint32_t seconds) {
+    return secondsOfDay(seconds, timeSynced);
+}
+
+uint32_t TimeUtils::secondsOfDay(uint32_t seconds, bool synced) {
+    if (!synced) {
+        return seconds % (24 * 60 * 60);
+    }
+    return (seconds + GMT_OFFSET_SEC + DAYLIGHT_OFFSET_SEC) % (24 * 60 * 60);
+}
+
 bool TimeUtils::syncTimeWithNTP() {
     if (WiFi.status() != WL_CONNECTED) {
         Serial.println("WiFiが接続されていないため、NTP同期をスキップします");
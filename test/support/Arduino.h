@@ -0,0 +1,116 @@
+#ifndef TEST_SUPPORT_ARDUINO_H
+#define TEST_SUPPORT_ARDUINO_H
+
+// ホストテスト用のArduinoコアの代替ヘッダー
+// 解析モジュールが使うString・Serial・millis()だけを標準ライブラリで実装する
+// millis()は実時間ではなくNativeClock::nowMsを返すため、テストから時刻を進められる
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <atomic>
+
+#define HEX 16
+#define DEC 10
+#define ARRAY_LEN(a) (sizeof(a) / sizeof((a)[0]))
+#define PI 3.14159265358979
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+class String {
+private:
+    std::string text;
+    
+    static std::string fromUnsigned(unsigned long long value, unsigned char base) {
+        char buffer[72];
+        snprintf(buffer, sizeof(buffer), base == HEX ? "%llx" : "%llu", value);
+        return buffer;
+    }
+
+public:
+    String() {}
+    String(const char* value) : text(value ? value : "") {}
+    String(const std::string& value) : text(value) {}
+    String(char value) : text(1, value) {}
+    String(int value, unsigned char base = DEC) : text(base == DEC ? std::to_string(value) : fromUnsigned((unsigned)value, base)) {}
+    String(unsigned int value, unsigned char base = DEC) : text(fromUnsigned(value, base)) {}
+    String(long value, unsigned char base = DEC) : text(base == DEC ? std::to_string(value) : fromUnsigned((unsigned long)value, base)) {}
+    String(unsigned long value, unsigned char base = DEC) : text(fromUnsigned(value, base)) {}
+    String(long long value) : text(std::to_string(value)) {}
+    String(unsigned long long value) : text(fromUnsigned(value, DEC)) {}
+    String(signed char value) : text(std::to_string(value)) {}
+    String(short value) : text(std::to_string(value)) {}
+    String(unsigned char value, unsigned char base = DEC) : text(fromUnsigned(value, base)) {}
+    String(unsigned short value, unsigned char base = DEC) : text(fromUnsigned(value, base)) {}
+    String(float value, unsigned int decimals = 2) : String((double)value, decimals) {}
+    String(double value, unsigned int decimals = 2) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+        text = buffer;
+    }
+    
+    const char* c_str() const { return text.c_str(); }
+    unsigned int length() const { return text.size(); }
+    bool isEmpty() const { return text.empty(); }
+    bool reserve(unsigned int size) { text.reserve(size); return true; }
+    
+    String substring(unsigned int from) const { return from < text.size() ? text.substr(from) : std::string(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < text.size() ? text.substr(from, to - from) : std::string();
+    }
+    int indexOf(const String& value) const {
+        size_t pos = text.find(value.text);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    bool startsWith(const String& value) const { return text.compare(0, value.text.size(), value.text) == 0; }
+    bool endsWith(const String& value) const {
+        return text.size() >= value.text.size() &&
+               text.compare(text.size() - value.text.size(), value.text.size(), value.text) == 0;
+    }
+    int toInt() const { return atoi(text.c_str()); }
+    float toFloat() const { return (float)atof(text.c_str()); }
+    
+    char operator[](unsigned int index) const { return index < text.size() ? text[index] : 0; }
+    String& operator+=(const String& value) { text += value.text; return *this; }
+    String& operator+=(const char* value) { text += value; return *this; }
+    String& operator+=(char value) { text += value; return *this; }
+    bool concat(const char* value) { text += value; return true; }
+    bool operator==(const String& value) const { return text == value.text; }
+    bool operator==(const char* value) const { return text == value; }
+    bool operator!=(const String& value) const { return text != value.text; }
+    
+    friend String operator+(const String& a, const String& b) { return String(a.text + b.text); }
+    friend String operator+(const String& a, const char* b) { return String(a.text + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.text); }
+};
+
+// ArduinoJsonのString対応（ARDUINOJSON_ENABLE_ARDUINO_STRING）が参照する
+class StringSumHelper : public String {};
+
+// Serialの出力はテスト結果の表示を乱さないよう捨てる
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+    size_t print(const String& value) { return value.length(); }
+    size_t print(const char* value) { return strlen(value); }
+    size_t println(const String& value = String()) { return value.length() + 1; }
+    size_t println(const char* value) { return strlen(value) + 1; }
+    size_t printf(const char*, ...) { return 0; }
+};
+
+inline HardwareSerial Serial;
+
+// FreeRTOSの代替（test/support/freertos）のタスクからも読むためatomicにする
+namespace NativeClock {
+    inline std::atomic<unsigned long> nowMs{0};
+}
+
+inline unsigned long millis() { return NativeClock::nowMs; }
+inline unsigned long micros() { return NativeClock::nowMs * 1000UL; }
+inline void delay(unsigned long ms) { NativeClock::nowMs += ms; }
+inline void yield() {}
+inline void configTime(long, int, const char*) {}
+
+#endif // TEST_SUPPORT_ARDUINO_H
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef TEST_SUPPORT_FS_H
+#define TEST_SUPPORT_FS_H
+
+// ホストテスト用のFSライブラリの代替ヘッダー
+// ファイルはNativeFs::filesにメモリ上で保持する（テストから中身の確認・削除ができる）
+#include <Arduino.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+
+namespace NativeFs {
+    inline std::map<std::string, std::vector<uint8_t>> files;
+    // 設定するとwrite()のたびに書き込み前に呼ぶ（書き込み中に他の処理が進むかの確認用）
+    inline std::function<void()> writeHook;
+}
+
+class File {
+private:
+    std::vector<uint8_t>* data;
+    size_t position;
+
+public:
+    File() : data(nullptr), position(0) {}
+    explicit File(std::vector<uint8_t>* file) : data(file), position(0) {}
+    
+    explicit operator bool() const { return data != nullptr; }
+    size_t size() const { return data ? data->size() : 0; }
+    
+    size_t read(uint8_t* dst, size_t length) {
+        if (!data) return 0;
+        size_t available = data->size() - position;
+        if (length > available) length = available;
+        memcpy(dst, data->data() + position, length);
+        position += length;
+        return length;
+    }
+    size_t write(const uint8_t* src, size_t length) {
+        if (!data) return 0;
+        if (NativeFs::writeHook) NativeFs::writeHook();
+        data->insert(data->end(), src, src + length);
+        return length;
+    }
+    void flush() {}
+    void close() { data = nullptr; }
+};
+
+namespace fs {
+    class FS {
+    public:
+        bool exists(const char* path) { return NativeFs::files.count(path) > 0; }
+        bool exists(const String& path) { return exists(path.c_str()); }
+        File open(const char* path, const char* mode = FILE_READ) {
+            if (strcmp(mode, FILE_WRITE) == 0) {
+                std::vector<uint8_t>& file = NativeFs::files[path];
+                file.clear();
+                return File(&file);
+            }
+            auto it = NativeFs::files.find(path);
+            return it != NativeFs::files.end() ? File(&it->second) : File();
+        }
+        File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+        bool remove(const char* path) { return NativeFs::files.erase(path) > 0; }
+        bool remove(const String& path) { return remove(path.c_str()); }
+    };
+}
+
+#endif // TEST_SUPPORT_FS_H
\ No newline at end of file
@@ -0,0 +1,141 @@
+#ifndef TEST_SUPPORT_HTTP_CLIENT_H
+#define TEST_SUPPORT_HTTP_CLIENT_H
+
+// ホストテスト用のHTTPClientの代替ヘッダー
+// http://host:port/path へPOSIXソケットでHTTP/1.1のPOSTを送り、接続を閉じるまでを応答として読む
+// （テスト内のモックサーバー向け。https://もTLSなしで同じ経路を使う）
+// 接続・応答の待ち時間は実時間（ms）で数える
+#include <Arduino.h>
+#include <WiFi.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+class HTTPClient {
+private:
+    std::string host;
+    uint16_t port = 80;
+    std::string path;
+    std::vector<std::string> headers;
+    uint32_t connectTimeoutMs = 5000;
+    uint32_t timeoutMs = 5000;
+    std::string payload;
+    
+    // 0以上はソケット、負はHTTPC_ERROR_*
+    int connectSocket() {
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* address = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &address) != 0 || !address) {
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int result = ::connect(fd, address->ai_addr, address->ai_addrlen);
+        freeaddrinfo(address);
+        if (result != 0 && errno == EINPROGRESS) {
+            pollfd waiting = { fd, POLLOUT, 0 };
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (poll(&waiting, 1, (int)connectTimeoutMs) == 1 &&
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+                result = 0;
+            }
+        }
+        if (result != 0) {
+            close(fd);
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        return fd;
+    }
+
+public:
+    bool begin(WiFiClient&, const String& url) {
+        std::string text = url.c_str();
+        size_t scheme = text.find("://");
+        if (scheme == std::string::npos) return false;
+        std::string rest = text.substr(scheme + 3);
+        size_t slash = rest.find('/');
+        std::string authority = rest.substr(0, slash);
+        path = slash == std::string::npos ? "/" : rest.substr(slash);
+        size_t colon = authority.find(':');
+        host = authority.substr(0, colon);
+        port = colon == std::string::npos ? (text.compare(0, 5, "https") == 0 ? 443 : 80) : 
+               (uint16_t)atoi(authority.c_str() + colon + 1);
+        headers.clear();
+        payload.clear();
+        return !host.empty();
+    }
+    
+    void setConnectTimeout(int32_t ms) { connectTimeoutMs = (uint32_t)ms; }
+    void setTimeout(uint16_t ms) { timeoutMs = ms; }
+    void addHeader(const String& name, const String& value) { headers.push_back(std::string(name.c_str()) + ": " + value.c_str()); }
+    
+    int POST(const String& body) {
+        int fd = connectSocket();
+        if (fd < 0) return fd;
+        
+        std::string request = "POST " + path + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n";
+        for (const std::string& header : headers) {
+            request += header + "\r\n";
+        }
+        request += "Content-Length: " + std::to_string(body.length()) + "\r\n\r\n" + body.c_str();
+        if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) {
+            close(fd);
+            return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+        }
+        
+        // 応答の待ち時間は受信の合間ごとに数える（ESP32のHTTPClientと同じ）
+        std::string response;
+        char buffer[1024];
+        for (;;) {
+            pollfd waiting = { fd, POLLIN, 0 };
+            if (poll(&waiting, 1, (int)timeoutMs) != 1) {
+                close(fd);
+                return HTTPC_ERROR_READ_TIMEOUT;
+            }
+            ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received <= 0) break;
+            response.append(buffer, received);
+        }
+        close(fd);
+        
+        size_t headerEnd = response.find("\r\n\r\n");
+        if (response.compare(0, 5, "HTTP/") != 0 || headerEnd == std::string::npos) {
+            return HTTPC_ERROR_CONNECTION_LOST;
+        }
+        payload = response.substr(headerEnd + 4);
+        return atoi(response.c_str() + response.find(' ') + 1);
+    }
+    
+    String getString() { return String(payload); }
+    void end() {}
+    
+    static String errorToString(int error) {
+        switch (error) {
+            case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+            case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+            case HTTPC_ERROR_NOT_CONNECTED: return "not connected";
+            case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+            case HTTPC_ERROR_READ_TIMEOUT: return "read Timeout";
+            default: return String();
+        }
+    }
+};
+
+#endif // TEST_SUPPORT_HTTP_CLIENT_H
\ No newline at end of file
@@ -0,0 +1,251 @@
+#ifndef TEST_SUPPORT_M5UNIFIED_H
+#define TEST_SUPPORT_M5UNIFIED_H
+
+// ホストテスト用のM5Unified（M5GFX/LovyanGFX）の代替ヘッダー
+// 表示モジュールが使う描画APIだけを画素の配列で実装し、書いた画素・フォントで描いた文字・DMA転送を数える
+// フォントは固定幅のモデル（文字サイズ1で半角6px・全角12px・高さ12px）で、画素は文字コードから決まる模様
+// M5Canvasは親（M5.Display）のDMA転送中に書き込まれた画素をNativeDisplay::tornWritesに数える（転送元の書き換え）
+// NativeDisplay::spriteAvailableを下ろすとスプライトを確保できない（PSRAMなしの再現用）
+#include <Arduino.h>
+#include <vector>
+
+#define BLACK       0x0000
+#define NAVY        0x000F
+#define DARKGREEN   0x03E0
+#define BLUE        0x001F
+#define DARKGREY    0x7BEF
+#define RED         0xF800
+#define GREEN       0x07E0
+#define CYAN        0x07FF
+#define MAGENTA     0xF81F
+#define ORANGE      0xFDA0
+#define YELLOW      0xFFE0
+#define WHITE       0xFFFF
+
+namespace lgfx {
+    struct swap565_t {
+        uint16_t raw;
+    };
+    struct IFont {};
+}
+
+namespace fonts {
+    inline const lgfx::IFont lgfxJapanGothic_12{};
+}
+
+namespace NativeDisplay {
+    inline bool spriteAvailable = true;
+    inline uint64_t tornWrites = 0;
+}
+
+class LovyanGFX {
+protected:
+    std::vector<uint16_t> frame;
+    int32_t frameWidth;
+    int32_t frameHeight;
+    int32_t clipLeft;
+    int32_t clipTop;
+    int32_t clipRight;
+    int32_t clipBottom;
+    int32_t cursorX = 0;
+    int32_t cursorY = 0;
+    uint16_t textColor = WHITE;
+    uint16_t textBackground = BLACK;
+    int32_t textSize = 1;
+    const LovyanGFX* dmaSource = nullptr;   // この画素を転送元にしているパネル（スプライトのみ）
+    bool dmaPending = false;
+    uint32_t writeDepth = 0;
+    
+    static uint32_t decode(const char*& text) {
+        uint8_t lead = (uint8_t)*text++;
+        uint8_t extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+        uint32_t codepoint = extra ? lead & (0x3F >> extra) : lead;
+        for (uint8_t i = 0; i < extra && ((uint8_t)*text & 0xC0) == 0x80; i++) {
+            codepoint = (codepoint << 6) | ((uint8_t)*text++ & 0x3F);
+        }
+        return codepoint;
+    }
+    
+    int32_t glyphAdvance(uint32_t codepoint) const { return (codepoint < 0x80 ? 6 : 12) * textSize; }
+    
+    void writePixel(int32_t x, int32_t y, uint16_t color) {
+        if (x < clipLeft || x >= clipRight || y < clipTop || y >= clipBottom) return;
+        frame[(size_t)y * frameWidth + x] = color;
+        nativeWrittenPixels++;
+        if (dmaSource && dmaSource->dmaPending) NativeDisplay::tornWrites++;
+    }
+    
+    int32_t drawText(const char* text, int32_t x, int32_t y) {
+        int32_t start = x;
+        while (*text) {
+            uint32_t codepoint = decode(text);
+            int32_t advance = glyphAdvance(codepoint);
+            uint32_t pattern = codepoint * 2654435761u;
+            for (int32_t row = 0; row < fontHeight(); row++) {
+                for (int32_t column = 0; column < advance; column++) {
+                    // 文字の端1ドットは背景にして、隣の文字と模様が続かないようにする
+                    int32_t u = column / textSize, v = row / textSize;
+                    bool ink = u > 0 && v > 0 && ((pattern >> ((u * 3 + v * 5) % 29)) & 1);
+                    writePixel(x + column, y + row, ink ? textColor : textBackground);
+                }
+            }
+            nativeFontGlyphs++;
+            x += advance;
+        }
+        return x - start;
+    }
+
+public:
+    // 計測値（テストから読み、必要ならリセットする）
+    uint64_t nativeWrittenPixels = 0;   // 描画で書いた画素（転送で受け取った画素は含まない）
+    uint64_t nativeReadPixels = 0;
+    uint32_t nativeFontGlyphs = 0;      // フォントで描いた文字数
+    uint64_t nativePushedPixels = 0;    // DMAで受け取った画素
+    uint32_t nativeDmaPushes = 0;
+    
+    LovyanGFX(int32_t width = 0, int32_t height = 0) { nativeReset(width, height); }
+    virtual ~LovyanGFX() {}
+    
+    // 画面を黒に戻し、計測値と状態を初期化する
+    void nativeReset(int32_t width, int32_t height) {
+        frame.assign((size_t)width * height, BLACK);
+        frameWidth = width;
+        frameHeight = height;
+        clearClipRect();
+        dmaPending = false;
+        writeDepth = 0;
+        nativeWrittenPixels = 0;
+        nativeReadPixels = 0;
+        nativeFontGlyphs = 0;
+        nativePushedPixels = 0;
+        nativeDmaPushes = 0;
+    }
+    std::vector<uint16_t>& nativePixels() { return frame; }
+    bool nativeDmaPending() const { return dmaPending; }
+    bool nativeWriting() const { return writeDepth > 0; }
+    
+    int32_t width() const { return frameWidth; }
+    int32_t height() const { return frameHeight; }
+    void setRotation(uint8_t) {}
+    void setBrightness(uint8_t) {}
+    void setTextSize(float size) { textSize = size < 1 ? 1 : (int32_t)size; }
+    void setFont(const lgfx::IFont*) {}
+    int32_t fontHeight() const { return 12 * textSize; }
+    
+    void setCursor(int32_t x, int32_t y) { cursorX = x; cursorY = y; }
+    void setTextColor(uint32_t color) { textColor = (uint16_t)color; }
+    void setTextColor(uint32_t color, uint32_t background) {
+        textColor = (uint16_t)color;
+        textBackground = (uint16_t)background;
+    }
+    size_t print(const char* text) {
+        cursorX += drawText(text, cursorX, cursorY);
+        return strlen(text);
+    }
+    size_t print(const String& text) { return print(text.c_str()); }
+    int32_t drawString(const char* text, int32_t x, int32_t y) { return drawText(text, x, y); }
+    int32_t textWidth(const char* text) const {
+        int32_t width = 0;
+        while (*text) width += glyphAdvance(decode(text));
+        return width;
+    }
+    int32_t textWidth(const String& text) const { return textWidth(text.c_str()); }
+    
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+        for (int32_t row = y; row < y + h; row++) {
+            for (int32_t column = x; column < x + w; column++) {
+                writePixel(column, row, (uint16_t)color);
+            }
+        }
+    }
+    void fillScreen(uint32_t color) { fillRect(0, 0, frameWidth, frameHeight, color); }
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) { fillRect(x, y, 1, h, color); }
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) { fillRect(x, y, w, 1, color); }
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+        drawFastHLine(x, y, w, color);
+        drawFastHLine(x, y + h - 1, w, color);
+        drawFastVLine(x, y + 1, h - 2, color);
+        drawFastVLine(x + w - 1, y + 1, h - 2, color);
+    }
+    
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const lgfx::swap565_t* image) {
+        for (int32_t row = 0; row < h; row++) {
+            for (int32_t column = 0; column < w; column++) {
+                writePixel(x + column, y + row, image[(size_t)row * w + column].raw);
+            }
+        }
+    }
+    void readRect(int32_t x, int32_t y, int32_t w, int32_t h, lgfx::swap565_t* image) {
+        for (int32_t row = 0; row < h; row++) {
+            for (int32_t column = 0; column < w; column++) {
+                image[(size_t)row * w + column].raw = frame[(size_t)(y + row) * frameWidth + x + column];
+            }
+        }
+        nativeReadPixels += (uint64_t)w * h;
+    }
+    uint16_t readPixel(int32_t x, int32_t y) const { return frame[(size_t)y * frameWidth + x]; }
+    
+    void setClipRect(int32_t x, int32_t y, int32_t w, int32_t h) {
+        clipLeft = x < 0 ? 0 : x;
+        clipTop = y < 0 ? 0 : y;
+        clipRight = x + w > frameWidth ? frameWidth : x + w;
+        clipBottom = y + h > frameHeight ? frameHeight : y + h;
+    }
+    void clearClipRect() { setClipRect(0, 0, frameWidth, frameHeight); }
+    
+    // DMA転送はその場でクリップ範囲の画素を写し、waitDMA()まで転送中として扱う
+    void initDMA() {}
+    void startWrite() { writeDepth++; }
+    void endWrite() { if (writeDepth > 0) writeDepth--; }
+    void waitDMA() { dmaPending = false; }
+    void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, const lgfx::swap565_t* image) {
+        uint64_t before = nativeWrittenPixels;
+        pushImage(x, y, w, h, image);
+        nativePushedPixels += nativeWrittenPixels - before;
+        nativeWrittenPixels = before;
+        nativeDmaPushes++;
+        dmaPending = true;
+    }
+};
+
+class M5Canvas : public LovyanGFX {
+public:
+    explicit M5Canvas(LovyanGFX* parent = nullptr) { dmaSource = parent; }
+    
+    void setColorDepth(int) {}
+    void setPsram(bool) {}
+    void* createSprite(int32_t width, int32_t height) {
+        if (!NativeDisplay::spriteAvailable) return nullptr;
+        nativeReset(width, height);
+        return frame.data();
+    }
+    void deleteSprite() { nativeReset(0, 0); }
+    void* getBuffer() { return frame.empty() ? nullptr : frame.data(); }
+};
+
+// タッチはテストがnativeCount・nativeX・nativeYで指定する
+class NativeTouch {
+public:
+    struct Detail {
+        int16_t x;
+        int16_t y;
+    };
+    uint8_t nativeCount = 0;
+    int16_t nativeX = 0;
+    int16_t nativeY = 0;
+    
+    uint8_t getCount() const { return nativeCount; }
+    Detail getDetail() const { return {nativeX, nativeY}; }
+};
+
+class M5UnifiedClass {
+public:
+    LovyanGFX Display{320, 240};
+    NativeTouch Touch;
+    
+    void update() {}
+};
+
+inline M5UnifiedClass M5;
+
+#endif // TEST_SUPPORT_M5UNIFIED_H
\ No newline at end of file
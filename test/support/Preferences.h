@@ -0,0 +1,59 @@
+#ifndef TEST_SUPPORT_PREFERENCES_H
+#define TEST_SUPPORT_PREFERENCES_H
+
+// ホストテスト用のPreferences（NVS）の代替ヘッダー
+// 値は「名前空間/キー」ごとにNativeNvs::entriesへ保持する（テストから中身の確認・破損ができる）
+// NativeNvs::failWritesを立てると書き込みが失敗する（フラッシュ満杯などの再現用）
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace NativeNvs {
+    inline std::map<std::string, std::vector<uint8_t>> entries;
+    inline bool failWrites = false;
+    inline uint32_t writeCount = 0;
+    inline uint32_t failedWriteCount = 0;
+}
+
+class Preferences {
+private:
+    std::string prefix;
+    bool opened = false;
+    
+    std::string path(const char* key) const { return prefix + key; }
+
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        prefix = std::string(name) + "/";
+        opened = true;
+        return true;
+    }
+    void end() { opened = false; }
+    
+    bool isKey(const char* key) { return opened && NativeNvs::entries.count(path(key)) > 0; }
+    size_t getBytesLength(const char* key) {
+        auto it = NativeNvs::entries.find(path(key));
+        return (opened && it != NativeNvs::entries.end()) ? it->second.size() : 0;
+    }
+    size_t getBytes(const char* key, void* buffer, size_t length) {
+        auto it = NativeNvs::entries.find(path(key));
+        if (!opened || it == NativeNvs::entries.end() || it->second.size() > length) return 0;
+        memcpy(buffer, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+    size_t putBytes(const char* key, const void* value, size_t length) {
+        if (!opened) return 0;
+        if (NativeNvs::failWrites) {
+            NativeNvs::failedWriteCount++;
+            return 0;
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(value);
+        NativeNvs::entries[path(key)].assign(bytes, bytes + length);
+        NativeNvs::writeCount++;
+        return length;
+    }
+    bool remove(const char* key) { return opened && NativeNvs::entries.erase(path(key)) > 0; }
+};
+
+#endif // TEST_SUPPORT_PREFERENCES_H
\ No newline at end of file
@@ -0,0 +1,11 @@
+#ifndef TEST_SUPPORT_SD_H
+#define TEST_SUPPORT_SD_H
+
+// ホストテスト用のSDライブラリの代替ヘッダー（ファイルの実体はFS.hの代替を参照）
+#include <FS.h>
+
+class SDClass : public fs::FS {};
+
+inline SDClass SD;
+
+#endif // TEST_SUPPORT_SD_H
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef TEST_SUPPORT_WIFI_H
+#define TEST_SUPPORT_WIFI_H
+
+// ホストテスト用のWiFiライブラリの代替ヘッダー
+// 既定は未接続。テストはWiFi.nativeStatusで接続状態を切り替える
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_CONNECTED = 3,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+public:
+    wl_status_t nativeStatus = WL_DISCONNECTED;
+    wl_status_t status() { return nativeStatus; }
+};
+
+// 接続はHTTPClientの代替（test/support/HTTPClient.h）がソケットで直接行うため、中身は持たない
+class WiFiClient {
+public:
+    virtual ~WiFiClient() {}
+};
+
+inline WiFiClass WiFi;
+
+#endif // TEST_SUPPORT_WIFI_H
\ No newline at end of file
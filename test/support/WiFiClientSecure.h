@@ -0,0 +1,13 @@
+#ifndef TEST_SUPPORT_WIFI_CLIENT_SECURE_H
+#define TEST_SUPPORT_WIFI_CLIENT_SECURE_H
+
+// ホストテスト用のWiFiClientSecureの代替ヘッダー（TLSは行わず、設定されたルートCAを記録するだけ）
+#include <WiFi.h>
+
+class WiFiClientSecure : public WiFiClient {
+public:
+    const char* caCert = nullptr;
+    void setCACert(const char* rootCa) { caCert = rootCa; }
+};
+
+#endif // TEST_SUPPORT_WIFI_CLIENT_SECURE_H
\ No newline at end of file
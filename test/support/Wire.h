@@ -0,0 +1,15 @@
+#ifndef TEST_SUPPORT_WIRE_H
+#define TEST_SUPPORT_WIRE_H
+
+// ホストテスト用のWireライブラリの代替ヘッダー（バスは持たず、接続の有無はbsec2.hの代替で決める）
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    bool begin() { return true; }
+    bool begin(int, int) { return true; }
+};
+
+inline TwoWire Wire;
+
+#endif // TEST_SUPPORT_WIRE_H
\ No newline at end of file
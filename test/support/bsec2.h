@@ -0,0 +1,196 @@
+#ifndef TEST_SUPPORT_BSEC2_H
+#define TEST_SUPPORT_BSEC2_H
+
+// ホストテスト用のBSEC2ライブラリの代替ヘッダー
+// データ型・出力IDの値とレイアウトはBSEC 2.x / BME68x Sensor libraryと同じ
+// Bsec2はアルゴリズムを持たず、テストがNativeBsec::feed()で積んだ出力をrun()ごとに1件ずつコールバックへ渡す
+#include <Arduino.h>
+#include <Wire.h>
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+
+#define BSEC_OK 0
+#define BME68X_OK 0
+#define BME68X_I2C_ADDR_LOW 0x76
+#define BME68X_I2C_ADDR_HIGH 0x77
+
+#define BSEC_NUMBER_OUTPUTS 30
+#define BSEC_MAX_STATE_BLOB_SIZE 221
+
+#define BSEC_SAMPLE_RATE_DISABLED 65535.0f
+#define BSEC_SAMPLE_RATE_ULP 0.0033333f
+#define BSEC_SAMPLE_RATE_LP 0.33333f
+#define BSEC_SAMPLE_RATE_CONT 1.0f
+#define BSEC_SAMPLE_RATE_SCAN 0.055556f
+
+typedef enum {
+    BSEC_OUTPUT_IAQ = 1,
+    BSEC_OUTPUT_STATIC_IAQ = 2,
+    BSEC_OUTPUT_CO2_EQUIVALENT = 3,
+    BSEC_OUTPUT_BREATH_VOC_EQUIVALENT = 4,
+    BSEC_OUTPUT_RAW_TEMPERATURE = 6,
+    BSEC_OUTPUT_RAW_PRESSURE = 7,
+    BSEC_OUTPUT_RAW_HUMIDITY = 8,
+    BSEC_OUTPUT_RAW_GAS = 9,
+    BSEC_OUTPUT_STABILIZATION_STATUS = 12,
+    BSEC_OUTPUT_RUN_IN_STATUS = 13,
+    BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE = 14,
+    BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY = 15,
+    BSEC_OUTPUT_COMPENSATED_GAS = 18,
+    BSEC_OUTPUT_GAS_PERCENTAGE = 21,
+    BSEC_OUTPUT_GAS_ESTIMATE_1 = 22,
+    BSEC_OUTPUT_GAS_ESTIMATE_2 = 23,
+    BSEC_OUTPUT_GAS_ESTIMATE_3 = 24,
+    BSEC_OUTPUT_GAS_ESTIMATE_4 = 25,
+    BSEC_OUTPUT_RAW_GAS_INDEX = 26
+} bsec_virtual_sensor_t;
+
+typedef bsec_virtual_sensor_t bsecSensor;
+
+typedef struct {
+    int64_t time_stamp;
+    float signal;
+    uint8_t signal_dimensions;
+    uint8_t sensor_id;
+    uint8_t accuracy;
+} bsec_output_t;
+
+typedef bsec_output_t bsecData;
+
+typedef struct {
+    bsecData output[BSEC_NUMBER_OUTPUTS];
+    uint8_t nOutputs;
+} bsecOutputs;
+
+// bme68x_data::statusのビット
+#define BME68X_NEW_DATA_MSK 0x80
+#define BME68X_GASM_VALID_MSK 0x20
+#define BME68X_HEAT_STAB_MSK 0x10
+
+struct bme68x_data {
+    uint8_t status;
+    uint8_t gas_index;
+    uint8_t meas_index;
+    uint8_t res_heat;
+    uint8_t idac;
+    uint8_t gas_wait;
+    float temperature;
+    float pressure;
+    float humidity;
+    float gas_resistance;
+};
+
+typedef struct bme68x_data bme68xData;
+
+typedef struct {
+    uint8_t major;
+    uint8_t minor;
+    uint8_t major_bugfix;
+    uint8_t minor_bugfix;
+} bsec_version_t;
+
+class Bsec2;
+typedef void (*bsecCallback)(const bme68xData data, const bsecOutputs outputs, Bsec2 bsec);
+
+// テストから操作するセンサーの状態
+namespace NativeBsec {
+    struct Sample {
+        bme68xData data;
+        bsecOutputs outputs;
+    };
+    
+    // 接続されているBME688のアドレス（既定は0x77の1個）
+    inline std::set<uint8_t> connected = { BME68X_I2C_ADDR_HIGH };
+    // アドレスごとに次のrun()で渡す出力
+    inline std::map<uint8_t, std::deque<Sample>> pending;
+    // trueにするとupdateSubscription()が失敗する
+    inline bool failSubscription = false;
+    inline uint32_t subscriptionCount = 0;
+    // pendingの保護（専用BSECタスクの代替スレッドからもrun()が呼ばれる）
+    inline std::mutex pendingMutex;
+    
+    inline void feed(uint8_t address, const bme68xData& data, const bsecOutputs& outputs) {
+        std::lock_guard<std::mutex> guard(pendingMutex);
+        pending[address].push_back({ data, outputs });
+    }
+    
+    inline size_t pendingCount(uint8_t address) {
+        std::lock_guard<std::mutex> guard(pendingMutex);
+        auto it = pending.find(address);
+        return it == pending.end() ? 0 : it->second.size();
+    }
+    
+    inline void reset() {
+        std::lock_guard<std::mutex> guard(pendingMutex);
+        connected = { BME68X_I2C_ADDR_HIGH };
+        pending.clear();
+        failSubscription = false;
+        subscriptionCount = 0;
+    }
+}
+
+class Bme68x {
+public:
+    int8_t status = BME68X_OK;
+};
+
+class Bsec2 {
+private:
+    uint8_t address = 0;
+    bsecCallback callback = nullptr;
+    uint8_t state[BSEC_MAX_STATE_BLOB_SIZE] = {};
+    uint32_t processedCount = 0;
+
+public:
+    int status = BSEC_OK;
+    bsec_version_t version = { 2, 6, 1, 0 };
+    Bme68x sensor;
+    float sampleRate = 0.0f;
+    uint32_t runCount = 0;
+    
+    bool begin(uint8_t i2cAddress, TwoWire&) {
+        address = i2cAddress;
+        return NativeBsec::connected.count(i2cAddress) > 0;
+    }
+    
+    bool updateSubscription(bsecSensor*, uint8_t, float rate) {
+        if (NativeBsec::failSubscription) return false;
+        sampleRate = rate;
+        NativeBsec::subscriptionCount++;
+        return true;
+    }
+    
+    void attachCallback(bsecCallback function) { callback = function; }
+    
+    // 積まれた出力があれば1件取り出し、BSECと同じく全出力に呼び出し時刻（ns）を付けてコールバックする
+    bool run() {
+        runCount++;
+        NativeBsec::Sample sample;
+        {
+            std::lock_guard<std::mutex> guard(NativeBsec::pendingMutex);
+            auto it = NativeBsec::pending.find(address);
+            if (it == NativeBsec::pending.end() || it->second.empty()) return true;
+            sample = it->second.front();
+            it->second.pop_front();
+        }
+        for (uint8_t i = 0; i < sample.outputs.nOutputs; i++) {
+            sample.outputs.output[i].time_stamp = getTimeMs() * 1000000;
+        }
+        // 校正状態は処理したサンプルごとに変わる（先頭に処理件数を書く）
+        processedCount++;
+        memcpy(state, &processedCount, sizeof(processedCount));
+        if (callback) callback(sample.data, sample.outputs, *this);
+        return true;
+    }
+    
+    bool getState(uint8_t* out) { memcpy(out, state, sizeof(state)); return true; }
+    bool setState(uint8_t* in) { memcpy(state, in, sizeof(state)); return true; }
+    bool setConfig(const uint8_t*) { return true; }
+    
+    static int64_t getTimeMs() { return (int64_t)millis(); }
+};
+
+#endif // TEST_SUPPORT_BSEC2_H
\ No newline at end of file
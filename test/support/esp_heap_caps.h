@@ -0,0 +1,24 @@
+#ifndef TEST_SUPPORT_ESP_HEAP_CAPS_H
+#define TEST_SUPPORT_ESP_HEAP_CAPS_H
+
+// ホストテスト用のESP-IDFヒープ関数の代替ヘッダー
+// NativeHeap::spiramAvailableを下ろすとPSRAMを指定した確保が失敗する（PSRAMなしの再現用）
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+namespace NativeHeap {
+    inline bool spiramAvailable = true;
+}
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) {
+    if ((caps & MALLOC_CAP_SPIRAM) && !NativeHeap::spiramAvailable) return nullptr;
+    return malloc(size);
+}
+
+inline void heap_caps_free(void* ptr) { free(ptr); }
+
+#endif // TEST_SUPPORT_ESP_HEAP_CAPS_H
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef TEST_SUPPORT_FREERTOS_H
+#define TEST_SUPPORT_FREERTOS_H
+
+// ホストテスト用のFreeRTOSの代替ヘッダー
+// タスクはstd::thread、ミューテックスはstd::mutexで実装する
+// 1tick = 1ms。待ち時間はmillis()（NativeClock）で数えるため、テストが時刻を進めるまでタスクは起床しない
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define configMAX_PRIORITIES 25
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#endif // TEST_SUPPORT_FREERTOS_H
\ No newline at end of file
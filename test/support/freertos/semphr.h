@@ -0,0 +1,54 @@
+#ifndef TEST_SUPPORT_FREERTOS_SEMPHR_H
+#define TEST_SUPPORT_FREERTOS_SEMPHR_H
+
+// ミューテックスとバイナリセマフォ（再帰なし、優先度継承なし）
+// どちらも取得できる数が最大1のセマフォとして実装し、ミューテックスは取得可能な状態で作る
+// 待ち時間は実時間（ms）で数える
+#include "FreeRTOS.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+struct NativeSemaphore {
+    std::mutex mutex;
+    std::condition_variable given;
+    bool available;
+    
+    explicit NativeSemaphore(bool initiallyAvailable) : available(initiallyAvailable) {}
+};
+
+typedef NativeSemaphore* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new NativeSemaphore(true);
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return new NativeSemaphore(false);
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    if (ticks == portMAX_DELAY) {
+        semaphore->given.wait(lock, [semaphore]() { return semaphore->available; });
+    } else if (!semaphore->given.wait_for(lock, std::chrono::milliseconds(ticks), 
+                                          [semaphore]() { return semaphore->available; })) {
+        return pdFALSE;
+    }
+    semaphore->available = false;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> guard(semaphore->mutex);
+    if (semaphore->available) return pdFALSE;
+    semaphore->available = true;
+    semaphore->given.notify_one();
+    return pdTRUE;
+}
+
+#endif // TEST_SUPPORT_FREERTOS_SEMPHR_H
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef TEST_SUPPORT_FREERTOS_TASK_H
+#define TEST_SUPPORT_FREERTOS_TASK_H
+
+// タスクは切り離したstd::threadで動かし、通知はタスクごとのカウンターと条件変数で待つ
+// vTaskDelete(nullptr)はタスク関数から戻る直前に呼ばれる前提で、スレッドの終了を記録するだけ
+#include <Arduino.h>
+#include "FreeRTOS.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct NativeTask {
+    std::mutex mutex;
+    std::condition_variable wake;
+    uint32_t notifyCount = 0;
+    std::atomic<bool> finished{false};
+};
+
+typedef NativeTask* TaskHandle_t;
+
+namespace NativeRtos {
+    inline thread_local NativeTask* currentTask = nullptr;
+    inline std::atomic<uint32_t> runningTasks{0};
+    
+    // 起動したタスクがすべて終了するまで待つ（テストの後始末用）
+    inline bool waitForTasks(uint32_t timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (runningTasks.load() > 0) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char*, uint32_t, void* param,
+                                          UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+    NativeTask* task = new NativeTask();
+    if (handle) *handle = task;
+    NativeRtos::runningTasks++;
+    std::thread([function, param, task]() {
+        NativeRtos::currentTask = task;
+        function(param);
+    }).detach();
+    return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr) {
+        task = NativeRtos::currentTask;
+    }
+    // 他のスレッドが通知中の可能性があるため、ハンドルは解放しない（テスト中のみ存在）
+    if (task && !task->finished.exchange(true)) {
+        NativeRtos::runningTasks--;
+    }
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return NativeRtos::currentTask;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    unsigned long start = millis();
+    while (millis() - start < ticks) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    if (!task) return pdFAIL;
+    std::lock_guard<std::mutex> guard(task->mutex);
+    task->notifyCount++;
+    task->wake.notify_all();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    NativeTask* task = NativeRtos::currentTask;
+    if (!task) return 0;
+    unsigned long start = millis();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    while (task->notifyCount == 0) {
+        if (ticks != portMAX_DELAY && millis() - start >= ticks) break;
+        task->wake.wait_for(lock, std::chrono::microseconds(200));
+    }
+    uint32_t count = task->notifyCount;
+    if (count > 0) {
+        task->notifyCount = clearOnExit ? 0 : count - 1;
+    }
+    return count;
+}
+
+#endif // TEST_SUPPORT_FREERTOS_TASK_H
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include <unity.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "AnomalyDetector.h"
+
+// 合成した室内データで、平常時の誤検知・変化の検知遅れ・時刻の飛びへの対応を確認する
+// 平常時は気温±1.5℃・気圧±1hPaの日周変化に測定ノイズを重ねる
+
+static const uint32_t START = 1700000000;
+static const uint32_t INTERVAL = 3;
+
+static std::vector<AnomalyEvent> events;
+
+struct IndoorSignal {
+    std::mt19937 rng;
+    std::normal_distribution<float> noise;
+    float iaqOffset;
+    float temperatureOffset;
+    float pressureSlope;        // hPa/時（DRIFTの確認用）
+    uint32_t pressureSlopeStart;
+    
+    explicit IndoorSignal(uint32_t seed) :
+        rng(seed), noise(0.0f, 1.0f), iaqOffset(0.0f), temperatureOffset(0.0f), pressureSlope(0.0f), pressureSlopeStart(0) {}
+    
+    SensorReading at(uint32_t t) {
+        const float day = 2.0f * (float)M_PI * (float)((t - START) % 86400) / 86400.0f;
+        SensorReading reading;
+        reading.timestamp = t;
+        reading.time_synced = true;
+        reading.temperature = 22.0f + 1.5f * sinf(day) + temperatureOffset + 0.02f * noise(rng);
+        reading.humidity = 45.0f - 4.0f * sinf(day) + 0.1f * noise(rng);
+        reading.pressure = 1013.0f + 1.0f * sinf(day + 1.0f) + 0.02f * noise(rng);
+        if (pressureSlope != 0.0f && t >= pressureSlopeStart) {
+            reading.pressure += pressureSlope * (float)(t - pressureSlopeStart) / 3600.0f;
+        }
+        reading.iaq = 50.0f + 5.0f * sinf(day) + iaqOffset + 1.0f * noise(rng);
+        reading.has_iaq_data = true;
+        reading.gas_resistance = 120000.0f * (1.0f + 0.1f * sinf(day)) * (1.0f + 0.005f * noise(rng));
+        return reading;
+    }
+};
+
+static void run(AnomalyDetector& detector, IndoorSignal& signal, uint32_t from, uint32_t to) {
+    for (uint32_t t = from; t < to; t += INTERVAL) {
+        detector.update(signal.at(t));
+    }
+}
+
+static const AnomalyEvent* firstEvent(uint8_t sensorId, uint32_t after) {
+    for (const AnomalyEvent& event : events) {
+        if (event.sensorId == sensorId && event.timestamp >= after) {
+            return &event;
+        }
+    }
+    return nullptr;
+}
+
+static const AnomalyEvent* firstEvent(uint8_t sensorId, AnomalyType type, uint32_t after) {
+    for (const AnomalyEvent& event : events) {
+        if (event.sensorId == sensorId && event.type == type && event.timestamp >= after) {
+            return &event;
+        }
+    }
+    return nullptr;
+}
+
+void setUp(void) {
+    events.clear();
+}
+
+void tearDown(void) {
+}
+
+static void attach(AnomalyDetector& detector) {
+    detector.setCallback([](const AnomalyEvent& event) {
+        events.push_back(event);
+    });
+}
+
+void test_no_false_alarms_over_three_quiet_days(void) {
+    AnomalyDetector detector;
+    attach(detector);
+    IndoorSignal signal(1);
+    run(detector, signal, START, START + 3 * 86400);
+    TEST_ASSERT_EQUAL_UINT32(0, events.size());
+}
+
+void test_iaq_step_is_detected_within_a_minute(void) {
+    AnomalyDetector detector;
+    attach(detector);
+    IndoorSignal signal(2);
+    const uint32_t stepAt = START + 6 * 3600;
+    run(detector, signal, START, stepAt);
+    TEST_ASSERT_EQUAL_UINT32(0, events.size());
+    
+    // 調理などでIAQが40上がったまま続く
+    signal.iaqOffset = 40.0f;
+    run(detector, signal, stepAt, stepAt + 3600);
+    
+    const AnomalyEvent* event = firstEvent(BSEC_OUTPUT_IAQ, stepAt);
+    TEST_ASSERT_NOT_NULL(event);
+    TEST_ASSERT_EQUAL_INT8(1, event->direction);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(60, event->timestamp - stepAt);
+}
+
+void test_pressure_drop_is_detected_as_drift(void) {
+    AnomalyDetector detector;
+    attach(detector);
+    IndoorSignal signal(3);
+    const uint32_t dropAt = START + 12 * 3600;
+    run(detector, signal, START, dropAt);
+    
+    // 低気圧の接近で1時間に1.5hPaずつ下がり始める
+    signal.pressureSlope = -1.5f;
+    signal.pressureSlopeStart = dropAt;
+    run(detector, signal, dropAt, dropAt + 6 * 3600);
+    
+    // 予測残差の偏りとしては数分で、傾きの変化としては2時間以内に検知する
+    const AnomalyEvent* first = firstEvent(BSEC_OUTPUT_RAW_PRESSURE, dropAt);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_EQUAL_INT8(-1, first->direction);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(10 * 60, first->timestamp - dropAt);
+    
+    const AnomalyEvent* drift = firstEvent(BSEC_OUTPUT_RAW_PRESSURE, AnomalyType::DRIFT, dropAt);
+    TEST_ASSERT_NOT_NULL(drift);
+    TEST_ASSERT_EQUAL_INT8(-1, drift->direction);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2 * 3600, drift->timestamp - dropAt);
+}
+
+void test_long_gap_restarts_baseline(void) {
+    AnomalyDetector detector;
+    attach(detector);
+    IndoorSignal signal(4);
+    run(detector, signal, START, START + 6 * 3600);
+    
+    // 電源断などで半日止まり、再開時には日周変化で値が大きく変わっている
+    signal.iaqOffset = 40.0f;
+    const uint32_t resumeAt = START + 18 * 3600 + 1234;
+    run(detector, signal, resumeAt, resumeAt + 2 * 3600);
+    TEST_ASSERT_EQUAL_UINT32(0, events.size());
+}
+
+void test_clock_jump_restarts_baseline(void) {
+    AnomalyDetector detector;
+    attach(detector);
+    IndoorSignal signal(5);
+    run(detector, signal, START, START + 6 * 3600);
+    
+    // 時刻が戻った場合（RTCの再設定など）も予測の基準を作り直し、誤検知しない
+    signal.iaqOffset = 40.0f;
+    run(detector, signal, START + 3600, START + 3 * 3600);
+    TEST_ASSERT_EQUAL_UINT32(0, events.size());
+}
+
+void test_ntp_sync_switches_epoch_without_alarm(void) {
+    AnomalyDetector detector;
+    attach(detector);
+    IndoorSignal signal(6);
+    
+    // NTP同期前はmillis()（toSeconds()で起動からの秒）
+    for (uint32_t ms = 0; ms < 3600 * 1000; ms += INTERVAL * 1000) {
+        SensorReading reading = signal.at(START + ms / 1000);
+        reading.timestamp = ms;
+        reading.time_synced = false;
+        detector.update(reading);
+    }
+    
+    signal.iaqOffset = 40.0f;
+    run(detector, signal, START + 3600, START + 2 * 3600);
+    TEST_ASSERT_EQUAL_UINT32(0, events.size());
+}
+
+// 気圧がslope（hPa/時）で下がり始めてからDRIFTを検知するまでの秒数（12時間以内に検知しなければ0）
+static uint32_t pressureDriftDelay(float slope, uint32_t seed) {
+    events.clear();
+    AnomalyDetector detector;
+    attach(detector);
+    IndoorSignal signal(seed);
+    const uint32_t dropAt = START + 12 * 3600;
+    run(detector, signal, START, dropAt);
+    signal.pressureSlope = slope;
+    signal.pressureSlopeStart = dropAt;
+    run(detector, signal, dropAt, dropAt + 12 * 3600);
+    const AnomalyEvent* drift = firstEvent(BSEC_OUTPUT_RAW_PRESSURE, AnomalyType::DRIFT, dropAt);
+    return drift ? drift->timestamp - dropAt : 0;
+}
+
+void test_detection_delay_and_cost(void) {
+    // 7日間の平常時の誤検知数、気温の3σ（残差の標準偏差の下限0.05℃の3倍）の段差と気圧低下（-1・-0.3hPa/時）の
+    // 検知までの時間、1読み取りあたりの処理時間
+    AnomalyDetector quiet;
+    attach(quiet);
+    IndoorSignal signal(7);
+    std::vector<SensorReading> week;
+    for (uint32_t t = START; t < START + 7 * 86400; t += INTERVAL) {
+        week.push_back(signal.at(t));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (const SensorReading& reading : week) {
+        quiet.update(reading);
+    }
+    double updateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / week.size();
+    const size_t falseAlarms = events.size();
+    
+    events.clear();
+    AnomalyDetector detector;
+    attach(detector);
+    IndoorSignal stepped(8);
+    const uint32_t stepAt = START + 6 * 3600;
+    run(detector, stepped, START, stepAt);
+    stepped.temperatureOffset = 3.0f * ANOMALY_FIELDS[0].minSigma;
+    run(detector, stepped, stepAt, stepAt + 3600);
+    const AnomalyEvent* step = firstEvent(BSEC_OUTPUT_RAW_TEMPERATURE, stepAt);
+    uint32_t stepDelay = step ? step->timestamp - stepAt : 0;
+    
+    uint32_t fastDrift = pressureDriftDelay(-1.0f, 9);
+    uint32_t slowDrift = pressureDriftDelay(-0.3f, 10);
+    
+    char message[192];
+    snprintf(message, sizeof(message), "7 quiet days: %u false alarms; temperature 3-sigma step %u s; "
+             "pressure drift -1 hPa/h %u min, -0.3 hPa/h %s; %.0f ns/reading",
+             (unsigned)falseAlarms, stepDelay, fastDrift / 60,
+             slowDrift ? (String(slowDrift / 3600.0f, 1) + " h").c_str() : "not within 12 h", updateNs);
+    TEST_MESSAGE(message);
+    
+    // -0.3hPa/時は気圧の傾きの許容幅（driftDelta）と同じなので検知の有無は判定せず、結果だけ表示する
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, falseAlarms);
+    TEST_ASSERT_NOT_NULL(step);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(60, stepDelay);
+    TEST_ASSERT_TRUE(fastDrift > 0 && fastDrift <= 3 * 3600);
+    TEST_ASSERT_LESS_THAN(20000.0, updateNs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_false_alarms_over_three_quiet_days);
+    RUN_TEST(test_iaq_step_is_detected_within_a_minute);
+    RUN_TEST(test_pressure_drop_is_detected_as_drift);
+    RUN_TEST(test_long_gap_restarts_baseline);
+    RUN_TEST(test_clock_jump_restarts_baseline);
+    RUN_TEST(test_ntp_sync_switches_epoch_without_alarm);
+    RUN_TEST(test_detection_delay_and_cost);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "DerivedMetrics.h"
+
+// 列カーネル（多項式近似・分岐なし）の結果を、libmで1件ずつ計算する素直な実装と比べ、
+// まとめて計算しても1件ずつ計算しても同じ値になること、極端な入力でも有限値になることを確認する
+
+struct Reference {
+    float dewPoint;
+    float absoluteHumidity;
+    float heatIndex;
+    float seaLevelPressure;
+};
+
+// 1件ずつのlibm版（DerivedMetrics.hの式をそのまま書いたもの）
+static Reference reference(float t, float rh, float p, float altitude) {
+    rh = rh < 0.1f ? 0.1f : (rh > 100.0f ? 100.0f : rh);
+    Reference r;
+    
+    const float gamma = logf(rh / 100.0f) + 17.62f * t / (243.12f + t);
+    r.dewPoint = 243.12f * gamma / (17.62f - gamma);
+    r.absoluteHumidity = 216.7f * 6.112f * expf(gamma) / (273.15f + t);
+    
+    const float tf = t * 1.8f + 32.0f;
+    float heat = 0.5f * (tf + 61.0f + (tf - 68.0f) * 1.2f + rh * 0.094f);
+    if (0.5f * (heat + tf) >= 80.0f) {
+        heat = -42.379f + 2.04901523f * tf + 10.14333127f * rh 
+               - 0.22475541f * tf * rh - 0.00683783f * tf * tf - 0.05481717f * rh * rh 
+               + 0.00122874f * tf * tf * rh + 0.00085282f * tf * rh * rh 
+               - 0.00000199f * tf * tf * rh * rh;
+        if (rh < 13.0f && tf >= 80.0f && tf <= 112.0f) {
+            heat -= (13.0f - rh) * 0.25f * sqrtf((17.0f - fabsf(tf - 95.0f)) / 17.0f);
+        } else if (rh > 85.0f && tf >= 80.0f && tf <= 87.0f) {
+            heat += (rh - 85.0f) * 0.1f * (87.0f - tf) * 0.2f;
+        }
+    }
+    r.heatIndex = (heat - 32.0f) / 1.8f;
+    
+    const float lh = 0.0065f * altitude;
+    r.seaLevelPressure = p * powf(1.0f - lh / (t + lh + 273.15f), -5.257f);
+    return r;
+}
+
+static std::vector<SensorReading> randomReadings(size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> temperature(-40.0f, 60.0f);
+    std::uniform_real_distribution<float> humidity(0.0f, 100.0f);
+    std::uniform_real_distribution<float> pressure(300.0f, 1100.0f);
+    
+    std::vector<SensorReading> readings(count);
+    for (SensorReading& reading : readings) {
+        reading.temperature = temperature(rng);
+        reading.humidity = humidity(rng);
+        reading.pressure = pressure(rng);
+    }
+    return readings;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_batched_matches_scalar_libm(void) {
+    const float altitudes[] = { -400.0f, 0.0f, 35.0f, 1500.0f, 4000.0f };
+    std::vector<SensorReading> readings = randomReadings(4096, 7);
+    
+    float maxError[DerivedMetrics::FIELD_COUNT] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (float altitude : altitudes) {
+        for (size_t offset = 0; offset < readings.size(); offset += DerivedColumns::BATCH_SIZE) {
+            DerivedColumns columns;
+            size_t n = DerivedMetrics::compute(&readings[offset], readings.size() - offset, altitude, columns);
+            TEST_ASSERT_EQUAL(DerivedColumns::BATCH_SIZE, n);
+            
+            for (size_t i = 0; i < n; i++) {
+                const SensorReading& reading = readings[offset + i];
+                const Reference expected = reference(reading.temperature, reading.humidity, reading.pressure, altitude);
+                const float values[] = { expected.dewPoint, expected.absoluteHumidity,
+                                         expected.heatIndex, expected.seaLevelPressure };
+                for (uint8_t f = 0; f < DerivedMetrics::FIELD_COUNT; f++) {
+                    // 海面気圧は値の大きさに対する相対誤差で見る
+                    float error = fabsf(columns.get(f, i) - values[f]);
+                    if (f == 3) error /= values[f];
+                    if (error > maxError[f]) maxError[f] = error;
+                }
+            }
+        }
+    }
+    
+    TEST_ASSERT_TRUE(maxError[0] < 1e-3f);      // ℃
+    TEST_ASSERT_TRUE(maxError[1] < 1e-3f);      // g/m³
+    TEST_ASSERT_TRUE(maxError[2] < 1e-3f);      // ℃
+    TEST_ASSERT_TRUE(maxError[3] < 1e-5f);      // 相対
+}
+
+void test_batch_equals_one_at_a_time(void) {
+    // まとめて計算しても1件ずつ計算しても同じ値（ビット単位で一致）
+    std::vector<SensorReading> readings = randomReadings(DerivedColumns::BATCH_SIZE, 11);
+    DerivedColumns batch;
+    TEST_ASSERT_EQUAL(DerivedColumns::BATCH_SIZE, DerivedMetrics::compute(readings.data(), readings.size(), 120.0f, batch));
+    
+    for (size_t i = 0; i < readings.size(); i++) {
+        DerivedColumns single;
+        TEST_ASSERT_EQUAL(1, DerivedMetrics::compute(&readings[i], 1, 120.0f, single));
+        for (uint8_t f = 0; f < DerivedMetrics::FIELD_COUNT; f++) {
+            const float a = batch.get(f, i);
+            const float b = single.get(f, 0);
+            TEST_ASSERT_EQUAL(0, memcmp(&a, &b, sizeof(float)));
+        }
+    }
+}
+
+void test_batch_limited_to_batch_size(void) {
+    std::vector<SensorReading> readings = randomReadings(DerivedColumns::BATCH_SIZE + 5, 3);
+    DerivedColumns columns;
+    TEST_ASSERT_EQUAL(DerivedColumns::BATCH_SIZE, DerivedMetrics::compute(readings.data(), readings.size(), 0.0f, columns));
+    TEST_ASSERT_EQUAL(DerivedColumns::BATCH_SIZE, columns.count);
+    TEST_ASSERT_EQUAL(5, DerivedMetrics::compute(readings.data() + DerivedColumns::BATCH_SIZE, 5, 0.0f, columns));
+    TEST_ASSERT_EQUAL(0, DerivedMetrics::compute(readings.data(), 0, 0.0f, columns));
+}
+
+void test_known_values(void) {
+    SensorReading readings[3];
+    readings[0].temperature = 20.0f;    // 20℃ 50% → 露点9.3℃、絶対湿度8.6g/m³
+    readings[0].humidity = 50.0f;
+    readings[0].pressure = 1000.0f;
+    readings[1].temperature = 32.22f;   // 90°F 70% → 暑さ指数105.9°F（41.1℃）
+    readings[1].humidity = 70.0f;
+    readings[1].pressure = 1013.25f;
+    readings[2].temperature = 15.0f;    // 標準大気の1000mは898.7hPa
+    readings[2].humidity = 60.0f;
+    readings[2].pressure = 898.7f;
+    
+    DerivedColumns columns;
+    DerivedMetrics::compute(readings, 3, 0.0f, columns);
+    TEST_ASSERT_TRUE(fabsf(columns.dewPoint[0] - 9.26f) < 0.05f);
+    TEST_ASSERT_TRUE(fabsf(columns.absoluteHumidity[0] - 8.63f) < 0.05f);
+    TEST_ASSERT_TRUE(fabsf(columns.heatIndex[1] - 41.06f) < 0.1f);
+    TEST_ASSERT_TRUE(fabsf(columns.seaLevelPressure[0] - 1000.0f) < 0.01f);   // 高度0では補正しない
+    
+    DerivedMetrics::compute(&readings[2], 1, 1000.0f, columns);
+    TEST_ASSERT_TRUE(fabsf(columns.seaLevelPressure[0] - 1013.25f) < 3.0f);
+}
+
+void test_extreme_inputs_stay_finite(void) {
+    const float temperatures[] = { -40.0f, 0.0f, 60.0f };
+    const float humidities[] = { -5.0f, 0.0f, 100.0f, 120.0f };
+    const float pressures[] = { 300.0f, 1100.0f };
+    const float altitudes[] = { -500.0f, 9000.0f };
+    
+    for (float t : temperatures) {
+        for (float rh : humidities) {
+            for (float p : pressures) {
+                for (float altitude : altitudes) {
+                    SensorReading reading;
+                    reading.temperature = t;
+                    reading.humidity = rh;
+                    reading.pressure = p;
+                    DerivedColumns columns;
+                    DerivedMetrics::compute(&reading, 1, altitude, columns);
+                    for (uint8_t f = 0; f < DerivedMetrics::FIELD_COUNT; f++) {
+                        TEST_ASSERT_TRUE(isfinite(columns.get(f, 0)));
+                    }
+                    // 露点は気温を超えない
+                    TEST_ASSERT_TRUE(columns.dewPoint[0] <= t + 0.01f);
+                }
+            }
+        }
+    }
+}
+
+void test_kernel_benchmark(void) {
+    // 列カーネルとlibmで1件ずつ計算する場合の1件あたりの時間（値はビルドフラグで大きく変わる）
+    const size_t count = 4096;
+    const int rounds = 50;
+    std::vector<SensorReading> readings = randomReadings(count, 5);
+    std::vector<float> temperature(count), humidity(count), pressure(count);
+    for (size_t i = 0; i < count; i++) {
+        temperature[i] = readings[i].temperature;
+        humidity[i] = readings[i].humidity;
+        pressure[i] = readings[i].pressure;
+    }
+    std::vector<float> dewPoint(count), absoluteHumidity(count), heatIndex(count), seaLevelPressure(count);
+    std::vector<Reference> expected(count);
+    DerivedColumns columns;
+    volatile float sink = 0.0f;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        DerivedMetrics::computeColumns(temperature.data(), humidity.data(), pressure.data(), count, 35.0f,
+                                       dewPoint.data(), absoluteHumidity.data(), heatIndex.data(), seaLevelPressure.data());
+        sink = sink + dewPoint[r];
+    }
+    double columnNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (rounds * count);
+    
+    // 記録時と同じく、SensorReadingの配列から32件ずつ列に集めて計算する
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t offset = 0; offset < count; offset += DerivedColumns::BATCH_SIZE) {
+            DerivedMetrics::compute(&readings[offset], count - offset, 35.0f, columns);
+            sink = sink + columns.heatIndex[0];
+        }
+    }
+    double batchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (rounds * count);
+    
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            expected[i] = reference(readings[i].temperature, readings[i].humidity, readings[i].pressure, 35.0f);
+        }
+        sink = sink + expected[r].dewPoint;
+    }
+    double scalarNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (rounds * count);
+    
+    char message[160];
+    snprintf(message, sizeof(message), "per reading: columns %.1f ns, compute() in batches of %u %.1f ns, scalar libm %.1f ns",
+             columnNs, (unsigned)DerivedColumns::BATCH_SIZE, batchNs, scalarNs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(sink == sink);
+    TEST_ASSERT_LESS_THAN(2000, (int)batchNs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_batched_matches_scalar_libm);
+    RUN_TEST(test_batch_equals_one_at_a_time);
+    RUN_TEST(test_batch_limited_to_batch_size);
+    RUN_TEST(test_known_values);
+    RUN_TEST(test_extreme_inputs_stay_finite);
+    RUN_TEST(test_kernel_benchmark);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include <unity.h>
+#include <string.h>
+#include "DeviceRegistry.h"
+#include "SystemTypes.h"
+
+// SensorReadingがデバイス名をハンドルで持ち、バイト列のコピーで受け渡しても
+// 名前とフラグが失われないこと、登録表の重複・上限の扱いを確認する
+// （登録表は静的なので、上限を確かめるテストは最後に実行する）
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_default_device_and_interning(void) {
+    TEST_ASSERT_EQUAL_STRING("M5Stack_001", DeviceRegistry::getName(DeviceRegistry::DEFAULT_DEVICE));
+    TEST_ASSERT_EQUAL_UINT16(DeviceRegistry::DEFAULT_DEVICE, DeviceRegistry::intern("M5Stack_001"));
+    
+    const uint16_t kitchen = DeviceRegistry::intern("kitchen");
+    TEST_ASSERT_TRUE(DeviceRegistry::isValid(kitchen));
+    TEST_ASSERT_EQUAL_UINT16(kitchen, DeviceRegistry::intern(String("kitchen")));
+    TEST_ASSERT_EQUAL_STRING("kitchen", DeviceRegistry::getName(kitchen));
+    
+    TEST_ASSERT_EQUAL_UINT16(DeviceRegistry::INVALID_HANDLE, DeviceRegistry::intern(""));
+    TEST_ASSERT_EQUAL_UINT16(DeviceRegistry::INVALID_HANDLE, DeviceRegistry::intern((const char*)nullptr));
+    TEST_ASSERT_EQUAL_STRING("unknown", DeviceRegistry::getName(DeviceRegistry::INVALID_HANDLE));
+}
+
+void test_long_names_truncated(void) {
+    const uint16_t handle = DeviceRegistry::intern("living-room-window-sensor-north");
+    TEST_ASSERT_EQUAL(23, strlen(DeviceRegistry::getName(handle)));
+    TEST_ASSERT_EQUAL_UINT16(handle, DeviceRegistry::intern("living-room-window-sensor-north"));
+}
+
+void test_reading_survives_byte_copy(void) {
+    SensorReading reading;
+    reading.timestamp = 1700000000;
+    reading.temperature = 23.5f;
+    reading.iaq = 87.0f;
+    reading.device_handle = DeviceRegistry::intern("bedroom");
+    reading.outlier_mask = 0x0105;
+    reading.channel = 3;
+    reading.has_iaq_data = true;
+    reading.time_synced = true;
+    
+    // リングバッファ・SD保存と同じくバイト列として複製する
+    uint8_t bytes[sizeof(SensorReading)];
+    memcpy(bytes, &reading, sizeof(bytes));
+    SensorReading copy;
+    memcpy(&copy, bytes, sizeof(copy));
+    
+    TEST_ASSERT_EQUAL_UINT32(1700000000, copy.timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(23.5f, copy.temperature);
+    TEST_ASSERT_EQUAL_UINT16(0x0105, copy.outlier_mask);
+    TEST_ASSERT_EQUAL_UINT8(3, copy.channel);
+    TEST_ASSERT_TRUE(copy.has_iaq_data);
+    TEST_ASSERT_TRUE(copy.time_synced);
+    TEST_ASSERT_FALSE(copy.has_co2_data);
+    TEST_ASSERT_EQUAL_STRING("bedroom", DeviceRegistry::getName(copy.device_handle));
+}
+
+void test_full_registry_rejects_new_names(void) {
+    // 上限（32件）まで埋める
+    char name[24];
+    uint16_t last = 0;
+    for (int i = 0; DeviceRegistry::getDeviceCount() < 32; i++) {
+        snprintf(name, sizeof(name), "device-%d", i);
+        last = DeviceRegistry::intern(name);
+        TEST_ASSERT_TRUE(DeviceRegistry::isValid(last));
+    }
+    TEST_ASSERT_EQUAL_UINT16(DeviceRegistry::INVALID_HANDLE, DeviceRegistry::intern("one-too-many"));
+    // 登録済みの名前は引き続き解決できる
+    TEST_ASSERT_EQUAL_UINT16(last, DeviceRegistry::intern(name));
+    TEST_ASSERT_EQUAL_UINT16(DeviceRegistry::DEFAULT_DEVICE, DeviceRegistry::intern("M5Stack_001"));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_device_and_interning);
+    RUN_TEST(test_long_names_truncated);
+    RUN_TEST(test_reading_survives_byte_copy);
+    RUN_TEST(test_full_registry_rejects_new_names);
+    return UNITY_END();
+}
\ No newline at end of file
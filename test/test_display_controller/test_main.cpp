@@ -0,0 +1,292 @@
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include <esp_heap_caps.h>
+#include "DisplayController.h"
+
+// 表示の差分描画を、M5Unifiedの代替（test/support/M5Unified.h）のパネルの画素で確かめる
+// 毎回画面を消して全体を描き直す描画（ページ切り替え直後と同じ）と、差分描画の結果が画素単位で一致すること、
+// 変わらない行は描かないこと、行が消えてフィールドの番号がずれた時に重なった行を描き直すことを見る
+// PSRAMのバッファに合成する場合は、変更した矩形だけがDMAで転送され、転送中のバッファを書き換えないことを見る
+
+static SensorReading makeReading(float temperature, float runin = 100.0f) {
+    SensorReading reading;
+    reading.temperature = temperature;
+    reading.humidity = 45.0f;
+    reading.pressure = 1008.0f;
+    reading.co2_equivalent = 620.0f;
+    reading.iaq = 48.0f;
+    reading.voc_equivalent = 0.6f;
+    reading.runin_status = runin;
+    reading.stabilized = true;
+    return reading;
+}
+
+// 同じ内容を別のコントローラーで最初から描いた画面（差分描画の正解）
+// パネルは共有なので、描いた後に元の画面へ戻す
+static std::vector<uint16_t> freshFrame(const SensorReading& reading, DisplayPage page) {
+    std::vector<uint16_t> drawn = M5.Display.nativePixels();
+    DisplayController fresh;
+    fresh.initialize();
+    fresh.showSensorData(reading, page);
+    fresh.finishFrame();
+    std::vector<uint16_t> expected = M5.Display.nativePixels();
+    M5.Display.nativePixels() = drawn;
+    return expected;
+}
+
+static bool sameAsFresh(const SensorReading& reading, DisplayPage page) {
+    return M5.Display.nativePixels() == freshFrame(reading, page);
+}
+
+// 3秒ごとの読み取りで少しずつ動く値
+static SensorReading driftingReading(int i) {
+    SensorReading reading = makeReading(22.0f + 0.5f * sinf(i * 0.01f), 100.0f);
+    reading.humidity = 45.0f + 3.0f * sinf(i * 0.004f);
+    reading.co2_equivalent = 600.0f + 80.0f * sinf(i * 0.002f);
+    reading.iaq = 50.0f + 20.0f * sinf(i * 0.003f);
+    reading.voc_equivalent = 0.6f + 0.2f * sinf(i * 0.005f);
+    return reading;
+}
+
+static uint64_t frameHash(const std::vector<uint16_t>& pixels) {
+    uint64_t hash = 1469598103934665603ull;
+    for (uint16_t pixel : pixels) hash = (hash ^ pixel) * 1099511628211ull;
+    return hash;
+}
+
+void setUp(void) {
+    NativeClock::nowMs = 0;
+    NativeDisplay::spriteAvailable = false;     // 差分描画そのものはLCDへの直接描画で見る
+    NativeHeap::spiramAvailable = true;
+    NativeDisplay::tornWrites = 0;
+    M5.Display.nativeReset(DisplayController::SCREEN_WIDTH, DisplayController::SCREEN_HEIGHT);
+}
+
+void tearDown(void) {
+}
+
+void test_unchanged_page_writes_nothing(void) {
+    DisplayController display;
+    display.initialize();
+    display.showSensorData(makeReading(22.4f), DisplayPage::SENSOR_DATA_1);
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(22.4f), DisplayPage::SENSOR_DATA_1));
+    
+    M5.Display.nativeWrittenPixels = 0;
+    display.showSensorData(makeReading(22.4f), DisplayPage::SENSOR_DATA_1);
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)M5.Display.nativeWrittenPixels);
+}
+
+void test_changed_value_redraws_only_changed_characters(void) {
+    DisplayController display;
+    display.initialize();
+    display.showSensorData(makeReading(22.4f), DisplayPage::SENSOR_DATA_1);
+    
+    // 「温度: 22.4℃」→「温度: 22.5℃」は4と5の後ろ（5と℃）だけを描く
+    M5.Display.nativeWrittenPixels = 0;
+    M5.Display.nativeFontGlyphs = 0;
+    display.showSensorData(makeReading(22.5f), DisplayPage::SENSOR_DATA_1);
+    TEST_ASSERT_EQUAL_UINT32(2, M5.Display.nativeFontGlyphs);
+    TEST_ASSERT_EQUAL_UINT32((12 + 24) * 24, (uint32_t)M5.Display.nativeWrittenPixels);
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(22.5f), DisplayPage::SENSOR_DATA_1));
+    
+    // 桁が減った行は前回より短くなった分だけ末尾を消す
+    display.showSensorData(makeReading(9.5f), DisplayPage::SENSOR_DATA_1);
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(9.5f), DisplayPage::SENSOR_DATA_1));
+}
+
+void test_removed_line_repaints_overlapped_fields(void) {
+    // 慣らし中の注記が消えるとフッターの3行がそれぞれ1つ前の番号に移り、
+    // 消した矩形が描いたばかりの行に重なる（重なった行を描き直さないと欠ける）
+    DisplayController display;
+    display.initialize();
+    display.showSensorData(makeReading(22.4f, 30.0f), DisplayPage::SENSOR_DATA_2);
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(22.4f, 30.0f), DisplayPage::SENSOR_DATA_2));
+    
+    display.showSensorData(makeReading(22.4f, 60.0f), DisplayPage::SENSOR_DATA_2);
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(22.4f, 60.0f), DisplayPage::SENSOR_DATA_2));
+    
+    // 注記が戻る場合も同じ
+    display.showSensorData(makeReading(22.4f, 40.0f), DisplayPage::SENSOR_DATA_2);
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(22.4f, 40.0f), DisplayPage::SENSOR_DATA_2));
+}
+
+void test_page_change_redraws_whole_screen(void) {
+    DisplayController display;
+    display.initialize();
+    display.showSensorData(makeReading(22.4f), DisplayPage::SENSOR_DATA_1);
+    display.showSensorData(makeReading(22.4f), DisplayPage::SENSOR_DATA_2);
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(22.4f), DisplayPage::SENSOR_DATA_2));
+    display.showSensorData(makeReading(22.4f), DisplayPage::SENSOR_DATA_1);
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(22.4f), DisplayPage::SENSOR_DATA_1));
+}
+
+void test_pixels_per_update(void) {
+    // 3秒ごとの読み取りで値が少しずつ動き、500件ごとにページを切り替える3000件
+    // 比較対象は毎回全画面を消して描き直す描画（ページを切り替えた直後の描画と同じ処理）
+    const int updates = 3000;
+    DisplayController display;
+    DisplayController redraw;
+    display.initialize();
+    redraw.initialize();
+    
+    uint64_t diffPixels = 0, fullPixels = 0;
+    double diffNs = 0.0, fullNs = 0.0;
+    uint32_t mismatches = 0;
+    SystemStatus status = {};
+    for (int i = 0; i < updates; i++) {
+        NativeClock::nowMs = (unsigned long)i * 3000;
+        const DisplayPage page = (i / 500) % 2 ? DisplayPage::SENSOR_DATA_2 : DisplayPage::SENSOR_DATA_1;
+        const SensorReading reading = driftingReading(i);
+        
+        M5.Display.nativeWrittenPixels = 0;
+        auto start = std::chrono::steady_clock::now();
+        display.showSensorData(reading, page);
+        diffNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        diffPixels += M5.Display.nativeWrittenPixels;
+        
+        // 全体の描き直し（別のページを挟んで毎回ページ切り替えとして描かせる）
+        std::vector<uint16_t> drawn = M5.Display.nativePixels();
+        redraw.showStatus(status);
+        M5.Display.nativeWrittenPixels = 0;
+        start = std::chrono::steady_clock::now();
+        redraw.showSensorData(reading, page);
+        fullNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        fullPixels += M5.Display.nativeWrittenPixels;
+        if (M5.Display.nativePixels() != drawn) mismatches++;
+        M5.Display.nativePixels() = drawn;
+    }
+    
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+    TEST_ASSERT_LESS_THAN_UINT32((uint32_t)(fullPixels / 5), (uint32_t)diffPixels);
+    
+    char message[200];
+    snprintf(message, sizeof(message), "pixels per update: %llu full redraw, %llu diff; host render %.1f us full, %.1f us diff",
+             (unsigned long long)(fullPixels / updates), (unsigned long long)(diffPixels / updates),
+             fullNs / updates / 1000.0, diffNs / updates / 1000.0);
+    TEST_MESSAGE(message);
+}
+
+void test_canvas_pushes_only_changed_rows(void) {
+    NativeDisplay::spriteAvailable = true;
+    DisplayController display;
+    display.initialize();
+    display.showSensorData(makeReading(22.4f), DisplayPage::SENSOR_DATA_1);
+    display.finishFrame();
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(22.4f), DisplayPage::SENSOR_DATA_1));
+    
+    // 変わった2文字の矩形だけを転送し、転送の完了を待たずに戻る
+    M5.Display.nativeDmaPushes = 0;
+    M5.Display.nativePushedPixels = 0;
+    display.showSensorData(makeReading(22.5f), DisplayPage::SENSOR_DATA_1);
+    TEST_ASSERT_EQUAL_UINT32(1, M5.Display.nativeDmaPushes);
+    TEST_ASSERT_EQUAL_UINT32((12 + 24) * 24, (uint32_t)M5.Display.nativePushedPixels);
+    TEST_ASSERT_TRUE(M5.Display.nativeDmaPending());
+    TEST_ASSERT_TRUE(M5.Display.nativeWriting());
+    
+    // SDカードの前に呼ぶfinishFrame()で転送を完了させ、SPIバスを手放す
+    display.finishFrame();
+    TEST_ASSERT_FALSE(M5.Display.nativeDmaPending());
+    TEST_ASSERT_FALSE(M5.Display.nativeWriting());
+    TEST_ASSERT_TRUE(sameAsFresh(makeReading(22.5f), DisplayPage::SENSOR_DATA_1));
+    
+    // 離れた2行は別の矩形、変化がなければ転送しない
+    SensorReading reading = makeReading(23.5f);
+    reading.humidity = 46.0f;
+    M5.Display.nativeDmaPushes = 0;
+    display.showSensorData(reading, DisplayPage::SENSOR_DATA_1);
+    display.finishFrame();
+    TEST_ASSERT_EQUAL_UINT32(2, M5.Display.nativeDmaPushes);
+    TEST_ASSERT_TRUE(sameAsFresh(reading, DisplayPage::SENSOR_DATA_1));
+    
+    M5.Display.nativeDmaPushes = 0;
+    display.showSensorData(reading, DisplayPage::SENSOR_DATA_1);
+    TEST_ASSERT_EQUAL_UINT32(0, M5.Display.nativeDmaPushes);
+    TEST_ASSERT_FALSE(M5.Display.nativeWriting());
+}
+
+void test_canvas_not_written_while_pushing(void) {
+    // finishFrame()を呼ばずに描画・メッセージ・ページ切り替えを続けても、転送中のバッファには書かない
+    NativeDisplay::spriteAvailable = true;
+    DisplayController display;
+    display.initialize();
+    const DisplayPage pages[] = { DisplayPage::SENSOR_DATA_1, DisplayPage::SENSOR_DATA_2, DisplayPage::GRAPH };
+    SensorReading reading;
+    SystemStatus status = {};
+    for (int i = 0; i < 600; i++) {
+        NativeClock::nowMs = (unsigned long)i * 1000;
+        reading = driftingReading(i);
+        display.showSensorData(reading, pages[(i / 50) % 3]);
+        if (i % 97 == 0) display.showMessage("テスト", WHITE, 1500);
+        if (i % 120 == 60) display.showStatus(status);
+        display.update();
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)NativeDisplay::tornWrites);
+    
+    NativeClock::nowMs += 10000;
+    display.update();
+    display.showSensorData(reading, DisplayPage::SENSOR_DATA_1);
+    display.finishFrame();
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)NativeDisplay::tornWrites);
+}
+
+void test_canvas_pixels_per_update(void) {
+    // 直接描画とバッファ合成で同じ3000件を描き、毎回の画面が一致することと、LCDへ送る画素を比べる
+    const int updates = 3000;
+    std::vector<uint64_t> directFrames;
+    uint64_t lcdPixels[2] = { 0, 0 };
+    uint32_t pushes = 0;
+    double ns[2] = { 0.0, 0.0 };
+    uint32_t mismatches = 0;
+    
+    for (int mode = 0; mode < 2; mode++) {
+        NativeDisplay::spriteAvailable = mode == 1;
+        M5.Display.nativeReset(DisplayController::SCREEN_WIDTH, DisplayController::SCREEN_HEIGHT);
+        DisplayController display;
+        display.initialize();
+        display.finishFrame();
+        M5.Display.nativeWrittenPixels = 0;
+        M5.Display.nativePushedPixels = 0;
+        M5.Display.nativeDmaPushes = 0;
+        
+        for (int i = 0; i < updates; i++) {
+            NativeClock::nowMs = (unsigned long)i * 3000;
+            const DisplayPage page = (i / 500) % 2 ? DisplayPage::SENSOR_DATA_2 : DisplayPage::SENSOR_DATA_1;
+            auto start = std::chrono::steady_clock::now();
+            display.showSensorData(driftingReading(i), page);
+            ns[mode] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            display.finishFrame();
+            
+            const uint64_t hash = frameHash(M5.Display.nativePixels());
+            if (mode == 0) {
+                directFrames.push_back(hash);
+            } else if (directFrames[i] != hash) {
+                mismatches++;
+            }
+        }
+        lcdPixels[mode] = mode == 0 ? M5.Display.nativeWrittenPixels : M5.Display.nativePushedPixels;
+        pushes = M5.Display.nativeDmaPushes;
+    }
+    
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)NativeDisplay::tornWrites);
+    
+    char message[200];
+    snprintf(message, sizeof(message), "LCD pixels per update: %llu direct, %llu canvas in %.2f DMA pushes; host compose %.1f us direct, %.1f us canvas",
+             (unsigned long long)(lcdPixels[0] / updates), (unsigned long long)(lcdPixels[1] / updates),
+             (double)pushes / updates, ns[0] / updates / 1000.0, ns[1] / updates / 1000.0);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unchanged_page_writes_nothing);
+    RUN_TEST(test_changed_value_redraws_only_changed_characters);
+    RUN_TEST(test_removed_line_repaints_overlapped_fields);
+    RUN_TEST(test_page_change_redraws_whole_screen);
+    RUN_TEST(test_pixels_per_update);
+    RUN_TEST(test_canvas_pushes_only_changed_rows);
+    RUN_TEST(test_canvas_not_written_while_pushing);
+    RUN_TEST(test_canvas_pixels_per_update);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include "GasScan.h"
+
+// ガス抵抗の16bit対数符号化の精度と、1ステップずつ届く測定値をスキャン1周分にまとめる処理を確認する
+
+static const uint8_t VALID = BME68X_NEW_DATA_MSK | BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK;
+
+static GasScanAssembler assembler;
+
+static bool addStep(uint8_t index, float ohms, uint32_t timestamp, GasScan& completed,
+                    uint8_t status = VALID, float estimate = -1.0f) {
+    bme68xData data;
+    memset(&data, 0, sizeof(data));
+    data.status = status;
+    data.gas_index = index;
+    data.gas_resistance = ohms;
+    
+    bsecOutputs outputs;
+    outputs.nOutputs = 0;
+    if (estimate >= 0.0f) {
+        for (uint8_t i = 0; i < GasScan::ESTIMATE_COUNT; i++) {
+            outputs.output[i].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_1 + i;
+            outputs.output[i].signal = estimate * (i + 1);
+        }
+        outputs.nOutputs = GasScan::ESTIMATE_COUNT;
+    }
+    return assembler.addStep(data, outputs, timestamp, completed);
+}
+
+static float stepResistance(uint8_t step) {
+    return 10000.0f * powf(1.7f, step);
+}
+
+void setUp(void) {
+    assembler = GasScanAssembler();
+}
+
+void tearDown(void) {
+}
+
+void test_resistance_code_round_trip(void) {
+    // 10Ω〜1GΩで相対誤差は1/4096オクターブ（約0.017%）以内
+    float worst = 0.0f;
+    for (float ohms = 10.0f; ohms < 1e9f; ohms *= 1.0137f) {
+        const float decoded = GasScan::decodeResistance(GasScan::encodeResistance(ohms));
+        const float error = fabsf(decoded - ohms) / ohms;
+        if (error > worst) worst = error;
+    }
+    TEST_ASSERT_TRUE(worst < 0.00017f);
+    
+    TEST_ASSERT_EQUAL_UINT16(0, GasScan::encodeResistance(0.0f));
+    TEST_ASSERT_EQUAL_UINT16(0, GasScan::encodeResistance(-5.0f));
+    TEST_ASSERT_EQUAL_UINT16(0, GasScan::encodeResistance(NAN));
+    TEST_ASSERT_EQUAL_UINT16(65535, GasScan::encodeResistance(1e30f));
+    TEST_ASSERT_TRUE(GasScan::encodeResistance(1000.0f) < GasScan::encodeResistance(1001.0f));
+}
+
+void test_assembles_full_cycles(void) {
+    GasScan completed;
+    for (uint8_t cycle = 0; cycle < 3; cycle++) {
+        for (uint8_t step = 0; step < GasScan::MAX_STEPS; step++) {
+            const bool emitted = addStep(step, stepResistance(step), 1000 + cycle * 100 + step, completed,
+                                         VALID, step == GasScan::MAX_STEPS - 1 ? 0.1f * (cycle + 1) : -1.0f);
+            // 前の周回はプロファイルの先頭（gas_index 0）が届いた時点で確定する
+            TEST_ASSERT_EQUAL(cycle > 0 && step == 0, emitted);
+        }
+        if (cycle == 0) continue;
+        
+        TEST_ASSERT_EQUAL_UINT32(1000 + (cycle - 1) * 100, completed.timestamp);
+        TEST_ASSERT_EQUAL_UINT8(GasScan::MAX_STEPS, completed.stepCount);
+        TEST_ASSERT_EQUAL_UINT16((1 << GasScan::MAX_STEPS) - 1, completed.validMask);
+        for (uint8_t step = 0; step < GasScan::MAX_STEPS; step++) {
+            TEST_ASSERT_TRUE(fabsf(completed.getResistance(step) / stepResistance(step) - 1.0f) < 0.0002f);
+        }
+        TEST_ASSERT_TRUE(fabsf(completed.gasEstimate[3] - 0.4f * cycle) < 1e-6f);
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, assembler.getCompletedCount());
+    TEST_ASSERT_EQUAL_UINT32(0, assembler.getIncompleteCount());
+}
+
+void test_unstable_steps_marked_invalid(void) {
+    GasScan completed;
+    for (uint8_t step = 0; step < 4; step++) {
+        // 2ステップ目はヒーターが安定していない
+        const uint8_t status = step == 2 ? (uint8_t)(BME68X_NEW_DATA_MSK | BME68X_GASM_VALID_MSK) : VALID;
+        addStep(step, stepResistance(step), 500, completed, status);
+    }
+    TEST_ASSERT_TRUE(addStep(0, stepResistance(0), 600, completed));
+    
+    TEST_ASSERT_EQUAL_UINT8(4, completed.stepCount);
+    TEST_ASSERT_FALSE(completed.isStepValid(2));
+    TEST_ASSERT_TRUE(completed.isStepValid(3));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, completed.getResistance(2));
+    TEST_ASSERT_EQUAL_UINT32(1, assembler.getIncompleteCount());
+}
+
+void test_restart_mid_profile_and_bad_index(void) {
+    GasScan completed;
+    // 範囲外のgas_indexは無視する
+    TEST_ASSERT_FALSE(addStep(GasScan::MAX_STEPS, 1000.0f, 1, completed));
+    TEST_ASSERT_FALSE(addStep(0, 1000.0f, 2, completed));
+    TEST_ASSERT_FALSE(addStep(1, 1000.0f, 3, completed));
+    TEST_ASSERT_FALSE(addStep(2, 1000.0f, 4, completed));
+    // プロファイルの途中から始め直しても（2→1）そこで1周として確定する
+    TEST_ASSERT_TRUE(addStep(1, 1000.0f, 5, completed));
+    TEST_ASSERT_EQUAL_UINT8(3, completed.stepCount);
+    TEST_ASSERT_EQUAL_UINT32(2, completed.timestamp);
+    
+    // reset()後は途中の周回を出力しない
+    assembler.reset();
+    TEST_ASSERT_FALSE(addStep(0, 1000.0f, 6, completed));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_resistance_code_round_trip);
+    RUN_TEST(test_assembles_full_cycles);
+    RUN_TEST(test_unstable_steps_marked_invalid);
+    RUN_TEST(test_restart_mid_profile_and_bad_index);
+    return UNITY_END();
+}
\ No newline at end of file
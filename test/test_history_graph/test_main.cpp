@@ -0,0 +1,171 @@
+#include <unity.h>
+#include <math.h>
+#include <vector>
+#include <random>
+#include "HistoryGraph.h"
+
+// 読み取り値を表示列へ間引くLTTBが、系列全体に対する通常のLTTBと同じ点を選ぶこと、
+// 平均化と違い短いピークを残すこと、欠測・外れ値・リングの折り返しの扱いを確かめる
+
+static const uint8_t TEMPERATURE = 0;   // GRAPH_FIELDSの添字
+
+static SensorReading makeReading(float temperature, uint8_t channel = 0) {
+    SensorReading reading;
+    reading.temperature = temperature;
+    reading.channel = channel;
+    return reading;
+}
+
+// 系列全体を区間に分けてから選ぶ通常のLTTB（区間bの点は区間b-1で選んだ点と区間b+1の平均で決める）
+static std::vector<float> referenceLttb(const std::vector<float>& values, uint8_t n) {
+    std::vector<float> selected;
+    const size_t buckets = values.size() / n;
+    float anchorX = NAN;
+    float anchorY = NAN;
+    for (size_t b = 0; b + 1 < buckets; b++) {
+        float nextSum = 0.0f;
+        for (uint8_t i = 0; i < n; i++) nextSum += values[(b + 1) * n + i];
+        const float nextX = (float)(b + 1) * n + (n - 1) * 0.5f;
+        const float nextY = nextSum / n;
+        
+        size_t best = b * n;
+        float bestArea = -1.0f;
+        for (size_t x = b * n; x < (b + 1) * n && !isnan(anchorY); x++) {
+            float area = fabsf((anchorX - nextX) * (values[x] - anchorY) - (anchorX - x) * (nextY - anchorY));
+            if (area > bestArea) {
+                bestArea = area;
+                best = x;
+            }
+        }
+        anchorX = (float)best;
+        anchorY = values[best];
+        selected.push_back(anchorY);
+    }
+    return selected;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_matches_reference_lttb(void) {
+    const uint8_t n = 6;
+    const size_t readings = 120 * n;
+    std::mt19937 rng(11);
+    std::normal_distribution<float> step(0.0f, 0.4f);
+    
+    HistoryGraph graph(0, n);
+    std::vector<float> values;
+    float temperature = 22.0f;
+    for (size_t i = 0; i < readings; i++) {
+        temperature += step(rng);
+        values.push_back(temperature);
+        graph.update(makeReading(temperature));
+    }
+    
+    // 次の区間がそろうまで確定しないので、列は区間数より1つ少ない
+    std::vector<float> expected = referenceLttb(values, n);
+    TEST_ASSERT_EQUAL(readings / n - 1, graph.getColumnCount());
+    TEST_ASSERT_EQUAL(expected.size(), graph.size());
+    for (size_t k = 0; k < expected.size(); k++) {
+        float value = 0.0f;
+        TEST_ASSERT_TRUE(graph.getColumn(TEMPERATURE, expected.size() - 1 - k, value));
+        TEST_ASSERT_EQUAL_FLOAT(expected[k], value);
+    }
+}
+
+void test_keeps_short_peak(void) {
+    const uint8_t n = 8;
+    HistoryGraph graph(0, n);
+    for (uint16_t i = 0; i < n * 6; i++) {
+        // 3区間目の中ほどに1件だけのピーク（平均化では21.25に潰れる）
+        graph.update(makeReading(i == n * 2 + 3 ? 30.0f : 20.0f));
+    }
+    
+    float low = 0.0f;
+    float high = 0.0f;
+    TEST_ASSERT_TRUE(graph.getRange(TEMPERATURE, graph.size(), low, high));
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, low);
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, high);
+    
+    float peak = 0.0f;
+    TEST_ASSERT_TRUE(graph.getColumn(TEMPERATURE, graph.size() - 3, peak));
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, peak);
+}
+
+void test_missing_and_outlier_values(void) {
+    const uint8_t n = 2;
+    HistoryGraph graph(0, n);
+    
+    // CO2は最初の値が来るまで欠測
+    for (uint8_t i = 0; i < n * 3; i++) {
+        SensorReading reading = makeReading(20.0f);
+        if (i >= n * 2) {
+            reading.co2_equivalent = 600.0f;
+            reading.has_co2_data = true;
+        }
+        graph.update(reading);
+    }
+    const uint8_t co2 = 3;
+    float value = 0.0f;
+    TEST_ASSERT_EQUAL(2, graph.size());
+    TEST_ASSERT_FALSE(graph.getColumn(co2, 0, value));
+    TEST_ASSERT_FALSE(graph.getColumn(co2, 1, value));
+    TEST_ASSERT_TRUE(graph.getColumn(TEMPERATURE, 0, value));
+    
+    // 外れ値は描かずに直前の値で埋める
+    const uint16_t outlierBit = 1 << SENSOR_FIELD_INDEX.index[BSEC_OUTPUT_RAW_TEMPERATURE];
+    for (uint8_t i = 0; i < n * 3; i++) {
+        SensorReading reading = makeReading(i == n ? 95.0f : 20.0f);
+        if (i == n) reading.outlier_mask = outlierBit;
+        graph.update(reading);
+    }
+    float low = 0.0f;
+    float high = 0.0f;
+    TEST_ASSERT_TRUE(graph.getRange(TEMPERATURE, graph.size(), low, high));
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, high);
+    TEST_ASSERT_TRUE(graph.getColumn(co2, 0, value));
+    TEST_ASSERT_EQUAL_FLOAT(600.0f, value);
+}
+
+void test_ring_keeps_latest_columns(void) {
+    const uint8_t n = 1;
+    HistoryGraph graph(0, n);
+    const uint32_t total = HistoryGraph::MAX_COLUMNS + 50;
+    for (uint32_t i = 0; i <= total; i++) {
+        graph.update(makeReading((float)i));
+        graph.update(makeReading(-100.0f, 1));   // 他チャンネルは無視
+    }
+    
+    TEST_ASSERT_EQUAL_UINT32(total, graph.getColumnCount());
+    TEST_ASSERT_EQUAL(HistoryGraph::MAX_COLUMNS, graph.size());
+    float value = 0.0f;
+    TEST_ASSERT_TRUE(graph.getColumn(TEMPERATURE, 0, value));
+    TEST_ASSERT_EQUAL_FLOAT((float)(total - 1), value);
+    TEST_ASSERT_TRUE(graph.getColumn(TEMPERATURE, HistoryGraph::MAX_COLUMNS - 1, value));
+    TEST_ASSERT_EQUAL_FLOAT((float)(total - HistoryGraph::MAX_COLUMNS), value);
+    TEST_ASSERT_FALSE(graph.getColumn(TEMPERATURE, HistoryGraph::MAX_COLUMNS, value));
+    
+    float low = 0.0f;
+    float high = 0.0f;
+    TEST_ASSERT_TRUE(graph.getRange(TEMPERATURE, 10, low, high));
+    TEST_ASSERT_EQUAL_FLOAT((float)(total - 10), low);
+    TEST_ASSERT_EQUAL_FLOAT((float)(total - 1), high);
+    
+    // 列の読み取り件数を変えると履歴を捨てる（範囲外の値は丸める）
+    graph.setSamplesPerColumn(200);
+    TEST_ASSERT_EQUAL_UINT8(HistoryGraph::MAX_SAMPLES_PER_COLUMN, graph.getSamplesPerColumn());
+    TEST_ASSERT_EQUAL(0, graph.size());
+    TEST_ASSERT_FALSE(graph.getRange(TEMPERATURE, 10, low, high));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_reference_lttb);
+    RUN_TEST(test_keeps_short_peak);
+    RUN_TEST(test_missing_and_outlier_values);
+    RUN_TEST(test_ring_keeps_latest_columns);
+    return UNITY_END();
+}
\ No newline at end of file
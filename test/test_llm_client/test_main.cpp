@@ -0,0 +1,314 @@
+#include <unity.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <WiFi.h>
+#include "LlmClient.h"
+
+// ローカルのモックHTTPサーバー（Chat Completions互換の応答を遅延付きで返す）に対してLlmClientを動かし、
+// 通信タスクとメインループの分離、待ち時間、キャッシュ、失敗の通知、end()でのタスク終了待ちを確認する
+
+static const char* REPLY = "気圧がゆっくり下がっています。夕方から雨の予感です。";
+static const char* PROMPT = "直近7日間: temperature 平均22.1℃ 傾き-0.10/h";
+
+// 127.0.0.1の空きポートで待ち受け、1接続に1応答を返して閉じる
+struct MockHttpServer {
+    int listenFd = -1;
+    uint16_t port = 0;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<int> status{200};
+    std::atomic<uint32_t> delayMs{0};
+    std::atomic<int> requestCount{0};
+    std::mutex mutex;
+    std::string lastRequest;
+    
+    void start() {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listenFd, (sockaddr*)&address, sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, (sockaddr*)&address, &length);
+        port = ntohs(address.sin_port);
+        listen(listenFd, 4);
+        running = true;
+        thread = std::thread([this]() { serve(); });
+    }
+    
+    void stop() {
+        running = false;
+        shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        thread.join();
+    }
+    
+    String url() const { return "http://127.0.0.1:" + String((unsigned)port) + "/v1/chat/completions"; }
+    
+    void serve() {
+        while (running) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) break;
+            std::string request = readRequest(fd);
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                lastRequest = request;
+            }
+            requestCount++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs.load()));
+            
+            std::string body = status == 200 ?
+                std::string("{\"choices\":[{\"message\":{\"role\":\"assistant\",\"content\":\"") + REPLY + "\"}}]}" :
+                std::string("{\"error\":{\"message\":\"internal error\"}}");
+            std::string response = "HTTP/1.1 " + std::to_string(status.load()) + " X\r\nContent-Type: application/json\r\n"
+                                   "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+            send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+            close(fd);
+        }
+    }
+    
+    // ヘッダーとContent-Length分の本文を読む
+    static std::string readRequest(int fd) {
+        std::string request;
+        char buffer[1024];
+        size_t expected = std::string::npos;
+        while (expected == std::string::npos || request.size() < expected) {
+            ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received <= 0) break;
+            request.append(buffer, received);
+            size_t headerEnd = request.find("\r\n\r\n");
+            size_t lengthAt = request.find("Content-Length: ");
+            if (expected == std::string::npos && headerEnd != std::string::npos && lengthAt != std::string::npos) {
+                expected = headerEnd + 4 + atoi(request.c_str() + lengthAt + 16);
+            }
+        }
+        return request;
+    }
+    
+    std::string getLastRequest() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return lastRequest;
+    }
+};
+
+static MockHttpServer* server = nullptr;
+static LlmClient* client = nullptr;
+
+struct Outcome {
+    bool called = false;
+    bool success = false;
+    std::string text;
+};
+
+static LlmCallback recordTo(Outcome& outcome) {
+    return [&outcome](bool success, const char* text) {
+        outcome.called = true;
+        outcome.success = success;
+        outcome.text = text;
+    };
+}
+
+// 応答が届くまでメインループのようにupdate()を呼び続ける（1msごと、時刻も1msずつ進める）
+// 戻り値は実時間での経過（ms）。最も長かったupdate()の時間をlongestUpdateUsに返す
+static double runUntilCalled(const Outcome& outcome, double& longestUpdateUs, uint32_t limitMs = 5000) {
+    auto start = std::chrono::steady_clock::now();
+    longestUpdateUs = 0.0;
+    for (uint32_t i = 0; i < limitMs && !outcome.called; i++) {
+        auto before = std::chrono::steady_clock::now();
+        client->update();
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - before).count();
+        if (us > longestUpdateUs) longestUpdateUs = us;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        NativeClock::nowMs += 1;
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void setUp(void) {
+    NativeClock::nowMs = 0;
+    WiFi.nativeStatus = WL_CONNECTED;
+    server = new MockHttpServer();
+    server->start();
+    client = new LlmClient();
+    TEST_ASSERT_TRUE(client->begin(server->url(), "test-model", "secret-key", ""));
+}
+
+void tearDown(void) {
+    delete client;
+    client = nullptr;
+    server->stop();
+    delete server;
+    server = nullptr;
+}
+
+void test_round_trip_keeps_main_loop_free(void) {
+    server->delayMs = 300;
+    Outcome outcome;
+    TEST_ASSERT_TRUE(client->request(PROMPT, recordTo(outcome)));
+    TEST_ASSERT_TRUE(client->isBusy());
+    TEST_ASSERT_FALSE(client->request(PROMPT, nullptr));   // 同時に1件のみ
+    
+    double longestUpdateUs;
+    double elapsedMs = runUntilCalled(outcome, longestUpdateUs);
+    TEST_ASSERT_TRUE(outcome.called);
+    TEST_ASSERT_TRUE(outcome.success);
+    TEST_ASSERT_EQUAL_STRING(REPLY, outcome.text.c_str());
+    TEST_ASSERT_FALSE(client->isBusy());
+    TEST_ASSERT_TRUE(elapsedMs >= 300.0);
+    
+    // http://のモックにはAPIキーを送らない
+    std::string request = server->getLastRequest();
+    TEST_ASSERT_TRUE(request.find("POST /v1/chat/completions HTTP/1.1") == 0);
+    TEST_ASSERT_TRUE(request.find("Authorization") == std::string::npos);
+    TEST_ASSERT_TRUE(request.find("test-model") != std::string::npos);
+    
+    char message[128];
+    snprintf(message, sizeof(message), "mock delay 300 ms: end-to-end %.0f ms, longest update() %.1f us",
+             elapsedMs, longestUpdateUs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(longestUpdateUs < 5000.0);
+}
+
+void test_identical_prompt_served_from_cache(void) {
+    Outcome first;
+    client->request(PROMPT, recordTo(first));
+    double longestUpdateUs;
+    runUntilCalled(first, longestUpdateUs);
+    TEST_ASSERT_TRUE(first.success);
+    TEST_ASSERT_EQUAL(1, server->requestCount.load());
+    
+    // 同じプロンプトはrequest()の中で即座に応答し、サーバーへは送らない
+    Outcome cached;
+    auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(client->request(PROMPT, recordTo(cached)));
+    double cachedUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    TEST_ASSERT_TRUE(cached.called);
+    TEST_ASSERT_EQUAL_STRING(REPLY, cached.text.c_str());
+    TEST_ASSERT_FALSE(client->isBusy());
+    TEST_ASSERT_EQUAL(1, server->requestCount.load());
+    
+    // 有効期限を過ぎたら、または別のプロンプトなら送り直す
+    NativeClock::nowMs += LlmClient::CACHE_TTL_MS;
+    Outcome expired;
+    TEST_ASSERT_TRUE(client->request(PROMPT, recordTo(expired)));
+    TEST_ASSERT_FALSE(expired.called);
+    runUntilCalled(expired, longestUpdateUs);
+    TEST_ASSERT_EQUAL(2, server->requestCount.load());
+    
+    Outcome other;
+    client->request("別のプロンプト", recordTo(other));
+    runUntilCalled(other, longestUpdateUs);
+    TEST_ASSERT_EQUAL(3, server->requestCount.load());
+    
+    char message[64];
+    snprintf(message, sizeof(message), "cache hit %.1f us", cachedUs);
+    TEST_MESSAGE(message);
+}
+
+void test_http_error_is_reported_through_callback(void) {
+    server->status = 500;
+    Outcome outcome;
+    client->request(PROMPT, recordTo(outcome));
+    double longestUpdateUs;
+    double elapsedMs = runUntilCalled(outcome, longestUpdateUs);
+    TEST_ASSERT_TRUE(outcome.called);
+    TEST_ASSERT_FALSE(outcome.success);
+    TEST_ASSERT_TRUE(outcome.text.find("HTTP 500") == 0);
+    
+    // 失敗した応答はキャッシュしない
+    TEST_ASSERT_NULL(client->getCachedResponse());
+    server->status = 200;
+    Outcome retry;
+    client->request(PROMPT, recordTo(retry));
+    runUntilCalled(retry, longestUpdateUs);
+    TEST_ASSERT_TRUE(retry.success);
+    TEST_ASSERT_EQUAL(2, server->requestCount.load());
+    
+    char message[64];
+    snprintf(message, sizeof(message), "HTTP 500 reported after %.0f ms", elapsedMs);
+    TEST_MESSAGE(message);
+}
+
+void test_response_timeout_fails_request(void) {
+    client->setTimeouts(1000, 200);
+    server->delayMs = 1000;
+    Outcome outcome;
+    client->request(PROMPT, recordTo(outcome));
+    double longestUpdateUs;
+    double elapsedMs = runUntilCalled(outcome, longestUpdateUs);
+    TEST_ASSERT_TRUE(outcome.called);
+    TEST_ASSERT_FALSE(outcome.success);
+    TEST_ASSERT_TRUE(outcome.text.find("HTTP -11") == 0);
+    TEST_ASSERT_TRUE(elapsedMs >= 200.0 && elapsedMs < 900.0);
+}
+
+void test_unreachable_endpoint_fails_request(void) {
+    // サーバーを止めたポート（接続拒否）
+    uint16_t port = server->port;
+    server->stop();
+    delete client;
+    client = new LlmClient();
+    TEST_ASSERT_TRUE(client->begin("http://127.0.0.1:" + String((unsigned)port) + "/v1/chat/completions", "test-model", "", ""));
+    server->start();   // tearDown用に別のポートで再開
+    
+    Outcome outcome;
+    client->request(PROMPT, recordTo(outcome));
+    double longestUpdateUs;
+    runUntilCalled(outcome, longestUpdateUs);
+    TEST_ASSERT_TRUE(outcome.called);
+    TEST_ASSERT_FALSE(outcome.success);
+    TEST_ASSERT_TRUE(outcome.text.find("HTTP -1") == 0);
+    
+    // WiFi未接続なら通信しない
+    WiFi.nativeStatus = WL_DISCONNECTED;
+    Outcome offline;
+    client->request(PROMPT, recordTo(offline));
+    runUntilCalled(offline, longestUpdateUs);
+    TEST_ASSERT_FALSE(offline.success);
+    TEST_ASSERT_EQUAL_STRING("WiFi未接続", offline.text.c_str());
+}
+
+void test_end_waits_for_pending_request(void) {
+    // 通信中にend()してもタスクが応答を書き終えてから戻るので、その後に破棄してよい
+    server->delayMs = 300;
+    Outcome outcome;
+    client->request(PROMPT, recordTo(outcome));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    
+    auto start = std::chrono::steady_clock::now();
+    client->end();
+    double endMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    TEST_ASSERT_FALSE(client->isAvailable());
+    TEST_ASSERT_TRUE(endMs >= 200.0);
+    TEST_ASSERT_TRUE(client->getState() == LlmClient::State::DONE);
+    TEST_ASSERT_FALSE(client->request(PROMPT, nullptr));
+    
+    // 完了した応答は終了後もupdate()で受け取れる
+    client->update();
+    TEST_ASSERT_TRUE(outcome.called);
+    TEST_ASSERT_TRUE(outcome.success);
+    
+    char message[64];
+    snprintf(message, sizeof(message), "end() waited %.0f ms for the pending request", endMs);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_keeps_main_loop_free);
+    RUN_TEST(test_identical_prompt_served_from_cache);
+    RUN_TEST(test_http_error_is_reported_through_callback);
+    RUN_TEST(test_response_timeout_fails_request);
+    RUN_TEST(test_unreachable_endpoint_fails_request);
+    RUN_TEST(test_end_waits_for_pending_request);
+    return UNITY_END();
+}
\ No newline at end of file
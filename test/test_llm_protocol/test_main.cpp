@@ -0,0 +1,186 @@
+#include <unity.h>
+#include <string.h>
+#include <string>
+#include <ArduinoJson.h>
+#include "LlmProtocol.h"
+#include "OmenPromptBuilder.h"
+
+// 予感レポートのプロンプトを組み立て、モックのLLMサーバー（Chat Completions互換の応答を返す）と
+// LlmProtocolでやり取りして、要求・応答・エラーの扱いと通信経路の選択を確認する
+
+static const uint32_t START = 1700000000;
+
+// 受け取った要求を記録し、設定した応答本文を返す
+struct MockLlmServer {
+    enum class Mode { REPLY, API_ERROR, NO_CONTENT, MALFORMED };
+    
+    Mode mode = Mode::REPLY;
+    std::string reply = "気圧がゆっくり下がっています。夕方から雨の予感です。";
+    std::string receivedModel;
+    std::string receivedPrompt;
+    int receivedMaxTokens = 0;
+    int requestCount = 0;
+    
+    String handle(const String& body) {
+        JsonDocument request;
+        if (deserializeJson(request, body)) {
+            return "{\"error\":{\"message\":\"invalid request\"}}";
+        }
+        requestCount++;
+        receivedModel = request["model"] | "";
+        receivedPrompt = request["messages"][0]["content"] | "";
+        receivedMaxTokens = request["max_tokens"] | 0;
+        
+        JsonDocument response;
+        switch (mode) {
+            case Mode::REPLY: {
+                JsonObject message = response["choices"].to<JsonArray>().add<JsonObject>()["message"].to<JsonObject>();
+                message["role"] = "assistant";
+                message["content"] = reply.c_str();
+                break;
+            }
+            case Mode::API_ERROR:
+                response["error"]["message"] = "rate limited";
+                break;
+            case Mode::NO_CONTENT:
+                response["choices"].to<JsonArray>();
+                break;
+            case Mode::MALFORMED:
+                return "{\"choices\":[";
+        }
+        String out;
+        serializeJson(response, out);
+        return out;
+    }
+};
+
+static OmenSummary summary;
+
+// 1週間分の読み取り値（気温の日周変化と、最終日に下がり続ける気圧）
+static void fillSummary() {
+    summary.reset();
+    for (uint32_t t = START; t < START + 7 * 86400; t += 300) {
+        SensorReading reading;
+        reading.timestamp = t;
+        reading.time_synced = true;
+        reading.temperature = 21.0f + 2.0f * sinf(2.0f * (float)M_PI * (float)(t % 86400) / 86400.0f);
+        reading.humidity = 50.0f;
+        reading.pressure = t > START + 6 * 86400 ? 1013.0f - (float)(t - START - 6 * 86400) / 3600.0f : 1013.0f;
+        reading.iaq = 40.0f;
+        reading.has_iaq_data = true;
+        reading.co2_equivalent = 600.0f;
+        reading.has_co2_data = true;
+        summary.update(reading);
+    }
+}
+
+static bool exchange(MockLlmServer& server, const char* prompt, char* out, size_t size) {
+    String body;
+    if (!LlmProtocol::buildRequest("mock-model", prompt, 200, body)) {
+        snprintf(out, size, "要求の組み立てに失敗");
+        return false;
+    }
+    return LlmProtocol::parseResponse(server.handle(body), out, size);
+}
+
+void setUp(void) {
+    fillSummary();
+}
+
+void tearDown(void) {
+}
+
+void test_transport_never_skips_verification(void) {
+    // https://はルートCAがなければ使わない（証明書を検証しない接続でAPIキーを送らない）
+    TEST_ASSERT_TRUE(LlmProtocol::selectTransport("https://api.openai.com/v1/chat/completions", false) == LlmTransport::REJECTED);
+    TEST_ASSERT_TRUE(LlmProtocol::selectTransport("https://api.openai.com/v1/chat/completions", true) == LlmTransport::VERIFIED_TLS);
+    TEST_ASSERT_TRUE(LlmProtocol::selectTransport("http://192.168.1.10:8080/v1/chat/completions", false) == LlmTransport::PLAIN);
+    TEST_ASSERT_TRUE(LlmProtocol::selectTransport("http://192.168.1.10:8080/v1/chat/completions", true) == LlmTransport::PLAIN);
+    TEST_ASSERT_TRUE(LlmProtocol::selectTransport("ftp://example.com/", true) == LlmTransport::REJECTED);
+    TEST_ASSERT_TRUE(LlmProtocol::selectTransport("", true) == LlmTransport::REJECTED);
+    
+    TEST_ASSERT_TRUE(LlmProtocol::sendsApiKey(LlmTransport::VERIFIED_TLS));
+    TEST_ASSERT_FALSE(LlmProtocol::sendsApiKey(LlmTransport::PLAIN));
+    TEST_ASSERT_FALSE(LlmProtocol::sendsApiKey(LlmTransport::REJECTED));
+}
+
+void test_prompt_fits_budget_with_whole_lines(void) {
+    char large[2048];
+    char small[2048];
+    uint16_t largeTokens = 0;
+    uint16_t smallTokens = 0;
+    size_t largeLength = OmenPromptBuilder::build(summary, 7, OmenPromptBuilder::DEFAULT_TOKEN_BUDGET,
+                                                  large, sizeof(large), &largeTokens);
+    size_t smallLength = OmenPromptBuilder::build(summary, 7, 120, small, sizeof(small), &smallTokens);
+    
+    TEST_ASSERT_TRUE(largeLength > 0);
+    TEST_ASSERT_EQUAL(strlen(large), largeLength);
+    TEST_ASSERT_TRUE(largeTokens <= OmenPromptBuilder::DEFAULT_TOKEN_BUDGET);
+    TEST_ASSERT_TRUE(smallTokens <= 120);
+    TEST_ASSERT_EQUAL('\n', large[largeLength - 1]);
+    TEST_ASSERT_EQUAL('\n', small[smallLength - 1]);
+    TEST_ASSERT_TRUE(strstr(large, "pres mean") != nullptr);
+    TEST_ASSERT_TRUE(strstr(large, "day-6") != nullptr);
+    
+    // 予算を絞ると優先度の低い行から落ち、残る行は同じ内容
+    TEST_ASSERT_TRUE(smallLength < largeLength);
+    TEST_ASSERT_EQUAL(0, strncmp(large, small, smallLength));
+}
+
+void test_round_trip_through_mock_server(void) {
+    char prompt[2048];
+    OmenPromptBuilder::build(summary, 7, OmenPromptBuilder::DEFAULT_TOKEN_BUDGET, prompt, sizeof(prompt));
+    
+    MockLlmServer server;
+    char out[1024];
+    TEST_ASSERT_TRUE(exchange(server, prompt, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING(server.reply.c_str(), out);
+    
+    // 改行・日本語を含むプロンプトがそのまま届く
+    TEST_ASSERT_EQUAL(1, server.requestCount);
+    TEST_ASSERT_EQUAL_STRING("mock-model", server.receivedModel.c_str());
+    TEST_ASSERT_EQUAL_STRING(prompt, server.receivedPrompt.c_str());
+    TEST_ASSERT_EQUAL(200, server.receivedMaxTokens);
+    TEST_ASSERT_EQUAL_UINT32(OmenPromptBuilder::digest(prompt), OmenPromptBuilder::digest(server.receivedPrompt.c_str()));
+}
+
+void test_failures_report_reason(void) {
+    MockLlmServer server;
+    char out[256];
+    
+    server.mode = MockLlmServer::Mode::API_ERROR;
+    TEST_ASSERT_FALSE(exchange(server, "p", out, sizeof(out)));
+    TEST_ASSERT_TRUE(strstr(out, "rate limited") != nullptr);
+    
+    server.mode = MockLlmServer::Mode::NO_CONTENT;
+    TEST_ASSERT_FALSE(exchange(server, "p", out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("応答に本文がありません", out);
+    
+    server.mode = MockLlmServer::Mode::MALFORMED;
+    TEST_ASSERT_FALSE(exchange(server, "p", out, sizeof(out)));
+    TEST_ASSERT_TRUE(strncmp(out, "応答の解析に失敗", strlen("応答の解析に失敗")) == 0);
+}
+
+void test_long_reply_truncated_on_character_boundary(void) {
+    MockLlmServer server;
+    server.reply.clear();
+    for (int i = 0; i < 100; i++) {
+        server.reply += "雨";   // 3バイト
+    }
+    
+    // 32バイトの出力には10文字（30バイト）まで入る
+    char out[32];
+    TEST_ASSERT_TRUE(exchange(server, "p", out, sizeof(out)));
+    TEST_ASSERT_EQUAL(30, strlen(out));
+    TEST_ASSERT_EQUAL(0, strncmp(out, server.reply.c_str(), 30));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_transport_never_skips_verification);
+    RUN_TEST(test_prompt_fits_budget_with_whole_lines);
+    RUN_TEST(test_round_trip_through_mock_server);
+    RUN_TEST(test_failures_report_reason);
+    RUN_TEST(test_long_reply_truncated_on_character_boundary);
+    return UNITY_END();
+}
\ No newline at end of file
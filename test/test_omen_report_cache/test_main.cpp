@@ -0,0 +1,290 @@
+#include <unity.h>
+#include <chrono>
+#include <string.h>
+#include <SD.h>
+#include "OmenReportCache.h"
+#include "OmenPromptBuilder.h"
+
+// 1週間分の読み取り値とユーザーの表示操作を、YokanAISystem::scheduleOmenReports()と同じ手順の
+// 事前生成（時間窓が変わったら生成、入力が同じなら引き継ぎ）で模擬し、
+// キャッシュのヒット率・表示の待ち・再起動後の再生成の有無を確認する
+
+static const uint32_t START = 1700006400;        // UTCの0時
+static const uint32_t READING_INTERVAL = 60;
+static const uint32_t VIEW_INTERVAL = 17 * 60;  // 時間窓の境界とずれる間隔で表示する
+static const uint32_t LLM_LATENCY_MS = 1200;
+static const uint16_t TOKEN_BUDGET = 400;
+
+// 応答に時間がかかり、一定の割合で失敗するLLM
+struct MockLlm {
+    uint32_t failEvery = 0;     // 0なら失敗しない
+    uint32_t requests = 0;
+    
+    bool busy = false;
+    unsigned long doneAtMs = 0;
+    bool success = false;
+    
+    void request() {
+        requests++;
+        busy = true;
+        doneAtMs = NativeClock::nowMs + LLM_LATENCY_MS;
+        success = failEvery == 0 || requests % failEvery != 0;
+    }
+};
+
+struct Simulation {
+    OmenSummary summary;
+    OmenReportCache cache;
+    MockLlm llm;
+    char prompt[2048];
+    
+    bool synced = true;         // NTP同期済み（falseならnowは起動からの秒）
+    
+    // 応答待ちの生成
+    OmenReportKind pendingKind = OmenReportKind::HOURLY;
+    uint32_t pendingWindow = 0;
+    bool pendingSynced = true;
+    uint32_t pendingDigest = 0;
+    uint32_t pendingAt = 0;
+    
+    uint32_t staleWhilePending = 0;
+    uint32_t staleOtherwise = 0;
+    uint32_t narratives = 0;
+    uint32_t fallbacks = 0;
+    
+    // 実時間での計測
+    double viewNs = 0.0;
+    double maxViewNs = 0.0;
+    double buildNs = 0.0;
+    uint32_t builds = 0;
+    
+    void update(uint32_t now) {
+        NativeClock::nowMs = (unsigned long)(now - START) * 1000UL;
+        
+        if (llm.busy && NativeClock::nowMs >= llm.doneAtMs) {
+            llm.busy = false;
+            store(pendingKind, pendingWindow, pendingSynced, pendingDigest, pendingAt, llm.success);
+        }
+        if (llm.busy) return;
+        
+        for (uint8_t i = 0; i < OmenReportCache::KIND_COUNT; i++) {
+            const OmenReportKind kind = (OmenReportKind)(OmenReportCache::KIND_COUNT - 1 - i);
+            const uint32_t window = OmenReportCache::windowStart(kind, now, synced);
+            if (cache.hasWindow(kind, window, synced)) continue;
+            
+            auto start = std::chrono::steady_clock::now();
+            OmenPromptBuilder::build(summary, OmenReportCache::reportDays(kind), TOKEN_BUDGET, prompt, sizeof(prompt));
+            const uint32_t digest = OmenPromptBuilder::digest(prompt);
+            buildNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            builds++;
+            if (cache.adoptIfUnchanged(kind, window, synced, digest)) continue;
+            
+            pendingKind = kind;
+            pendingWindow = window;
+            pendingSynced = synced;
+            pendingDigest = digest;
+            pendingAt = now;
+            llm.request();
+            return;
+        }
+    }
+    
+    void store(OmenReportKind kind, uint32_t window, bool windowSynced, uint32_t digest, uint32_t at, bool narrative) {
+        // 失敗時はローカルのレポートで代用する（YokanAISystemのwriteOmenReport()に相当）
+        char text[64];
+        snprintf(text, sizeof(text), "%s %08lx", narrative ? "llm" : "local", (unsigned long)digest);
+        TEST_ASSERT_TRUE(cache.store(kind, window, windowSynced, digest, at, text, narrative));
+        if (narrative) narratives++; else fallbacks++;
+    }
+    
+    void view(uint32_t now) {
+        for (uint8_t i = 0; i < OmenReportCache::KIND_COUNT; i++) {
+            const OmenReportKind kind = (OmenReportKind)i;
+            const uint32_t window = OmenReportCache::windowStart(kind, now, synced);
+            const uint32_t staleBefore = cache.getStaleCount();
+            auto start = std::chrono::steady_clock::now();
+            const OmenReportEntry* entry = cache.view(kind, window, synced);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            viewNs += ns;
+            if (ns > maxViewNs) maxViewNs = ns;
+            if (entry && cache.getStaleCount() != staleBefore) {
+                if (llm.busy || !cache.hasWindow(kind, window, synced)) staleWhilePending++; else staleOtherwise++;
+            }
+        }
+    }
+    
+    // [from, to)の読み取り値を流す（outageの間は読み取りなし）
+    void run(uint32_t from, uint32_t to, uint32_t outageFrom = 0, uint32_t outageTo = 0) {
+        for (uint32_t t = from; t < to; t += READING_INTERVAL) {
+            if (t < outageFrom || t >= outageTo) {
+                SensorReading reading;
+                reading.timestamp = t;
+                reading.time_synced = true;
+                reading.temperature = 21.0f + 2.0f * sinf(2.0f * (float)M_PI * (float)(t % 86400) / 86400.0f);
+                reading.humidity = 50.0f + (float)((t / 3600) % 7);
+                reading.pressure = 1013.0f - (float)((t - START) / 86400);
+                reading.iaq = 40.0f + (float)((t / 600) % 5);
+                reading.has_iaq_data = true;
+                summary.update(reading);
+            }
+            update(t);
+            if ((t - START) % VIEW_INTERVAL == 0) {
+                view(t);
+            }
+        }
+    }
+};
+
+static uint32_t windowsIn(OmenReportKind kind, uint32_t from, uint32_t to) {
+    uint32_t count = 0;
+    uint32_t last = 0xFFFFFFFF;
+    for (uint32_t t = from; t < to; t += READING_INTERVAL) {
+        const uint32_t window = OmenReportCache::windowStart(kind, t, true);
+        if (window != last) {
+            count++;
+            last = window;
+        }
+    }
+    return count;
+}
+
+void setUp(void) {
+    NativeFs::files.clear();
+    NativeClock::nowMs = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_week_of_views_served_from_cache(void) {
+    Simulation sim;
+    sim.llm.failEvery = 20;
+    sim.cache.begin(true);
+    sim.run(START, START + 7 * 86400);
+    
+    const uint32_t windows = windowsIn(OmenReportKind::HOURLY, START, START + 7 * 86400) +
+                             windowsIn(OmenReportKind::DAILY, START, START + 7 * 86400);
+    // 入力は毎時変わるので、すべての窓で1回ずつ生成される（失敗はローカルのレポートで埋まる）
+    TEST_ASSERT_EQUAL_UINT32(windows, sim.cache.getGeneratedCount());
+    TEST_ASSERT_EQUAL_UINT32(windows, sim.llm.requests);
+    TEST_ASSERT_TRUE(sim.fallbacks > 0);
+    TEST_ASSERT_EQUAL_UINT32(windows, sim.narratives + sim.fallbacks);
+    
+    // 表示はLLMを待たない：ないのは最初の生成前だけ、古い窓を返すのは生成待ちの間だけ
+    TEST_ASSERT_TRUE(sim.cache.getViewCount() > 1000);
+    TEST_ASSERT_TRUE(sim.cache.getMissCount() <= OmenReportCache::KIND_COUNT);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.staleOtherwise);
+    TEST_ASSERT_TRUE(sim.cache.getHitRate() > 0.95f);
+    
+    char message[160];
+    snprintf(message, sizeof(message), "hit rate %.1f%%, view %.0f ns (max %.0f ns), prompt+digest %.1f us per window (mock LLM %u ms)",
+             sim.cache.getHitRate() * 100.0f, sim.viewNs / sim.cache.getViewCount(), sim.maxViewNs,
+             sim.buildNs / sim.builds / 1000.0, LLM_LATENCY_MS);
+    TEST_MESSAGE(message);
+}
+
+void test_outage_windows_carried_over(void) {
+    // 3日目の10:30〜14:30はセンサーが止まる。11時の窓は10:30までの入力で作り直し、
+    // 12〜14時の窓は入力が変わらないので前のレポートを引き継ぐ
+    Simulation sim;
+    sim.cache.begin(false);
+    const uint32_t outageFrom = START + 2 * 86400 + 10 * 3600 + 1800;
+    const uint32_t outageTo = outageFrom + 4 * 3600;
+    sim.run(START, START + 4 * 86400, outageFrom, outageTo);
+    
+    const uint32_t windows = windowsIn(OmenReportKind::HOURLY, START, START + 4 * 86400) +
+                             windowsIn(OmenReportKind::DAILY, START, START + 4 * 86400);
+    TEST_ASSERT_EQUAL_UINT32(3, sim.cache.getUnchangedCount());
+    TEST_ASSERT_EQUAL_UINT32(windows - 3, sim.cache.getGeneratedCount());
+    TEST_ASSERT_TRUE(sim.cache.getHitRate() > 0.95f);
+}
+
+void test_reboot_reloads_without_regeneration(void) {
+    Simulation before;
+    before.cache.begin(true);
+    const uint32_t reboot = START + 2 * 86400 + 5 * 3600 + 600;
+    before.run(START, reboot);
+    TEST_ASSERT_FALSE(before.llm.busy);
+    TEST_ASSERT_TRUE(NativeFs::files.count("/omen_hourly.bin") > 0);
+    TEST_ASSERT_TRUE(NativeFs::files.count("/omen_daily.bin") > 0);
+    
+    // 再起動後：保存済みのレポートで同じ窓は埋まっており、要約が空でも生成しない
+    Simulation after;
+    after.cache.begin(true);
+    after.update(reboot);
+    after.view(reboot);
+    TEST_ASSERT_EQUAL_UINT32(0, after.llm.requests);
+    TEST_ASSERT_EQUAL_UINT32(0, after.cache.getGeneratedCount());
+    TEST_ASSERT_EQUAL_UINT32(2, after.cache.getViewCount());
+    TEST_ASSERT_TRUE(after.cache.getHitRate() == 1.0f);
+    TEST_ASSERT_EQUAL_STRING(before.cache.get(OmenReportKind::DAILY)->text,
+                             after.cache.get(OmenReportKind::DAILY)->text);
+}
+
+void test_incompatible_file_discarded(void) {
+    Simulation before;
+    before.cache.begin(true);
+    before.run(START, START + 3600);
+    
+    // 構造体の版が違うファイルは読み込まない
+    std::vector<uint8_t>& file = NativeFs::files["/omen_daily.bin"];
+    TEST_ASSERT_EQUAL(sizeof(OmenReportEntry), file.size());
+    reinterpret_cast<OmenReportEntry*>(file.data())->version = OmenReportCache::ENTRY_VERSION + 1;
+    NativeFs::files["/omen_hourly.bin"].resize(10);
+    
+    OmenReportCache cache;
+    cache.begin(true);
+    TEST_ASSERT_NULL(cache.get(OmenReportKind::DAILY));
+    TEST_ASSERT_NULL(cache.get(OmenReportKind::HOURLY));
+}
+
+void test_unsynced_windows_kept_apart_and_not_saved(void) {
+    OmenReportCache cache;
+    cache.begin(true);
+    
+    // NTP同期前：起動から1時間2分。窓は起動からの秒で区切り、SDカードには保存しない
+    const uint32_t uptime = 3600 + 120;
+    const uint32_t uptimeWindow = OmenReportCache::windowStart(OmenReportKind::HOURLY, uptime, false);
+    TEST_ASSERT_EQUAL_UINT32(3600, uptimeWindow);
+    TEST_ASSERT_EQUAL_UINT32(86400, OmenReportCache::windowStart(OmenReportKind::DAILY, 86400 + 7200, false));
+    TEST_ASSERT_TRUE(cache.store(OmenReportKind::HOURLY, uptimeWindow, false, 0x1234, uptime, "uptime", false));
+    TEST_ASSERT_TRUE(cache.hasWindow(OmenReportKind::HOURLY, uptimeWindow, false));
+    TEST_ASSERT_FALSE(cache.hasWindow(OmenReportKind::HOURLY, uptimeWindow, true));
+    TEST_ASSERT_EQUAL(0, NativeFs::files.count("/omen_hourly.bin"));
+    
+    // 同期後：同期前の窓は現在の窓とみなさない。入力が同じなら引き継ぎ、このときに保存する
+    TEST_ASSERT_TRUE(cache.view(OmenReportKind::HOURLY, START, true) != nullptr);
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getStaleCount());
+    TEST_ASSERT_FALSE(cache.hasWindow(OmenReportKind::HOURLY, START, true));
+    TEST_ASSERT_TRUE(cache.adoptIfUnchanged(OmenReportKind::HOURLY, START, true, 0x1234));
+    TEST_ASSERT_TRUE(cache.hasWindow(OmenReportKind::HOURLY, START, true));
+    TEST_ASSERT_FALSE(cache.hasWindow(OmenReportKind::HOURLY, START, false));
+    TEST_ASSERT_EQUAL(1, NativeFs::files.count("/omen_hourly.bin"));
+    
+    // 再起動して同期前に作ったレポートは、前回の同期済みのファイルを上書きしない
+    OmenReportCache rebooted;
+    rebooted.begin(true);
+    TEST_ASSERT_TRUE(rebooted.hasWindow(OmenReportKind::HOURLY, START, true));
+    TEST_ASSERT_TRUE(rebooted.store(OmenReportKind::HOURLY, uptimeWindow, false, 0x5678, uptime, "after reboot", false));
+    OmenReportCache again;
+    again.begin(true);
+    TEST_ASSERT_TRUE(again.hasWindow(OmenReportKind::HOURLY, START, true));
+    TEST_ASSERT_EQUAL_STRING("uptime", again.get(OmenReportKind::HOURLY)->text);
+    
+    // 同期前の窓が書かれたファイル（壊れた・古い版の書き込み）は読み込まない
+    std::vector<uint8_t>& file = NativeFs::files["/omen_hourly.bin"];
+    reinterpret_cast<OmenReportEntry*>(file.data())->timeSynced = false;
+    OmenReportCache discarded;
+    discarded.begin(true);
+    TEST_ASSERT_NULL(discarded.get(OmenReportKind::HOURLY));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_week_of_views_served_from_cache);
+    RUN_TEST(test_outage_windows_carried_over);
+    RUN_TEST(test_reboot_reloads_without_regeneration);
+    RUN_TEST(test_incompatible_file_discarded);
+    RUN_TEST(test_unsynced_windows_kept_apart_and_not_saved);
+    return UNITY_END();
+}
\ No newline at end of file
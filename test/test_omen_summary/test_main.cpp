@@ -0,0 +1,271 @@
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include <random>
+#include "OmenSummary.h"
+#include "TimeUtils.h"
+
+// 10日分の読み取り値を固定サイズの時間・日ごとの集計に積み上げ、
+// 直近の集計が全読み取り値からの総当たりの計算と一致することを確かめる
+// （外れ値・データなしの項目の除外、イベントのリング、時刻が戻ったときの破棄も確認する）
+
+static const uint32_t START = 1700000000;
+static const uint32_t INTERVAL = 300;
+static const uint32_t DAYS = 10;
+
+struct Sample {
+    uint32_t seconds;
+    SensorReading reading;
+};
+
+static std::vector<Sample> samples;
+
+static SensorReading makeReading(uint32_t seconds, float temperature, float iaq) {
+    SensorReading reading;
+    reading.timestamp = seconds;
+    reading.time_synced = true;
+    reading.temperature = temperature;
+    reading.humidity = 45.0f;
+    reading.pressure = 1013.0f;
+    reading.iaq = iaq;
+    reading.has_iaq_data = true;
+    return reading;
+}
+
+// 開始時刻がstart以上end未満の読み取り値からOMEN_FIELDS[fieldIndex]を集計する
+static OmenRollup::Value bruteForce(uint8_t fieldIndex, uint32_t start, uint32_t end) {
+    OmenRollup::Value result = { 0, 0.0f, 0.0f, 0.0f };
+    const SensorField* field = SensorFields::find(OMEN_FIELDS[fieldIndex]);
+    double sum = 0.0;
+    for (const Sample& sample : samples) {
+        if (sample.seconds < start || sample.seconds >= end) continue;
+        if (!SensorFields::hasValue(*field, sample.reading)) continue;
+        if (sample.reading.outlier_mask & (1 << (field - SENSOR_FIELDS))) continue;
+        
+        float value = SensorFields::getValue(*field, sample.reading);
+        if (result.count == 0 || value < result.minValue) result.minValue = value;
+        if (result.count == 0 || value > result.maxValue) result.maxValue = value;
+        sum += value;
+        result.count++;
+    }
+    result.mean = result.count > 0 ? (float)(sum / result.count) : 0.0f;
+    return result;
+}
+
+static void assertRollupMatches(const OmenRollup& rollup, uint32_t start, uint32_t end) {
+    for (uint8_t i = 0; i < OmenRollup::FIELD_COUNT; i++) {
+        OmenRollup::Value expected = bruteForce(i, start, end);
+        TEST_ASSERT_EQUAL_UINT32(expected.count, rollup.values[i].count);
+        if (expected.count == 0) continue;
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f * fabsf(expected.mean) + 1e-4f, expected.mean, rollup.values[i].mean);
+        TEST_ASSERT_EQUAL_FLOAT(expected.minValue, rollup.values[i].minValue);
+        TEST_ASSERT_EQUAL_FLOAT(expected.maxValue, rollup.values[i].maxValue);
+    }
+}
+
+static AnomalyEvent makeEvent(uint32_t seconds, AnomalyType type, uint8_t channel = 0) {
+    AnomalyEvent event = {};
+    event.timestamp = seconds;
+    event.timeSynced = true;
+    event.channel = channel;
+    event.sensorId = BSEC_OUTPUT_IAQ;
+    event.type = type;
+    event.direction = 1;
+    event.value = (float)seconds;
+    return event;
+}
+
+static uint32_t dayStart(uint32_t seconds) {
+    return seconds - TimeUtils::secondsOfDay(seconds, true);
+}
+
+void setUp(void) {
+    samples.clear();
+}
+
+void tearDown(void) {
+}
+
+void test_rollups_match_brute_force(void) {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+    OmenSummary summary(0);
+    
+    for (uint32_t t = START; t < START + DAYS * 86400; t += INTERVAL) {
+        const float hourOfDay = (float)(t % 86400) / 3600.0f;
+        SensorReading reading = makeReading(t, 21.0f + 2.0f * sinf(hourOfDay * 0.26f) + noise(rng), 60.0f + noise(rng) * 20.0f);
+        // 一部はCO2なし・温度を外れ値扱いにして、集計から除かれることを確かめる
+        if ((t / INTERVAL) % 3 == 0) {
+            reading.co2_equivalent = 500.0f + noise(rng) * 100.0f;
+            reading.has_co2_data = true;
+        }
+        if ((t / INTERVAL) % 17 == 0) {
+            reading.temperature = 80.0f;
+            reading.outlier_mask = 1 << (SensorFields::find(BSEC_OUTPUT_RAW_TEMPERATURE) - SENSOR_FIELDS);
+        }
+        samples.push_back({ t, reading });
+        summary.update(reading);
+        
+        SensorReading otherChannel = reading;
+        otherChannel.channel = 1;
+        otherChannel.temperature = -40.0f;
+        summary.update(otherChannel);
+    }
+    
+    TEST_ASSERT_EQUAL_UINT32(samples.size(), summary.getReadingCount());
+    const uint32_t last = samples.back().seconds;
+    const uint32_t today = dayStart(last);
+    
+    // 日ごと（8日を超えた分は残らない）
+    for (uint8_t ago = 0; ago < OmenSummary::DAILY_ROLLUPS; ago++) {
+        const uint32_t start = today - ago * 86400;
+        const OmenRollup* daily = summary.getDaily(ago);
+        TEST_ASSERT_NOT_NULL(daily);
+        TEST_ASSERT_EQUAL_UINT32(start, daily->start);
+        assertRollupMatches(*daily, start, start + 86400);
+    }
+    TEST_ASSERT_NULL(summary.getDaily(OmenSummary::DAILY_ROLLUPS));
+    
+    // 時間ごと
+    for (uint8_t ago = 0; ago < OmenSummary::HOURLY_ROLLUPS; ago++) {
+        const uint32_t start = last - last % 3600 - ago * 3600;
+        const OmenRollup* hourly = summary.getHourly(ago);
+        TEST_ASSERT_NOT_NULL(hourly);
+        assertRollupMatches(*hourly, start, start + 3600);
+    }
+    
+    // 直近7日のまとめ
+    OmenRollup week;
+    TEST_ASSERT_TRUE(summary.aggregate(7, week));
+    TEST_ASSERT_EQUAL_UINT32(today - 6 * 86400, week.start);
+    assertRollupMatches(week, today - 6 * 86400, last + 1);
+}
+
+void test_update_and_aggregate_cost(void) {
+    // 3秒間隔で7日分（約20万件）の取り込み時間と、7日分のまとめ（レポートの材料）を作る時間
+    std::mt19937 rng(9);
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+    std::vector<SensorReading> readings;
+    for (uint32_t t = START; t < START + 7 * 86400; t += 3) {
+        SensorReading reading = makeReading(t, 21.0f + noise(rng), 60.0f + 20.0f * noise(rng));
+        reading.co2_equivalent = 500.0f + 100.0f * noise(rng);
+        reading.has_co2_data = true;
+        readings.push_back(reading);
+    }
+    
+    OmenSummary summary(0);
+    auto start = std::chrono::steady_clock::now();
+    for (const SensorReading& reading : readings) {
+        summary.update(reading);
+    }
+    double updateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / readings.size();
+    TEST_ASSERT_EQUAL_UINT32(readings.size(), summary.getReadingCount());
+    
+    const int rounds = 10000;
+    OmenRollup week;
+    uint32_t counted = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        summary.aggregate(7, week);
+        counted += week.values[0].count;
+    }
+    double aggregateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    // 当日を含む7暦日分（開始日の0時より前の読み取り値は入らない）
+    uint32_t inWeek = 0;
+    for (const SensorReading& reading : readings) {
+        if (reading.timestamp >= week.start) inWeek++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(rounds * inWeek, counted);
+    
+    char message[160];
+    snprintf(message, sizeof(message), "%u readings: update %.0f ns/reading, 7-day aggregate %.2f us, %u bytes",
+             (unsigned)readings.size(), updateNs, aggregateNs / 1000.0, (unsigned)sizeof(OmenSummary));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN(20000.0, updateNs);
+}
+
+void test_aggregate_skips_missing_days(void) {
+    OmenSummary summary(0);
+    // 3日前と当日だけ読み取り値がある
+    const uint32_t today = dayStart(START + 5 * 86400);
+    const uint32_t times[] = { today - 3 * 86400 + 600, today - 3 * 86400 + 4000, today + 100, today + 7300 };
+    for (uint32_t t : times) {
+        SensorReading reading = makeReading(t, 20.0f + (float)(t % 7), 50.0f);
+        samples.push_back({ t, reading });
+        summary.update(reading);
+    }
+    
+    TEST_ASSERT_NULL(summary.getDaily(1));
+    TEST_ASSERT_NOT_NULL(summary.getDaily(3));
+    
+    OmenRollup result;
+    TEST_ASSERT_TRUE(summary.aggregate(7, result));
+    TEST_ASSERT_EQUAL_UINT32(today - 3 * 86400, result.start);
+    assertRollupMatches(result, today - 3 * 86400, today + 86400);
+    
+    TEST_ASSERT_TRUE(summary.aggregate(1, result));
+    assertRollupMatches(result, today, today + 86400);
+}
+
+void test_events_ring_keeps_newest(void) {
+    OmenSummary summary(0);
+    summary.update(makeReading(START, 20.0f, 50.0f));
+    
+    const uint32_t total = OmenSummary::RECENT_EVENTS + 5;
+    for (uint32_t i = 0; i < total; i++) {
+        summary.recordEvent(makeEvent(START + i * 60, (AnomalyType)(i % 3)));
+    }
+    summary.recordEvent(makeEvent(START, AnomalyType::SPIKE, 1));   // 他チャンネルは無視
+    
+    TEST_ASSERT_EQUAL_UINT8(OmenSummary::RECENT_EVENTS, summary.getRecentEventCount());
+    for (uint8_t i = 0; i < OmenSummary::RECENT_EVENTS; i++) {
+        const AnomalyEvent* event = summary.getRecentEvent(i);
+        TEST_ASSERT_NOT_NULL(event);
+        TEST_ASSERT_EQUAL_UINT32(START + (total - 1 - i) * 60, event->timestamp);
+    }
+    TEST_ASSERT_NULL(summary.getRecentEvent(OmenSummary::RECENT_EVENTS));
+    
+    // 合計は種類ごとに全件を数え、区間のイベント数にも入る
+    TEST_ASSERT_EQUAL_UINT32(7, summary.getEventTotal(AnomalyType::SPIKE));
+    TEST_ASSERT_EQUAL_UINT32(7, summary.getEventTotal(AnomalyType::SHIFT));
+    TEST_ASSERT_EQUAL_UINT32(7, summary.getEventTotal(AnomalyType::DRIFT));
+    OmenRollup result;
+    TEST_ASSERT_TRUE(summary.aggregate(1, result));
+    TEST_ASSERT_EQUAL_UINT16(total, result.eventCount);
+}
+
+void test_resets_when_time_goes_backwards(void) {
+    OmenSummary summary(0);
+    for (uint32_t i = 0; i < 10; i++) {
+        summary.update(makeReading(START + i * INTERVAL, 25.0f, 50.0f));
+    }
+    summary.recordEvent(makeEvent(START, AnomalyType::SHIFT));
+    TEST_ASSERT_EQUAL_UINT32(10, summary.getReadingCount());
+    
+    // 時刻が戻ったら古い集計とイベントを捨てる
+    summary.update(makeReading(START - 86400, 18.0f, 40.0f));
+    TEST_ASSERT_EQUAL_UINT32(1, summary.getReadingCount());
+    TEST_ASSERT_EQUAL_UINT32(START - 86400, summary.getFirstTimestamp());
+    TEST_ASSERT_EQUAL_UINT8(0, summary.getRecentEventCount());
+    OmenRollup result;
+    TEST_ASSERT_TRUE(summary.aggregate(7, result));
+    TEST_ASSERT_EQUAL_UINT32(1, result.values[0].count);
+    TEST_ASSERT_EQUAL_FLOAT(18.0f, result.values[0].mean);
+    
+    // NTP同期前（起動からのミリ秒）の値が届いた場合も基準が変わるので捨てる
+    SensorReading unsynced = makeReading(120000, 30.0f, 40.0f);
+    unsynced.time_synced = false;
+    summary.update(unsynced);
+    TEST_ASSERT_EQUAL_UINT32(1, summary.getReadingCount());
+    TEST_ASSERT_EQUAL_UINT32(120, summary.getLastTimestamp());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rollups_match_brute_force);
+    RUN_TEST(test_update_and_aggregate_cost);
+    RUN_TEST(test_aggregate_skips_missing_days);
+    RUN_TEST(test_events_ring_keeps_newest);
+    RUN_TEST(test_resets_when_time_goes_backwards);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include <unity.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "HampelFilter.h"
+#include "ReadingFilter.h"
+
+// HampelFilter（二分探索で保つ昇順窓・MADのマージ走査）を毎回ソートし直す素朴な実装と突き合わせ、
+// ReadingFilterの既定設定が生の値を残してフラグだけ立てることを確認する
+
+struct BruteForceHampel {
+    std::vector<float> window;
+    size_t size;
+    float threshold;
+    float minDeviation;
+    float minRelativeDeviation;
+    
+    bool update(float value, float& median) {
+        bool outlier = false;
+        median = value;
+        if (window.size() >= size) {
+            std::vector<float> sorted(window);
+            std::sort(sorted.begin(), sorted.end());
+            median = sorted[sorted.size() / 2];
+            
+            std::vector<float> deviations;
+            for (float x : sorted) {
+                deviations.push_back(fabsf(x - median));
+            }
+            std::sort(deviations.begin(), deviations.end());
+            float mad = deviations[deviations.size() / 2];
+            
+            float limit = threshold * (HampelFilter::MAD_SCALE * mad);
+            float floor = fmaxf(minDeviation, minRelativeDeviation * fabsf(median));
+            if (limit < floor) limit = floor;
+            outlier = fabsf(value - median) > limit;
+            window.erase(window.begin());
+        }
+        window.push_back(value);
+        return outlier;
+    }
+};
+
+static void compareWithBruteForce(uint8_t windowSize, float threshold, float minAbs, float minRel, uint32_t seed) {
+    HampelFilter filter;
+    filter.configure(windowSize, threshold, minAbs, minRel);
+    BruteForceHampel reference = { {}, windowSize, threshold, minAbs, minRel };
+    
+    // 0.1刻みに丸めたランダムウォーク（同値が頻繁に出る）に2%の割合でスパイクを混ぜる
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> step(0.0f, 0.3f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float level = 20.0f;
+    uint32_t outliers = 0;
+    
+    for (int i = 0; i < 5000; i++) {
+        level += step(rng);
+        float value = roundf(level * 10.0f) / 10.0f;
+        if (unit(rng) < 0.02f) {
+            value += (unit(rng) < 0.5f ? -1.0f : 1.0f) * (5.0f + 20.0f * unit(rng));
+        }
+        
+        float median, expectedMedian;
+        bool outlier = filter.update(value, median);
+        bool expected = reference.update(value, expectedMedian);
+        TEST_ASSERT_EQUAL_MESSAGE(expected, outlier, "outlier flag differs from brute force");
+        TEST_ASSERT_EQUAL_FLOAT(expectedMedian, median);
+        if (outlier) outliers++;
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, outliers);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_hampel_matches_brute_force_window_3(void) {
+    compareWithBruteForce(3, 3.0f, 0.0f, 0.0f, 1);
+}
+
+void test_hampel_matches_brute_force_window_7(void) {
+    compareWithBruteForce(7, 3.0f, 0.5f, 0.0f, 2);
+}
+
+void test_hampel_matches_brute_force_window_15(void) {
+    compareWithBruteForce(15, 2.5f, 0.0f, 0.05f, 3);
+}
+
+void test_even_window_is_rounded_down_to_odd(void) {
+    HampelFilter filter;
+    filter.configure(8, 3.0f, 0.0f, 0.0f);
+    TEST_ASSERT_EQUAL_UINT8(7, filter.getWindow());
+}
+
+static SensorReading makeReading(float temperature) {
+    SensorReading reading;
+    reading.temperature = temperature;
+    reading.humidity = 45.0f;
+    reading.pressure = 1013.0f;
+    reading.gas_resistance = 50000.0f;
+    return reading;
+}
+
+void test_default_flags_outlier_and_keeps_raw_value(void) {
+    ReadingFilter filter;
+    OutlierFilterConfig config;
+    TEST_ASSERT_TRUE(filter.getConfig(BSEC_OUTPUT_RAW_TEMPERATURE, config));
+    TEST_ASSERT_FALSE(config.replace);
+    
+    for (int i = 0; i < config.window; i++) {
+        SensorReading reading = makeReading(20.0f + 0.1f * (i % 3));
+        TEST_ASSERT_FALSE(filter.apply(reading));
+    }
+    
+    SensorReading spike = makeReading(35.0f);
+    TEST_ASSERT_TRUE(filter.apply(spike));
+    size_t bit = SensorFields::find(BSEC_OUTPUT_RAW_TEMPERATURE) - SENSOR_FIELDS;
+    TEST_ASSERT_EQUAL_UINT16(1 << bit, spike.outlier_mask);
+    TEST_ASSERT_EQUAL_FLOAT(35.0f, spike.temperature);
+    TEST_ASSERT_EQUAL_UINT32(1, filter.getOutlierCount(BSEC_OUTPUT_RAW_TEMPERATURE));
+}
+
+void test_replace_substitutes_window_median(void) {
+    ReadingFilter filter;
+    OutlierFilterConfig config;
+    filter.getConfig(BSEC_OUTPUT_RAW_TEMPERATURE, config);
+    config.replace = true;
+    TEST_ASSERT_TRUE(filter.configure(BSEC_OUTPUT_RAW_TEMPERATURE, config));
+    
+    for (int i = 0; i < config.window; i++) {
+        SensorReading reading = makeReading(20.0f);
+        filter.apply(reading);
+    }
+    
+    SensorReading spike = makeReading(35.0f);
+    TEST_ASSERT_TRUE(filter.apply(spike));
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, spike.temperature);
+}
+
+void test_channels_are_filtered_independently(void) {
+    ReadingFilter filter;
+    OutlierFilterConfig config;
+    filter.getConfig(BSEC_OUTPUT_RAW_TEMPERATURE, config);
+    
+    // チャンネル0を20℃、チャンネル1を30℃で埋めても互いの判定に影響しない
+    for (int i = 0; i < config.window; i++) {
+        SensorReading first = makeReading(20.0f);
+        SensorReading second = makeReading(30.0f);
+        second.channel = 1;
+        filter.apply(first);
+        filter.apply(second);
+    }
+    
+    SensorReading second = makeReading(30.0f);
+    second.channel = 1;
+    TEST_ASSERT_FALSE(filter.apply(second));
+    
+    SensorReading outOfRange = makeReading(99.0f);
+    outOfRange.channel = ReadingFilter::MAX_CHANNELS;
+    TEST_ASSERT_FALSE(filter.apply(outOfRange));
+    TEST_ASSERT_EQUAL_UINT16(0, outOfRange.outlier_mask);
+}
+
+void test_filter_benchmark(void) {
+    // 1回の判定にかかる時間：HampelFilter（窓7・15）と毎回ソートする素朴な実装、ReadingFilter::apply()（既定設定）
+    const int rounds = 100000;
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+    std::vector<float> values(rounds);
+    for (int i = 0; i < rounds; i++) {
+        values[i] = 20.0f + noise(rng);
+    }
+    
+    char message[160];
+    const uint8_t windows[] = { 7, 15 };
+    for (uint8_t window : windows) {
+        HampelFilter filter;
+        filter.configure(window, 3.0f, 0.0f, 0.0f);
+        BruteForceHampel reference = { {}, window, 3.0f, 0.0f, 0.0f };
+        uint32_t flagged = 0;
+        float median;
+        
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            flagged += filter.update(values[i], median);
+        }
+        double hampelNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+        
+        uint32_t expected = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            expected += reference.update(values[i], median);
+        }
+        double bruteNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+        TEST_ASSERT_EQUAL_UINT32(expected, flagged);
+        
+        snprintf(message, sizeof(message), "window %u: hampel %.0f ns/update, re-sort %.0f ns/update", window, hampelNs, bruteNs);
+        TEST_MESSAGE(message);
+    }
+    
+    ReadingFilter filter;
+    std::vector<SensorReading> readings(rounds);
+    for (int i = 0; i < rounds; i++) {
+        readings[i] = makeReading(values[i]);
+        readings[i].humidity += values[i] - 20.0f;
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        filter.apply(readings[i]);
+    }
+    double applyNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    TEST_ASSERT_EQUAL_UINT32(rounds, filter.getProcessedCount());
+    
+    snprintf(message, sizeof(message), "ReadingFilter::apply (default fields) %.0f ns/reading", applyNs);
+    TEST_MESSAGE(message);
+    
+    // BSECの最短の呼び出し間隔（1秒）に比べて十分短い
+    TEST_ASSERT_LESS_THAN(50000.0, applyNs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hampel_matches_brute_force_window_3);
+    RUN_TEST(test_hampel_matches_brute_force_window_7);
+    RUN_TEST(test_hampel_matches_brute_force_window_15);
+    RUN_TEST(test_even_window_is_rounded_down_to_odd);
+    RUN_TEST(test_default_flags_outlier_and_keeps_raw_value);
+    RUN_TEST(test_replace_substitutes_window_median);
+    RUN_TEST(test_channels_are_filtered_independently);
+    RUN_TEST(test_filter_benchmark);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include <unity.h>
+#include "SamplingRateController.h"
+
+// 適応サンプリングのヒステリシス（昇格は即時・降格は最短滞在時間の後）と、
+// 購読変更に失敗した場合のrejectModeChange()による取り消しを確認する
+
+static SamplingRateController controller;
+static uint32_t nowSeconds;
+
+static SensorReading makeReading(float temperature, float iaq, bool hasIaq = true) {
+    SensorReading reading;
+    reading.temperature = temperature;
+    reading.humidity = 50.0f;
+    reading.iaq = iaq;
+    reading.has_iaq_data = hasIaq;
+    return reading;
+}
+
+// LP（3秒間隔）相当の周期で1件進め、モード変更があればtrueを返す
+static bool step(const SensorReading& reading, SamplingMode& newMode, uint32_t seconds = 3) {
+    nowSeconds += seconds;
+    return controller.update(reading, nowSeconds, newMode);
+}
+
+// 指定時間、一定の値を流し続けた間のモード変更回数
+static int holdSteady(uint32_t seconds, float iaq = 50.0f) {
+    int changes = 0;
+    SamplingMode mode;
+    for (uint32_t elapsed = 0; elapsed < seconds; elapsed += 3) {
+        if (step(makeReading(22.0f, iaq), mode)) {
+            changes++;
+        }
+    }
+    return changes;
+}
+
+void setUp(void) {
+    nowSeconds = 1000;
+    controller = SamplingRateController();
+    controller.setConfig(SamplingControllerConfig());
+    controller.reset(SamplingMode::LP, nowSeconds);
+}
+
+void tearDown(void) {}
+
+void test_escalation_is_immediate_and_deescalation_waits_for_dwell(void) {
+    SamplingMode mode;
+    TEST_ASSERT_FALSE(step(makeReading(22.0f, 50.0f), mode));
+    
+    // 異常検知中は次の読み取り値で即座にCONTへ
+    controller.setAnomalyActive(true);
+    TEST_ASSERT_TRUE(step(makeReading(22.0f, 50.0f), mode));
+    TEST_ASSERT_EQUAL((int)SamplingMode::CONT, (int)mode);
+    const uint32_t escalatedAt = nowSeconds;
+    
+    // 異常が収まっても最短滞在時間（120秒）まではCONTを維持
+    controller.setAnomalyActive(false);
+    while (nowSeconds + 3 - escalatedAt < controller.getConfig().minDwellSeconds) {
+        TEST_ASSERT_FALSE(step(makeReading(22.0f, 50.0f), mode));
+        TEST_ASSERT_EQUAL((int)SamplingMode::CONT, (int)controller.getCurrentMode());
+    }
+    TEST_ASSERT_TRUE(step(makeReading(22.0f, 50.0f), mode));
+    TEST_ASSERT_EQUAL((int)SamplingMode::LP, (int)mode);
+    TEST_ASSERT_EQUAL_UINT32(2, controller.getModeChangeCount());
+}
+
+void test_iaq_excursion_uses_separate_enter_and_exit_thresholds(void) {
+    // 変化率による昇格を外し、IAQの閾値だけで判定させる
+    SamplingControllerConfig config;
+    config.iaqRateLow = 1e6f;
+    config.iaqRateHigh = 1e6f;
+    controller.setConfig(config);
+    SamplingMode mode;
+    
+    // 入る閾値（150）未満では昇格しない
+    TEST_ASSERT_FALSE(step(makeReading(22.0f, 140.0f), mode));
+    TEST_ASSERT_TRUE(step(makeReading(22.0f, 150.0f), mode));
+    TEST_ASSERT_EQUAL((int)SamplingMode::CONT, (int)mode);
+    
+    // 出る閾値（120）以上の間は最短滞在時間を過ぎてもCONTのまま
+    TEST_ASSERT_EQUAL(0, holdSteady(600, 130.0f));
+    TEST_ASSERT_EQUAL((int)SamplingMode::CONT, (int)controller.getCurrentMode());
+    
+    // IAQ出力のない読み取り値では逸脱状態を変えない
+    TEST_ASSERT_FALSE(step(makeReading(22.0f, 0.0f, false), mode));
+    TEST_ASSERT_EQUAL((int)SamplingMode::CONT, (int)controller.getCurrentMode());
+    
+    TEST_ASSERT_TRUE(step(makeReading(22.0f, 119.0f), mode));
+    TEST_ASSERT_EQUAL((int)SamplingMode::LP, (int)mode);
+}
+
+void test_stable_readings_step_down_to_ulp_and_change_steps_back_up(void) {
+    // 安定継続時間（30分）に達するまではLPを維持
+    TEST_ASSERT_EQUAL(0, holdSteady(controller.getConfig().stableSeconds - 3));
+    TEST_ASSERT_EQUAL((int)SamplingMode::LP, (int)controller.getCurrentMode());
+    TEST_ASSERT_EQUAL(1, holdSteady(3));
+    TEST_ASSERT_EQUAL((int)SamplingMode::ULP, (int)controller.getCurrentMode());
+    
+    // 緩やかな温度変化（1分で0.3℃、平滑後0.05℃/分超）でLPへ、急な変化でCONTへ即時に戻る
+    SamplingMode mode;
+    TEST_ASSERT_TRUE(step(makeReading(22.3f, 50.0f), mode, 60));
+    TEST_ASSERT_EQUAL((int)SamplingMode::LP, (int)mode);
+    TEST_ASSERT_TRUE(step(makeReading(25.0f, 50.0f), mode));
+    TEST_ASSERT_EQUAL((int)SamplingMode::CONT, (int)mode);
+    TEST_ASSERT_EQUAL_UINT32(60, controller.getSecondsInMode(SamplingMode::ULP));
+}
+
+void test_flapping_input_is_bounded_by_dwell(void) {
+    // 異常状態が読み取り値ごとに反転しても、降格は最短滞在時間に1回まで
+    SamplingMode mode;
+    const uint32_t duration = 1200;
+    for (uint32_t elapsed = 0; elapsed < duration; elapsed += 3) {
+        controller.setAnomalyActive((elapsed / 3) % 2 == 0);
+        step(makeReading(22.0f, 50.0f), mode);
+    }
+    const uint32_t maxChanges = 2 * (duration / controller.getConfig().minDwellSeconds + 1);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(maxChanges, controller.getModeChangeCount());
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2, controller.getModeChangeCount());
+}
+
+void test_reject_mode_change_restores_mode_and_dwell_origin(void) {
+    SamplingMode mode;
+    holdSteady(30);
+    
+    // 昇格の取り消し：モードと回数が戻り、条件が続く次の読み取り値で再び要求する
+    controller.setAnomalyActive(true);
+    TEST_ASSERT_TRUE(step(makeReading(22.0f, 50.0f), mode));
+    controller.rejectModeChange();
+    TEST_ASSERT_EQUAL((int)SamplingMode::LP, (int)controller.getCurrentMode());
+    TEST_ASSERT_EQUAL_UINT32(0, controller.getModeChangeCount());
+    
+    // 2回目の取り消しは何もしない
+    controller.rejectModeChange();
+    TEST_ASSERT_EQUAL((int)SamplingMode::LP, (int)controller.getCurrentMode());
+    TEST_ASSERT_EQUAL_UINT32(0, controller.getModeChangeCount());
+    
+    TEST_ASSERT_TRUE(step(makeReading(22.0f, 50.0f), mode));
+    TEST_ASSERT_EQUAL((int)SamplingMode::CONT, (int)mode);
+    const uint32_t escalatedAt = nowSeconds;
+    
+    // 降格の取り消し：滞在時間の起点は昇格時のままなので、次の読み取り値ですぐに再試行する
+    controller.setAnomalyActive(false);
+    while (!step(makeReading(22.0f, 50.0f), mode)) {}
+    TEST_ASSERT_EQUAL((int)SamplingMode::LP, (int)mode);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(controller.getConfig().minDwellSeconds, nowSeconds - escalatedAt);
+    controller.rejectModeChange();
+    TEST_ASSERT_EQUAL((int)SamplingMode::CONT, (int)controller.getCurrentMode());
+    TEST_ASSERT_TRUE(step(makeReading(22.0f, 50.0f), mode));
+    TEST_ASSERT_EQUAL((int)SamplingMode::LP, (int)mode);
+    TEST_ASSERT_EQUAL_UINT32(2, controller.getModeChangeCount());
+    
+    // 取り消さなかった降格の後は、新しい起点から最短滞在時間を数える
+    controller.setAnomalyActive(true);
+    TEST_ASSERT_TRUE(step(makeReading(22.0f, 50.0f), mode));
+    controller.setAnomalyActive(false);
+    TEST_ASSERT_FALSE(step(makeReading(22.0f, 50.0f), mode));
+    TEST_ASSERT_EQUAL((int)SamplingMode::CONT, (int)controller.getCurrentMode());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_escalation_is_immediate_and_deescalation_waits_for_dwell);
+    RUN_TEST(test_iaq_excursion_uses_separate_enter_and_exit_thresholds);
+    RUN_TEST(test_stable_readings_step_down_to_ulp_and_change_steps_back_up);
+    RUN_TEST(test_flapping_input_is_bounded_by_dwell);
+    RUN_TEST(test_reject_mode_change_restores_mode_and_dwell_origin);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,631 @@
+#include <unity.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <SD.h>
+#include "SensorDataCollector.h"
+#include "SensorTrace.h"
+#include "SyntheticSensorSource.h"
+
+// SensorDataCollectorをBSEC2・FreeRTOSの代替（test/support）の上で動かし、
+// BSECコールバック（生産者）から消費者までの受け渡しを確認する
+
+static SensorDataCollector* collector = nullptr;
+static std::vector<SensorReading> received;
+static std::thread::id receiverThread;
+
+// IAQ（負なら出力なし）と温度の2出力のサンプル
+static void makeSample(float iaq, float temperature, bme68xData& data, bsecOutputs& outputs, uint8_t accuracy = 1) {
+    memset(&data, 0, sizeof(data));
+    data.temperature = temperature;
+    data.gas_resistance = 50000.0f;
+    
+    memset(&outputs, 0, sizeof(outputs));
+    if (iaq >= 0.0f) {
+        outputs.output[outputs.nOutputs].sensor_id = BSEC_OUTPUT_IAQ;
+        outputs.output[outputs.nOutputs].signal = iaq;
+        outputs.output[outputs.nOutputs].accuracy = accuracy;
+        outputs.nOutputs++;
+    }
+    outputs.output[outputs.nOutputs].sensor_id = BSEC_OUTPUT_RAW_TEMPERATURE;
+    outputs.output[outputs.nOutputs].signal = temperature;
+    outputs.nOutputs++;
+}
+
+static void feedSample(uint8_t address, float iaq, float temperature, uint8_t accuracy = 1) {
+    bme68xData data;
+    bsecOutputs outputs;
+    makeSample(iaq, temperature, data, outputs, accuracy);
+    NativeBsec::feed(address, data, outputs);
+}
+
+static bool injectSample(SensorDataCollector& target, uint8_t channel, float iaq, float temperature, uint32_t timestamp) {
+    bme68xData data;
+    bsecOutputs outputs;
+    makeSample(iaq, temperature, data, outputs);
+    return target.injectBsecData(data, outputs, timestamp, false, channel);
+}
+
+static void onReading(const SensorReading& reading) {
+    received.push_back(reading);
+    receiverThread = std::this_thread::get_id();
+}
+
+// 専用タスクが指定件数をリングへ積むまで、時刻を1msずつ進めながら待つ（実時間で最大1秒）
+// タスクは測定前のポーリング間隔（vTaskDelay）をmillis()で数えるため、時刻を止めると起床しない
+static bool waitForPending(size_t count) {
+    for (int i = 0; i < 1000 && collector->getPendingReadingCount() < count; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        NativeClock::nowMs += 1;
+    }
+    return collector->getPendingReadingCount() >= count;
+}
+
+void setUp(void) {
+    NativeBsec::reset();
+    NativeNvs::entries.clear();
+    NativeNvs::failWrites = false;
+    NativeNvs::writeCount = 0;
+    NativeNvs::failedWriteCount = 0;
+    NativeClock::nowMs = 0;
+    received.clear();
+    collector = new SensorDataCollector();
+    collector->setCallback(onReading);
+}
+
+void tearDown(void) {
+    // stopSensorTask()はタスクの終了まで待つため、時刻を進めずにそのまま破棄できる
+    collector->stopSensorTask();
+    delete collector;
+    collector = nullptr;
+}
+
+void test_consumers_are_decoupled_from_run_timing(void) {
+    TEST_ASSERT_TRUE(collector->initialize());
+    TEST_ASSERT_EQUAL(1, collector->getSensorCount());
+    TEST_ASSERT_TRUE(collector->startSensorTask());
+    
+    // 専用タスクがBSECの要求周期（LP: 3秒）ごとに5件を生成する間、消費者側は何もしない
+    std::vector<unsigned long> fedAt;
+    for (int i = 0; i < 5; i++) {
+        fedAt.push_back(NativeClock::nowMs);
+        feedSample(BME68X_I2C_ADDR_HIGH, 50.0f + i, 20.0f + i);
+        TEST_ASSERT_TRUE(waitForPending(i + 1));
+        NativeClock::nowMs += 3000;
+    }
+    TEST_ASSERT_EQUAL(0, received.size());
+    TEST_ASSERT_EQUAL(5, collector->getPendingReadingCount());
+    
+    // まとめて配信しても順序・値・取得時刻は生成時のまま、呼び出しは消費者側のスレッドで行われる
+    NativeClock::nowMs += 60000;
+    collector->update();
+    TEST_ASSERT_EQUAL(5, received.size());
+    TEST_ASSERT_TRUE(receiverThread == std::this_thread::get_id());
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(50.0f + i, received[i].iaq);
+        TEST_ASSERT_EQUAL_FLOAT(20.0f + i, received[i].temperature);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(fedAt[i], received[i].timestamp);
+        TEST_ASSERT_LESS_THAN_UINT32(fedAt[i] + 3000, received[i].timestamp);
+        TEST_ASSERT_FALSE(received[i].time_synced);
+    }
+    
+    // 新しい測定がなければ何度update()しても配信されない
+    for (int i = 0; i < 10; i++) {
+        collector->update();
+    }
+    TEST_ASSERT_EQUAL(5, received.size());
+    TEST_ASSERT_EQUAL_UINT32(0, collector->getDroppedReadingCount());
+}
+
+void test_full_ring_keeps_oldest_until_consumers_catch_up(void) {
+    TEST_ASSERT_TRUE(collector->initialize());
+    
+    // 消費者が止まっている間にリング容量を超えて生成されたサンプルは新しい方から捨てる
+    const size_t total = SensorDataCollector::READING_RING_CAPACITY + 8;
+    for (size_t i = 0; i < total; i++) {
+        SensorReading reading;
+        reading.timestamp = 1000 + i;
+        reading.iaq = (float)i;
+        collector->publishReading(reading);
+    }
+    TEST_ASSERT_EQUAL(SensorDataCollector::READING_RING_CAPACITY, collector->getPendingReadingCount());
+    TEST_ASSERT_EQUAL_UINT32(8, collector->getDroppedReadingCount());
+    
+    TEST_ASSERT_EQUAL(SensorDataCollector::READING_RING_CAPACITY, collector->dispatchPendingReadings());
+    TEST_ASSERT_EQUAL(SensorDataCollector::READING_RING_CAPACITY, received.size());
+    for (size_t i = 0; i < received.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(1000 + i, received[i].timestamp);
+    }
+}
+
+void test_publish_latency(void) {
+    TEST_ASSERT_TRUE(collector->initialize());
+    collector->setCallback(nullptr);
+    
+    // 生産者側の1件の投入（ロック + リングへのコピー）と、投入から消費者のコールバックまでの時間
+    const int rounds = 20000;
+    SensorReading reading;
+    reading.iaq = 50.0f;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        reading.timestamp = i;
+        collector->publishReading(reading);
+        SensorReading popped;
+        collector->popReading(popped);
+    }
+    double publishNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    
+    uint32_t delivered = 0;
+    collector->setCallback([&delivered](const SensorReading&) { delivered++; });
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        reading.timestamp = i;
+        collector->publishReading(reading);
+        collector->dispatchPendingReadings();
+    }
+    double dispatchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    TEST_ASSERT_EQUAL_UINT32(rounds, delivered);
+    
+    char message[128];
+    snprintf(message, sizeof(message), "publish+pop %.0f ns/sample, publish->callback %.0f ns/sample",
+             publishNs, dispatchNs);
+    TEST_MESSAGE(message);
+    
+    // BSECコールバック内で行う投入はBSECの呼び出し間隔（最短1秒）に比べて十分短い
+    TEST_ASSERT_LESS_THAN(20000.0, publishNs);
+}
+
+void test_explicit_batch_receives_only_enqueued_readings(void) {
+    TEST_ASSERT_TRUE(collector->initialize());
+    
+    // 全件を受け取る消費者と、コールバックでの判定結果（ここでは偶数の時刻）だけを受け取る消費者
+    std::vector<size_t> autoBatches;
+    std::vector<uint32_t> routed;
+    TEST_ASSERT_EQUAL_INT8(0, collector->addBatchConsumer([&autoBatches](const SensorReading*, size_t count) {
+        autoBatches.push_back(count);
+    }, 4, 1000));
+    int8_t routedId = collector->addBatchConsumer([&routed](const SensorReading* readings, size_t count) {
+        for (size_t i = 0; i < count; i++) routed.push_back(readings[i].timestamp);
+    }, 3, 1000, false);
+    TEST_ASSERT_EQUAL_INT8(1, routedId);
+    collector->setCallback([routedId](const SensorReading& reading) {
+        if (reading.timestamp % 2 == 0) {
+            collector->enqueueBatch(routedId, reading);
+        }
+    });
+    
+    for (uint32_t i = 0; i < 8; i++) {
+        SensorReading reading;
+        reading.timestamp = i;
+        collector->publishReading(reading);
+    }
+    collector->dispatchPendingReadings();
+    TEST_ASSERT_EQUAL(2, autoBatches.size());
+    TEST_ASSERT_EQUAL(4, autoBatches[1]);
+    TEST_ASSERT_EQUAL(3, routed.size());
+    
+    // 残りの1件は最大遅延を過ぎてから配信される
+    collector->flushBatches();
+    TEST_ASSERT_EQUAL(3, routed.size());
+    NativeClock::nowMs += 1000;
+    collector->flushBatches();
+    TEST_ASSERT_EQUAL(4, routed.size());
+    for (size_t i = 0; i < routed.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(i * 2, routed[i]);
+    }
+    
+    TEST_ASSERT_FALSE(collector->enqueueBatch(2, SensorReading()));
+    TEST_ASSERT_FALSE(collector->enqueueBatch(-1, SensorReading()));
+}
+
+// 投入から配信までの1件あたりの時間（コールバックと一括配信の構成はtargetに設定済み）
+static double measureDispatchNs(SensorDataCollector& target, int rounds) {
+    SensorReading reading;
+    reading.iaq = 50.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        reading.timestamp = i;
+        target.publishReading(reading);
+        target.dispatchPendingReadings();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+}
+
+void test_batch_routing_overhead(void) {
+    // 1件ずつのコールバックだけの場合と、一括配信を加えた場合の1件あたりの時間を比べる
+    // （SD保存と同じく、コールバックで判定した半数だけをenqueueBatch()で入れる構成も測る）
+    const int rounds = 20000;
+    uint32_t delivered = 0;
+    uint32_t batched = 0;
+    auto countReading = [&delivered](const SensorReading&) { delivered++; };
+    auto countBatch = [&batched](const SensorReading*, size_t count) { batched += count; };
+    
+    TEST_ASSERT_TRUE(collector->initialize());
+    collector->setCallback(countReading);
+    double callbackNs = measureDispatchNs(*collector, rounds);
+    
+    SensorDataCollector* autoCollector = new SensorDataCollector();
+    TEST_ASSERT_TRUE(autoCollector->initialize());
+    autoCollector->setCallback(countReading);
+    autoCollector->addBatchConsumer(countBatch, 16, 60000);
+    double autoNs = measureDispatchNs(*autoCollector, rounds);
+    autoCollector->flushBatches(true);
+    TEST_ASSERT_EQUAL_UINT32(rounds, batched);
+    
+    SensorDataCollector* routedCollector = new SensorDataCollector();
+    TEST_ASSERT_TRUE(routedCollector->initialize());
+    int8_t routedId = routedCollector->addBatchConsumer(countBatch, 16, 60000, false);
+    routedCollector->setCallback([&delivered, routedCollector, routedId](const SensorReading& reading) {
+        delivered++;
+        if (reading.timestamp % 2 == 0) {
+            routedCollector->enqueueBatch(routedId, reading);
+        }
+    });
+    double routedNs = measureDispatchNs(*routedCollector, rounds);
+    routedCollector->flushBatches(true);
+    TEST_ASSERT_EQUAL_UINT32(3 * rounds, delivered);
+    TEST_ASSERT_EQUAL_UINT32(rounds + rounds / 2, batched);
+    delete autoCollector;
+    delete routedCollector;
+    
+    char message[160];
+    snprintf(message, sizeof(message), "dispatch: callback %.0f ns/sample, +batch(all) %.0f ns/sample, +batch(enqueued half) %.0f ns/sample",
+             callbackNs, autoNs, routedNs);
+    TEST_MESSAGE(message);
+    
+    // 一括配信のバッファへのコピーはBSECの呼び出し間隔（最短1秒）に比べて十分短い
+    TEST_ASSERT_LESS_THAN(20000.0, autoNs - callbackNs);
+}
+
+void test_recorded_trace_replays_through_dispatch(void) {
+    // 実センサーの経路（BSECコールバック → リング → 配信）で記録する
+    TEST_ASSERT_TRUE(collector->initialize());
+    SensorTraceRecorder recorder;
+    NativeFs::files.clear();
+    TEST_ASSERT_TRUE(recorder.begin(SD, "/trace.bin"));
+    collector->setTraceRecorder(&recorder);
+    for (int i = 0; i < 6; i++) {
+        feedSample(BME68X_I2C_ADDR_HIGH, 40.0f + 7 * i, 21.0f + 0.5f * i);
+        collector->update();
+        NativeClock::nowMs += 3000;
+    }
+    collector->setTraceRecorder(nullptr);
+    recorder.stop();
+    TEST_ASSERT_EQUAL(6, received.size());
+    TEST_ASSERT_EQUAL_UINT32(6, recorder.getRecordCount());
+    std::vector<SensorReading> live = received;
+    received.clear();
+    
+    // センサーのない別の収集器へSensorTracePlayer経由で再生し、同じ値・時刻が配信される
+    SensorDataCollector target;
+    target.setCallback(onReading);
+    SensorTraceReplayer replayer;
+    TEST_ASSERT_TRUE(replayer.begin(SD, "/trace.bin", target, SensorTraceReplayer::SPEED_UNTHROTTLED));
+    for (int i = 0; i < 100 && replayer.isReplaying(); i++) {
+        replayer.update();
+        target.update();
+    }
+    TEST_ASSERT_FALSE(replayer.isReplaying());
+    TEST_ASSERT_EQUAL_UINT32(6, replayer.getReplayedCount());
+    TEST_ASSERT_EQUAL(live.size(), received.size());
+    for (size_t i = 0; i < live.size(); i++) {
+        TEST_ASSERT_EQUAL_FLOAT(live[i].iaq, received[i].iaq);
+        TEST_ASSERT_EQUAL_FLOAT(live[i].temperature, received[i].temperature);
+        TEST_ASSERT_EQUAL_UINT32(live[i].timestamp, received[i].timestamp);
+        TEST_ASSERT_EQUAL(live[i].time_synced, received[i].time_synced);
+        TEST_ASSERT_EQUAL_UINT8(live[i].channel, received[i].channel);
+        TEST_ASSERT_FALSE(live[i].replayed);
+        TEST_ASSERT_TRUE(received[i].replayed);
+    }
+}
+
+void test_replay_keeps_live_channel_state(void) {
+    TEST_ASSERT_TRUE(collector->initialize());
+    collector->setAdaptiveSampling(true);
+    feedSample(BME68X_I2C_ADDR_HIGH, 50.0f, 22.0f);
+    collector->update();
+    TEST_ASSERT_EQUAL(1, received.size());
+    const uint32_t liveFiltered = collector->getReadingFilter().getProcessedCount();
+    const uint32_t subscriptions = NativeBsec::subscriptionCount;
+    
+    // 主チャンネル・未接続のチャンネル3へ再生し、範囲外のチャンネルは読み飛ばす
+    // 変化率の大きい値を続けて流しても、再生の値で適応サンプリングは動かない
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_TRUE(injectSample(*collector, SensorDataCollector::PRIMARY_CHANNEL, 100.0f + 20 * i, 30.0f + i, 1000 + i));
+    }
+    TEST_ASSERT_TRUE(injectSample(*collector, 3, 300.0f, 25.0f, 2000));
+    TEST_ASSERT_TRUE(injectSample(*collector, SensorDataCollector::MAX_SENSORS, 999.0f, 99.0f, 3000));
+    collector->update();
+    TEST_ASSERT_EQUAL(22, received.size());
+    TEST_ASSERT_TRUE(received[1].replayed);
+    TEST_ASSERT_EQUAL_UINT8(3, received[21].channel);
+    TEST_ASSERT_TRUE(received[21].replayed);
+    
+    // 実センサー側の最新値・外れ値判定の窓・購読は再生の影響を受けない
+    TEST_ASSERT_EQUAL_FLOAT(50.0f, collector->getIAQ());
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, collector->getTemperature());
+    TEST_ASSERT_EQUAL_UINT32(liveFiltered, collector->getReadingFilter().getProcessedCount());
+    TEST_ASSERT_EQUAL_UINT32(subscriptions, NativeBsec::subscriptionCount);
+    
+    // IAQを含まない次の実測定は、再生の値ではなく前回の実測定のIAQを引き継ぐ
+    NativeClock::nowMs += 3000;
+    feedSample(BME68X_I2C_ADDR_HIGH, -1.0f, 22.5f);
+    collector->update();
+    TEST_ASSERT_EQUAL(23, received.size());
+    TEST_ASSERT_FALSE(received[22].replayed);
+    TEST_ASSERT_EQUAL_FLOAT(50.0f, received[22].iaq);
+    TEST_ASSERT_EQUAL_FLOAT(22.5f, received[22].temperature);
+}
+
+// 2チャンネルに交互に積んだ値が、それぞれのチャンネル番号・状態で配信されることを確認する
+// ch0はIAQ 100+i、ch1はIAQ 200+i（ch1は奇数回目にIAQ出力なし＝前回のch1の値を引き継ぐ）
+static void checkInterleavedChannels(const std::vector<SensorReading>& readings, int rounds) {
+    int seen[2] = { 0, 0 };
+    float lastIaq[2] = { 0.0f, 0.0f };
+    for (const SensorReading& reading : readings) {
+        TEST_ASSERT_LESS_THAN(2, reading.channel);
+        const int i = seen[reading.channel]++;
+        if (reading.channel == 0) {
+            TEST_ASSERT_EQUAL_FLOAT(100.0f + i, reading.iaq);
+            TEST_ASSERT_EQUAL_FLOAT(20.0f + i, reading.temperature);
+        } else {
+            TEST_ASSERT_EQUAL_FLOAT((i % 2) ? lastIaq[1] : 200.0f + i, reading.iaq);
+            TEST_ASSERT_EQUAL_FLOAT(30.0f + i, reading.temperature);
+        }
+        lastIaq[reading.channel] = reading.iaq;
+    }
+    TEST_ASSERT_EQUAL(rounds, seen[0]);
+    TEST_ASSERT_EQUAL(rounds, seen[1]);
+}
+
+static void feedInterleaved(int round) {
+    feedSample(BME68X_I2C_ADDR_HIGH, 100.0f + round, 20.0f + round);
+    feedSample(BME68X_I2C_ADDR_LOW, (round % 2) ? -1.0f : 200.0f + round, 30.0f + round);
+}
+
+void test_interleaved_channels_route_by_running_channel(void) {
+    NativeBsec::connected = { BME68X_I2C_ADDR_HIGH, BME68X_I2C_ADDR_LOW };
+    TEST_ASSERT_TRUE(collector->initialize());
+    TEST_ASSERT_EQUAL(2, collector->getSensorCount());
+    TEST_ASSERT_EQUAL_HEX8(BME68X_I2C_ADDR_HIGH, collector->getSensorAddress(0));
+    TEST_ASSERT_EQUAL_HEX8(BME68X_I2C_ADDR_LOW, collector->getSensorAddress(1));
+    
+    // メインループでの実行：update()ごとに両チャンネルを順にrun()する
+    const int rounds = 6;
+    for (int i = 0; i < rounds; i++) {
+        feedInterleaved(i);
+        collector->update();
+        NativeClock::nowMs += 3000;
+    }
+    TEST_ASSERT_EQUAL(2 * rounds, received.size());
+    checkInterleavedChannels(received, rounds);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f + rounds - 1, collector->getIAQ());
+    
+    // 専用タスクでの実行：消費者を止めたまま両チャンネルの測定を溜め、まとめて配信しても同じ振り分けになる
+    received.clear();
+    TEST_ASSERT_TRUE(collector->startSensorTask());
+    for (int i = 0; i < rounds; i++) {
+        feedInterleaved(rounds + i);
+        TEST_ASSERT_TRUE(waitForPending(2 * (i + 1)));
+        NativeClock::nowMs += 3000;
+    }
+    collector->update();
+    TEST_ASSERT_EQUAL(2 * rounds, received.size());
+    std::vector<SensorReading> taskReadings;
+    for (const SensorReading& reading : received) {
+        SensorReading shifted = reading;
+        shifted.iaq -= rounds;
+        shifted.temperature -= rounds;
+        taskReadings.push_back(shifted);
+    }
+    checkInterleavedChannels(taskReadings, rounds);
+    TEST_ASSERT_EQUAL(0, NativeBsec::pendingCount(BME68X_I2C_ADDR_HIGH));
+    TEST_ASSERT_EQUAL(0, NativeBsec::pendingCount(BME68X_I2C_ADDR_LOW));
+}
+
+void test_trace_write_does_not_block_sensor_task(void) {
+    TEST_ASSERT_TRUE(collector->initialize());
+    SensorTraceRecorder recorder;
+    NativeFs::files.clear();
+    TEST_ASSERT_TRUE(recorder.begin(SD, "/trace.bin"));
+    collector->setTraceRecorder(&recorder);
+    TEST_ASSERT_TRUE(collector->startSensorTask());
+    
+    feedSample(BME68X_I2C_ADDR_HIGH, 50.0f, 22.0f);
+    TEST_ASSERT_TRUE(waitForPending(1));
+    const size_t headerSize = NativeFs::files["/trace.bin"].size();
+    
+    // update()がSDカードへ書き込んでいる最中に、専用タスクが次の測定を記録・投入できる
+    bool producedDuringWrite = false;
+    int writes = 0;
+    NativeFs::writeHook = [&]() {
+        if (writes++ > 0) return;
+        NativeClock::nowMs += 3000;
+        feedSample(BME68X_I2C_ADDR_HIGH, 51.0f, 22.1f);
+        producedDuringWrite = waitForPending(2);
+    };
+    collector->update();
+    NativeFs::writeHook = nullptr;
+    TEST_ASSERT_TRUE(producedDuringWrite);
+    TEST_ASSERT_EQUAL(2, received.size());
+    
+    // 書き込み中に記録した分はもう一方のバッファに入り、次のupdate()で書き出される
+    const size_t firstRecordEnd = NativeFs::files["/trace.bin"].size();
+    TEST_ASSERT_GREATER_THAN(headerSize, firstRecordEnd);
+    TEST_ASSERT_EQUAL_UINT32(2, recorder.getRecordCount());
+    collector->update();
+    TEST_ASSERT_EQUAL(2 * firstRecordEnd - headerSize, NativeFs::files["/trace.bin"].size());
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.getDroppedCount());
+    
+    // stopSensorTask()はタスクの終了を待ってから戻る（時刻を進めなくても終了している）
+    collector->stopSensorTask();
+    TEST_ASSERT_TRUE(NativeRtos::waitForTasks(100));
+    collector->setTraceRecorder(nullptr);
+    recorder.stop();
+}
+
+void test_failed_state_save_is_retried_with_backoff(void) {
+    TEST_ASSERT_TRUE(collector->initialize());
+    NativeNvs::failWrites = true;
+    
+    // 校正完了（精度3）の最初の読み取り値で保存を試み、失敗する
+    feedSample(BME68X_I2C_ADDR_HIGH, 50.0f, 22.0f, 3);
+    collector->update();
+    collector->update();
+    TEST_ASSERT_EQUAL_UINT32(1, NativeNvs::failedWriteCount);
+    
+    // 失敗は保存済みとして扱わず、1分・2分・4分…と間隔を倍にしながら再試行する
+    uint32_t backoffMs = SensorDataCollector::STATE_SAVE_RETRY_MS;
+    for (uint32_t attempt = 2; attempt <= 4; attempt++) {
+        NativeClock::nowMs += backoffMs - 1;
+        collector->update();
+        TEST_ASSERT_EQUAL_UINT32(attempt - 1, NativeNvs::failedWriteCount);
+        NativeClock::nowMs += 1;
+        collector->update();
+        TEST_ASSERT_EQUAL_UINT32(attempt, NativeNvs::failedWriteCount);
+        backoffMs *= 2;
+    }
+    
+    // 書き込めるようになれば次の再試行で保存し、以降は通常の保存間隔に戻る
+    NativeNvs::failWrites = false;
+    NativeClock::nowMs += backoffMs;
+    collector->update();
+    TEST_ASSERT_EQUAL_UINT32(2, NativeNvs::writeCount);  // 本体とヘッダー
+    NativeClock::nowMs += SensorDataCollector::STATE_SAVE_INTERVAL_MS - 1;
+    collector->update();
+    TEST_ASSERT_EQUAL_UINT32(2, NativeNvs::writeCount);
+    NativeClock::nowMs += 1;
+    feedSample(BME68X_I2C_ADDR_HIGH, 51.0f, 22.0f, 3);
+    collector->update();
+    collector->update();
+    TEST_ASSERT_EQUAL_UINT32(4, NativeNvs::writeCount);
+    
+    // 保存した状態は次の起動で復元される
+    SensorDataCollector restarted;
+    TEST_ASSERT_TRUE(restarted.initialize());
+    TEST_ASSERT_TRUE(restarted.getStateReport().indexOf("復元済み") >= 0);
+}
+
+void test_scan_trace_replay_throughput(void) {
+    TEST_ASSERT_TRUE(collector->initialize());
+    static const uint8_t scanConfig[4] = { 1, 2, 3, 4 };
+    TEST_ASSERT_TRUE(collector->enableGasScan(scanConfig));
+    std::vector<GasScan> scans;
+    collector->setGasScanCallback([&scans](const GasScan& scan) { scans.push_back(scan); });
+    collector->setCallback(nullptr);
+    
+    // 10ステップのヒータープロファイルを周回ごとに抵抗値を変えて記録する（分類確率は最終ステップのみ）
+    const int cycles = 2000;
+    SensorTraceRecorder recorder;
+    NativeFs::files.clear();
+    TEST_ASSERT_TRUE(recorder.begin(SD, "/scan.bin"));
+    for (int cycle = 0; cycle < cycles; cycle++) {
+        for (uint8_t step = 0; step < GasScan::MAX_STEPS; step++) {
+            bme68xData data;
+            memset(&data, 0, sizeof(data));
+            data.status = BME68X_NEW_DATA_MSK | BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK;
+            data.gas_index = step;
+            data.gas_resistance = 10000.0f * (step + 1) + cycle;
+            bsecOutputs outputs;
+            memset(&outputs, 0, sizeof(outputs));
+            if (step == GasScan::MAX_STEPS - 1) {
+                outputs.output[0].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_1;
+                outputs.output[0].signal = 0.5f;
+                outputs.nOutputs = 1;
+            }
+            recorder.record(data, outputs, 1700000000 + cycle * 10 + step, true);
+        }
+        recorder.swapBuffers();
+        recorder.flush();
+    }
+    recorder.stop();
+    TEST_ASSERT_EQUAL_UINT32(cycles * GasScan::MAX_STEPS, recorder.getRecordCount());
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.getDroppedCount());
+    
+    // トレース → 再生 → GasScanAssembler → スキャンのリング → コールバックを待ち時間なしで回す
+    SensorTraceReplayer replayer;
+    TEST_ASSERT_TRUE(replayer.begin(SD, "/scan.bin", *collector, SensorTraceReplayer::SPEED_UNTHROTTLED));
+    auto start = std::chrono::steady_clock::now();
+    while (replayer.isReplaying()) {
+        replayer.update();
+        collector->update();
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    
+    // 最後の周回は次の周回の先頭が届かないため確定しない
+    TEST_ASSERT_EQUAL(cycles - 1, scans.size());
+    TEST_ASSERT_EQUAL_UINT32(0, collector->getDroppedGasScanCount());
+    for (size_t i = 0; i < scans.size(); i += 97) {
+        TEST_ASSERT_EQUAL_UINT32(1700000000 + i * 10, scans[i].timestamp);
+        TEST_ASSERT_EQUAL_UINT16((1 << GasScan::MAX_STEPS) - 1, scans[i].validMask);
+        TEST_ASSERT_FLOAT_WITHIN(10.0f, 20000.0f + i, scans[i].getResistance(1));
+        TEST_ASSERT_EQUAL_FLOAT(0.5f, scans[i].gasEstimate[0]);
+    }
+    
+    char message[128];
+    snprintf(message, sizeof(message), "scan replay %.0f ns/step, %.1f us/scan, %.0f scans/s",
+             elapsedNs / (cycles * GasScan::MAX_STEPS), elapsedNs / cycles / 1000.0, cycles * 1e9 / elapsedNs);
+    TEST_MESSAGE(message);
+    
+    // 実機のスキャン（1周数秒〜数十秒）に対して桁違いに速く、リングから取りこぼさない
+    TEST_ASSERT_LESS_THAN(1000000.0, elapsedNs / cycles);
+}
+
+void test_synthetic_load_stays_out_of_live_state(void) {
+    TEST_ASSERT_TRUE(collector->initialize());
+    collector->setAdaptiveSampling(true);
+    feedSample(BME68X_I2C_ADDR_HIGH, 50.0f, 22.0f);
+    collector->update();
+    TEST_ASSERT_EQUAL(1, received.size());
+    const uint32_t liveFiltered = collector->getReadingFilter().getProcessedCount();
+    const uint32_t subscriptions = NativeBsec::subscriptionCount;
+    
+    // 主チャンネルを共有する仮想デバイスへ大きなステップ変化とIAQスパイクを頻繁に起こす
+    SyntheticLoadConfig config;
+    config.deviceCount = 2;
+    config.samplesPerSecond = 0;
+    config.stepChangeProbability = 0.2f;
+    config.stepChangeMagnitude = 8.0f;
+    config.iaqSpikeProbability = 0.2f;
+    SyntheticSensorSource load;
+    TEST_ASSERT_TRUE(load.begin(*collector, config));
+    TEST_ASSERT_EQUAL(200, load.update(200));
+    TEST_ASSERT_EQUAL(201, received.size());
+    for (size_t i = 1; i < received.size(); i++) {
+        TEST_ASSERT_TRUE(received[i].synthetic);
+    }
+    TEST_ASSERT_EQUAL_UINT8(SensorDataCollector::PRIMARY_CHANNEL, received[1].channel);
+    
+    // 実センサー側の最新値・外れ値判定の窓・適応サンプリング（購読）は変わらない
+    TEST_ASSERT_EQUAL_FLOAT(50.0f, collector->getIAQ());
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, collector->getTemperature());
+    TEST_ASSERT_EQUAL_UINT32(liveFiltered, collector->getReadingFilter().getProcessedCount());
+    TEST_ASSERT_EQUAL_UINT32(subscriptions, NativeBsec::subscriptionCount);
+    
+    // 実センサーの値には印が付かない
+    load.stop();
+    NativeClock::nowMs += 3000;
+    feedSample(BME68X_I2C_ADDR_HIGH, 51.0f, 22.5f);
+    collector->update();
+    TEST_ASSERT_EQUAL(202, received.size());
+    TEST_ASSERT_FALSE(received[201].synthetic);
+    TEST_ASSERT_EQUAL_FLOAT(51.0f, collector->getIAQ());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_consumers_are_decoupled_from_run_timing);
+    RUN_TEST(test_full_ring_keeps_oldest_until_consumers_catch_up);
+    RUN_TEST(test_publish_latency);
+    RUN_TEST(test_explicit_batch_receives_only_enqueued_readings);
+    RUN_TEST(test_batch_routing_overhead);
+    RUN_TEST(test_recorded_trace_replays_through_dispatch);
+    RUN_TEST(test_replay_keeps_live_channel_state);
+    RUN_TEST(test_interleaved_channels_route_by_running_channel);
+    RUN_TEST(test_trace_write_does_not_block_sensor_task);
+    RUN_TEST(test_failed_state_save_is_retried_with_backoff);
+    RUN_TEST(test_scan_trace_replay_throughput);
+    RUN_TEST(test_synthetic_load_stays_out_of_live_state);
+    return UNITY_END();
+}
\ No newline at end of file
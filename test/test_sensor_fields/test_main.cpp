@@ -0,0 +1,278 @@
+#include <unity.h>
+#include <chrono>
+#include <string.h>
+#include <stddef.h>
+#include "SensorFields.h"
+#include "DeviceRegistry.h"
+
+// 対応表から生成するデコード・購読リスト・CSV・JSON・スキーマを、
+// 表に置き換える前の手書きswitchと同じ結果になるか確かめる
+
+static bsecOutputs outputs;
+
+static void addOutput(uint8_t sensorId, float signal, uint8_t accuracy = 0) {
+    bsecData& output = outputs.output[outputs.nOutputs++];
+    output.sensor_id = sensorId;
+    output.signal = signal;
+    output.accuracy = accuracy;
+}
+
+// 置き換え前のSensorDataCollector::processBsecOutputsと同じ取り込み
+static void decodeBySwitch(const bsecOutputs& source, SensorReading& reading, uint8_t& iaqAccuracy) {
+    reading.has_co2_data = false;
+    reading.has_iaq_data = false;
+    reading.has_voc_data = false;
+    for (uint8_t i = 0; i < source.nOutputs; i++) {
+        const bsecData& output = source.output[i];
+        switch (output.sensor_id) {
+            case BSEC_OUTPUT_RAW_TEMPERATURE: reading.temperature = output.signal; break;
+            case BSEC_OUTPUT_RAW_HUMIDITY: reading.humidity = output.signal; break;
+            case BSEC_OUTPUT_RAW_PRESSURE: reading.pressure = output.signal / 100.0f; break;
+            case BSEC_OUTPUT_CO2_EQUIVALENT:
+                reading.co2_equivalent = output.signal;
+                reading.has_co2_data = true;
+                break;
+            case BSEC_OUTPUT_IAQ:
+                reading.iaq = output.signal;
+                reading.has_iaq_data = true;
+                iaqAccuracy = output.accuracy;
+                break;
+            case BSEC_OUTPUT_BREATH_VOC_EQUIVALENT:
+                reading.voc_equivalent = output.signal;
+                reading.has_voc_data = true;
+                break;
+            case BSEC_OUTPUT_RAW_GAS: reading.gas_resistance = output.signal; break;
+            case BSEC_OUTPUT_STABILIZATION_STATUS: reading.stabilized = (output.signal == 1); break;
+            case BSEC_OUTPUT_RUN_IN_STATUS:
+                reading.runin_status = output.signal;
+                reading.is_calibrated = (output.signal >= 75.0f);
+                break;
+            case BSEC_OUTPUT_STATIC_IAQ: reading.static_iaq = output.signal; break;
+            case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE: reading.extra[0] = output.signal; break;
+            case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY: reading.extra[1] = output.signal; break;
+            case BSEC_OUTPUT_GAS_PERCENTAGE: reading.extra[2] = output.signal; break;
+        }
+    }
+}
+
+// SensorDataCollectorがLPモードで購読する全出力
+static void addFullOutputSet() {
+    addOutput(BSEC_OUTPUT_RAW_TEMPERATURE, 23.25f);
+    addOutput(BSEC_OUTPUT_RAW_HUMIDITY, 41.5f);
+    addOutput(BSEC_OUTPUT_RAW_PRESSURE, 101325.0f);
+    addOutput(BSEC_OUTPUT_CO2_EQUIVALENT, 612.0f);
+    addOutput(BSEC_OUTPUT_IAQ, 87.5f, 3);
+    addOutput(BSEC_OUTPUT_BREATH_VOC_EQUIVALENT, 0.84f);
+    addOutput(BSEC_OUTPUT_RAW_GAS, 48211.0f);
+    addOutput(BSEC_OUTPUT_STABILIZATION_STATUS, 1.0f);
+    addOutput(BSEC_OUTPUT_RUN_IN_STATUS, 80.0f);
+    addOutput(BSEC_OUTPUT_STATIC_IAQ, 72.0f);
+    addOutput(BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE, 22.1f);
+    addOutput(BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY, 45.2f);
+    addOutput(BSEC_OUTPUT_GAS_PERCENTAGE, 55.0f);
+}
+
+static size_t countColumns(const String& line) {
+    size_t columns = 1;
+    for (unsigned int i = 0; i < line.length(); i++) {
+        if (line[i] == ',') columns++;
+    }
+    return columns;
+}
+
+void setUp(void) {
+    memset(&outputs, 0, sizeof(outputs));
+}
+
+void tearDown(void) {
+}
+
+void test_decode_matches_switch(void) {
+    addFullOutputSet();
+    addOutput(BSEC_OUTPUT_COMPENSATED_GAS, 4.5f);   // 表にない出力は無視される
+    
+    SensorReading byTable;
+    SensorReading bySwitch;
+    uint8_t tableAccuracy = 0;
+    uint8_t switchAccuracy = 0;
+    SensorFields::decode(outputs, byTable, &tableAccuracy);
+    decodeBySwitch(outputs, bySwitch, switchAccuracy);
+    
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(SensorFields::getValue(SENSOR_FIELDS[i], bySwitch), SensorFields::getValue(SENSOR_FIELDS[i], byTable));
+    }
+    TEST_ASSERT_EQUAL(bySwitch.has_co2_data, byTable.has_co2_data);
+    TEST_ASSERT_EQUAL(bySwitch.has_iaq_data, byTable.has_iaq_data);
+    TEST_ASSERT_EQUAL(bySwitch.has_voc_data, byTable.has_voc_data);
+    TEST_ASSERT_EQUAL(bySwitch.is_calibrated, byTable.is_calibrated);
+    TEST_ASSERT_EQUAL_UINT8(switchAccuracy, tableAccuracy);
+    TEST_ASSERT_EQUAL_UINT8(3, tableAccuracy);
+    TEST_ASSERT_EQUAL_FLOAT(1013.25f, byTable.pressure);
+    TEST_ASSERT_TRUE(byTable.stabilized);
+    TEST_ASSERT_TRUE(byTable.is_calibrated);
+    TEST_ASSERT_TRUE(byTable.has_co2_data && byTable.has_iaq_data && byTable.has_voc_data);
+    TEST_ASSERT_EQUAL_FLOAT(55.0f, SensorFields::getValue(*SensorFields::find(BSEC_OUTPUT_GAS_PERCENTAGE), byTable));
+}
+
+void test_extra_outputs_take_slots_in_table_order(void) {
+    // FIELD_EXTRAの項目は表の順にextra[0]から詰めて割り当て、他の項目とは重ならない
+    uint8_t next = 0;
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        const SensorField& field = SENSOR_FIELDS[i];
+        TEST_ASSERT_EQUAL(field.member != nullptr || (field.flags & FIELD_EXTRA), SensorFields::hasSlot(field));
+        if (field.flags & FIELD_EXTRA) {
+            TEST_ASSERT_NULL(field.member);
+            TEST_ASSERT_EQUAL_INT8(next, SENSOR_FIELD_INDEX.extraSlot[i]);
+            next++;
+        } else {
+            TEST_ASSERT_EQUAL_INT8(-1, SENSOR_FIELD_INDEX.extraSlot[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT8(next, SENSOR_FIELD_INDEX.extraCount);
+    TEST_ASSERT_EQUAL_UINT8(3, next);
+    
+    SensorReading reading;
+    const SensorField& percentage = *SensorFields::find(BSEC_OUTPUT_GAS_PERCENTAGE);
+    TEST_ASSERT_EQUAL_PTR(&reading.extra[2], SensorFields::slot(percentage, reading));
+    TEST_ASSERT_NULL(SensorFields::slot(*SensorFields::find(BSEC_OUTPUT_STABILIZATION_STATUS), reading));
+    
+    // 熱補償後の温度・湿度は生の値とは別の列に入る
+    addFullOutputSet();
+    SensorFields::decode(outputs, reading);
+    TEST_ASSERT_EQUAL_FLOAT(23.25f, reading.temperature);
+    TEST_ASSERT_EQUAL_FLOAT(22.1f, reading.extra[0]);
+    TEST_ASSERT_EQUAL_FLOAT(41.5f, reading.humidity);
+    TEST_ASSERT_EQUAL_FLOAT(45.2f, reading.extra[1]);
+    TEST_ASSERT_EQUAL_FLOAT(55.0f, reading.extra[2]);
+}
+
+void test_decode_benchmark(void) {
+    // BSECコールバック内で1回の出力（全13出力）を取り込む時間を、表引きと手書きswitchで比べる
+    addFullOutputSet();
+    const int rounds = 200000;
+    SensorReading reading;
+    uint8_t accuracy = 0;
+    volatile float sink = 0.0f;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        outputs.output[0].signal = (float)i;
+        SensorFields::decode(outputs, reading, &accuracy);
+        sink = sink + reading.temperature;
+    }
+    double tableNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        outputs.output[0].signal = (float)i;
+        decodeBySwitch(outputs, reading, accuracy);
+        sink = sink + reading.temperature;
+    }
+    double switchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    
+    char message[128];
+    snprintf(message, sizeof(message), "decode %u outputs: table %.1f ns, switch %.1f ns",
+             (unsigned)outputs.nOutputs, tableNs, switchNs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_FLOAT((float)(rounds - 1), reading.temperature);
+    TEST_ASSERT_LESS_THAN(5000.0, tableNs);
+}
+
+void test_decode_resets_quality_flags(void) {
+    SensorReading reading;
+    addOutput(BSEC_OUTPUT_IAQ, 50.0f, 1);
+    addOutput(BSEC_OUTPUT_CO2_EQUIVALENT, 500.0f);
+    SensorFields::decode(outputs, reading);
+    TEST_ASSERT_TRUE(reading.has_iaq_data);
+    
+    // 温度だけの出力ではIAQ・CO2・VOCのフラグが落ち、保存対象から外れる
+    memset(&outputs, 0, sizeof(outputs));
+    addOutput(BSEC_OUTPUT_RAW_TEMPERATURE, 21.0f);
+    uint8_t accuracy = 9;
+    SensorFields::decode(outputs, reading, &accuracy);
+    TEST_ASSERT_FALSE(reading.has_iaq_data);
+    TEST_ASSERT_FALSE(reading.has_co2_data);
+    TEST_ASSERT_EQUAL_UINT8(9, accuracy);
+    TEST_ASSERT_FALSE(SensorFields::hasValue(*SensorFields::find(BSEC_OUTPUT_IAQ), reading));
+    TEST_ASSERT_TRUE(SensorFields::hasValue(*SensorFields::find(BSEC_OUTPUT_RAW_TEMPERATURE), reading));
+}
+
+void test_index_matches_linear_search(void) {
+    for (uint16_t id = 0; id < 256; id++) {
+        const SensorField* expected = nullptr;
+        for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+            if (SENSOR_FIELDS[i].sensorId == id) expected = &SENSOR_FIELDS[i];
+        }
+        TEST_ASSERT_EQUAL_PTR(expected, SensorFields::find((uint8_t)id));
+    }
+}
+
+void test_subscription_lists_table_outputs(void) {
+    bsecSensor list[SensorFields::FIELD_COUNT + 4];
+    TEST_ASSERT_EQUAL_UINT8(SensorFields::FIELD_COUNT, SensorFields::buildSubscription(list, sizeof(list) / sizeof(list[0])));
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT8(SENSOR_FIELDS[i].sensorId, list[i]);
+    }
+    
+    // 容量を超えて書き込まない
+    TEST_ASSERT_EQUAL_UINT8(3, SensorFields::buildSubscription(list, 3));
+}
+
+void test_csv_row_matches_header(void) {
+    SensorReading reading;
+    reading.timestamp = 1700000000;
+    reading.temperature = 23.456f;
+    reading.stabilized = true;
+    reading.device_handle = DeviceRegistry::intern("kitchen");
+    reading.channel = 1;
+    reading.outlier_mask = 5;
+    
+    String header = SensorFields::csvHeader();
+    String row = SensorFields::csvRow(reading);
+    TEST_ASSERT_TRUE(header.startsWith("timestamp,temperature,"));
+    TEST_ASSERT_TRUE(header.endsWith(",static_iaq,heat_comp_temperature,heat_comp_humidity,gas_percentage,device_id,channel,outlier_mask"));
+    TEST_ASSERT_EQUAL(SensorFields::FIELD_COUNT + 4, countColumns(header));
+    TEST_ASSERT_EQUAL(countColumns(header), countColumns(row));
+    TEST_ASSERT_TRUE(row.startsWith("1700000000,23.46,"));
+    TEST_ASSERT_TRUE(row.indexOf(",0.00,1,0.00,0.00,0.00,0.00,0.00,kitchen,1,5") >= 0);
+}
+
+void test_json_and_schema_cover_every_field(void) {
+    SensorReading reading;
+    reading.iaq = 42.0f;
+    
+    JsonDocument payload;
+    SensorFields::toJson(reading, payload);
+    JsonDocument schema;
+    SensorFields::describeSchema(schema);
+    TEST_ASSERT_EQUAL((int)sizeof(SensorReading), schema["record_size"] | 0);
+    
+    for (size_t i = 0; i < SensorFields::FIELD_COUNT; i++) {
+        const SensorField& field = SENSOR_FIELDS[i];
+        TEST_ASSERT_TRUE(payload[field.column].is<float>());
+        TEST_ASSERT_EQUAL_STRING(field.column, schema["fields"][(int)i]["name"] | "");
+        TEST_ASSERT_EQUAL(field.sensorId, schema["fields"][(int)i]["bsec_output"] | -1);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(42.0f, payload["iaq"] | 0.0f);
+    
+    // 型とオフセットはSensorReadingの実際の配置と一致する
+    TEST_ASSERT_EQUAL((int)offsetof(SensorReading, temperature), schema["fields"][0]["offset"] | -1);
+    TEST_ASSERT_EQUAL((int)offsetof(SensorReading, pressure), schema["fields"][2]["offset"] | -1);
+    TEST_ASSERT_EQUAL((int)offsetof(SensorReading, static_iaq), schema["fields"][9]["offset"] | -1);
+    TEST_ASSERT_EQUAL((int)offsetof(SensorReading, extra) + 2 * (int)sizeof(float), schema["fields"][12]["offset"] | -1);
+    TEST_ASSERT_EQUAL_STRING("f32", schema["fields"][12]["type"] | "");
+    TEST_ASSERT_EQUAL_STRING("flag", schema["fields"][7]["type"] | "");
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_decode_matches_switch);
+    RUN_TEST(test_extra_outputs_take_slots_in_table_order);
+    RUN_TEST(test_decode_benchmark);
+    RUN_TEST(test_decode_resets_quality_flags);
+    RUN_TEST(test_index_matches_linear_search);
+    RUN_TEST(test_subscription_lists_table_outputs);
+    RUN_TEST(test_csv_row_matches_header);
+    RUN_TEST(test_json_and_schema_cover_every_field);
+    return UNITY_END();
+}
\ No newline at end of file
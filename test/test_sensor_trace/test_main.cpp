@@ -0,0 +1,186 @@
+#include <unity.h>
+#include <string.h>
+#include <vector>
+#include "SensorTracePlayer.h"
+
+// 記録形式で組み立てたトレースをSensorTracePlayerで再生し、
+// 再生時刻・投入先の満杯・破損の扱いを確認する
+
+static std::vector<uint8_t> trace;
+
+static void beginTrace() {
+    trace.clear();
+    SensorTraceHeader header = SensorTraceFormat::makeHeader();
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+    trace.insert(trace.end(), bytes, bytes + sizeof(header));
+}
+
+static void appendRecord(uint32_t captureMs, uint32_t timestamp, uint8_t channel, float iaq, uint8_t nOutputs = 2) {
+    SensorTraceRecordHeader header;
+    header.captureMs = captureMs;
+    header.timestamp = timestamp;
+    header.nOutputs = nOutputs;
+    header.channel = channel;
+    header.flags = SensorTraceRecordHeader::FLAG_TIME_SYNCED;
+    header.reserved = 0;
+    
+    bme68xData data;
+    memset(&data, 0, sizeof(data));
+    data.temperature = 20.0f + channel;
+    data.gas_resistance = 50000.0f;
+    
+    bsecData outputs[BSEC_NUMBER_OUTPUTS];
+    memset(outputs, 0, sizeof(outputs));
+    outputs[0].sensor_id = BSEC_OUTPUT_IAQ;
+    outputs[0].signal = iaq;
+    outputs[1].sensor_id = BSEC_OUTPUT_RAW_TEMPERATURE;
+    outputs[1].signal = data.temperature;
+    
+    size_t offset = trace.size();
+    trace.resize(offset + SensorTraceFormat::recordSize(nOutputs));
+    size_t written = SensorTraceFormat::encodeRecord(trace.data() + offset, trace.size() - offset, header, data, outputs);
+    TEST_ASSERT_EQUAL(SensorTraceFormat::recordSize(nOutputs), written);
+}
+
+void setUp(void) {
+    beginTrace();
+}
+
+void tearDown(void) {
+}
+
+void test_round_trip_preserves_records(void) {
+    for (uint32_t i = 0; i < 5; i++) {
+        appendRecord(1000 + i * 3000, 1700000000 + i * 3, i % 2, 25.0f + i);
+    }
+    
+    SensorTraceMemorySource source(trace.data(), trace.size());
+    SensorTracePlayer player;
+    TEST_ASSERT_TRUE(player.begin(source, SensorTracePlayer::SPEED_UNTHROTTLED, 0));
+    
+    std::vector<SensorTraceRecord> received;
+    size_t fed = player.update(0, 64, [&received](const SensorTraceRecord& record) {
+        received.push_back(record);
+        return true;
+    });
+    
+    TEST_ASSERT_EQUAL(5, fed);
+    TEST_ASSERT_EQUAL(5, received.size());
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_UINT32(1700000000 + i * 3, received[i].header.timestamp);
+        TEST_ASSERT_EQUAL_UINT8(i % 2, received[i].header.channel);
+        TEST_ASSERT_EQUAL_UINT8(SensorTraceRecordHeader::FLAG_TIME_SYNCED, received[i].header.flags);
+        TEST_ASSERT_EQUAL_UINT8(2, received[i].outputs.nOutputs);
+        TEST_ASSERT_EQUAL_UINT8(BSEC_OUTPUT_IAQ, received[i].outputs.output[0].sensor_id);
+        TEST_ASSERT_EQUAL_FLOAT(25.0f + i, received[i].outputs.output[0].signal);
+        TEST_ASSERT_EQUAL_FLOAT(20.0f + i % 2, received[i].data.temperature);
+    }
+    TEST_ASSERT_TRUE(player.getState() == SensorTracePlayer::State::FINISHED);
+}
+
+void test_speed_scales_capture_interval(void) {
+    // 3秒間隔の記録を10倍速で再生すると300msごとに1件ずつ出てくる
+    for (uint32_t i = 0; i < 4; i++) {
+        appendRecord(5000 + i * 3000, 1700000000 + i * 3, 0, 30.0f);
+    }
+    
+    SensorTraceMemorySource source(trace.data(), trace.size());
+    SensorTracePlayer player;
+    TEST_ASSERT_TRUE(player.begin(source, 10.0f, 100000));
+    
+    auto accept = [](const SensorTraceRecord&) { return true; };
+    TEST_ASSERT_EQUAL(1, player.update(100000, 64, accept));
+    TEST_ASSERT_EQUAL(0, player.update(100299, 64, accept));
+    TEST_ASSERT_EQUAL(1, player.update(100300, 64, accept));
+    TEST_ASSERT_EQUAL(2, player.update(100900, 64, accept));
+    TEST_ASSERT_FALSE(player.isPlaying());
+}
+
+void test_full_sink_keeps_pending_record(void) {
+    // 投入先（読み取り値リング）が満杯のときは読み進めず、次回に同じレコードから再開する
+    const size_t total = 40;
+    const size_t ringCapacity = 32;
+    for (uint32_t i = 0; i < total; i++) {
+        appendRecord(i * 3000, 1700000000 + i, 0, (float)i);
+    }
+    
+    SensorTraceMemorySource source(trace.data(), trace.size());
+    SensorTracePlayer player;
+    TEST_ASSERT_TRUE(player.begin(source, SensorTracePlayer::SPEED_UNTHROTTLED, 0));
+    
+    std::vector<uint32_t> ring;
+    auto push = [&ring, ringCapacity](const SensorTraceRecord& record) {
+        if (ring.size() >= ringCapacity) {
+            return false;
+        }
+        ring.push_back(record.header.timestamp);
+        return true;
+    };
+    
+    TEST_ASSERT_EQUAL(ringCapacity, player.update(0, 64, push));
+    TEST_ASSERT_TRUE(player.isPlaying());
+    
+    std::vector<uint32_t> consumed(ring);
+    ring.clear();
+    TEST_ASSERT_EQUAL(total - ringCapacity, player.update(0, 64, push));
+    consumed.insert(consumed.end(), ring.begin(), ring.end());
+    
+    TEST_ASSERT_EQUAL(total, consumed.size());
+    for (uint32_t i = 0; i < total; i++) {
+        TEST_ASSERT_EQUAL_UINT32(1700000000 + i, consumed[i]);
+    }
+    TEST_ASSERT_EQUAL(total, player.getReplayedCount());
+}
+
+void test_max_records_limits_batch(void) {
+    for (uint32_t i = 0; i < 10; i++) {
+        appendRecord(i, 1700000000 + i, 0, 0.0f);
+    }
+    
+    SensorTraceMemorySource source(trace.data(), trace.size());
+    SensorTracePlayer player;
+    TEST_ASSERT_TRUE(player.begin(source, SensorTracePlayer::SPEED_UNTHROTTLED, 0));
+    
+    auto accept = [](const SensorTraceRecord&) { return true; };
+    TEST_ASSERT_EQUAL(4, player.update(0, 4, accept));
+    TEST_ASSERT_EQUAL(4, player.update(0, 4, accept));
+    TEST_ASSERT_EQUAL(2, player.update(0, 4, accept));
+    TEST_ASSERT_FALSE(player.isPlaying());
+}
+
+void test_rejects_incompatible_header(void) {
+    appendRecord(0, 1700000000, 0, 0.0f);
+    trace[0] = 'X';
+    
+    SensorTraceMemorySource source(trace.data(), trace.size());
+    SensorTracePlayer player;
+    TEST_ASSERT_FALSE(player.begin(source, SensorTracePlayer::SPEED_UNTHROTTLED, 0));
+    TEST_ASSERT_TRUE(player.getState() == SensorTracePlayer::State::FORMAT_MISMATCH);
+}
+
+void test_stops_on_corrupted_record(void) {
+    appendRecord(0, 1700000000, 0, 0.0f);
+    appendRecord(1, 1700000001, 0, 0.0f);
+    // 2件目のnOutputsを範囲外にする
+    size_t second = sizeof(SensorTraceHeader) + SensorTraceFormat::recordSize(2);
+    trace[second + offsetof(SensorTraceRecordHeader, nOutputs)] = BSEC_NUMBER_OUTPUTS + 1;
+    
+    SensorTraceMemorySource source(trace.data(), trace.size());
+    SensorTracePlayer player;
+    TEST_ASSERT_TRUE(player.begin(source, SensorTracePlayer::SPEED_UNTHROTTLED, 0));
+    
+    auto accept = [](const SensorTraceRecord&) { return true; };
+    TEST_ASSERT_EQUAL(1, player.update(0, 64, accept));
+    TEST_ASSERT_TRUE(player.getState() == SensorTracePlayer::State::CORRUPTED);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_preserves_records);
+    RUN_TEST(test_speed_scales_capture_interval);
+    RUN_TEST(test_full_sink_keeps_pending_record);
+    RUN_TEST(test_max_records_limits_batch);
+    RUN_TEST(test_rejects_incompatible_header);
+    RUN_TEST(test_stops_on_corrupted_record);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include <unity.h>
+#include <thread>
+#include "SpscRingBuffer.h"
+#include "SystemTypes.h"
+
+// 単一生産者・単一消費者のリングを、1スレッドでの境界条件と、
+// 生産者・消費者を別スレッドで同時に動かしたときの順序・欠落・重複で確認する
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_fifo_and_wraparound(void) {
+    SpscRingBuffer<uint32_t, 4> ring;
+    uint32_t value = 0;
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_FALSE(ring.pop(value));
+    
+    // 容量を何周もしながら入れた順に出てくる
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 3; i++) TEST_ASSERT_TRUE(ring.push(next++));
+        for (int i = 0; i < 3; i++) {
+            TEST_ASSERT_TRUE(ring.pop(value));
+            TEST_ASSERT_EQUAL_UINT32(expected++, value);
+        }
+    }
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getDroppedCount());
+}
+
+void test_full_ring_drops_newest(void) {
+    SpscRingBuffer<uint32_t, 4> ring;
+    for (uint32_t i = 0; i < 4; i++) TEST_ASSERT_TRUE(ring.push(i));
+    TEST_ASSERT_EQUAL(4, ring.size());
+    
+    // 満杯では新しい要素を捨て、入っている要素は失わない
+    TEST_ASSERT_FALSE(ring.push(100));
+    TEST_ASSERT_FALSE(ring.push(101));
+    TEST_ASSERT_EQUAL_UINT32(2, ring.getDroppedCount());
+    
+    uint32_t value;
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(ring.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i, value);
+    }
+    TEST_ASSERT_FALSE(ring.pop(value));
+}
+
+void test_concurrent_producer_consumer(void) {
+    // BSECコールバック（生産者）とメインループ（消費者）を模して、読み取り値を別スレッドで受け渡す
+    static SpscRingBuffer<SensorReading, 32> ring;
+    const uint32_t total = 200000;
+    
+    std::thread producer([total]() {
+        for (uint32_t i = 1; i <= total; i++) {
+            SensorReading reading;
+            reading.timestamp = i;
+            reading.temperature = (float)i;
+            reading.channel = (uint8_t)(i & 0x03);
+            ring.push(reading);     // 満杯なら捨てる（生産者は待たない）
+        }
+    });
+    
+    uint32_t received = 0;
+    uint32_t last = 0;
+    bool ordered = true;
+    bool intact = true;
+    auto drain = [&]() {
+        SensorReading reading;
+        while (ring.pop(reading)) {
+            ordered = ordered && reading.timestamp > last;
+            intact = intact && reading.temperature == (float)reading.timestamp &&
+                     reading.channel == (uint8_t)(reading.timestamp & 0x03);
+            last = reading.timestamp;
+            received++;
+        }
+    };
+    while (last < total && received + ring.getDroppedCount() < total) {
+        drain();
+        std::this_thread::yield();
+    }
+    producer.join();
+    drain();
+    
+    // 捨てた件数と受け取った件数で全件になり、順序が入れ替わらず、要素が壊れない
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_TRUE(intact);
+    TEST_ASSERT_EQUAL_UINT32(total, received + ring.getDroppedCount());
+    TEST_ASSERT_TRUE(received > 0);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_and_wraparound);
+    RUN_TEST(test_full_ring_drops_newest);
+    RUN_TEST(test_concurrent_producer_consumer);
+    return UNITY_END();
+}
\ No newline at end of file
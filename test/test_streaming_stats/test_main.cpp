@@ -0,0 +1,169 @@
+#include <unity.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "StreamingStats.h"
+
+// Welford法の逐次平均・分散を全件を保持した2パス計算と突き合わせ、
+// EWMAの時定数と外れ値の除外を確認する
+
+static void batchMeanVariance(const std::vector<double>& values, double& mean, double& variance) {
+    double sum = 0.0;
+    for (double v : values) sum += v;
+    mean = sum / values.size();
+    
+    double squares = 0.0;
+    for (double v : values) squares += (v - mean) * (v - mean);
+    variance = values.size() > 1 ? squares / (values.size() - 1) : 0.0;
+}
+
+static void compareWithBatch(float offset, float sigma, uint32_t seed) {
+    RunningStats stats;
+    std::vector<double> values;
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, sigma);
+    
+    for (uint32_t i = 0; i < 20000; i++) {
+        float value = offset + noise(rng);
+        stats.update(value, 1700000000 + i * 3);
+        values.push_back(value);
+        
+        if (i == 1 || i == 99 || i == 19999) {
+            double mean, variance;
+            batchMeanVariance(values, mean, variance);
+            TEST_ASSERT_EQUAL_UINT32(values.size(), stats.count);
+            TEST_ASSERT_FLOAT_WITHIN(fabs(mean) * 1e-6 + 1e-6, mean, stats.getMean());
+            TEST_ASSERT_FLOAT_WITHIN(variance * 1e-4 + 1e-9, variance, stats.getVariance());
+        }
+    }
+    
+    float minValue = values[0], maxValue = values[0];
+    for (double v : values) {
+        if (v < minValue) minValue = v;
+        if (v > maxValue) maxValue = v;
+    }
+    TEST_ASSERT_EQUAL_FLOAT(minValue, stats.minValue);
+    TEST_ASSERT_EQUAL_FLOAT(maxValue, stats.maxValue);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_welford_matches_batch_temperature(void) {
+    compareWithBatch(22.0f, 0.3f, 1);
+}
+
+void test_welford_matches_batch_large_offset(void) {
+    // ガス抵抗のように大きな値の小さなばらつきでも桁落ちしない
+    compareWithBatch(150000.0f, 25.0f, 2);
+}
+
+void test_single_sample_has_zero_variance(void) {
+    RunningStats stats;
+    stats.update(5.0f, 100);
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, stats.getMean());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, stats.getVariance());
+    
+    stats.update(NAN, 103);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.count);
+}
+
+void test_ewma_step_response_follows_time_constant(void) {
+    // 0から1への段差に対し、時定数τ経過後のEWMAは1 - e^-1になる（サンプル間隔によらない）
+    const uint32_t intervals[] = { 3, 300 };
+    for (uint32_t interval : intervals) {
+        RunningStats stats;
+        stats.update(0.0f, 0);
+        uint32_t t = 0;
+        while (t < 3600) {
+            t += interval;
+            stats.update(1.0f, t);
+        }
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f - expf(-1.0f), stats.getEwma(StreamingStats::EWMA_1HOUR));
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, stats.getEwma(StreamingStats::EWMA_1MIN));
+    }
+}
+
+void test_outlier_fields_are_skipped(void) {
+    StreamingStats stats;
+    size_t bit = SensorFields::find(BSEC_OUTPUT_RAW_TEMPERATURE) - SENSOR_FIELDS;
+    
+    for (uint32_t i = 0; i < 10; i++) {
+        SensorReading reading;
+        reading.timestamp = 1700000000 + i * 3;
+        reading.time_synced = true;
+        reading.temperature = (i == 5) ? 80.0f : 20.0f;
+        reading.outlier_mask = (i == 5) ? (1 << bit) : 0;
+        stats.update(reading);
+    }
+    
+    const RunningStats* temperature = stats.get(0, BSEC_OUTPUT_RAW_TEMPERATURE);
+    TEST_ASSERT_NOT_NULL(temperature);
+    TEST_ASSERT_EQUAL_UINT32(9, temperature->count);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, temperature->maxValue);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.getChannel(0)->skippedOutliers);
+    TEST_ASSERT_NULL(stats.get(StreamingStats::MAX_CHANNELS, BSEC_OUTPUT_RAW_TEMPERATURE));
+}
+
+void test_update_benchmark(void) {
+    // 1回の読み取り値（全項目）の取り込みにかかる時間と、同じ値を全件保持して2パスで求め直す場合の比較
+    const uint32_t rounds = 100000;
+    std::mt19937 rng(4);
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+    std::vector<SensorReading> readings(rounds);
+    for (uint32_t i = 0; i < rounds; i++) {
+        SensorReading& reading = readings[i];
+        reading.timestamp = 1700000000 + i * 3;
+        reading.time_synced = true;
+        reading.temperature = 22.0f + noise(rng);
+        reading.humidity = 45.0f + noise(rng);
+        reading.pressure = 1013.0f + noise(rng);
+        reading.gas_resistance = 150000.0f + 100.0f * noise(rng);
+        reading.iaq = 50.0f + noise(rng);
+        reading.co2_equivalent = 600.0f + noise(rng);
+        reading.voc_equivalent = 0.8f + 0.01f * noise(rng);
+        reading.has_iaq_data = true;
+        reading.has_co2_data = true;
+        reading.has_voc_data = true;
+    }
+    
+    StreamingStats stats;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds; i++) {
+        stats.update(readings[i]);
+    }
+    double updateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    TEST_ASSERT_EQUAL_UINT32(rounds, stats.getChannel(0)->readingCount);
+    
+    // 比較用：温度1項目だけを直近1000件から2パスで求め直す
+    std::vector<double> window;
+    double mean = 0.0, variance = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds; i++) {
+        window.push_back(readings[i].temperature);
+        if (window.size() > 1000) window.erase(window.begin());
+        batchMeanVariance(window, mean, variance);
+    }
+    double batchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    
+    char message[160];
+    snprintf(message, sizeof(message), "StreamingStats::update %.0f ns/reading (all fields), two-pass over 1000 samples %.0f ns (one field)",
+             updateNs, batchNs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 22.0, mean);
+    TEST_ASSERT_LESS_THAN(20000.0, updateNs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_welford_matches_batch_temperature);
+    RUN_TEST(test_welford_matches_batch_large_offset);
+    RUN_TEST(test_single_sample_has_zero_variance);
+    RUN_TEST(test_ewma_step_response_follows_time_constant);
+    RUN_TEST(test_outlier_fields_are_skipped);
+    RUN_TEST(test_update_benchmark);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include <unity.h>
+#include <string.h>
+#include "ToastQueue.h"
+
+// 表示順（優先度・追加順）、重複のまとめ、割り込み中の表示時間の扱い、満杯時の押し出しを確認する
+
+static const uint32_t RED = 0xF800;
+static const uint32_t WHITE = 0xFFFF;
+
+static ToastQueue queue;
+
+// 表示すべきメッセージの文言（なければ空文字列）
+static const char* shownText(unsigned long now) {
+    const Toast* toast = queue.update(now);
+    return toast ? toast->text : "";
+}
+
+void setUp(void) {
+    queue = ToastQueue();
+}
+
+void tearDown(void) {
+}
+
+void test_shows_by_priority_then_age(void) {
+    TEST_ASSERT_TRUE(queue.push("info-a", WHITE, ToastPriority::INFO, 1000, 0));
+    TEST_ASSERT_TRUE(queue.push("warn", WHITE, ToastPriority::WARNING, 1000, 0));
+    TEST_ASSERT_TRUE(queue.push("info-b", WHITE, ToastPriority::INFO, 1000, 0));
+    
+    TEST_ASSERT_EQUAL_STRING("warn", shownText(0));
+    TEST_ASSERT_EQUAL_STRING("warn", shownText(999));
+    TEST_ASSERT_EQUAL_STRING("info-a", shownText(1000));
+    TEST_ASSERT_EQUAL_STRING("info-b", shownText(2000));
+    TEST_ASSERT_NULL(queue.update(3000));
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+void test_repeats_coalesced_and_restarted(void) {
+    TEST_ASSERT_TRUE(queue.push("SD error", RED, ToastPriority::ERROR, 3000, 0));
+    TEST_ASSERT_NOT_NULL(queue.update(0));
+    TEST_ASSERT_TRUE(queue.push("SD error", RED, ToastPriority::ERROR, 3000, 2000));
+    TEST_ASSERT_TRUE(queue.push("SD error", RED, ToastPriority::ERROR, 3000, 2500));
+    
+    TEST_ASSERT_EQUAL(1, queue.size());
+    const Toast* toast = queue.update(5000);
+    TEST_ASSERT_NOT_NULL(toast);
+    TEST_ASSERT_EQUAL_UINT16(3, toast->repeats);
+    TEST_ASSERT_NULL(queue.update(5500));
+}
+
+void test_preempted_toast_keeps_remaining_time(void) {
+    // 1秒表示したところでエラーに割り込まれ、エラーの3秒間は表示時間を数えない
+    TEST_ASSERT_TRUE(queue.push("saved", WHITE, ToastPriority::INFO, 2000, 0));
+    TEST_ASSERT_EQUAL_STRING("saved", shownText(0));
+    TEST_ASSERT_TRUE(queue.push("WiFi lost", RED, ToastPriority::ERROR, 3000, 1000));
+    TEST_ASSERT_EQUAL_STRING("WiFi lost", shownText(1000));
+    TEST_ASSERT_EQUAL_STRING("WiFi lost", shownText(3999));
+    
+    // 戻ってからは残りの1秒だけ表示する
+    TEST_ASSERT_EQUAL_STRING("saved", shownText(4000));
+    TEST_ASSERT_EQUAL_STRING("saved", shownText(4999));
+    TEST_ASSERT_NULL(queue.update(5000));
+}
+
+void test_eviction_skips_shown_toasts(void) {
+    // 表示中のメッセージと、割り込まれて中断中のメッセージは満杯でも押し出さない
+    TEST_ASSERT_TRUE(queue.push("shown-0", WHITE, ToastPriority::INFO, 5000, 0));
+    TEST_ASSERT_EQUAL_STRING("shown-0", shownText(0));
+    TEST_ASSERT_TRUE(queue.push("shown-1", WHITE, ToastPriority::WARNING, 5000, 10));
+    TEST_ASSERT_EQUAL_STRING("shown-1", shownText(10));
+    
+    char text[16];
+    for (uint8_t i = 2; i < ToastQueue::CAPACITY; i++) {
+        snprintf(text, sizeof(text), "pending-%u", i);
+        TEST_ASSERT_TRUE(queue.push(text, WHITE, ToastPriority::INFO, 5000, 20));
+    }
+    TEST_ASSERT_EQUAL(ToastQueue::CAPACITY, queue.size());
+    
+    // 押し出されるのはまだ表示していない最も古いINFO
+    TEST_ASSERT_TRUE(queue.push("new-info", WHITE, ToastPriority::INFO, 5000, 30));
+    TEST_ASSERT_EQUAL(1, queue.getDroppedCount());
+    TEST_ASSERT_EQUAL_STRING("shown-1", shownText(30));
+    
+    // 表示待ちがすべて押し出し済みでも、表示したものは残る
+    for (uint8_t i = 0; i < ToastQueue::CAPACITY; i++) {
+        snprintf(text, sizeof(text), "more-%u", i);
+        queue.push(text, WHITE, ToastPriority::INFO, 5000, 40);
+    }
+    TEST_ASSERT_EQUAL(ToastQueue::CAPACITY, queue.size());
+    TEST_ASSERT_EQUAL_STRING("shown-1", shownText(5009));
+    TEST_ASSERT_EQUAL_STRING("shown-0", shownText(5010));
+    TEST_ASSERT_EQUAL_STRING("shown-0", shownText(9999));
+}
+
+void test_rejects_when_only_shown_toasts_are_lower(void) {
+    // 優先度の低いものが表示済みしかなければ、新しいメッセージのほうを捨てる
+    TEST_ASSERT_TRUE(queue.push("shown-info", WHITE, ToastPriority::INFO, 5000, 0));
+    TEST_ASSERT_EQUAL_STRING("shown-info", shownText(0));
+    char text[16];
+    for (uint8_t i = 1; i < ToastQueue::CAPACITY; i++) {
+        snprintf(text, sizeof(text), "warn-%u", i);
+        TEST_ASSERT_TRUE(queue.push(text, WHITE, ToastPriority::WARNING, 5000, 10));
+    }
+    
+    TEST_ASSERT_FALSE(queue.push("late-info", WHITE, ToastPriority::INFO, 5000, 20));
+    TEST_ASSERT_EQUAL(ToastQueue::CAPACITY, queue.size());
+    TEST_ASSERT_EQUAL(1, queue.getDroppedCount());
+}
+
+void test_long_text_truncated_on_character_boundary(void) {
+    char text[Toast::TEXT_SIZE * 2] = "";
+    for (size_t i = 0; i < Toast::TEXT_SIZE / 3 + 4; i++) {
+        strcat(text, "予");    // 3バイト
+    }
+    TEST_ASSERT_TRUE(queue.push(text, WHITE, ToastPriority::INFO, 1000, 0));
+    const Toast* toast = queue.update(0);
+    TEST_ASSERT_NOT_NULL(toast);
+    TEST_ASSERT_EQUAL(0, strlen(toast->text) % 3);
+    TEST_ASSERT_EQUAL(0, strncmp(toast->text, text, strlen(toast->text)));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_shows_by_priority_then_age);
+    RUN_TEST(test_repeats_coalesced_and_restarted);
+    RUN_TEST(test_preempted_toast_keeps_remaining_time);
+    RUN_TEST(test_eviction_skips_shown_toasts);
+    RUN_TEST(test_rejects_when_only_shown_toasts_are_lower);
+    RUN_TEST(test_long_text_truncated_on_character_boundary);
+    return UNITY_END();
+}
\ No newline at end of file
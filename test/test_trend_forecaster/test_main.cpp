@@ -0,0 +1,167 @@
+#include <unity.h>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <random>
+#include "TrendForecaster.h"
+
+// 数週間分の合成した室温（日周変化＋数日周期の天候変化＋ノイズ）で1〜6時間先の予測誤差を測り、
+// 日周成分を学習した後は持続予測（今の値がそのまま続く）より誤差が小さく、週を追って悪化しないことを確認する
+
+static const uint32_t START = 1700000000;
+static const uint32_t INTERVAL = 60;
+static const uint32_t WEEK = 7 * 86400;
+
+struct RoomTemperature {
+    std::mt19937 rng;
+    std::normal_distribution<float> noise;
+    
+    explicit RoomTemperature(uint32_t seed) : rng(seed), noise(0.0f, 0.05f) {}
+    
+    float at(uint32_t t) {
+        const float day = 2.0f * (float)M_PI * (float)(t % 86400) / 86400.0f;
+        const float weather = 2.0f * (float)M_PI * (float)(t - START) / (4.3f * 86400.0f);
+        return 21.0f + 2.5f * sinf(day - 1.2f) + 0.8f * sinf(2.0f * day) + 1.5f * sinf(weather) + noise(rng);
+    }
+};
+
+struct ForecastError {
+    double forecastSum[TrendSnapshot::FORECAST_HOURS];
+    double persistenceSum[TrendSnapshot::FORECAST_HOURS];
+    uint32_t count[TrendSnapshot::FORECAST_HOURS];
+    
+    ForecastError() {
+        for (uint8_t h = 0; h < TrendSnapshot::FORECAST_HOURS; h++) {
+            forecastSum[h] = persistenceSum[h] = 0.0;
+            count[h] = 0;
+        }
+    }
+    float forecastMae(uint8_t h) const { return (float)(forecastSum[h] / count[h]); }
+    float persistenceMae(uint8_t h) const { return (float)(persistenceSum[h] / count[h]); }
+};
+
+struct Pending {
+    uint8_t hour;
+    float forecast;
+    float persistence;
+};
+
+// 1時間ごとに予測を出し、該当時刻の実測値と比べて週ごとに集計する
+static void simulate(uint32_t weeks, ForecastError* errors, TrendForecaster& forecaster) {
+    RoomTemperature room(1);
+    std::multimap<uint32_t, Pending> pending;
+    
+    for (uint32_t t = START; t < START + weeks * WEEK; t += INTERVAL) {
+        SensorReading reading;
+        reading.timestamp = t;
+        reading.time_synced = true;
+        reading.temperature = room.at(t);
+        forecaster.update(reading);
+        
+        auto range = pending.equal_range(t);
+        const uint32_t week = (t - START) / WEEK;
+        for (auto it = range.first; it != range.second; ++it) {
+            errors[week].forecastSum[it->second.hour] += fabsf(it->second.forecast - reading.temperature);
+            errors[week].persistenceSum[it->second.hour] += fabsf(it->second.persistence - reading.temperature);
+            errors[week].count[it->second.hour]++;
+        }
+        pending.erase(range.first, range.second);
+        
+        if ((t - START) % 3600 == 0) {
+            TrendSnapshot snapshot = forecaster.getSnapshot(0, BSEC_OUTPUT_RAW_TEMPERATURE);
+            if (!snapshot.valid) continue;
+            for (uint8_t h = 0; h < TrendSnapshot::FORECAST_HOURS; h++) {
+                pending.insert({ t + (h + 1) * 3600, { h, snapshot.forecast[h], reading.temperature } });
+            }
+        }
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_forecast_beats_persistence_after_first_week(void) {
+    TrendForecaster forecaster;
+    ForecastError errors[3];
+    simulate(3, errors, forecaster);
+    
+    TEST_ASSERT_TRUE(forecaster.getSnapshot(0, BSEC_OUTPUT_RAW_TEMPERATURE).seasonal);
+    for (uint8_t week = 1; week < 3; week++) {
+        for (uint8_t h = 0; h < TrendSnapshot::FORECAST_HOURS; h++) {
+            char message[96];
+            snprintf(message, sizeof(message), "week %u +%uh: forecast %.3f persistence %.3f", week + 1, h + 1,
+                     errors[week].forecastMae(h), errors[week].persistenceMae(h));
+            TEST_MESSAGE(message);
+            TEST_ASSERT_TRUE_MESSAGE(errors[week].forecastMae(h) < errors[week].persistenceMae(h), message);
+        }
+        // 日周変化が支配的な6時間先では持続予測の半分以下
+        TEST_ASSERT_TRUE(errors[week].forecastMae(5) < 0.5f * errors[week].persistenceMae(5));
+    }
+}
+
+void test_forecast_error_does_not_grow_over_weeks(void) {
+    TrendForecaster forecaster;
+    ForecastError errors[4];
+    simulate(4, errors, forecaster);
+    
+    for (uint8_t h = 0; h < TrendSnapshot::FORECAST_HOURS; h++) {
+        TEST_ASSERT_TRUE(errors[3].forecastMae(h) < errors[1].forecastMae(h) * 1.25f);
+    }
+}
+
+void test_update_cost(void) {
+    // 3秒間隔で1週間、4項目（気温・湿度・気圧・IAQ）を含む読み取り値1件あたりの取り込み時間
+    RoomTemperature room(2);
+    std::vector<SensorReading> readings;
+    for (uint32_t t = START; t < START + WEEK; t += 3) {
+        SensorReading reading;
+        reading.timestamp = t;
+        reading.time_synced = true;
+        reading.temperature = room.at(t);
+        reading.humidity = 90.0f - 2.0f * reading.temperature;
+        reading.pressure = 1013.0f + 0.5f * (reading.temperature - 21.0f);
+        reading.iaq = 50.0f + 4.0f * (reading.temperature - 21.0f);
+        reading.has_iaq_data = true;
+        readings.push_back(reading);
+    }
+    
+    TrendForecaster forecaster;
+    auto start = std::chrono::steady_clock::now();
+    for (const SensorReading& reading : readings) {
+        forecaster.update(reading);
+    }
+    double updateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / readings.size();
+    
+    char message[128];
+    snprintf(message, sizeof(message), "update %.0f ns/reading (4 fields), %u bytes for %u channels",
+             updateNs, (unsigned)sizeof(TrendForecaster), TrendForecaster::MAX_CHANNELS);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(forecaster.getSnapshot(0, BSEC_OUTPUT_RAW_PRESSURE).seasonal);
+    TEST_ASSERT_LESS_THAN(20000.0, updateNs);
+}
+
+void test_channel_out_of_range_is_invalid(void) {
+    TrendForecaster forecaster;
+    SensorReading reading;
+    reading.channel = TrendForecaster::MAX_CHANNELS;
+    reading.timestamp = START;
+    reading.time_synced = true;
+    reading.temperature = 20.0f;
+    for (uint8_t i = 0; i < TrendForecaster::MIN_SAMPLES; i++) {
+        reading.timestamp += INTERVAL;
+        forecaster.update(reading);
+    }
+    TEST_ASSERT_FALSE(forecaster.getSnapshot(TrendForecaster::MAX_CHANNELS, BSEC_OUTPUT_RAW_TEMPERATURE).valid);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_forecast_beats_persistence_after_first_week);
+    RUN_TEST(test_forecast_error_does_not_grow_over_weeks);
+    RUN_TEST(test_update_cost);
+    RUN_TEST(test_channel_out_of_range_is_invalid);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include <unity.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "WindowedAggregator.h"
+
+// 窓の最小・最大・件数・分位点を、全サンプルを保持して毎回数え直す素朴な実装と突き合わせる
+// 期限切れはスロット（最小・最大）・区間（分位点）単位なので、素朴な実装も同じ境界で数える
+
+struct Sample {
+    uint32_t timestamp;
+    float value;
+};
+
+static SensorReading makeReading(uint32_t timestamp, float co2, uint8_t channel = 0) {
+    SensorReading reading;
+    reading.timestamp = timestamp;
+    reading.time_synced = true;
+    reading.co2_equivalent = co2;
+    reading.has_co2_data = true;
+    reading.channel = channel;
+    return reading;
+}
+
+static void compareWithBruteForce(uint32_t windowSeconds, uint32_t interval, uint32_t duration, uint32_t seed) {
+    WindowedAggregator aggregator;
+    int8_t index = aggregator.addWindow(0, BSEC_OUTPUT_CO2_EQUIVALENT, windowSeconds);
+    TEST_ASSERT_EQUAL_INT(0, index);
+    const WindowedAggregator::Window* window = aggregator.getWindow(index);
+    
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 15.0f);
+    std::vector<Sample> samples;
+    float level = 600.0f;
+    const uint32_t start = 1700000000;
+    
+    for (uint32_t t = start; t < start + duration; t += interval) {
+        level += noise(rng);
+        if (level < 400.0f) level = 400.0f;
+        aggregator.update(makeReading(t, level));
+        samples.push_back({ t, level });
+        
+        // 最小・最大は現在のスロットを含むslotCount個のスロット
+        const uint32_t slot = t / window->slotSeconds;
+        const uint32_t oldestSlot = slot >= window->slotCount ? slot - (window->slotCount - 1) : 0;
+        float expectedMin = INFINITY, expectedMax = -INFINITY;
+        for (const Sample& sample : samples) {
+            if (sample.timestamp / window->slotSeconds < oldestSlot) continue;
+            expectedMin = fminf(expectedMin, sample.value);
+            expectedMax = fmaxf(expectedMax, sample.value);
+        }
+        float minValue, maxValue;
+        TEST_ASSERT_TRUE(aggregator.getMin(index, minValue));
+        TEST_ASSERT_TRUE(aggregator.getMax(index, maxValue));
+        TEST_ASSERT_EQUAL_FLOAT(expectedMin, minValue);
+        TEST_ASSERT_EQUAL_FLOAT(expectedMax, maxValue);
+        
+        // 件数・分位点は現在の区間を含むQUANTILE_BUCKETS個の区間
+        const uint32_t bucketId = t / window->bucketSeconds;
+        std::vector<float> live;
+        for (const Sample& sample : samples) {
+            if (bucketId - sample.timestamp / window->bucketSeconds < WindowedAggregator::QUANTILE_BUCKETS) {
+                live.push_back(sample.value);
+            }
+        }
+        TEST_ASSERT_EQUAL_UINT32(live.size(), aggregator.getCount(index));
+        
+        if (live.size() >= 50 && (t - start) % (interval * 97) == 0) {
+            std::sort(live.begin(), live.end());
+            const float quantiles[] = { 0.05f, 0.5f, 0.95f };
+            for (float q : quantiles) {
+                float value;
+                TEST_ASSERT_TRUE(aggregator.getQuantile(index, q, value));
+                // 返された値の順位（同値があれば範囲）が要求した分位から数%以内
+                float lowRank = (float)(std::lower_bound(live.begin(), live.end(), value) - live.begin()) / live.size();
+                float highRank = (float)(std::upper_bound(live.begin(), live.end(), value) - live.begin()) / live.size();
+                TEST_ASSERT_TRUE(lowRank <= q + 0.05f);
+                TEST_ASSERT_TRUE(highRank >= q - 0.05f);
+            }
+        }
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_fifteen_minute_window_matches_brute_force(void) {
+    compareWithBruteForce(15 * 60, 3, 3 * 3600, 1);
+}
+
+void test_daily_window_matches_brute_force(void) {
+    compareWithBruteForce(24 * 3600, 300, 4 * 86400, 2);
+}
+
+void test_irregular_window_matches_brute_force(void) {
+    // 窓幅がスロット数・区間数で割り切れない場合
+    compareWithBruteForce(1000, 7, 4 * 3600, 3);
+}
+
+void test_rejects_channel_out_of_range(void) {
+    WindowedAggregator aggregator;
+    TEST_ASSERT_EQUAL_INT(-1, aggregator.addWindow(WindowedAggregator::MAX_CHANNELS, BSEC_OUTPUT_CO2_EQUIVALENT, 900));
+    TEST_ASSERT_EQUAL_INT(0, aggregator.addWindow(WindowedAggregator::MAX_CHANNELS - 1, BSEC_OUTPUT_CO2_EQUIVALENT, 900));
+    TEST_ASSERT_EQUAL_UINT8(1, aggregator.getWindowCount());
+}
+
+void test_rejects_windows_beyond_capacity(void) {
+    WindowedAggregator aggregator;
+    for (uint8_t i = 0; i < WindowedAggregator::MAX_WINDOWS; i++) {
+        TEST_ASSERT_EQUAL_INT(i, aggregator.addWindow(0, BSEC_OUTPUT_CO2_EQUIVALENT, 600 * (i + 1)));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, aggregator.addWindow(1, BSEC_OUTPUT_IAQ, 600));
+    // 同じ窓の再登録は既存の番号を返す
+    TEST_ASSERT_EQUAL_INT(1, aggregator.addWindow(0, BSEC_OUTPUT_CO2_EQUIVALENT, 1200));
+}
+
+void test_other_channels_and_outliers_are_ignored(void) {
+    WindowedAggregator aggregator;
+    int8_t index = aggregator.addWindow(1, BSEC_OUTPUT_CO2_EQUIVALENT, 900);
+    size_t bit = SensorFields::find(BSEC_OUTPUT_CO2_EQUIVALENT) - SENSOR_FIELDS;
+    
+    aggregator.update(makeReading(1700000000, 500.0f, 1));
+    aggregator.update(makeReading(1700000003, 5000.0f, 0));
+    SensorReading outlier = makeReading(1700000006, 9000.0f, 1);
+    outlier.outlier_mask = 1 << bit;
+    aggregator.update(outlier);
+    
+    float maxValue;
+    TEST_ASSERT_TRUE(aggregator.getMax(index, maxValue));
+    TEST_ASSERT_EQUAL_FLOAT(500.0f, maxValue);
+    TEST_ASSERT_EQUAL_UINT32(1, aggregator.getCount(index));
+}
+
+void test_update_and_query_benchmark(void) {
+    // 1秒間隔で2日分：4つの窓（15分・1時間・6時間・24時間）への取り込み時間とp95の問い合わせ時間、
+    // 24時間窓のp95の順位誤差（6時間ごとに全件を数え直して確認）
+    WindowedAggregator aggregator;
+    const uint32_t seconds[] = { 15 * 60, 3600, 6 * 3600, 24 * 3600 };
+    for (uint32_t s : seconds) {
+        TEST_ASSERT_TRUE(aggregator.addWindow(0, BSEC_OUTPUT_CO2_EQUIVALENT, s) >= 0);
+    }
+    const WindowedAggregator::Window* daily = aggregator.getWindow(3);
+    
+    std::mt19937 rng(5);
+    std::normal_distribution<float> noise(0.0f, 15.0f);
+    std::vector<Sample> samples;
+    float level = 600.0f;
+    const uint32_t start = 1700000000;
+    const uint32_t duration = 2 * 86400;
+    double updateNs = 0.0, queryNs = 0.0, cachedNs = 0.0;
+    uint32_t queries = 0;
+    float worstRankError = 0.0f;
+    
+    for (uint32_t t = start; t < start + duration; t++) {
+        level += noise(rng) * 0.1f;
+        if (level < 400.0f) level = 400.0f;
+        SensorReading reading = makeReading(t, level);
+        samples.push_back({ t, level });
+        
+        auto begin = std::chrono::steady_clock::now();
+        aggregator.update(reading);
+        updateNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        
+        if ((t - start) % 600 == 0) {
+            float value;
+            begin = std::chrono::steady_clock::now();
+            TEST_ASSERT_TRUE(aggregator.getQuantile(3, 0.95f, value));
+            queryNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+            // 更新がなければ同じ窓への2回目以降はマージ済みのスケッチを使う
+            float again;
+            begin = std::chrono::steady_clock::now();
+            aggregator.getQuantile(3, 0.95f, again);
+            cachedNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+            TEST_ASSERT_EQUAL_FLOAT(value, again);
+            queries++;
+            
+            if ((t - start) % (6 * 3600) == 0 && t > start) {
+                const uint32_t bucketId = t / daily->bucketSeconds;
+                std::vector<float> live;
+                for (const Sample& sample : samples) {
+                    if (bucketId - sample.timestamp / daily->bucketSeconds < WindowedAggregator::QUANTILE_BUCKETS) {
+                        live.push_back(sample.value);
+                    }
+                }
+                std::sort(live.begin(), live.end());
+                float lowRank = (float)(std::lower_bound(live.begin(), live.end(), value) - live.begin()) / live.size();
+                float highRank = (float)(std::upper_bound(live.begin(), live.end(), value) - live.begin()) / live.size();
+                float error = (lowRank > 0.95f) ? lowRank - 0.95f : ((highRank < 0.95f) ? 0.95f - highRank : 0.0f);
+                if (error > worstRankError) worstRankError = error;
+            }
+        }
+    }
+    
+    char message[224];
+    snprintf(message, sizeof(message), "4 windows: update %.0f ns/reading, p95 query %.2f us (%.2f us repeated), worst p95 rank error %.2f%%, %u bytes",
+             updateNs / duration, queryNs / queries / 1000.0, cachedNs / queries / 1000.0, worstRankError * 100.0f,
+             (unsigned)sizeof(WindowedAggregator));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worstRankError <= 0.05f);
+    TEST_ASSERT_LESS_THAN(20000.0, updateNs / duration);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifteen_minute_window_matches_brute_force);
+    RUN_TEST(test_daily_window_matches_brute_force);
+    RUN_TEST(test_irregular_window_matches_brute_force);
+    RUN_TEST(test_rejects_channel_out_of_range);
+    RUN_TEST(test_rejects_windows_beyond_capacity);
+    RUN_TEST(test_other_channels_and_outliers_are_ignored);
+    RUN_TEST(test_update_and_query_benchmark);
+    return UNITY_END();
+}
\ No newline at end of file